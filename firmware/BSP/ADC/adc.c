@@ -96,6 +96,154 @@ void ADC_Dual_Init(void)
     // adc_software_trigger_enable(ADC0, ADC_REGULAR_CHANNEL);
 }
 
+/*!
+ * \brief   重新配置双ADC的工作模式和规则通道（两个ADC须已禁用）
+ */
+static void ADC_Dual_Reconfig(uint32_t mode, uint8_t ch0, uint8_t ch1,
+                              uint32_t sample_time, uint32_t trigger, ControlStatus continuous)
+{
+    adc_mode_config(mode);
+    
+    adc_special_function_config(ADC0, ADC_CONTINUOUS_MODE, continuous);
+    adc_regular_channel_config(ADC0, 0, ch0, sample_time);
+    adc_external_trigger_source_config(ADC0, ADC_REGULAR_CHANNEL, trigger);
+    
+    adc_special_function_config(ADC1, ADC_CONTINUOUS_MODE, continuous);
+    adc_regular_channel_config(ADC1, 0, ch1, sample_time);
+    adc_external_trigger_source_config(ADC1, ADC_REGULAR_CHANNEL, trigger);
+}
+
+/*!
+ * \brief   使能两个ADC并等待上电稳定
+ */
+void ADC_Dual_Enable(void)
+{
+    adc_enable(ADC0);
+    adc_enable(ADC1);
+    delay_us(10);
+}
+
+/*!
+ * \brief   进入快速交替采样模式（单节点）
+ * \details 两个ADC转换同一通道：ADC时钟72MHz/6 = 12MHz，1.5周期采样（快速交替要求<7周期），
+ *          连续转换，ADC1先转换、ADC0滞后7个ADC时钟，每个ADC 14周期一次，
+ *          合成采样率2×12MHz/14 ≈ 1.714MHz。DMA字格式不变：高16位ADC1（先），低16位ADC0（后）。
+ *          1.5周期采样只有125ns，节点须为低阻运放输出。
+ *          配置完成后由调用者软件触发ADC0开始（先准备好DMA，旧的TIMER3触发样本不会混入）
+ * \param   node - 0=PA6（ADC_CH6），1=PB1（ADC_CH9）
+ */
+void ADC_Interleave_Start(uint8_t node)
+{
+    uint8_t channel = node ? ADC_CHANNEL_9 : ADC_CHANNEL_6;
+    
+    adc_disable(ADC0);
+    adc_disable(ADC1);
+    rcu_adc_clock_config(RCU_CKADC_CKAPB2_DIV6);
+    
+    ADC_Dual_Reconfig(ADC_DAUL_REGULAL_FOLLOWUP_FAST, channel, channel,
+                      ADC_SAMPLETIME_1POINT5, ADC0_1_2_EXTTRIG_REGULAR_NONE, ENABLE);
+    
+    ADC_Dual_Enable();
+}
+
+/*!
+ * \brief   退出快速交替采样，恢复ADC_Dual_Init的规则并行/TIMER3_CH3触发配置
+ */
+void ADC_Interleave_Stop(void)
+{
+    adc_disable(ADC0);
+    adc_disable(ADC1);
+    rcu_adc_clock_config(RCU_CKADC_CKAPB2_DIV12);
+    
+    ADC_Dual_Reconfig(ADC_DAUL_REGULAL_PARALLEL, ADC_CHANNEL_6, ADC_CHANNEL_9,
+                      ADC_SAMPLETIME_13POINT5, ADC0_1_EXTTRIG_REGULAR_T3_CH3, DISABLE);
+    
+    ADC_Dual_Enable();
+}
+
+uint8_t ADC_Scan_ChannelValid(uint8_t channel)
+{
+    /* PA4/PA5/PA7为DAC5311的SPI0引脚 */
+    return (channel < 16 && channel != 4 && channel != 5 && channel != 7) ? 1 : 0;
+}
+
+/*!
+ * \brief   外部通道对应的GPIO配置为模拟输入（CH0-7=PA0-7，CH8-9=PB0-1，CH10-15=PC0-5）
+ */
+static void ADC_Scan_PinInit(uint8_t channel)
+{
+    if(channel < 8)
+    {
+        gpio_init(GPIOA, GPIO_MODE_AIN, GPIO_OSPEED_50MHZ, BIT(channel));
+    }
+    else if(channel < 10)
+    {
+        gpio_init(GPIOB, GPIO_MODE_AIN, GPIO_OSPEED_50MHZ, BIT(channel - 8));
+    }
+    else
+    {
+        rcu_periph_clock_enable(RCU_GPIOC);
+        gpio_init(GPIOC, GPIO_MODE_AIN, GPIO_OSPEED_50MHZ, BIT(channel - 10));
+    }
+}
+
+/*!
+ * \brief   配置多节点扫描（规则并行 + 扫描模式，仍由TIMER3_CH3触发）
+ * \details 节点2k在ADC0的第k个rank，节点2k+1在ADC1的第k个rank，两个ADC序列等长；
+ *          节点数为奇数时ADC1最后一个rank重复节点1的通道（结果丢弃，两个ADC不同时采同一通道）。
+ *          每次触发按rank依次转换，每个rank产生一个DMA字，
+ *          按16位看adc_buffer即为按帧交错的节点样本：第t帧节点n在[t×2R + n]。
+ *          rank k比rank 0晚k×ADC_SCAN_RANK_CYCLES个ADC时钟采样，相位由调用者校正。
+ *          返回时两个ADC保持禁用：调用者重新定位DMA后调用ADC_Dual_Enable，保证帧对齐
+ * \param   channels - 节点ADC通道（各不相同，ADC_Scan_ChannelValid）
+ * \param   count    - 节点数（2~ADC_SCAN_MAX_NODES）
+ * \return  每个ADC的rank数R
+ */
+uint8_t ADC_Scan_Config(const uint8_t *channels, uint8_t count)
+{
+    uint8_t ranks = (uint8_t)((count + 1) / 2);
+    
+    adc_disable(ADC0);
+    adc_disable(ADC1);
+    
+    adc_special_function_config(ADC0, ADC_SCAN_MODE, ENABLE);
+    adc_special_function_config(ADC1, ADC_SCAN_MODE, ENABLE);
+    adc_channel_length_config(ADC0, ADC_REGULAR_CHANNEL, ranks);
+    adc_channel_length_config(ADC1, ADC_REGULAR_CHANNEL, ranks);
+    
+    for(uint8_t k = 0; k < ranks; k++)
+    {
+        uint8_t ch0 = channels[2 * k];
+        uint8_t ch1 = (2 * k + 1 < count) ? channels[2 * k + 1] : channels[1];
+        
+        ADC_Scan_PinInit(ch0);
+        ADC_Scan_PinInit(ch1);
+        adc_regular_channel_config(ADC0, k, ch0, ADC_SAMPLETIME_13POINT5);
+        adc_regular_channel_config(ADC1, k, ch1, ADC_SAMPLETIME_13POINT5);
+    }
+    
+    return ranks;
+}
+
+/*!
+ * \brief   退出多节点扫描，恢复ADC_Dual_Init的两通道配置
+ */
+void ADC_Scan_Stop(void)
+{
+    adc_disable(ADC0);
+    adc_disable(ADC1);
+    
+    adc_special_function_config(ADC0, ADC_SCAN_MODE, DISABLE);
+    adc_special_function_config(ADC1, ADC_SCAN_MODE, DISABLE);
+    adc_channel_length_config(ADC0, ADC_REGULAR_CHANNEL, 1);
+    adc_channel_length_config(ADC1, ADC_REGULAR_CHANNEL, 1);
+    
+    ADC_Dual_Reconfig(ADC_DAUL_REGULAL_PARALLEL, ADC_CHANNEL_6, ADC_CHANNEL_9,
+                      ADC_SAMPLETIME_13POINT5, ADC0_1_EXTTRIG_REGULAR_T3_CH3, DISABLE);
+    
+    ADC_Dual_Enable();
+}
+
 /* ========== 旧的单通道ADC初始化（保留，不使用） ========== */
 void ADC_Init(void)//ͨ��1    PA1     ����ģʽ    ����ģʽ    �ڲ���������      adcʱ��Ϊ9M
 {
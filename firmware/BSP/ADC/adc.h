@@ -6,6 +6,24 @@
 /* 双ADC同步模式初始化 */
 void ADC_Dual_Init(void);
 
+/* 快速交替采样（单节点，两个ADC错开7个ADC时钟转换同一通道） */
+#define ADC_FAST_CLOCK_HZ       12000000UL  /* 72MHz/6 */
+#define ADC_FAST_CONV_CYCLES    14          /* 1.5采样 + 12.5转换 */
+#define ADC_FAST_SAMPLE_RATE    (2 * ADC_FAST_CLOCK_HZ / ADC_FAST_CONV_CYCLES)  /* 合成采样率≈1.714MHz */
+void ADC_Interleave_Start(uint8_t node);
+void ADC_Interleave_Stop(void);
+
+/* 使能两个ADC并等待稳定 */
+void ADC_Dual_Enable(void);
+
+/* 多节点扫描（规则并行 + 扫描模式，每次触发依次转换R个rank） */
+#define ADC_SCAN_MAX_NODES      8           /* 每个ADC最多4个rank */
+#define ADC_SCAN_CLOCK_HZ       6000000UL   /* 72MHz/12 */
+#define ADC_SCAN_RANK_CYCLES    26          /* 13.5采样 + 12.5转换 */
+uint8_t ADC_Scan_ChannelValid(uint8_t channel);
+uint8_t ADC_Scan_Config(const uint8_t *channels, uint8_t count);
+void ADC_Scan_Stop(void);
+
 /* 单通道ADC读取（保留旧接口，兼容性） */
 double ADC_Read(uint32_t adc_periph);
 
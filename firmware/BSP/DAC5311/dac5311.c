@@ -1,22 +1,6 @@
 #include "dac5311.h"
 #include "adc.h"
-
-/*!
- * \brief   DAC5311 SPI引脚定义
- * \details 使用SPI0硬件接口（根据电路图）
- *          PA5 = SPI0_SCK
- *          PA7 = SPI0_MOSI (DIN - 发送数据到DAC)
- *          PA4 = CS片选 (SYNC)
- */
-#define DAC5311_SPI             SPI0
-#define DAC5311_SPI_CLK         RCU_SPI0
-
-#define DAC5311_GPIO_PORT       GPIOA
-#define DAC5311_GPIO_CLK        RCU_GPIOA
-
-#define DAC5311_SCK_PIN         GPIO_PIN_5   /* SPI0_SCK:  PA5 */
-#define DAC5311_MOSI_PIN        GPIO_PIN_7   /* SPI0_MOSI: PA7 (DIN) */
-#define DAC5311_CS_PIN          GPIO_PIN_4   /* CS片选:    PA4 (SYNC) */
+#include "../../USER/profile.h"
 
 /*!
  * \brief   片选控制宏
@@ -52,10 +36,10 @@ void DAC5311_Init(void)
     /* 3. 配置SPI参数 */
     spi_init_struct.trans_mode           = SPI_TRANSMODE_FULLDUPLEX;  /* 全双工 */
     spi_init_struct.device_mode          = SPI_MASTER;                /* 主机模式 */
-    spi_init_struct.frame_size           = SPI_FRAMESIZE_8BIT;        /* 8位数据帧 */
+    spi_init_struct.frame_size           = SPI_FRAMESIZE_16BIT;       /* 16位数据帧（一次写完一帧，可由DMA直接搬运） */
     spi_init_struct.clock_polarity_phase = SPI_CK_PL_LOW_PH_1EDGE;    /* CPOL=0, CPHA=0 */
     spi_init_struct.nss                  = SPI_NSS_SOFT;              /* 软件CS控制 */
-    spi_init_struct.prescale             = SPI_PSC_32;                /* 分频32: 72MHz/32=2.25MHz */
+    spi_init_struct.prescale             = SPI_PSC_4;                 /* 分频4: 72MHz/4=18MHz（一帧0.9us，满足400kHz高速模式） */
     spi_init_struct.endian               = SPI_ENDIAN_MSB;            /* MSB先发送 */
     
     spi_init(DAC5311_SPI, &spi_init_struct);
@@ -68,23 +52,23 @@ void DAC5311_Init(void)
 }
 
 /*!
- * \brief   通过硬件SPI发送一个字节
- * \param   data 要发送的字节
- * \return  接收到的字节（DAC5311不返回数据，忽略）
+ * \brief   通过硬件SPI发送一个16位帧
+ * \param   frame 要发送的帧
+ * \return  接收到的数据（DAC5311不返回数据，忽略）
  */
-static uint8_t DAC5311_SPI_SendByte(uint8_t data)
+static uint16_t DAC5311_SPI_SendFrame(uint16_t frame)
 {
     /* 等待发送缓冲区空 */
     while(RESET == spi_i2s_flag_get(DAC5311_SPI, SPI_FLAG_TBE));
     
     /* 发送数据 */
-    spi_i2s_data_transmit(DAC5311_SPI, data);
+    spi_i2s_data_transmit(DAC5311_SPI, frame);
     
     /* 等待接收缓冲区非空 */
     while(RESET == spi_i2s_flag_get(DAC5311_SPI, SPI_FLAG_RBNE));
     
     /* 读取接收到的数据（清除RBNE标志）*/
-    return (uint8_t)spi_i2s_data_receive(DAC5311_SPI);
+    return spi_i2s_data_receive(DAC5311_SPI);
 }
 
 /*!
@@ -97,21 +81,43 @@ static uint8_t DAC5311_SPI_SendByte(uint8_t data)
  */
 void DAC5311_Write(uint8_t data)
 {
-    /* 将8位数据（0-255）转换为12位（0-4080）：左移4位 */
-    uint16_t dac_value = ((uint16_t)data) << 4;
+    DAC5311_Write12((uint16_t)data << 4);
+}
+
+/*!
+ * \brief   写入DAC5311 12位码值（通过硬件SPI）
+ * \param   code 12位DAC数据（0-4095）
+ * \details 插值DDS模式使用，低4位不再补零
+ */
+void DAC5311_Write12(uint16_t code)
+{
+    PROF_BEGIN(prof_t);
     
     /* 1. 拉低CS，选中DAC5311 */
     DAC5311_CS_LOW();
     
-    /* 2. 发送16位数据：高8位 + 低8位 */
-    DAC5311_SPI_SendByte((uint8_t)(dac_value >> 8));   /* 高8位：D11-D4 */
-    DAC5311_SPI_SendByte((uint8_t)(dac_value & 0xFF)); /* 低8位：D3-D0 + 填充 */
+    /* 2. 发送16位数据帧 */
+    DAC5311_SPI_SendFrame(DAC5311_FRAME12(code));
     
     /* 3. 拉高CS，取消选中（数据锁存）*/
     DAC5311_CS_HIGH();
     
     /* 4. 短暂延迟，确保DAC5311完成转换 */
     for(volatile int i = 0; i < 10; i++);
+    
+    PROF_END(PROF_DAC_WRITE, prof_t);
+}
+
+/*!
+ * \brief   清除SPI接收残留（高速模式DMA只写不读，会留下溢出标志）
+ * \details 从高速模式切回中断模式前调用，保证DAC5311_Write的RBNE等待正常
+ */
+void DAC5311_FlushRx(void)
+{
+    while(SET == spi_i2s_flag_get(DAC5311_SPI, SPI_FLAG_TRANS));
+    (void)spi_i2s_data_receive(DAC5311_SPI);
+    (void)spi_i2s_flag_get(DAC5311_SPI, SPI_FLAG_RXORERR);
+    DAC5311_CS_HIGH();
 }
 
 /* 保留原来的SPI中断处理函数（暂时注释掉，改用定时器中断） */
@@ -10,10 +10,39 @@
  *          注意：PA7保留给ADC1_CH7使用
  */
 
+/*!
+ * \brief   DAC5311 SPI引脚定义
+ * \details 使用SPI0硬件接口（根据电路图）
+ *          PA5 = SPI0_SCK
+ *          PA7 = SPI0_MOSI (DIN - 发送数据到DAC)
+ *          PA4 = CS片选 (SYNC)
+ */
+#define DAC5311_SPI             SPI0
+#define DAC5311_SPI_CLK         RCU_SPI0
+
+#define DAC5311_GPIO_PORT       GPIOA
+#define DAC5311_GPIO_CLK        RCU_GPIOA
+
+#define DAC5311_SCK_PIN         GPIO_PIN_5   /* SPI0_SCK:  PA5 */
+#define DAC5311_MOSI_PIN        GPIO_PIN_7   /* SPI0_MOSI: PA7 (DIN) */
+#define DAC5311_CS_PIN          GPIO_PIN_4   /* CS片选:    PA4 (SYNC) */
+
+/* 8位样本 → 16位SPI帧（左移4位得到12位数据，0-4080） */
+#define DAC5311_FRAME(data)     ((uint16_t)((uint16_t)(data) << 4))
+
+/* 12位码值 → 16位SPI帧（插值DDS直接输出12位，0-4095） */
+#define DAC5311_FRAME12(code)   ((uint16_t)((uint16_t)(code) & 0x0FFF))
+
 /* 初始化DAC5311（SPI接口）*/
 void DAC5311_Init(void);
 
 /* 写入8位DAC数据（0-255）*/
 void DAC5311_Write(uint8_t data);
 
+/* 写入12位DAC码值（0-4095）*/
+void DAC5311_Write12(uint16_t code);
+
+/* 清除SPI接收残留（高速DMA模式切回后调用）*/
+void DAC5311_FlushRx(void);
+
 #endif
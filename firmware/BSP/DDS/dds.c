@@ -2,16 +2,140 @@
  * \file     dds.c
  * \brief    DDS频率控制模块实现
  * \details  使用相位累加器实现频率可调的正弦波生成
+ *          正弦波默认使用插值模式：1/4周期12位表 + 相位低位线性插值，
+ *          相比8位256点查表大幅降低相位截断杂散和量化噪声（THD）
+ *          参数（增量/波形表/幅度/模式）采用双缓冲：
+ *          - 线程/UART上下文只修改dds_request，然后整块发布到后台缓冲区
+ *          - 中断在相位累加器回绕（周期边界）时切换前后台，不会读到半更新的参数
  */
 
 #include "dds.h"
 #include "../SINE/sine_table.h"
+#include "../DAC5311/dac5311.h"
+#include "gd32f10x.h"
 
-/* DDS状态变量 */
-static uint32_t dds_phase_accumulator = 0;  /* 相位累加器（32位） */
-static uint32_t dds_phase_increment = 0;    /* 相位增量 */
+/* TIMER2引擎切换（timer.c） */
+extern void TIMER2_DDS_SelectEngine(uint8_t high_rate);
+
+/* DDS中断侧状态 */
+static uint32_t dds_phase_accumulator = 0;  /* 相位累加器（32位，仅中断修改） */
+static DDS_Params_t dds_bank[2];            /* 前台/后台参数块 */
+static volatile uint8_t dds_active = 0;     /* 中断正在使用的参数块索引 */
+static volatile uint8_t dds_pending = 0;    /* 1=后台参数块已发布，等待周期边界切换 */
+
+/* 线程侧状态 */
+static DDS_Params_t dds_request;            /* 最新请求的参数（仅线程/UART上下文修改） */
 static uint32_t dds_current_freq = 100;     /* 当前频率（Hz） */
-static uint8_t dds_output_enable = 0;       /* 输出使能标志 */
+static uint8_t dds_high_rate = 0;           /* 高速模式标志（400kHz DMA引擎） */
+static uint8_t dds_interp = 1;              /* 1=正弦波使用插值模式 */
+
+/*!
+ * \brief   按当前幅度缩放波形表样本（以中点128为中心）
+ */
+static inline uint8_t DDS_ScaleSample(uint8_t raw, uint16_t amplitude)
+{
+    int32_t ac = (int32_t)raw - 128;
+    return (uint8_t)(128 + ((ac * (int32_t)amplitude) >> 8));
+}
+
+/*!
+ * \brief   插值正弦样本（1/4周期表 + 线性插值）
+ * \param   phase     相位累加器值
+ * \param   amplitude 幅度（Q8）
+ * \return  12位DAC码值（0-4095）
+ * \details 相位位分配：[31:30]象限，[29:23]表索引（7位），[22:14]插值系数（9位）
+ *          Q1/Q3镜像索引，Q2/Q3取负；一次乘法插值 + 一次乘法缩放
+ */
+static inline uint16_t DDS_InterpSample(uint32_t phase, uint16_t amplitude)
+{
+    uint32_t quadrant = phase >> 30;
+    uint32_t pos = (phase >> 14) & 0xFFFF;   /* 象限内位置：7位索引 + 9位小数 */
+
+    if(quadrant & 1) pos = 0x10000 - pos;    /* 下降沿象限：镜像 */
+
+    uint32_t idx = pos >> 9;                 /* 0-128 */
+    int32_t frac = (int32_t)(pos & 0x1FF);
+    int32_t y0 = sine_quarter_table[idx];
+    int32_t y1 = sine_quarter_table[idx + 1];
+    int32_t y = y0 + (((y1 - y0) * frac) >> 9);
+
+    if(quadrant & 2) y = -y;                 /* 负半周 */
+
+    return (uint16_t)(2048 + ((y * (int32_t)amplitude) >> 8));
+}
+
+/*!
+ * \brief   计算当前参数块的输出样本（中断上下文）
+ * \return  12位DAC码值（0-4095）
+ */
+static inline uint16_t DDS_ComputeSample(const DDS_Params_t *p)
+{
+    if(p->mode == DDS_MODE_INTERP)
+    {
+        return DDS_InterpSample(dds_phase_accumulator, p->amplitude);
+    }
+    /* 查表模式：相位累加器高8位索引，8位样本扩展为12位 */
+    return (uint16_t)DDS_ScaleSample(p->table[dds_phase_accumulator >> 24], p->amplitude) << 4;
+}
+
+/*!
+ * \brief   根据波形表和插值开关确定运行模式
+ */
+static uint8_t DDS_RunMode(void)
+{
+    return (dds_interp && dds_request.table == sine_table) ? DDS_MODE_INTERP : DDS_MODE_TABLE;
+}
+
+/*!
+ * \brief   周期边界处理（中断上下文）
+ * \param   wrapped 本次累加是否发生回绕（新周期开始）
+ * \details 后台参数块已发布且处于周期边界（或输出关闭）时切换前后台；
+ *          发布的参数块带reset_phase时从零相位开始新周期
+ */
+static inline void DDS_SwapAtBoundary(uint8_t wrapped)
+{
+    if(dds_pending && (wrapped || dds_bank[dds_active].mode == DDS_MODE_OFF))
+    {
+        dds_active ^= 1;
+        dds_pending = 0;
+        if(dds_bank[dds_active].reset_phase) dds_phase_accumulator = 0;
+    }
+}
+
+/*!
+ * \brief   发布dds_request到后台参数块
+ * \param   immediate 1=立即切换（引擎切换时使用，TIMER2已停止），0=等待周期边界
+ * \details 先在临界区内撤销未切换的发布（中断此后不会再切换），
+ *          再整块拷贝到后台缓冲区，最后置pending，中断看到的总是完整参数块；
+ *          被撤销的发布若带reset_phase则并入本次发布，相位复位不会因连续发布而丢失
+ */
+static void DDS_Publish(uint8_t immediate)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint8_t back = dds_active ^ 1;
+    uint8_t carry_reset = dds_pending && dds_bank[back].reset_phase;
+    dds_pending = 0;
+    __set_PRIMASK(primask);
+
+    dds_bank[back] = dds_request;
+    dds_bank[back].reset_phase |= carry_reset;
+    dds_request.reset_phase = 0;  /* 相位复位只随本次发布生效一次 */
+    __DMB();
+
+    if(immediate)
+    {
+        primask = __get_PRIMASK();
+        __disable_irq();
+        dds_active = back;
+        if(dds_bank[back].reset_phase) dds_phase_accumulator = 0;
+        __set_PRIMASK(primask);
+    }
+    else
+    {
+        dds_pending = 1;
+    }
+}
 
 /*!
  * \brief   DDS初始化
@@ -19,28 +143,46 @@ static uint8_t dds_output_enable = 0;       /* 输出使能标志 */
 void DDS_Init(void)
 {
     dds_phase_accumulator = 0;
-    dds_output_enable = 0;
+    dds_request.phase_increment = 0;
+    dds_request.table = sine_table;
+    dds_request.amplitude = DDS_AMPLITUDE_FULL;
+    dds_request.mode = DDS_MODE_OFF;
+    dds_request.reset_phase = 1;
     DDS_SetFrequency(100);  /* 默认100Hz */
+    DDS_Publish(1);
 }
 
 /*!
  * \brief   设置输出频率
- * \param   freq_hz 频率（Hz），范围：10-2000Hz
+ * \param   freq_hz 频率（Hz），范围：10-20000Hz
  * \details 计算公式：phase_increment = (freq * 2^32) / sample_rate
+ *          频率超过DDS_MAX_FREQ时自动切换到400kHz高速引擎
  */
 void DDS_SetFrequency(uint32_t freq_hz)
 {
     /* 限制频率范围 */
     if(freq_hz < DDS_MIN_FREQ) freq_hz = DDS_MIN_FREQ;
-    if(freq_hz > DDS_MAX_FREQ) freq_hz = DDS_MAX_FREQ;
-    
-    /* 计算相位增量
-     * phase_increment = (freq * 2^32) / sample_rate
-     * 为避免溢出，改写为：phase_increment = (freq * (2^32 / sample_rate))
-     * 2^32 / 50000 = 85899.34592 ≈ 85899 (已验证工作正常)
-     */
-    dds_phase_increment = freq_hz * 85899UL;
+    if(freq_hz > DDS_HS_MAX_FREQ) freq_hz = DDS_HS_MAX_FREQ;
+
+    uint8_t high_rate = (freq_hz > DDS_MAX_FREQ) ? 1 : 0;
+    uint32_t sample_rate = high_rate ? DDS_HS_SAMPLE_RATE : DDS_SAMPLE_RATE;
+
+    /* 计算相位增量（64位中间值，避免溢出和2^32/50000的截断误差） */
+    dds_request.phase_increment = (uint32_t)(((uint64_t)freq_hz << 32) / sample_rate);
     dds_current_freq = freq_hz;
+
+    /* 引擎切换（仅在跨越2kHz边界时重新配置TIMER2）：采样率改变，增量必须立即生效 */
+    if(high_rate != dds_high_rate)
+    {
+        dds_high_rate = high_rate;
+        timer_disable(TIMER2);
+        DDS_Publish(1);
+        TIMER2_DDS_SelectEngine(high_rate);
+    }
+    else
+    {
+        DDS_Publish(0);
+    }
 }
 
 /*!
@@ -54,40 +196,136 @@ uint32_t DDS_GetFrequency(void)
 
 /*!
  * \brief   获取下一个波形样本
- * \return  正弦波样本值（0-255）
+ * \return  12位DAC码值（0-4095）
  * \details 在50kHz定时器中断中调用此函数
  */
-uint8_t DDS_GetSample(void)
+uint16_t DDS_GetSample(void)
 {
-    uint8_t sample = 0;
-    
-    if(dds_output_enable)
+    const DDS_Params_t *p = &dds_bank[dds_active];
+    uint16_t sample = 2048;  /* 输出禁用时，输出中点值 */
+
+    if(p->mode != DDS_MODE_OFF)
     {
-        /* 从相位累加器高8位获取查找表索引 */
-        uint8_t index = (dds_phase_accumulator >> 24) & 0xFF;
-        
-        /* 从正弦波表获取样本（直接输出，不滤波）*/
-        sample = sine_table[index];
-        
+        /* 按当前模式计算样本，按幅度缩放（自动量程）*/
+        sample = DDS_ComputeSample(p);
+
         /* 相位累加 */
-        dds_phase_accumulator += dds_phase_increment;
+        uint32_t next = dds_phase_accumulator + p->phase_increment;
+        uint8_t wrapped = (next < dds_phase_accumulator) ? 1 : 0;
+        dds_phase_accumulator = next;
+        DDS_SwapAtBoundary(wrapped);
     }
     else
     {
-        /* 输出禁用时，输出中点值 */
-        sample = 128;
+        DDS_SwapAtBoundary(0);
     }
-    
+
     return sample;
 }
 
+/*!
+ * \brief   填充一块DAC5311 SPI帧
+ * \param   frames 目标缓冲区（DMA半缓冲区）
+ * \param   count  样本数
+ * \details 高速模式下由DMA半传输/传输完成中断调用，一次生成一整块样本；
+ *          块内遇到周期边界同样切换参数块
+ */
+void DDS_FillBlock(uint16_t *frames, uint32_t count)
+{
+    for(uint32_t i = 0; i < count; i++)
+    {
+        const DDS_Params_t *p = &dds_bank[dds_active];
+
+        if(p->mode != DDS_MODE_OFF)
+        {
+            frames[i] = DAC5311_FRAME12(DDS_ComputeSample(p));
+
+            uint32_t next = dds_phase_accumulator + p->phase_increment;
+            uint8_t wrapped = (next < dds_phase_accumulator) ? 1 : 0;
+            dds_phase_accumulator = next;
+            DDS_SwapAtBoundary(wrapped);
+        }
+        else
+        {
+            frames[i] = DAC5311_FRAME12(2048);
+            DDS_SwapAtBoundary(0);
+        }
+    }
+}
+
+/*!
+ * \brief   当前是否工作在高速模式
+ * \return  1=高速模式（400kHz DMA），0=经典模式（50kHz中断）
+ */
+uint8_t DDS_IsHighRate(void)
+{
+    return dds_high_rate;
+}
+
+/*!
+ * \brief   设置输出幅度
+ * \param   amplitude_q8 幅度（Q8定点，256=满幅）
+ * \details 在播放路径中乘法缩放，波形表保持满幅不变；
+ *          高增益DUT降低激励避免削波，低增益DUT恢复满幅
+ */
+void DDS_SetAmplitude(uint16_t amplitude_q8)
+{
+    if(amplitude_q8 < DDS_AMPLITUDE_MIN) amplitude_q8 = DDS_AMPLITUDE_MIN;
+    if(amplitude_q8 > DDS_AMPLITUDE_FULL) amplitude_q8 = DDS_AMPLITUDE_FULL;
+
+    dds_request.amplitude = amplitude_q8;
+    DDS_Publish(0);
+}
+
+/*!
+ * \brief   获取输出幅度
+ * \return  幅度（Q8定点，256=满幅）
+ */
+uint16_t DDS_GetAmplitude(void)
+{
+    return dds_request.amplitude;
+}
+
+/*!
+ * \brief   切换波形表
+ * \param   table 256点波形表（0-255），NULL恢复正弦表
+ */
+void DDS_SetWaveTable(const uint8_t *table)
+{
+    dds_request.table = (table != 0) ? table : sine_table;
+    if(dds_request.mode != DDS_MODE_OFF) dds_request.mode = DDS_RunMode();
+    DDS_Publish(0);
+}
+
+/*!
+ * \brief   正弦波插值模式开关
+ * \param   enable 1=1/4周期12位插值，0=8位256点查表（原始模式）
+ */
+void DDS_SetInterpolation(uint8_t enable)
+{
+    dds_interp = enable ? 1 : 0;
+    if(dds_request.mode != DDS_MODE_OFF) dds_request.mode = DDS_RunMode();
+    DDS_Publish(0);
+}
+
+/*!
+ * \brief   获取插值模式开关
+ * \return  1=插值模式，0=查表模式
+ */
+uint8_t DDS_GetInterpolation(void)
+{
+    return dds_interp;
+}
+
 /*!
  * \brief   启动输出
+ * \details 相位复位随参数块一起发布，由中断在切换时执行
  */
 void DDS_Start(void)
 {
-    dds_phase_accumulator = 0;  /* 复位相位 */
-    dds_output_enable = 1;
+    dds_request.mode = DDS_RunMode();
+    dds_request.reset_phase = 1;
+    DDS_Publish(0);
 }
 
 /*!
@@ -95,7 +333,8 @@ void DDS_Start(void)
  */
 void DDS_Stop(void)
 {
-    dds_output_enable = 0;
+    dds_request.mode = DDS_MODE_OFF;
+    DDS_Publish(0);
 }
 
 /*!
@@ -122,15 +361,24 @@ uint32_t DDS_GetPhaseAccumulator(void)
  */
 uint8_t DDS_IsEnabled(void)
 {
-    return dds_output_enable;
+    return (dds_request.mode != DDS_MODE_OFF) ? 1 : 0;
 }
 
 /*!
  * \brief   获取相位增量（调试用）
- * \return  相位增量值
+ * \return  相位增量值（中断当前使用的参数块）
  */
 uint32_t DDS_GetPhaseIncrement(void)
 {
-    return dds_phase_increment;
+    return dds_bank[dds_active].phase_increment;
 }
 
+/*!
+ * \brief   获取DDS采样周期
+ * \return  TIMER2每个DDS样本的72MHz时钟数（50kHz为1440，400kHz为180）
+ * \details 与TIMER3同为72MHz，锁相参考据此把DDS相位增量精确换算到ADC采样周期
+ */
+uint32_t DDS_GetPeriodTicks(void)
+{
+    return 72000000UL / (dds_high_rate ? DDS_HS_SAMPLE_RATE : DDS_SAMPLE_RATE);
+}
@@ -1,7 +1,9 @@
 /*!
  * \file     dds.h
  * \brief    DDS频率控制模块头文件
- * \details  直接数字频率合成，支持10Hz-2000Hz频率输出
+ * \details  直接数字频率合成，支持10Hz-20kHz频率输出
+ *          - 经典模式（10Hz-2kHz）：TIMER2 50kHz中断逐点输出
+ *          - 高速模式（2kHz-20kHz）：TIMER2 400kHz触发DMA，中断仅按块填充
  */
 
 #ifndef _DDS_H_
@@ -15,6 +17,31 @@
 #define DDS_MAX_FREQ     2000       /* 最大频率：2000Hz */
 #define DDS_FREQ_STEP    10         /* 频率步进：10Hz */
 
+/* 高速模式配置（扩展带宽：DMA驱动SPI0，无逐点中断） */
+#define DDS_HS_SAMPLE_RATE  400000UL   /* 采样率：400kHz（对20kHz仍有20倍采样） */
+#define DDS_HS_MAX_FREQ     20000      /* 最大频率：20kHz */
+#define DDS_HS_BLOCK_SIZE   64         /* DMA半缓冲区样本数（每160us填充一次） */
+
+/* 幅度缩放（Q8定点：256=满幅0-255，128=半幅） */
+#define DDS_AMPLITUDE_FULL  256
+#define DDS_AMPLITUDE_MIN   8          /* 最小1/32满幅，避免输入参考通道过弱 */
+
+/* 输出模式 */
+typedef enum {
+    DDS_MODE_OFF = 0,               /* 输出中点（静默） */
+    DDS_MODE_TABLE,                 /* 256点8位查表 */
+    DDS_MODE_INTERP                 /* 1/4周期12位表 + 线性插值（正弦波默认） */
+} DDS_Mode_t;
+
+/* DDS参数块（双缓冲：中断只在周期边界切换，线程侧整块发布） */
+typedef struct {
+    uint32_t phase_increment;       /* 相位增量 */
+    const uint8_t *table;           /* 256点波形表 */
+    uint16_t amplitude;             /* 幅度（Q8） */
+    uint8_t mode;                   /* DDS_Mode_t */
+    uint8_t reset_phase;            /* 1=切换时相位归零 */
+} DDS_Params_t;
+
 /* 滤波器配置 */
 #define DDS_FILTER_ENABLED  1       /* 使能巴特沃斯滤波器（提升信号纯度和THD） */
 
@@ -27,8 +54,25 @@ void DDS_SetFrequency(uint32_t freq_hz);
 /* 获取当前频率 */
 uint32_t DDS_GetFrequency(void);
 
-/* 获取下一个波形样本（在定时器中断中调用） */
-uint8_t DDS_GetSample(void);
+/* 获取下一个波形样本（在定时器中断中调用），返回12位DAC码值 */
+uint16_t DDS_GetSample(void);
+
+/* 填充一块DAC5311 SPI帧（高速模式DMA中断中调用） */
+void DDS_FillBlock(uint16_t *frames, uint32_t count);
+
+/* 当前是否工作在高速模式（频率 > DDS_MAX_FREQ） */
+uint8_t DDS_IsHighRate(void);
+
+/* 设置/获取输出幅度（Q8，DDS_AMPLITUDE_MIN-DDS_AMPLITUDE_FULL） */
+void DDS_SetAmplitude(uint16_t amplitude_q8);
+uint16_t DDS_GetAmplitude(void);
+
+/* 切换波形表（NULL恢复正弦表），周期边界生效 */
+void DDS_SetWaveTable(const uint8_t *table);
+
+/* 正弦波插值模式开关（默认开启） */
+void DDS_SetInterpolation(uint8_t enable);
+uint8_t DDS_GetInterpolation(void);
 
 /* 获取当前正弦表索引 */
 uint8_t DDS_GetSineIndex(void);
@@ -36,6 +80,10 @@ uint8_t DDS_GetSineIndex(void);
 /* 获取当前相位累加器值 */
 uint32_t DDS_GetPhaseAccumulator(void);
 
+/* 获取中断当前使用的相位增量，及DDS采样周期（72MHz时钟数，与TIMER3同源） */
+uint32_t DDS_GetPhaseIncrement(void);
+uint32_t DDS_GetPeriodTicks(void);
+
 /* 启动/停止输出 */
 void DDS_Start(void);
 void DDS_Stop(void);
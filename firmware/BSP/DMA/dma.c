@@ -1,62 +1,79 @@
 #include "dma.h"
-
-/* USART DMA缓冲区 */
-uint8_t buf_recv[5] = {NULL};
-uint8_t buf_send[5] = {0x01,0x02,0x03,0x04,0x05};
+#include "../DAC5311/dac5311.h"
+#include "../../USER/stream.h"
+#include "../../USER/monitor.h"
+#include "../../USER/record.h"
+#include "../../USER/decimator.h"
+#include "../../USER/ets.h"
+#include "../../USER/track.h"
+#include "../../USER/lockin.h"
+#include "../USART/usart.h"
 
 /* ADC DMA缓冲区 - 双ADC同步模式 */
 uint32_t adc_buffer[ADC_BUFFER_SIZE] = {0};  /* 32位数据：[ADC1_data][ADC0_data] */
 
-void USART0_DMA_Init(void)
+/* 当前ADC DMA目标和传输点数（ADC_DMA_Restart/Retarget可改变），半传输中断按此划分前后两半 */
+static uint32_t *adc_dma_buffer = adc_buffer;
+static uint32_t adc_dma_count = ADC_BUFFER_SIZE;
+
+/* 开启了半传输/传输完成中断的使用者（ADC_BLOCK_USER_xxx） */
+static uint8_t adc_block_users = 0;
+
+/* DDS高速模式DMA缓冲区 */
+uint16_t dds_dma_buffer[DDS_DMA_BUFFER_SIZE] = {0};
+
+/* CS引脚掩码（DMA写入GPIOA的BC/BOP寄存器实现片选拉低/拉高） */
+static const uint32_t dds_cs_mask = DAC5311_CS_PIN;
+
+/*!
+ * \brief   初始化USART0接收DMA（DMA0_CH4，USART_DATA→内存，循环模式）
+ * \details 半满/全满中断与USART0空闲中断一起触发UART_RxDrain，
+ *          连续输入超过半个缓冲区时也能及时取出
+ * \param   buffer 接收缓冲区
+ * \param   size   缓冲区字节数
+ */
+void USART0_DMA_Init(uint8_t *buffer, uint32_t size)
 {
     dma_parameter_struct dma_struct;
     
     rcu_periph_clock_enable(RCU_DMA0);
-    
     dma_deinit(DMA0, DMA_CH4);
-    
     dma_struct_para_init(&dma_struct);
     
-    dma_struct.direction = DMA_PERIPHERAL_TO_MEMORY;        //�����赽�洢��
-    
-    dma_struct.memory_addr = (uint32_t)&buf_recv[0];
-    
-    dma_struct.memory_inc = DMA_MEMORY_INCREASE_ENABLE;     //�洢�������Լ�
-    
-    dma_struct.memory_width = DMA_MEMORY_WIDTH_8BIT;        //�洢�����ȣ�8bit
-    
-    dma_struct.number = 5;
-    
-    dma_struct.periph_addr = (uint32_t)(&USART_DATA(USART0));
-    
-    dma_struct.periph_inc = DMA_PERIPH_INCREASE_DISABLE;    //�����ַ���Լ�
-    
-    dma_struct.periph_width = DMA_PERIPHERAL_WIDTH_8BIT;    //������ȣ�8bit
-    
-    dma_struct.priority = DMA_PRIORITY_ULTRA_HIGH;    //�����ȼ�
-    
+    dma_struct.direction    = DMA_PERIPHERAL_TO_MEMORY;
+    dma_struct.memory_addr  = (uint32_t)buffer;
+    dma_struct.memory_inc   = DMA_MEMORY_INCREASE_ENABLE;
+    dma_struct.memory_width = DMA_MEMORY_WIDTH_8BIT;
+    dma_struct.number       = size;
+    dma_struct.periph_addr  = (uint32_t)(&USART_DATA(USART0));
+    dma_struct.periph_inc   = DMA_PERIPH_INCREASE_DISABLE;
+    dma_struct.periph_width = DMA_PERIPHERAL_WIDTH_8BIT;
+    dma_struct.priority     = DMA_PRIORITY_MEDIUM;
     dma_init(DMA0, DMA_CH4, &dma_struct);
     
-    dma_circulation_enable(DMA0, DMA_CH4);     //DMA ѭ��ʹ��
-    
+    dma_circulation_enable(DMA0, DMA_CH4);
     dma_memory_to_memory_disable(DMA0, DMA_CH4);
     
-    nvic_irq_enable(DMA0_Channel4_IRQn, 0, 0);
-    
-    dma_interrupt_enable(DMA0,DMA_CH4,DMA_INT_FTF|DMA_INT_ERR);
-    
-    dma_channel_enable(DMA0, DMA_CH4);         //DMA ͨ��ʹ��
+    /* 与USART0空闲中断同为(1,1)，UART_RxDrain不会重入 */
+    nvic_irq_enable(DMA0_Channel4_IRQn, 1, 1);
+    dma_interrupt_enable(DMA0, DMA_CH4, DMA_INT_HTF | DMA_INT_FTF);
     
+    dma_channel_enable(DMA0, DMA_CH4);
 }
 
+/*!
+ * \brief   DMA0通道4中断 - USART0接收缓冲区半满/全满
+ */
 void DMA0_Channel4_IRQHandler(void)
 {
-    if(dma_flag_get(DMA0,DMA_CH4,DMA_FLAG_FTF) != RESET)
+    MON_IRQ_ENTER(mon_t, 0);
+    if(dma_interrupt_flag_get(DMA0, DMA_CH4, DMA_INT_FLAG_HTF) != RESET ||
+       dma_interrupt_flag_get(DMA0, DMA_CH4, DMA_INT_FLAG_FTF) != RESET)
     {
-        dma_flag_clear(DMA0,DMA_CH4,DMA_FLAG_FTF);
-        dma_interrupt_flag_clear(DMA0,DMA_CH4,DMA_INTC_ERRIFC|DMA_INTC_FTFIFC);
-        printf("%s\n",buf_recv);
+        dma_flag_clear(DMA0, DMA_CH4, DMA_FLAG_G);
+        UART_RxDrain();
     }
+    MON_IRQ_EXIT(MON_IRQ_DMA_UART_RX, mon_t);
 }
 
 /*!
@@ -124,6 +141,19 @@ void ADC_DMA_Init(void)
  * \param   sample_count - 要采集的样本数量
  */
 void ADC_DMA_Restart(uint32_t sample_count)
+{
+    if(sample_count > ADC_BUFFER_SIZE) {
+        sample_count = ADC_BUFFER_SIZE;
+    }
+    ADC_DMA_Retarget(adc_buffer, sample_count);
+}
+
+/*!
+ * \brief   ADC DMA改写到指定缓冲区（循环模式）
+ * \param   buffer - 目标缓冲区（adc_buffer或抽取器原始缓冲区）
+ * \param   count  - 样本对数
+ */
+void ADC_DMA_Retarget(uint32_t *buffer, uint32_t count)
 {
     /* 禁用DMA通道 */
     dma_channel_disable(DMA0, DMA_CH0);
@@ -135,14 +165,226 @@ void ADC_DMA_Restart(uint32_t sample_count)
     dma_flag_clear(DMA0, DMA_CH0, DMA_FLAG_ERR);
     
     /* 重新设置传输数量 */
-    if(sample_count > ADC_BUFFER_SIZE) {
-        sample_count = ADC_BUFFER_SIZE;
-    }
-    dma_transfer_number_config(DMA0, DMA_CH0, sample_count);
+    adc_dma_buffer = buffer;
+    adc_dma_count = count;
+    dma_transfer_number_config(DMA0, DMA_CH0, count);
     
     /* ⭐ 重置内存地址到缓冲区起始位置 */
-    dma_memory_address_config(DMA0, DMA_CH0, (uint32_t)adc_buffer);
+    dma_memory_address_config(DMA0, DMA_CH0, (uint32_t)buffer);
+    
+    /* 单次传输之后恢复循环模式和块中断 */
+    dma_circulation_enable(DMA0, DMA_CH0);
+    if(adc_block_users)
+    {
+        dma_interrupt_enable(DMA0, DMA_CH0, DMA_INT_HTF | DMA_INT_FTF);
+    }
     
     /* 重新使能DMA通道 */
     dma_channel_enable(DMA0, DMA_CH0);
 }
+
+/*!
+ * \brief   ADC DMA单次传输（快速交替采集，填满后停止）
+ * \details 期间屏蔽块中断，数据流/长记录不会收到交替格式的样本；
+ *          结束后由ADC_DMA_Restart恢复循环模式
+ * \param   buffer - 目标缓冲区
+ * \param   count  - 样本字数
+ */
+void ADC_DMA_OneShot(uint32_t *buffer, uint32_t count)
+{
+    dma_channel_disable(DMA0, DMA_CH0);
+    dma_interrupt_disable(DMA0, DMA_CH0, DMA_INT_HTF | DMA_INT_FTF);
+    dma_flag_clear(DMA0, DMA_CH0, DMA_FLAG_G);
+    
+    dma_circulation_disable(DMA0, DMA_CH0);
+    dma_transfer_number_config(DMA0, DMA_CH0, count);
+    dma_memory_address_config(DMA0, DMA_CH0, (uint32_t)buffer);
+    
+    dma_channel_enable(DMA0, DMA_CH0);
+}
+
+/*!
+ * \brief   单次传输是否完成
+ */
+uint8_t ADC_DMA_OneShotDone(void)
+{
+    return (dma_flag_get(DMA0, DMA_CH0, DMA_FLAG_FTF) != RESET) ? 1 : 0;
+}
+
+/*!
+ * \brief   ADC DMA半传输/传输完成中断开关
+ * \param   user   - ADC_BLOCK_USER_xxx
+ * \param   enable - 1=开启，0=关闭（所有使用者都关闭后才关中断）
+ * \details 线程模式与DMA中断（ETS采满后自行关闭）都会调用，读-改-写和中断开关在临界区内完成
+ */
+void ADC_DMA_SetBlockIRQ(uint8_t user, uint8_t enable)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    
+    uint8_t was = adc_block_users;
+    
+    adc_block_users = enable ? (uint8_t)(adc_block_users | user) : (uint8_t)(adc_block_users & ~user);
+    if((was != 0) != (adc_block_users != 0))
+    {
+        if(adc_block_users)
+        {
+            dma_flag_clear(DMA0, DMA_CH0, DMA_FLAG_G);
+            /* 低于DDS（0,x）与USART0接收（1,1）：只做抽取入队/累加，输出在主循环中 */
+            nvic_irq_enable(DMA0_Channel0_IRQn, 2, 1);
+            dma_interrupt_enable(DMA0, DMA_CH0, DMA_INT_HTF | DMA_INT_FTF);
+        }
+        else
+        {
+            dma_interrupt_disable(DMA0, DMA_CH0, DMA_INT_HTF | DMA_INT_FTF);
+            nvic_irq_disable(DMA0_Channel0_IRQn);
+        }
+    }
+    
+    __set_PRIMASK(primask);
+}
+
+/*!
+ * \brief   一块adc_buffer格式样本交给数据流降采样、长记录累加、等效时间采样、单频跟踪和锁相
+ */
+void ADC_DMA_Dispatch(const uint32_t *block, uint32_t count, uint32_t frac_bits)
+{
+    Stream_OnADCBlock(block, count, frac_bits);
+    Record_OnADCBlock(block, count, frac_bits);
+    ETS_OnADCBlock(block, count, frac_bits);
+    Track_OnADCBlock(block, count, frac_bits);
+    Lockin_OnADCBlock(block, count, frac_bits);
+}
+
+/*!
+ * \brief   半缓冲区就绪：过采样时先抽取（结果写入adc_buffer后由抽取器分发）
+ */
+static void ADC_DMA_BlockReady(const uint32_t *block, uint32_t count)
+{
+    if(adc_dma_buffer != adc_buffer)
+    {
+        Decim_OnADCBlock(block, count);
+        return;
+    }
+    ADC_DMA_Dispatch(block, count, 0);
+}
+
+/*!
+ * \brief   DMA0通道0中断 - 前半/后半ADC数据就绪
+ */
+void DMA0_Channel0_IRQHandler(void)
+{
+    MON_IRQ_ENTER(mon_t, 0);
+    uint32_t half = adc_dma_count / 2;
+    
+    if(dma_interrupt_flag_get(DMA0, DMA_CH0, DMA_INT_FLAG_HTF) != RESET)
+    {
+        dma_interrupt_flag_clear(DMA0, DMA_CH0, DMA_INT_FLAG_HTF);
+        ADC_DMA_BlockReady(&adc_dma_buffer[0], half);
+    }
+    
+    if(dma_interrupt_flag_get(DMA0, DMA_CH0, DMA_INT_FLAG_FTF) != RESET)
+    {
+        dma_interrupt_flag_clear(DMA0, DMA_CH0, DMA_INT_FLAG_FTF);
+        ADC_DMA_BlockReady(&adc_dma_buffer[half], adc_dma_count - half);
+    }
+    MON_IRQ_EXIT(MON_IRQ_DMA_ADC, mon_t);
+}
+
+/*!
+ * \brief   单个DDS高速模式DMA通道配置
+ * \param   channel  DMA0通道
+ * \param   src      源地址（内存）
+ * \param   dst      目标地址（外设寄存器）
+ * \param   number   传输数量
+ * \param   width16  1=16位SPI帧（内存自增），0=32位GPIO掩码（内存不自增）
+ */
+static void DDS_DMA_ChannelConfig(dma_channel_enum channel, uint32_t src, uint32_t dst,
+                                  uint32_t number, uint8_t width16)
+{
+    dma_parameter_struct dma_struct;
+    
+    dma_deinit(DMA0, channel);
+    dma_struct_para_init(&dma_struct);
+    
+    dma_struct.direction    = DMA_MEMORY_TO_PERIPHERAL;
+    dma_struct.memory_addr  = src;
+    dma_struct.memory_inc   = width16 ? DMA_MEMORY_INCREASE_ENABLE : DMA_MEMORY_INCREASE_DISABLE;
+    dma_struct.memory_width = width16 ? DMA_MEMORY_WIDTH_16BIT : DMA_MEMORY_WIDTH_32BIT;
+    dma_struct.number       = number;
+    dma_struct.periph_addr  = dst;
+    dma_struct.periph_inc   = DMA_PERIPH_INCREASE_DISABLE;
+    dma_struct.periph_width = width16 ? DMA_PERIPHERAL_WIDTH_16BIT : DMA_PERIPHERAL_WIDTH_32BIT;
+    dma_struct.priority     = DMA_PRIORITY_ULTRA_HIGH;
+    dma_init(DMA0, channel, &dma_struct);
+    
+    dma_circulation_enable(DMA0, channel);
+    dma_memory_to_memory_disable(DMA0, channel);
+}
+
+/*!
+ * \brief   初始化DDS高速模式DMA（扩展带宽10Hz-20kHz）
+ * \details 每个TIMER2周期（400kHz）由三个DMA请求完成一次DAC5311写入，无需CPU参与：
+ *          - DMA0_CH2 (TIMER2_UP)  : GPIOA_BC  ← CS掩码  → SYNC拉低
+ *          - DMA0_CH5 (TIMER2_CH0) : SPI0_DATA ← 样本帧  → 发送16位帧
+ *          - DMA0_CH1 (TIMER2_CH2) : GPIOA_BOP ← CS掩码  → SYNC拉高（锁存）
+ *          DMA0_CH5半传输/传输完成中断中由DDS_FillBlock填充空闲的一半
+ */
+void DDS_DMA_Init(void)
+{
+    rcu_periph_clock_enable(RCU_DMA0);
+    
+    /* 预填充整个缓冲区，避免启动时输出旧数据 */
+    DDS_FillBlock(dds_dma_buffer, DDS_DMA_BUFFER_SIZE);
+    
+    DDS_DMA_ChannelConfig(DMA_CH2, (uint32_t)&dds_cs_mask,
+                          (uint32_t)&GPIO_BC(DAC5311_GPIO_PORT), 1, 0);
+    DDS_DMA_ChannelConfig(DMA_CH5, (uint32_t)dds_dma_buffer,
+                          (uint32_t)&SPI_DATA(DAC5311_SPI), DDS_DMA_BUFFER_SIZE, 1);
+    DDS_DMA_ChannelConfig(DMA_CH1, (uint32_t)&dds_cs_mask,
+                          (uint32_t)&GPIO_BOP(DAC5311_GPIO_PORT), 1, 0);
+    
+    /* 优先级与TIMER2中断相同（0,0），保证填充先于DMA追上 */
+    nvic_irq_enable(DMA0_Channel5_IRQn, 0, 0);
+    dma_interrupt_enable(DMA0, DMA_CH5, DMA_INT_HTF | DMA_INT_FTF);
+    
+    dma_channel_enable(DMA0, DMA_CH2);
+    dma_channel_enable(DMA0, DMA_CH5);
+    dma_channel_enable(DMA0, DMA_CH1);
+}
+
+/*!
+ * \brief   关闭DDS高速模式DMA（切回50kHz中断模式时调用）
+ */
+void DDS_DMA_Deinit(void)
+{
+    dma_interrupt_disable(DMA0, DMA_CH5, DMA_INT_HTF | DMA_INT_FTF);
+    dma_channel_disable(DMA0, DMA_CH2);
+    dma_channel_disable(DMA0, DMA_CH5);
+    dma_channel_disable(DMA0, DMA_CH1);
+    nvic_irq_disable(DMA0_Channel5_IRQn);
+    
+    /* 清除只写不读留下的SPI接收溢出 */
+    DAC5311_FlushRx();
+}
+
+/*!
+ * \brief   DMA0通道5中断 - DDS高速模式块填充
+ * \details 半传输：前半已发送完毕，填充前半；传输完成：填充后半
+ */
+void DMA0_Channel5_IRQHandler(void)
+{
+    MON_IRQ_ENTER(mon_t, 0);
+    if(dma_interrupt_flag_get(DMA0, DMA_CH5, DMA_INT_FLAG_HTF) != RESET)
+    {
+        dma_interrupt_flag_clear(DMA0, DMA_CH5, DMA_INT_FLAG_HTF);
+        DDS_FillBlock(&dds_dma_buffer[0], DDS_HS_BLOCK_SIZE);
+    }
+    
+    if(dma_interrupt_flag_get(DMA0, DMA_CH5, DMA_INT_FLAG_FTF) != RESET)
+    {
+        dma_interrupt_flag_clear(DMA0, DMA_CH5, DMA_INT_FLAG_FTF);
+        DDS_FillBlock(&dds_dma_buffer[DDS_HS_BLOCK_SIZE], DDS_HS_BLOCK_SIZE);
+    }
+    MON_IRQ_EXIT(MON_IRQ_DMA_DDS, mon_t);
+}
@@ -4,17 +4,18 @@
 
 #include "gd32f10x.h"
 #include "main.h"
-
-/* USART DMA缓冲区 */
-extern uint8_t buf_recv[5];
-extern uint8_t buf_send[5];
+#include "../DDS/dds.h"
 
 /* ADC DMA缓冲区 - 双ADC同步模式 */
 #define ADC_BUFFER_SIZE  512  /* 每通道512个采样点（提高低频精度）*/
 extern uint32_t adc_buffer[ADC_BUFFER_SIZE];  /* 32位：高16位=ADC1, 低16位=ADC0 */
 
-/* USART DMA初始化 */
-void USART0_DMA_Init(void);
+/* DDS高速模式DMA缓冲区 - DAC5311 SPI帧（双缓冲：前半/后半交替填充） */
+#define DDS_DMA_BUFFER_SIZE  (2 * DDS_HS_BLOCK_SIZE)
+extern uint16_t dds_dma_buffer[DDS_DMA_BUFFER_SIZE];
+
+/* USART0接收DMA初始化（循环模式） */
+void USART0_DMA_Init(uint8_t *buffer, uint32_t size);
 
 /* ADC DMA初始化（双ADC同步模式） */
 void ADC_DMA_Init(void);
@@ -22,4 +23,39 @@ void ADC_DMA_Init(void);
 /* 重启DMA采集（用于欠采样波形采集） */
 void ADC_DMA_Restart(uint32_t sample_count);
 
+/* ADC DMA改写到其他缓冲区（过采样抽取的原始缓冲区），ADC_DMA_Restart恢复adc_buffer */
+void ADC_DMA_Retarget(uint32_t *buffer, uint32_t count);
+
+/* ADC DMA单次传输（快速交替采集，屏蔽块中断），ADC_DMA_Restart恢复循环模式 */
+void ADC_DMA_OneShot(uint32_t *buffer, uint32_t count);
+uint8_t ADC_DMA_OneShotDone(void);
+
+/* 块样本码值的小数位：DMA直接采样为0（12位码），抽取输出为Q4；
+ * 长记录/跟踪/锁相内部统一换算到ADC_CODE_FRAC_BITS位小数，数据流/等效时间采样舍入回12位 */
+#define ADC_CODE_FRAC_BITS      4
+
+/* 块样本码值舍入为12位码 */
+static inline uint16_t ADC_Code12(uint32_t code, uint32_t frac_bits)
+{
+    code = (code + ((1UL << frac_bits) >> 1)) >> frac_bits;
+    return (uint16_t)((code > 4095) ? 4095 : code);
+}
+
+/* 把一块adc_buffer格式的样本交给数据流/长记录/等效时间采样（DMA中断或抽取器调用）
+ * frac_bits - 码值小数位（0或ADC_CODE_FRAC_BITS） */
+void ADC_DMA_Dispatch(const uint32_t *block, uint32_t count, uint32_t frac_bits);
+
+/* ADC DMA半传输/传输完成中断开关（按使用者计，任一使用者开启即开启） */
+#define ADC_BLOCK_USER_STREAM   0x01    /* 实时数据流按半缓冲区取样 */
+#define ADC_BLOCK_USER_RECORD   0x02    /* 长记录流式累加 */
+#define ADC_BLOCK_USER_DECIM    0x04    /* 过采样抽取 */
+#define ADC_BLOCK_USER_ETS      0x08    /* 等效时间采样相位格累加 */
+#define ADC_BLOCK_USER_TRACK    0x10    /* 单频跟踪滑动窗口累加 */
+#define ADC_BLOCK_USER_LOCKIN   0x20    /* 数字锁相混频和低通 */
+void ADC_DMA_SetBlockIRQ(uint8_t user, uint8_t enable);
+
+/* DDS高速模式DMA初始化/关闭（TIMER2事件 → CS/SPI0/CS） */
+void DDS_DMA_Init(void);
+void DDS_DMA_Deinit(void);
+
 #endif
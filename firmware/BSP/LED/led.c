@@ -1,4 +1,5 @@
 #include "led.h"
+#include "../PWM/pwm.h"
 
 // LED状态变量
 static led_mode_t current_mode = LED_MODE_OFF;
@@ -6,10 +7,8 @@ static uint16_t current_interval = 1000;  // 当前间隔时间(ms)，默认1秒
 static uint8_t current_brightness = 100;  // 当前亮度(0-100%)，默认100%
 static uint8_t specific_led_mask = 0x15;  // 特定LED掩码，默认0x15=LED3+LED4+LED5
 
-// PWM变量（极高频PWM以完全消除闪烁感）
-static uint16_t pwm_counter = 0;         // PWM计数器（0-99，10000Hz PWM）
+// PWM占空比（硬件PWM，10kHz，由pwm.c的定时器通道输出）
 static uint8_t pwm_duty = 100;           // PWM占空比(0-100)
-#define PWM_RESOLUTION 100               // PWM分辨率（100 = 10000Hz，周期100us）
 
 // 运行时变量
 static uint32_t led_counter = 0;
@@ -17,13 +16,7 @@ static uint8_t led_index = 0;
 static uint8_t led_state = 0;
 static uint8_t breath_direction = 0;     // 呼吸灯方向：0=变亮，1=变暗
 static uint8_t breath_brightness = 0;    // 呼吸灯当前亮度
-
-// 时间基准分频器（TIMER1是20KHz，需要分频到1KHz）
-static uint8_t time_divider = 0;
-#define TIME_DIV_FACTOR 20  // 20KHz -> 1KHz (每20次中断 = 1ms)
-// PWM时间基准（TIMER1是20KHz，每2次中断 = 1个PWM周期）
-static uint8_t pwm_divider = 0;
-#define PWM_DIV_FACTOR 2    // 20KHz -> 10KHz (每2次中断 = 100us = 1个PWM周期)
+static volatile uint8_t led_override_mask = 0;  // 由前台直接控制的LED（LED_Process不覆盖）
 
 void LED_Init(void)
 {
@@ -47,20 +40,12 @@ void LED_Init(void)
 
 void LED_All_Off(void)
 {
-    LED7_L;
-    LED3_L;
-    LED4_L;
-    LED6_L;
-    LED5_L;
+    for(uint8_t i = 0; i < PWM_LED_NUM; i++) PWM_SetDuty(i, 0);
 }
 
 void LED_All_On(void)
 {
-    LED7_H;
-    LED3_H;
-    LED4_H;
-    LED6_H;
-    LED5_H;
+    for(uint8_t i = 0; i < PWM_LED_NUM; i++) PWM_SetDuty(i, current_brightness);
 }
 
 void LED_Set_Mode(led_mode_t mode)
@@ -77,10 +62,7 @@ void LED_Set_Mode(led_mode_t mode)
     }
     pwm_duty = current_brightness;
     
-    // 根据模式初始化LED状态和led_state
-    LED_All_Off();
-    
-    // 模式初始化
+    // 模式初始化（LED输出由下一个1ms节拍的LED_Process刷新）
     if(mode == LED_MODE_BREATH)
     {
         breath_brightness = 0;  // 从0开始渐亮
@@ -113,7 +95,7 @@ void LED_Set_Interval(uint16_t interval_ms)
 void LED_Set_Brightness(uint8_t brightness)
 {
     // 设置亮度（0-100%）
-    // 使用1000Hz极高频PWM，完全消除闪烁（理论极限）
+    // 硬件PWM 10kHz，比较值在下一个PWM周期生效
     if(brightness <= 100)
     {
         current_brightness = brightness;
@@ -147,118 +129,56 @@ uint8_t LED_Get_Specific_Mask(void)
     return specific_led_mask;
 }
 
-// 软件PWM实现（10KHz极高频PWM完全消除闪烁）
-static void LED_PWM_Update(void)
+// 根据模式计算点亮的LED掩码（bit0=LED3, bit1=LED7, bit2=LED4, bit3=LED6, bit4=LED5）
+static uint8_t LED_Active_Mask(void)
 {
-    // PWM分频：每2次中断才更新一次PWM计数器（20KHz -> 10KHz）
-    pwm_divider++;
-    if(pwm_divider < PWM_DIV_FACTOR) return;
-    pwm_divider = 0;
-    
-    // PWM计数器：0-99循环，产生10000Hz的PWM（周期100us）
-    pwm_counter++;
-    if(pwm_counter >= PWM_RESOLUTION) pwm_counter = 0;
-    
-    // 将0-100的亮度直接映射到0-100的PWM周期（1:1映射）
-    uint16_t pwm_threshold = pwm_duty;
-    
-    // 判断当前PWM周期是高电平还是低电平
-    uint8_t led_on = (pwm_counter < pwm_threshold) ? 1 : 0;
-    
-    // 先关闭所有LED，然后根据模式和PWM状态决定哪些LED点亮
-    LED_All_Off();
-    
-    // 如果PWM处于低电平期，不点亮任何LED
-    if(!led_on) return;
-    
-    // PWM处于高电平期，根据模式决定哪些LED需要点亮
     switch(current_mode)
     {
         case LED_MODE_FLOW:
             // 流水灯：当前LED和前一个LED同时亮（拖尾效果）
-            switch(led_index)
-            {
-                case 0: LED3_H; LED5_H; break;  // LED3亮，LED5作为拖尾
-                case 1: LED7_H; LED3_H; break;  // LED7亮，LED3作为拖尾
-                case 2: LED4_H; LED7_H; break;  // LED4亮，LED7作为拖尾
-                case 3: LED6_H; LED4_H; break;  // LED6亮，LED4作为拖尾
-                case 4: LED5_H; LED6_H; break;  // LED5亮，LED6作为拖尾
-            }
-            break;
+            return (uint8_t)((1U << led_index) | (1U << ((led_index + 4) % 5)));
             
         case LED_MODE_BREATH:
             // 呼吸灯：所有LED同时亮（亮度由pwm_duty控制）
-            LED_All_On();
-            break;
+            return 0x1F;
             
         case LED_MODE_BLINK:
+        case LED_MODE_ALARM:
             // 闪烁灯：根据led_state决定是否点亮所有LED
-            if(led_state)
-            {
-                LED_All_On();
-            }
-            break;
+            return led_state ? 0x1F : 0;
             
         case LED_MODE_SPECIFIC:
             // 特定LED：根据掩码和led_state决定
-            if(led_state)
-            {
-                if(specific_led_mask & 0x01) LED3_H;
-                if(specific_led_mask & 0x02) LED7_H;
-                if(specific_led_mask & 0x04) LED4_H;
-                if(specific_led_mask & 0x08) LED6_H;
-                if(specific_led_mask & 0x10) LED5_H;
-            }
-            break;
+            return led_state ? specific_led_mask : 0;
             
         case LED_MODE_ROTATE:
             // 单个轮流：只亮当前索引的LED
-            switch(led_index)
-            {
-                case 0: LED3_H; break;
-                case 1: LED7_H; break;
-                case 2: LED4_H; break;
-                case 3: LED6_H; break;
-                case 4: LED5_H; break;
-            }
-            break;
+            return (uint8_t)(1U << led_index);
             
         default:
-            break;
+            return 0;
     }
 }
 
-void LED_Process(void)
+// 把模式结果写入硬件PWM（占空比未变化时PWM_SetDuty直接返回）
+static void LED_PWM_Update(void)
 {
-    // ==================== 软件PWM更新（每次中断都执行，20KHz） ====================
-    // PWM在内部分频到10KHz，才能实现10000Hz的PWM频率（完全无闪烁）
-    LED_PWM_Update();
+    uint8_t mask = LED_Active_Mask();
     
-    // ==================== 时间基准分频（20KHz -> 1KHz = 1ms） ====================
-    // TIMER1中断频率是20KHz (每50us一次)
-    // 需要每20次中断才算1ms，用于LED闪烁计时
-    time_divider++;
-    if(time_divider < TIME_DIV_FACTOR)
+    for(uint8_t i = 0; i < PWM_LED_NUM; i++)
     {
-        // 未达到1ms，不处理LED状态切换
-        return;
+        if(led_override_mask & (1U << i)) continue;
+        PWM_SetDuty(i, (mask & (1U << i)) ? pwm_duty : 0);
     }
-    time_divider = 0;  // 重置分频器，已经过了1ms
-    
-    // 调试信息（已关闭）
-    // static uint16_t debug_counter = 0;
-    // debug_counter++;
-    // if(debug_counter >= 1000) {
-    //     printf("[LED_Process] Mode=%d, Brightness=%d, PWM_Duty=%d, Index=%d\r\n", 
-    //            current_mode, current_brightness, pwm_duty, led_index);
-    //     debug_counter = 0;
-    // }
-    
+}
+
+// 1ms节拍（TIMER0更新中断，1kHz）：推进模式状态并刷新PWM占空比
+void LED_Process(void)
+{
     // ==================== 模式逻辑处理（每1ms执行一次） ====================
     switch(current_mode)
     {
         case LED_MODE_OFF:
-            LED_All_Off();
             break;
             
         case LED_MODE_FLOW:
@@ -267,7 +187,6 @@ void LED_Process(void)
             if(led_counter++ >= current_interval)
             {
                 led_counter = 0;
-                LED_All_Off();  // 切换前先关闭所有LED
                 led_index = (led_index + 1) % 5;
             }
             break;
@@ -332,7 +251,6 @@ void LED_Process(void)
             if(led_counter++ >= current_interval)
             {
                 led_counter = 0;
-                LED_All_Off();  // 切换前先关闭所有LED
                 led_index = (led_index + 1) % 5;
             }
             break;
@@ -348,6 +266,8 @@ void LED_Process(void)
             }
             break;
     }
+    
+    LED_PWM_Update();
 }
 
 // ==================== 外部中断功能实现（任务一） ====================
@@ -517,14 +437,16 @@ void LED_Error_Indicator(void)
     // 保存当前LED7状态
     uint8_t saved_mode = LED_Get_Current_Mode();
     
-    // LED7快速闪烁3次（每次100ms亮，100ms暗）
+    // LED7快速闪烁3次（每次100ms亮，100ms暗），期间LED_Process不覆盖LED7
+    led_override_mask |= (1U << PWM_LED7);
     for(uint8_t i = 0; i < 3; i++)
     {
-        LED7_H;
+        PWM_SetDuty(PWM_LED7, 100);
         delay_ms(100);
-        LED7_L;
+        PWM_SetDuty(PWM_LED7, 0);
         delay_ms(100);
     }
+    led_override_mask &= ~(1U << PWM_LED7);
     
     // 恢复之前的模式（如果需要）
     // LED_Set_Mode((led_mode_t)saved_mode);
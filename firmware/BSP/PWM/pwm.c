@@ -1,39 +1,225 @@
 #include "pwm.h"
 
-void PWM_Init(uint16_t psc,uint16_t per)
+/*!
+ * \brief   LED7(PB12)的DMA翻转模式
+ * \details TIMER1工作在中心对齐模式3，CH1比较值在上行和下行各匹配一次，
+ *          每次匹配产生一个DMA请求，DMA0_CH6循环写入GPIOB_BOP：
+ *          上行匹配 → 复位PB12（熄灭），下行匹配 → 置位PB12（点亮），
+ *          得到与TIMER1_CH3(PB11)相同的中心对齐PWM。
+ *          比较值只有在1-99之间才保证每个半周期匹配一次，0%/100%改为GPIO静态输出
+ */
+#define LED7_PIN            GPIO_PIN_12
+static const uint32_t led7_bop_pattern[2] = {
+    (uint32_t)LED7_PIN << 16,   /* 上行匹配：BOP高16位 → 复位 */
+    (uint32_t)LED7_PIN          /* 下行匹配：BOP低16位 → 置位 */
+};
+static uint8_t led7_dma_active = 0;
+
+static uint8_t led_pwm_duty[PWM_LED_NUM];
+
+/*!
+ * \brief   配置并启动LED7的DMA翻转通道（DMA0_CH6 ← TIMER1_CH1）
+ */
+static void PWM_LED7_DMA_Config(void)
+{
+    dma_parameter_struct dma_struct;
+
+    dma_deinit(DMA0, DMA_CH6);
+    dma_struct_para_init(&dma_struct);
+
+    dma_struct.direction    = DMA_MEMORY_TO_PERIPHERAL;
+    dma_struct.memory_addr  = (uint32_t)led7_bop_pattern;
+    dma_struct.memory_inc   = DMA_MEMORY_INCREASE_ENABLE;
+    dma_struct.memory_width = DMA_MEMORY_WIDTH_32BIT;
+    dma_struct.number       = 2;
+    dma_struct.periph_addr  = (uint32_t)&GPIO_BOP(GPIOB);
+    dma_struct.periph_inc   = DMA_PERIPH_INCREASE_DISABLE;
+    dma_struct.periph_width = DMA_PERIPHERAL_WIDTH_32BIT;
+    dma_struct.priority     = DMA_PRIORITY_LOW;
+    dma_init(DMA0, DMA_CH6, &dma_struct);
+
+    dma_circulation_enable(DMA0, DMA_CH6);
+    dma_memory_to_memory_disable(DMA0, DMA_CH6);
+}
+
+/*!
+ * \brief   初始化LED硬件PWM
+ * \details TIMER0: 边沿对齐，1MHz计数，周期100 → 10kHz，CH0N-CH2N输出到PB13-PB15，
+ *                  重复计数器=9 → 更新中断1kHz（LED_Process节拍）
+ *          TIMER1: 中心对齐，2MHz计数，ARR=100 → 10kHz，CH3输出到PB11，CH1驱动PB12的DMA
+ */
+void PWM_Init(void)
 {
     timer_parameter_struct timer_struct;
-    PWM_GPIO_Init();
+    timer_oc_parameter_struct timer_oc_struct;
+
+    rcu_periph_clock_enable(RCU_GPIOB);
+    rcu_periph_clock_enable(RCU_AF);
+    rcu_periph_clock_enable(RCU_TIMER0);
     rcu_periph_clock_enable(RCU_TIMER1);
-    timer_struct.clockdivision = TIMER_CKDIV_DIV1;
-    timer_struct.counterdirection = TIMER_COUNTER_UP;
-    timer_struct.period = per;
-    timer_struct.prescaler = psc;
+    rcu_periph_clock_enable(RCU_DMA0);
+
+    /* PB11/PB13-PB15复用推挽（定时器输出），PB12普通推挽（DMA写BOP）*/
+    gpio_init(GPIOB, GPIO_MODE_AF_PP, GPIO_OSPEED_10MHZ,
+              GPIO_PIN_11 | GPIO_PIN_13 | GPIO_PIN_14 | GPIO_PIN_15);
+    gpio_init(GPIOB, GPIO_MODE_OUT_PP, GPIO_OSPEED_10MHZ, LED7_PIN);
+    gpio_bit_reset(GPIOB, LED7_PIN);
+    gpio_pin_remap_config(GPIO_TIMER1_FULL_REMAP, ENABLE);  /* TIMER1_CH3 → PB11 */
+
+    timer_oc_struct.outputstate  = TIMER_CCX_DISABLE;
+    timer_oc_struct.outputnstate = TIMER_CCXN_DISABLE;
+    timer_oc_struct.ocpolarity   = TIMER_OC_POLARITY_HIGH;
+    timer_oc_struct.ocnpolarity  = TIMER_OCN_POLARITY_HIGH;
+    timer_oc_struct.ocidlestate  = TIMER_OC_IDLE_STATE_LOW;
+    timer_oc_struct.ocnidlestate = TIMER_OCN_IDLE_STATE_LOW;
+
+    /* ==================== TIMER0: LED4/LED6/LED5 + 1kHz节拍 ==================== */
+    timer_deinit(TIMER0);
+    timer_struct_para_init(&timer_struct);
+    timer_struct.prescaler         = 71;                        /* 72MHz/72 = 1MHz */
+    timer_struct.alignedmode       = TIMER_COUNTER_EDGE;
+    timer_struct.counterdirection  = TIMER_COUNTER_UP;
+    timer_struct.period            = PWM_LED_RESOLUTION - 1;    /* 100us = 10kHz */
+    timer_struct.clockdivision     = TIMER_CKDIV_DIV1;
+    timer_struct.repetitioncounter = (10000 / PWM_LED_TICK_HZ) - 1;  /* 每10个PWM周期更新一次 */
+    timer_init(TIMER0, &timer_struct);
+
+    /* 只使能互补输出：CCxE=0、CCxNE=1时CHxN与OxCPRE同相 */
+    timer_oc_struct.outputnstate = TIMER_CCXN_ENABLE;
+    timer_channel_output_config(TIMER0, TIMER_CH_0, &timer_oc_struct);
+    timer_channel_output_config(TIMER0, TIMER_CH_1, &timer_oc_struct);
+    timer_channel_output_config(TIMER0, TIMER_CH_2, &timer_oc_struct);
+    timer_oc_struct.outputnstate = TIMER_CCXN_DISABLE;
+
+    timer_channel_output_mode_config(TIMER0, TIMER_CH_0, TIMER_OC_MODE_PWM0);
+    timer_channel_output_mode_config(TIMER0, TIMER_CH_1, TIMER_OC_MODE_PWM0);
+    timer_channel_output_mode_config(TIMER0, TIMER_CH_2, TIMER_OC_MODE_PWM0);
+    timer_channel_output_shadow_config(TIMER0, TIMER_CH_0, TIMER_OC_SHADOW_ENABLE);
+    timer_channel_output_shadow_config(TIMER0, TIMER_CH_1, TIMER_OC_SHADOW_ENABLE);
+    timer_channel_output_shadow_config(TIMER0, TIMER_CH_2, TIMER_OC_SHADOW_ENABLE);
+    timer_channel_output_pulse_value_config(TIMER0, TIMER_CH_0, 0);
+    timer_channel_output_pulse_value_config(TIMER0, TIMER_CH_1, 0);
+    timer_channel_output_pulse_value_config(TIMER0, TIMER_CH_2, 0);
+
+    timer_auto_reload_shadow_enable(TIMER0);
+    timer_primary_output_config(TIMER0, ENABLE);   /* 高级定时器需要使能主输出 */
+
+    /* 1kHz更新中断：LED模式节拍（低优先级，不影响DDS/ADC/UART） */
+    timer_interrupt_flag_clear(TIMER0, TIMER_INT_FLAG_UP);
+    timer_interrupt_enable(TIMER0, TIMER_INT_UP);
+    nvic_irq_enable(TIMER0_UP_IRQn, 3, 0);
+
+    /* ==================== TIMER1: LED3 + LED7 ==================== */
+    timer_deinit(TIMER1);
+    timer_struct_para_init(&timer_struct);
+    timer_struct.prescaler         = 35;                        /* 72MHz/36 = 2MHz */
+    timer_struct.alignedmode       = TIMER_COUNTER_CENTER_BOTH; /* 上下行均产生比较事件 */
+    timer_struct.counterdirection  = TIMER_COUNTER_UP;
+    timer_struct.period            = PWM_LED_RESOLUTION;        /* 2×100/2MHz = 100us = 10kHz */
+    timer_struct.clockdivision     = TIMER_CKDIV_DIV1;
     timer_init(TIMER1, &timer_struct);
-    
-    
-    timer_oc_parameter_struct   timer_ocstruct;
-    timer_ocstruct.ocidlestate = TIMER_OC_IDLE_STATE_HIGH;  //ʼ״̬Ϊߵƽ
-    timer_ocstruct.ocpolarity = TIMER_OC_POLARITY_HIGH;     //ߵƽЧ
-    timer_ocstruct.outputstate = TIMER_CCX_ENABLE;
-    
-    timer_channel_output_config(TIMER1, TIMER_CH_3, &timer_ocstruct);
-    
-    timer_channel_output_mode_config(TIMER1, TIMER_CH_3, TIMER_OC_MODE_PWM0);       //ʹPWM0ģʽ
-    timer_channel_output_shadow_config(TIMER1,TIMER_CH_3,TIMER_OC_SHADOW_DISABLE);
-
-    /* ԶװӰӱȽʹ */
+
+    /* CH3 → PB11 */
+    timer_oc_struct.outputstate = TIMER_CCX_ENABLE;
+    timer_channel_output_config(TIMER1, TIMER_CH_3, &timer_oc_struct);
+    timer_channel_output_mode_config(TIMER1, TIMER_CH_3, TIMER_OC_MODE_PWM0);
+    timer_channel_output_shadow_config(TIMER1, TIMER_CH_3, TIMER_OC_SHADOW_ENABLE);
+    timer_channel_output_pulse_value_config(TIMER1, TIMER_CH_3, 0);
+
+    /* CH1：不输出引脚，仅产生比较事件驱动DMA */
+    timer_oc_struct.outputstate = TIMER_CCX_DISABLE;
+    timer_channel_output_config(TIMER1, TIMER_CH_1, &timer_oc_struct);
+    timer_channel_output_mode_config(TIMER1, TIMER_CH_1, TIMER_OC_MODE_TIMING);
+    timer_channel_output_shadow_config(TIMER1, TIMER_CH_1, TIMER_OC_SHADOW_ENABLE);
+    timer_channel_output_pulse_value_config(TIMER1, TIMER_CH_1, PWM_LED_RESOLUTION / 2);
+
     timer_auto_reload_shadow_enable(TIMER1);
-    
+    timer_dma_enable(TIMER1, TIMER_DMA_CH1D);
+    PWM_LED7_DMA_Config();
+
+    for(uint8_t i = 0; i < PWM_LED_NUM; i++) led_pwm_duty[i] = 0;
+    led7_dma_active = 0;
+
+    timer_enable(TIMER0);
     timer_enable(TIMER1);
 }
 
-void PWM_GPIO_Init(void)
+/*!
+ * \brief   LED7占空比设置（DMA翻转）
+ * \details 1-99%：从静态切到DMA时短暂停止TIMER1，计数器归零后按
+ *          “当前点亮、下一次上行匹配熄灭”重新同步DMA序列（PB11仅被打断几微秒）
+ */
+static void PWM_LED7_SetDuty(uint8_t duty)
 {
-    rcu_periph_clock_enable(RCU_GPIOB);
-    rcu_periph_clock_enable(RCU_AF);
-    
-    gpio_init(GPIOB,GPIO_MODE_AF_PP,GPIO_OSPEED_10MHZ,GPIO_PIN_11);
-    gpio_pin_remap_config(GPIO_TIMER1_FULL_REMAP, ENABLE);
-    
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    if(duty == 0 || duty >= PWM_LED_RESOLUTION)
+    {
+        dma_channel_disable(DMA0, DMA_CH6);
+        led7_dma_active = 0;
+        if(duty) gpio_bit_set(GPIOB, LED7_PIN);
+        else gpio_bit_reset(GPIOB, LED7_PIN);
+    }
+    else
+    {
+        timer_channel_output_pulse_value_config(TIMER1, TIMER_CH_1, duty);
+        if(!led7_dma_active)
+        {
+            timer_disable(TIMER1);
+            dma_channel_disable(DMA0, DMA_CH6);
+            PWM_LED7_DMA_Config();
+            timer_event_software_generate(TIMER1, TIMER_EVENT_SRC_UPG);  /* 计数器归零并装载比较值 */
+            timer_flag_clear(TIMER1, TIMER_FLAG_CH1);
+            gpio_bit_set(GPIOB, LED7_PIN);
+            dma_channel_enable(DMA0, DMA_CH6);
+            timer_enable(TIMER1);
+            led7_dma_active = 1;
+        }
+    }
+
+    __set_PRIMASK(primask);
+}
+
+/*!
+ * \brief   设置单个LED占空比
+ * \param   led  LED编号（PWM_LED3 ... PWM_LED5）
+ * \param   duty 占空比（0-100）
+ * \details 比较值带影子寄存器，下一个PWM周期生效，不产生毛刺
+ */
+void PWM_SetDuty(uint8_t led, uint8_t duty)
+{
+    if(led >= PWM_LED_NUM) return;
+    if(duty > PWM_LED_RESOLUTION) duty = PWM_LED_RESOLUTION;
+    if(led_pwm_duty[led] == duty) return;
+    led_pwm_duty[led] = duty;
+
+    switch(led)
+    {
+        case PWM_LED3:
+            /* 中心对齐PWM0：CNT<CV有效，CV>ARR时常亮 */
+            timer_channel_output_pulse_value_config(TIMER1, TIMER_CH_3,
+                (duty >= PWM_LED_RESOLUTION) ? (PWM_LED_RESOLUTION + 1) : duty);
+            break;
+        case PWM_LED7:
+            PWM_LED7_SetDuty(duty);
+            break;
+        case PWM_LED4:
+            timer_channel_output_pulse_value_config(TIMER0, TIMER_CH_0, duty);
+            break;
+        case PWM_LED6:
+            timer_channel_output_pulse_value_config(TIMER0, TIMER_CH_1, duty);
+            break;
+        case PWM_LED5:
+            timer_channel_output_pulse_value_config(TIMER0, TIMER_CH_2, duty);
+            break;
+    }
+}
+
+/*!
+ * \brief   获取单个LED占空比
+ */
+uint8_t PWM_GetDuty(uint8_t led)
+{
+    return (led < PWM_LED_NUM) ? led_pwm_duty[led] : 0;
 }
@@ -3,8 +3,35 @@
 
 #include "main.h"
 
-void PWM_Init(uint16_t psc,uint16_t per);
-void PWM_GPIO_Init(void);
+/*!
+ * \brief   LED硬件PWM驱动
+ * \details 5个LED全部由定时器硬件产生10kHz PWM，CPU只在亮度变化时写比较值：
+ *          - LED3 (PB11): TIMER1_CH3（完全重映射）
+ *          - LED4 (PB13): TIMER0_CH0_ON
+ *          - LED6 (PB14): TIMER0_CH1_ON
+ *          - LED5 (PB15): TIMER0_CH2_ON
+ *          - LED7 (PB12): 无定时器通道，TIMER1_CH1比较事件触发DMA0_CH6写GPIOB_BOP
+ *          TIMER0重复计数器分频得到1kHz更新中断，作为LED模式节拍
+ */
 
+/* LED编号（与LED_MASK位顺序一致） */
+#define PWM_LED3            0
+#define PWM_LED7            1
+#define PWM_LED4            2
+#define PWM_LED6            3
+#define PWM_LED5            4
+#define PWM_LED_NUM         5
+
+#define PWM_LED_RESOLUTION  100     /* 占空比分辨率：0-100% */
+#define PWM_LED_TICK_HZ     1000    /* LED模式节拍（TIMER0更新中断） */
+
+/* 初始化LED硬件PWM（TIMER0/TIMER1/DMA0_CH6）*/
+void PWM_Init(void);
+
+/* 设置单个LED占空比（0-100），与当前值相同时直接返回 */
+void PWM_SetDuty(uint8_t led, uint8_t duty);
+
+/* 获取单个LED占空比 */
+uint8_t PWM_GetDuty(uint8_t led);
 
 #endif
@@ -30,6 +30,23 @@ const uint8_t sine_table[SINE_TABLE_SIZE] = {
      79,  82,  85,  88,  91,  94,  97, 100, 103, 106, 109, 112, 115, 118, 121, 124
 };
 
-
-
-
+/* 1/4周期正弦表：129点 + 1个保护点，范围0-2047（12位）
+ * 公式：y = 2047*sin(pi/2 * i/128)
+ * 其余3个象限由对称性得到：Q1镜像索引，Q2/Q3取负
+ * 260字节，与256点8位全周期表相当，分辨率提高16倍（12位）
+ */
+const uint16_t sine_quarter_table[SINE_QUARTER_SIZE + 2] = {
+       0,   25,   50,   75,  100,  126,  151,  176,  201,  226,
+     251,  275,  300,  325,  350,  375,  399,  424,  449,  473,
+     497,  522,  546,  570,  594,  618,  642,  666,  690,  713,
+     737,  760,  783,  807,  830,  852,  875,  898,  920,  943,
+     965,  987, 1009, 1031, 1052, 1074, 1095, 1116, 1137, 1158,
+    1179, 1199, 1219, 1239, 1259, 1279, 1299, 1318, 1337, 1356,
+    1375, 1393, 1411, 1430, 1447, 1465, 1483, 1500, 1517, 1533,
+    1550, 1566, 1582, 1598, 1614, 1629, 1644, 1659, 1674, 1688,
+    1702, 1716, 1729, 1743, 1756, 1769, 1781, 1793, 1805, 1817,
+    1828, 1840, 1850, 1861, 1871, 1881, 1891, 1901, 1910, 1919,
+    1927, 1936, 1944, 1951, 1959, 1966, 1973, 1979, 1986, 1992,
+    1997, 2003, 2008, 2012, 2017, 2021, 2025, 2028, 2032, 2035,
+    2037, 2039, 2041, 2043, 2045, 2046, 2046, 2047, 2047, 2047
+};
@@ -2,6 +2,7 @@
  * \file     sine_table.h
  * \brief    正弦波查找表头文件
  * \details  256点正弦波表，范围0-255，用于DAC5311输出
+ *          1/4周期12位正弦表，配合线性插值使用（插值DDS模式）
  */
 
 #ifndef _SINE_TABLE_H_
@@ -14,6 +15,32 @@
 /* 正弦波查找表：0-255范围 */
 extern const uint8_t sine_table[SINE_TABLE_SIZE];
 
+/* 1/4周期正弦表：128段（129点）+1个保护点，幅度0-2047（12位DAC半幅） */
+#define SINE_QUARTER_BITS   7
+#define SINE_QUARTER_SIZE   (1 << SINE_QUARTER_BITS)
+#define SINE_QUARTER_PEAK   2047
+
+/* 1/4周期正弦表：y = 2047*sin(pi/2*i/128)，i=0-128，末尾重复峰值供插值越界读取 */
+extern const uint16_t sine_quarter_table[SINE_QUARTER_SIZE + 2];
+
+/*!
+ * \brief   相位累加器查1/4周期正弦表（长记录/跟踪的参考正弦）
+ * \param   phase - 2^32为一周期
+ * \return  -SINE_QUARTER_PEAK ~ +SINE_QUARTER_PEAK
+ * \details 高2位为象限，其后SINE_QUARTER_BITS位为象限内位置（不插值）
+ */
+static inline int32_t Sine_Quarter(uint32_t phase)
+{
+    uint32_t idx = phase >> (32 - 2 - SINE_QUARTER_BITS);
+    uint32_t pos = idx & (SINE_QUARTER_SIZE - 1);
+    int32_t v;
+    
+    if(idx & SINE_QUARTER_SIZE) v = sine_quarter_table[SINE_QUARTER_SIZE - pos];
+    else                        v = sine_quarter_table[pos];
+    
+    return (idx & (SINE_QUARTER_SIZE << 1)) ? -v : v;
+}
+
 #endif /* _SINE_TABLE_H_ */
 
 
@@ -0,0 +1,190 @@
+/*!
+ * \file    timebase.c
+ * \brief   TIMER5时间基准实现
+ * \author  GD32 Bode Analyzer
+ * \version v1.0
+ * \details 软件定时器挂在单链表上（调用者持有节点），TIMER5每1ms中断检查一次，
+ *          到期回调在中断中执行
+ */
+
+#include "timebase.h"
+#include "../../USER/monitor.h"
+
+/* 毫秒计数（TIMER5更新中断递增） */
+static volatile uint32_t timebase_ms = 0;
+
+/* 活动的软件定时器链表 */
+static Timebase_Timer_t *timebase_timers = NULL;
+
+/*!
+ * \brief   初始化TIMER5为单调时间基准
+ * \details 原delay_us每次调用都重新配置SysTick并在结束时关闭，SysTick无法同时
+ *          作时间统计；TIMER5是HD系列的基本定时器，无输出通道，专用于计时：
+ *          72MHz / 72 = 1MHz计数，周期1000 = 1ms更新中断
+ */
+void Timebase_Init(void)
+{
+    timer_parameter_struct timer_struct;
+    
+    rcu_periph_clock_enable(RCU_TIMER5);
+    timer_deinit(TIMER5);
+    timer_struct_para_init(&timer_struct);
+    
+    timer_struct.prescaler        = 71;                     /* 1MHz */
+    timer_struct.counterdirection = TIMER_COUNTER_UP;
+    timer_struct.period           = TIMEBASE_TICK_US - 1;   /* 1ms */
+    timer_struct.clockdivision    = TIMER_CKDIV_DIV1;
+    timer_init(TIMER5, &timer_struct);
+    
+    /* 最低优先级：只递增计数和检查软件定时器 */
+    timer_interrupt_flag_clear(TIMER5, TIMER_INT_FLAG_UP);
+    timer_interrupt_enable(TIMER5, TIMER_INT_UP);
+    nvic_irq_enable(TIMER5_IRQn, 3, 1);
+    
+    timer_enable(TIMER5);
+}
+
+uint32_t Timebase_Millis(void)
+{
+    return timebase_ms;
+}
+
+/*!
+ * \brief   单调微秒计数
+ * \details 更新中断已挂起但尚未处理（在更高优先级中断或关中断区内调用）时，
+ *          计数器已回绕，毫秒数补1
+ */
+uint32_t Timebase_Micros(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    
+    uint32_t ms = timebase_ms;
+    uint32_t cnt = TIMER_CNT(TIMER5);
+    if(TIMER_INTF(TIMER5) & TIMER_INTF_UPIF)
+    {
+        cnt = TIMER_CNT(TIMER5);
+        ms++;
+    }
+    
+    __set_PRIMASK(primask);
+    return ms * TIMEBASE_TICK_US + cnt;
+}
+
+uint32_t Timebase_Deadline(uint32_t ms)
+{
+    return timebase_ms + ms;
+}
+
+uint8_t Timebase_Expired(uint32_t deadline)
+{
+    return (int32_t)(timebase_ms - deadline) >= 0;
+}
+
+/*!
+ * \brief   忙等微秒
+ * \details 每次读计数器累计与上次的差（模1000），只要两次读取间隔<1ms即准确，
+ *          在屏蔽了TIMER5中断的高优先级中断（按键消抖等）中也不会卡死
+ */
+void Timebase_DelayUs(uint32_t us)
+{
+    uint32_t last = TIMER_CNT(TIMER5);
+    uint32_t elapsed = 0;
+    
+    while(elapsed < us)
+    {
+        uint32_t now = TIMER_CNT(TIMER5);
+        elapsed += (now >= last) ? (now - last) : (now + TIMEBASE_TICK_US - last);
+        last = now;
+    }
+}
+
+void Timebase_TimerStart(Timebase_Timer_t *timer, uint32_t delay_ms, uint32_t period_ms,
+                         void (*callback)(uint32_t arg), uint32_t arg)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    
+    timer->deadline = timebase_ms + delay_ms;
+    timer->period = period_ms;
+    timer->callback = callback;
+    timer->arg = arg;
+    if(!timer->active)
+    {
+        timer->next = timebase_timers;
+        timebase_timers = timer;
+        timer->active = 1;
+    }
+    
+    __set_PRIMASK(primask);
+}
+
+void Timebase_TimerStop(Timebase_Timer_t *timer)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    
+    if(timer->active)
+    {
+        Timebase_Timer_t **pp = &timebase_timers;
+        while(*pp && *pp != timer) pp = &(*pp)->next;
+        if(*pp) *pp = timer->next;
+        timer->active = 0;
+    }
+    
+    __set_PRIMASK(primask);
+}
+
+/*!
+ * \brief   毫秒计数 + 软件定时器到期检查
+ */
+static void Timebase_Tick(void)
+{
+    uint32_t now = ++timebase_ms;
+    if(timebase_timers == NULL) return;
+    
+    /* 回调可能启停定时器，链表操作与Start/Stop一样在关中断下进行 */
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    
+    Timebase_Timer_t **pp = &timebase_timers;
+    while(*pp)
+    {
+        Timebase_Timer_t *t = *pp;
+        if((int32_t)(now - t->deadline) < 0)
+        {
+            pp = &t->next;
+            continue;
+        }
+        
+        if(t->period)
+        {
+            t->deadline += t->period;
+            pp = &t->next;
+        }
+        else
+        {
+            *pp = t->next;
+            t->active = 0;
+        }
+        t->callback(t->arg);
+    }
+    
+    __set_PRIMASK(primask);
+}
+
+/*!
+ * \brief   TIMER5更新中断
+ */
+void TIMER5_IRQHandler(void)
+{
+    MON_IRQ_ENTER(mon_t, TIMER_CNT(TIMER5));
+    
+    if(timer_interrupt_flag_get(TIMER5, TIMER_INT_FLAG_UP) != RESET)
+    {
+        timer_interrupt_flag_clear(TIMER5, TIMER_INT_FLAG_UP);
+        Timebase_Tick();
+    }
+    
+    MON_IRQ_EXIT(MON_IRQ_TIMER5, mon_t);
+}
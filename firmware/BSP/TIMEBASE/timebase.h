@@ -0,0 +1,47 @@
+/*!
+ * \file    timebase.h
+ * \brief   TIMER5单调时间基准、微秒延时和软件定时器
+ * \author  GD32 Bode Analyzer
+ * \version v1.0
+ * \details 毫秒计数由TIMER5更新中断递增，微秒为毫秒计数加TIMER5当前计数；
+ *          截止时间按无符号差比较，计数回绕（约49.7天）后仍然正确
+ */
+
+#ifndef _TIMEBASE_H_
+#define _TIMEBASE_H_
+
+#include "gd32f10x.h"
+
+/* TIMER5基本定时器：1MHz计数，每1000计数（1ms）更新中断 */
+#define TIMEBASE_TICK_US    1000
+
+/* 软件定时器（调用者持有，到期回调在TIMER5中断中执行，须简短） */
+typedef struct Timebase_Timer {
+    uint32_t deadline;                      /* 到期时刻（ms） */
+    uint32_t period;                        /* 0=单次，否则为周期（ms） */
+    void (*callback)(uint32_t arg);
+    uint32_t arg;
+    struct Timebase_Timer *next;
+    uint8_t active;
+} Timebase_Timer_t;
+
+/* 初始化时间基准（须在任何delay之前调用） */
+void Timebase_Init(void);
+
+/* 单调毫秒/微秒计数（微秒约71分钟回绕，差值运算不受影响） */
+uint32_t Timebase_Millis(void);
+uint32_t Timebase_Micros(void);
+
+/* 截止时间：Timebase_Expired(Timebase_Deadline(ms))在ms毫秒后为真 */
+uint32_t Timebase_Deadline(uint32_t ms);
+uint8_t Timebase_Expired(uint32_t deadline);
+
+/* 忙等微秒（任意上下文可用，直接累计TIMER5计数差，不依赖更新中断） */
+void Timebase_DelayUs(uint32_t us);
+
+/* 启动/停止软件定时器（重复启动即重新定时） */
+void Timebase_TimerStart(Timebase_Timer_t *timer, uint32_t delay_ms, uint32_t period_ms,
+                         void (*callback)(uint32_t arg), uint32_t arg);
+void Timebase_TimerStop(Timebase_Timer_t *timer);
+
+#endif
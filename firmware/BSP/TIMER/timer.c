@@ -1,5 +1,19 @@
 #include "timer.h"
 #include "../../USER/main.h"
+#include "../DDS/dds.h"
+#include "../DMA/dma.h"
+#include "../../USER/profile.h"
+#include "../../USER/monitor.h"
+
+/* TIMER2高速模式比较点（400kHz周期=180个定时器时钟）
+ * 0: UP事件拉低SYNC → 4: CH0事件写入SPI帧（18MHz下约64个时钟）→ 100: CH2事件拉高SYNC
+ */
+#define DDS_HS_DATA_PULSE   4
+#define DDS_HS_SYNC_PULSE   100
+
+/* TIMER3当前实际采样率（Hz，预分频/周期量化后） */
+static uint32_t timer3_sample_rate = 0;
+static uint32_t timer3_period_ticks = 7200;     /* 实际采样周期（72MHz时钟数） */
 
 /*!
  * \brief   初始化TIMER2为50kHz采样率（用于DDS波形生成）
@@ -15,6 +29,10 @@ void TIMER2_DDS_Init(void)
     /* 使能TIMER2时钟 */
     rcu_periph_clock_enable(RCU_TIMER2);
     
+    /* 复位TIMER2（可能从高速模式切回） */
+    timer_deinit(TIMER2);
+    timer_struct_para_init(&timer_struct);
+    
     /* 配置定时器参数 */
     timer_struct.clockdivision = TIMER_CKDIV_DIV1;
     timer_struct.counterdirection = TIMER_COUNTER_UP;
@@ -32,6 +50,68 @@ void TIMER2_DDS_Init(void)
     timer_enable(TIMER2);
 }
 
+/*!
+ * \brief   初始化TIMER2为400kHz高速DDS模式（2kHz-20kHz）
+ * \details 不使能更新中断，三个DMA请求完成每个样本的SYNC拉低/SPI发送/SYNC拉高
+ *          比较通道仅用于产生DMA请求，不使能输出（CH0=PA6、CH2=PB0保持原功能）
+ *          CPU负载仅为每64个样本一次的DDS_FillBlock
+ */
+void TIMER2_DDS_HighRate_Init(void)
+{
+    timer_parameter_struct timer_struct;
+    timer_oc_parameter_struct timer_oc_struct;
+    
+    rcu_periph_clock_enable(RCU_TIMER2);
+    
+    timer_deinit(TIMER2);
+    timer_struct_para_init(&timer_struct);
+    
+    timer_struct.clockdivision = TIMER_CKDIV_DIV1;
+    timer_struct.counterdirection = TIMER_COUNTER_UP;
+    timer_struct.period = (72000000UL / DDS_HS_SAMPLE_RATE) - 1;  /* 180 - 1 */
+    timer_struct.prescaler = 0;
+    timer_init(TIMER2, &timer_struct);
+    
+    /* CH0/CH2：输出比较定时模式，仅产生比较事件 */
+    timer_channel_output_struct_para_init(&timer_oc_struct);
+    timer_oc_struct.outputstate = TIMER_CCX_DISABLE;
+    timer_channel_output_config(TIMER2, TIMER_CH_0, &timer_oc_struct);
+    timer_channel_output_config(TIMER2, TIMER_CH_2, &timer_oc_struct);
+    timer_channel_output_mode_config(TIMER2, TIMER_CH_0, TIMER_OC_MODE_TIMING);
+    timer_channel_output_mode_config(TIMER2, TIMER_CH_2, TIMER_OC_MODE_TIMING);
+    timer_channel_output_pulse_value_config(TIMER2, TIMER_CH_0, DDS_HS_DATA_PULSE);
+    timer_channel_output_pulse_value_config(TIMER2, TIMER_CH_2, DDS_HS_SYNC_PULSE);
+    
+    /* DMA请求在通道事件时发出 */
+    timer_channel_dma_request_source_select(TIMER2, TIMER_DMAREQUEST_CHANNELEVENT);
+    
+    DDS_DMA_Init();
+    timer_dma_enable(TIMER2, TIMER_DMA_UPD | TIMER_DMA_CH0D | TIMER_DMA_CH2D);
+    
+    timer_enable(TIMER2);
+}
+
+/*!
+ * \brief   切换DDS引擎（由DDS_SetFrequency在跨越DDS_MAX_FREQ时调用）
+ * \param   high_rate 1=400kHz DMA高速模式，0=50kHz中断模式
+ */
+void TIMER2_DDS_SelectEngine(uint8_t high_rate)
+{
+    timer_disable(TIMER2);
+    
+    if(high_rate)
+    {
+        timer_interrupt_disable(TIMER2, TIMER_INT_UP);
+        TIMER2_DDS_HighRate_Init();
+    }
+    else
+    {
+        timer_dma_disable(TIMER2, TIMER_DMA_UPD | TIMER_DMA_CH0D | TIMER_DMA_CH2D);
+        DDS_DMA_Deinit();
+        TIMER2_DDS_Init();
+    }
+}
+
 /* 全局计数器用于调试TIMER2中断 */
 static volatile uint32_t timer2_interrupt_count = 0;
 
@@ -79,12 +159,12 @@ uint32_t TIMER2_GetInterruptCount(void)
 /*!
  * \brief   TIMER2中断处理函数 - 50kHz采样率
  * \details 在此中断中生成DDS波形并输出到DAC5311
- *          自适应降采样：根据当前频率动态调整UART数据流密度
+ *          数据流改由ADC DMA半缓冲区驱动（见USER/stream.c），不在此中断中发送
  */
 void TIMER2_IRQHandler(void)
 {
-    static uint16_t stream_counter = 0;
-    static uint16_t stream_divisor = 50;  /* 默认降采样比例 */
+    MON_IRQ_ENTER(mon_t, TIMER_CNT(TIMER2));   /* 先读计数器：更新事件后经过的周期即入口延迟 */
+    PROF_BEGIN(prof_t);
     
     if(timer_interrupt_flag_get(TIMER2, TIMER_INT_FLAG_UP) != RESET)
     {
@@ -95,10 +175,9 @@ void TIMER2_IRQHandler(void)
         timer2_interrupt_count++;
         
         /* 获取DDS样本 */
-        extern uint8_t DDS_GetSample(void);
-        extern uint32_t DDS_GetFrequency(void);
+        extern uint16_t DDS_GetSample(void);
         
-        uint8_t sample;
+        uint16_t sample;  /* 12位DAC码值 */
         
         if(g_signal_type == SIGNAL_TYPE_ECG)
         {
@@ -113,7 +192,7 @@ void TIMER2_IRQHandler(void)
             uint32_t phase_index = (ecg_phase_accumulator >> 24) & 0xFF;  /* 0-255 */
             ecg_index = (phase_index * 360) >> 8;  /* 映射到0-359 */
             
-            sample = ecg_wave_table[ecg_index];
+            sample = (uint16_t)ecg_wave_table[ecg_index] << 4;
             
             /* 相位累加 */
             ecg_phase_accumulator += ecg_phase_increment;
@@ -125,51 +204,12 @@ void TIMER2_IRQHandler(void)
         }
         
         /* 输出到DAC5311 */
-        extern void DAC5311_Write(uint8_t data);
-        DAC5311_Write(sample);
-        
-        /* 自适应降采样：保持每周期约15个采样点 */
-        stream_counter++;
-        if(stream_counter >= stream_divisor)
-        {
-            stream_counter = 0;
-            
-            /* 动态计算降采样比例：每周期15个点
-             * divisor = 50000 / (freq * 15)
-             * 限制：最小10（5kHz数据流），最大500（100Hz数据流）
-             */
-            uint32_t freq = DDS_GetFrequency();
-            
-            if(g_signal_type == SIGNAL_TYPE_ECG || freq == 0)
-            {
-                /* ECG模式：高密度数据流
-                 * 50kHz / 20 = 2500Hz 数据流率
-                 * ECG频率50Hz，每个心跳50个数据点
-                 */
-                stream_divisor = 20;
-            }
-            else
-            {
-                stream_divisor = 50000 / (freq * 15);
-                if(stream_divisor < 10) stream_divisor = 10;   /* 最大5kHz数据流 */
-                if(stream_divisor > 500) stream_divisor = 500; /* 最小100Hz数据流 */
-            }
-            
-            /* 读取最新的ADC数据（双通道）*/
-            /* DMA格式：低16位ADC0(PA6)，高16位ADC1(PB1) */
-            /* 使用递增索引读取不同位置，避免重复读取同一个值 */
-            extern uint32_t adc_buffer[];
-            static uint16_t adc_read_index = 0;
-            uint32_t adc_val = adc_buffer[adc_read_index];
-            adc_read_index++;
-            if(adc_read_index >= 512) adc_read_index = 0;  /* 循环 */
-            uint16_t adc0 = adc_val & 0xFFFF;
-            uint16_t adc1 = (adc_val >> 16) & 0xFFFF;
-            
-            extern void UART_SendStreamData(uint8_t sample, uint16_t adc0, uint16_t adc1);
-            UART_SendStreamData(sample, adc0, adc1);
-        }
+        extern void DAC5311_Write12(uint16_t code);
+        DAC5311_Write12(sample);
     }
+    
+    PROF_END(PROF_TIMER2_IRQ, prof_t);
+    MON_IRQ_EXIT(MON_IRQ_TIMER2, mon_t);
 }
 
 /*!
@@ -224,6 +264,9 @@ void TIMER3_ADC_Init(uint32_t sample_rate_hz)
     
     /* 启动定时器 */
     timer_enable(TIMER3);
+    
+    timer3_sample_rate = 72000000 / (period + 1);
+    timer3_period_ticks = period + 1;
 }
 
 /*!
@@ -233,9 +276,11 @@ void TIMER3_ADC_Init(uint32_t sample_rate_hz)
  *          - 适用于自适应采样：根据信号频率调整采样率
  *          - 例如：测量100Hz信号时用5kHz采样，测量1kHz时用20kHz
  * 
+ * \return  实际采样率（Hz）
+ * 
  * \example TIMER3_SetSampleRate(20000);  // 切换到20kHz采样率
  */
-void TIMER3_SetSampleRate(uint32_t sample_rate_hz)
+uint32_t TIMER3_SetSampleRate(uint32_t sample_rate_hz)
 {
     /* ⭐ TIMER3是16位定时器，ARR最大65535
      * 当采样率<1099Hz时，需要使用预分频器
@@ -278,5 +323,50 @@ void TIMER3_SetSampleRate(uint32_t sample_rate_hz)
     
     /* 重新使能定时器 */
     timer_enable(TIMER3);
+    
+    /* 返回量化后的实际采样率（DFT计算应使用该值而非请求值） */
+    timer3_sample_rate = timer_clock / (prescaler + 1) / (period + 1);
+    timer3_period_ticks = (prescaler + 1) * (period + 1);
+    return timer3_sample_rate;
 }
 
+
+/*!
+ * \brief   按定时器时钟数设置TIMER3触发周期（不分频，等效时间采样需要精确周期）
+ * \param   ticks - 采样周期（72MHz时钟数，2~65536）
+ * \return  实际周期（时钟数）
+ */
+uint32_t TIMER3_SetPeriodTicks(uint32_t ticks)
+{
+    if(ticks < 2) ticks = 2;
+    if(ticks > 65536) ticks = 65536;
+    
+    timer_disable(TIMER3);
+    timer_prescaler_config(TIMER3, 0, TIMER_PSC_RELOAD_NOW);
+    timer_autoreload_value_config(TIMER3, ticks - 1);
+    timer_channel_output_pulse_value_config(TIMER3, TIMER_CH_3, (ticks - 1) / 2);
+    timer_counter_value_config(TIMER3, 0);
+    timer_event_software_generate(TIMER3, TIMER_EVENT_SRC_UPG);
+    timer_enable(TIMER3);
+    
+    timer3_sample_rate = 72000000 / ticks;
+    timer3_period_ticks = ticks;
+    return ticks;
+}
+
+/*!
+ * \brief   获取TIMER3当前实际采样率
+ * \return  采样率（Hz）
+ */
+uint32_t TIMER3_GetSampleRate(void)
+{
+    return timer3_sample_rate;
+}
+
+/*!
+ * \brief   获取TIMER3实际采样周期（72MHz时钟数，含预分频，与DDS同源可精确换算相位）
+ */
+uint32_t TIMER3_GetPeriodTicks(void)
+{
+    return timer3_period_ticks;
+}
@@ -8,11 +8,26 @@ void TIM1_Init(uint16_t psc,uint16_t per);
 /* 初始化TIMER2为50kHz采样率（用于DDS波形生成） */
 void TIMER2_DDS_Init(void);
 
+/* 初始化TIMER2为400kHz高速DDS模式（DMA驱动，2kHz-20kHz） */
+void TIMER2_DDS_HighRate_Init(void);
+
+/* 切换DDS引擎：1=高速DMA模式，0=50kHz中断模式 */
+void TIMER2_DDS_SelectEngine(uint8_t high_rate);
+
 /* 初始化TIMER3为ADC触发源（默认10kHz采样率） */
 void TIMER3_ADC_Init(uint32_t sample_rate_hz);
 
-/* 设置TIMER3采样率（动态调整） */
-void TIMER3_SetSampleRate(uint32_t sample_rate_hz);
+/* 设置TIMER3采样率（动态调整），返回实际采样率 */
+uint32_t TIMER3_SetSampleRate(uint32_t sample_rate_hz);
+
+/* 按72MHz时钟数精确设置TIMER3周期（等效时间采样），返回实际周期 */
+uint32_t TIMER3_SetPeriodTicks(uint32_t ticks);
+
+/* 获取TIMER3当前实际采样率 */
+uint32_t TIMER3_GetSampleRate(void);
+
+/* 获取TIMER3当前实际采样周期（72MHz时钟数） */
+uint32_t TIMER3_GetPeriodTicks(void);
 
 /* 获取TIMER2中断计数（调试用） */
 uint32_t TIMER2_GetInterruptCount(void);
@@ -1,6 +1,9 @@
 #include "timer_led.h"
 #include "led.h"
 #include "usart.h"
+#include "../PWM/pwm.h"
+#include "../../USER/profile.h"
+#include "../../USER/monitor.h"
 
 // 定时发送相关变量
 static uint16_t send_counter = 0;           // 发送计数器
@@ -39,55 +42,30 @@ uint16_t Timer_Get_Send_Interval(void)
     return send_interval;
 }
 
-void TIM1_Init_LED(uint16_t psc,uint16_t per)
+/**
+ * @brief: LED定时器初始化
+ * @description: LED亮度由TIMER0/TIMER1硬件PWM输出（pwm.c），不再需要20kHz软件PWM中断；
+ *               TIMER0重复计数器分频出1kHz更新中断，仅用于LED模式节拍
+ */
+void TIM_Init_LED(void)
 {
-    timer_parameter_struct timer_struct;
-    timer_oc_parameter_struct timer_oc_struct;
-    
-    rcu_periph_clock_enable(RCU_TIMER1);  // 定时器时钟72MHz
-    
-    // 定时器基础配置
-    timer_struct.clockdivision = TIMER_CKDIV_DIV1;
-    timer_struct.counterdirection = TIMER_COUNTER_UP;
-    timer_struct.period = per;
-    timer_struct.prescaler = psc;
-    timer_init(TIMER1, &timer_struct);
-    
-    // 配置CH1输出参数
-    timer_oc_struct.outputstate = TIMER_CCX_ENABLE;
-    timer_oc_struct.outputnstate = TIMER_CCXN_DISABLE;
-    timer_oc_struct.ocpolarity = TIMER_OC_POLARITY_HIGH;
-    timer_oc_struct.ocnpolarity = TIMER_OCN_POLARITY_HIGH;
-    timer_oc_struct.ocidlestate = TIMER_OC_IDLE_STATE_LOW;
-    timer_oc_struct.ocnidlestate = TIMER_OCN_IDLE_STATE_LOW;
-    timer_channel_output_config(TIMER1, TIMER_CH_1, &timer_oc_struct);
+    PWM_Init();
     
-    // 设置CH1比较值（占空比50%）
-    timer_channel_output_pulse_value_config(TIMER1, TIMER_CH_1, per / 2);
-    
-    // 设置CH1输出模式为PWM0
-    timer_channel_output_mode_config(TIMER1, TIMER_CH_1, TIMER_OC_MODE_PWM0);
-    timer_channel_output_shadow_config(TIMER1, TIMER_CH_1, TIMER_OC_SHADOW_DISABLE);
-    
-    // 使能中断
-    nvic_irq_enable(TIMER1_IRQn, 1, 1);
-    timer_interrupt_enable(TIMER1, TIMER_INT_UP);
-    
-    // 使能定时器
-    timer_enable(TIMER1);
-    
-    printf(">>> TIMER1 Initialized <<<\r\n");
-    printf("Frequency: %d Hz (triggers ADC)\r\n", 72000000 / (psc + 1) / (per + 1));
+    printf(">>> LED PWM Initialized <<<\r\n");
+    printf("PWM: 10kHz hardware (TIMER0 CH0N-CH2N, TIMER1 CH3, PB12 via DMA)\r\n");
+    printf("Tick: %d Hz (TIMER0 update)\r\n", PWM_LED_TICK_HZ);
 }
 
-// 定时器1中断处理函数 - 每1ms调用一次
-void TIMER1_IRQHandler(void)
+// 定时器0更新中断处理函数 - 每1ms调用一次（重复计数器分频）
+void TIMER0_UP_IRQHandler(void)
 {
-    timer_flag_clear(TIMER1,TIMER_FLAG_UP);
-    timer_interrupt_flag_clear(TIMER1,TIMER_INT_FLAG_UP);
+    MON_IRQ_ENTER(mon_t, TIMER_CNT(TIMER0));
+    timer_interrupt_flag_clear(TIMER0,TIMER_INT_FLAG_UP);
     
     // 调用LED处理函数
+    PROF_BEGIN(prof_t);
     LED_Process();
+    PROF_END(PROF_LED_PROCESS, prof_t);
     
     // ==================== 定时发送功能（任务三第3点） ====================
     // 注意：Project 2中禁用此功能，避免与现有USART冲突
@@ -110,5 +88,7 @@ void TIMER1_IRQHandler(void)
         }
     }
     */
+    
+    MON_IRQ_EXIT(MON_IRQ_TIMER0_UP, mon_t);
 }
 
@@ -3,8 +3,8 @@
 
 #include "main.h"
 
-// 定时器初始化（用于LED PWM控制）
-void TIM1_Init_LED(uint16_t psc,uint16_t per);
+// LED定时器初始化（硬件PWM + 1kHz模式节拍）
+void TIM_Init_LED(void);
 
 // 定时发送功能（任务三第3点）
 void Timer_Set_Send_Interval(uint16_t interval_ms);  // 设置发送间隔
@@ -1,539 +1,410 @@
 #include "usart.h"
 #include "../../USER/main.h"
+#include "../DMA/dma.h"
+#include "../../USER/scheduler.h"
+#include "../TIMEBASE/timebase.h"
+#include "../../USER/profile.h"
+#include "../../USER/monitor.h"
+#include <string.h>
 
-/* 重定向printf函数 */
-int fputc(int ch, FILE *f)
-{
-    usart_data_transmit(USART0, (uint8_t)ch);
-    while(RESET == usart_flag_get(USART0, USART_FLAG_TBE));
-    return ch;
-}
+/* UART发送环形缓冲区（DMA0_CH3排空，printf/二进制帧入队后立即返回） */
+static uint8_t uart_tx_buffer[UART_TX_BUFFER_SIZE];
+static volatile uint16_t uart_tx_head = 0;      /* 写入位置 */
+static volatile uint16_t uart_tx_tail = 0;      /* DMA读取位置（传输完成后前移） */
+static volatile uint16_t uart_tx_dma_len = 0;   /* 正在传输的字节数，0=DMA空闲 */
+static UART_TxStats_t uart_tx_stats = {0};
 
-void USART0_Init(uint32_t baudrate)
+/* UART接收：DMA0_CH4循环写入，中断中取出新字节回显并分行，完整行进入行队列 */
+static uint8_t uart_rx_dma_buffer[UART_RX_DMA_SIZE];
+static uint16_t uart_rx_read = 0;               /* 已取出的DMA缓冲区位置 */
+static char uart_rx_line[UART_RX_LINE_SIZE];    /* 正在拼接的行 */
+static uint8_t uart_rx_index = 0;
+static char uart_rx_queue[UART_RX_QUEUE_DEPTH][UART_RX_LINE_SIZE];
+static volatile uint8_t uart_rx_q_head = 0;     /* 中断写入 */
+static volatile uint8_t uart_rx_q_tail = 0;     /* 主循环读取 */
+
+#define UART_TX_MASK        (UART_TX_BUFFER_SIZE - 1)
+#define UART_TX_USED()      ((uint16_t)((uart_tx_head - uart_tx_tail) & UART_TX_MASK))
+
+/*!
+ * \brief   启动下一段DMA传输（调用者须已关中断）
+ * \details 每次只发送tail到缓冲区末尾的连续段，回绕部分在下一次完成中断中发送
+ */
+static void UART_TxStartDMA(void)
 {
-    rcu_periph_clock_enable(RCU_GPIOA);
-    rcu_periph_clock_enable(RCU_USART0);
+    uint16_t head = uart_tx_head;
+    uint16_t tail = uart_tx_tail;
+    uint16_t len;
     
-    gpio_init(GPIOA,GPIO_MODE_AF_PP,GPIO_OSPEED_50MHZ,GPIO_PIN_9);//TX
-    gpio_init(GPIOA,GPIO_MODE_IN_FLOATING,GPIO_OSPEED_50MHZ,GPIO_PIN_10);//RX  
-    //96N81
-    usart_baudrate_set( USART0,  baudrate);
-    usart_parity_config( USART0,  USART_PM_NONE);
-    usart_word_length_set( USART0,  USART_WL_8BIT);
-    usart_stop_bit_set( USART0,  USART_STB_1BIT);
-    usart_hardware_flow_rts_config(USART0, USART_RTS_DISABLE);
-    usart_hardware_flow_cts_config(USART0, USART_CTS_DISABLE);
+    if(uart_tx_dma_len != 0 || head == tail) return;
     
-    usart_transmit_config( USART0,  USART_TRANSMIT_ENABLE);
-    usart_receive_config( USART0,  USART_RECEIVE_ENABLE);
-    usart_interrupt_enable( USART0, USART_INT_RBNE);
+    len = (head > tail) ? (uint16_t)(head - tail) : (uint16_t)(UART_TX_BUFFER_SIZE - tail);
     
-    /* UART优先级低于TIMER2 (1,1) < (0,0)，确保DDS波形生成不被阻塞 */
-    nvic_irq_enable(USART0_IRQn,1, 1);
-    usart_enable(USART0);
+    dma_channel_disable(DMA0, DMA_CH3);
+    dma_memory_address_config(DMA0, DMA_CH3, (uint32_t)&uart_tx_buffer[tail]);
+    dma_transfer_number_config(DMA0, DMA_CH3, len);
+    uart_tx_dma_len = len;
+    dma_channel_enable(DMA0, DMA_CH3);
 }
 
-
-/* UART接收缓冲区 */
-#define UART_RX_BUFFER_SIZE 64
-static char uart_rx_buffer[UART_RX_BUFFER_SIZE];
-static uint8_t uart_rx_index = 0;
-
-/* 数据流控制 */
-static uint8_t uart_stream_enable = 0;  /* 0=禁用, 1=启用数据流 */
-static uint32_t uart_timestamp = 0;     /* 时间戳计数器 */
-
-/* 字符串比较函数 */
-static int str_compare(const char *str1, const char *str2, uint32_t len)
+/*!
+ * \brief   处理DMA传输完成（中断或轮询调用，调用者须已关中断）
+ */
+static void UART_TxService(void)
 {
-    for(uint32_t i = 0; i < len; i++)
-    {
-        if(str1[i] != str2[i]) return 1;
-        if(str1[i] == '\0') return 0;
-    }
-    return 0;
+    if(uart_tx_dma_len == 0) return;
+    if(dma_flag_get(DMA0, DMA_CH3, DMA_FLAG_FTF) == RESET) return;
+    
+    dma_flag_clear(DMA0, DMA_CH3, DMA_FLAG_G);
+    uart_tx_tail = (uint16_t)((uart_tx_tail + uart_tx_dma_len) & UART_TX_MASK);
+    uart_tx_dma_len = 0;
+    UART_TxStartDMA();
 }
 
-/* 字符串转整数 */
-static uint32_t str_to_uint(const char *str)
+/*!
+ * \brief   缓冲区满时当前上下文能否等待
+ * \details 线程模式（命令在主循环中执行，应答不能丢）和抢占优先级>=1的中断
+ *          （USART0回显等）可以等待；抢占优先级0的实时中断（TIMER2 DDS等）直接丢弃
+ */
+static uint8_t UART_TxCanWait(void)
 {
-    uint32_t result = 0;
-    while(*str >= '0' && *str <= '9')
-    {
-        result = result * 10 + (*str - '0');
-        str++;
-    }
-    return result;
+    uint32_t ipsr = __get_IPSR();
+    
+    if(ipsr == 0) return 1;
+    if(ipsr < 16) return 0;
+    /* 默认分组PRE2_SUB2：4位优先级的高2位为抢占优先级 */
+    return (NVIC_GetPriority((IRQn_Type)(ipsr - 16)) >> 2) != 0;
 }
 
-/* 处理UART命令 */
-static void process_uart_command(void)
+/*!
+ * \brief   写入发送缓冲区
+ * \details 空间不足时：可等待的上下文轮询DMA完成标志直到有空间（关中断时也能推进），
+ *          否则丢弃剩余字节并计数
+ */
+static void UART_TxEnqueue(const uint8_t *data, uint32_t len)
 {
-    extern void DDS_SetFrequency(uint32_t freq_hz);
-    extern uint32_t DDS_GetFrequency(void);
-    extern void DDS_Start(void);
-    extern void DDS_Stop(void);
+    uint8_t waited = 0;
     
-    /* FREQ:xxx - 设置频率并启动DDS */
-    if(str_compare(uart_rx_buffer, "FREQ:", 5) == 0)
-    {
-        uint32_t freq = str_to_uint(uart_rx_buffer + 5);
-        if(freq >= 10 && freq <= 2000)
-        {
-            DDS_SetFrequency(freq);
-            DDS_Start();  /* 自动启动DDS，确保有信号输出 */
-            
-            /* 设置自适应采样率（10倍频率） */
-            extern void TIMER3_SetSampleRate(uint32_t sample_rate_hz);
-            TIMER3_SetSampleRate(freq * 10);
-            
-            printf("OK:FREQ:%uHz (DAC5311 -> PB1)\r\n", (unsigned int)freq);
-        }
-        else
-        {
-            printf("ERROR:FREQ_RANGE (10-2000Hz)\r\n");
-        }
-    }
-    /* TYPE:SINE - 切换到正弦波模式 */
-    else if(str_compare(uart_rx_buffer, "TYPE:SINE", 9) == 0)
-    {
-        extern volatile SignalType_t g_signal_type;
-        g_signal_type = SIGNAL_TYPE_SINE;
-        printf("OK:TYPE:SINE\r\n");
-    }
-    /* TYPE:ECG - 切换到心电ECG模式并启动 */
-    else if(str_compare(uart_rx_buffer, "TYPE:ECG", 8) == 0)
-    {
-        extern volatile SignalType_t g_signal_type;
-        extern void DDS_Start(void);
-        extern void TIMER3_SetSampleRate(uint32_t sample_rate_hz);
-        
-        g_signal_type = SIGNAL_TYPE_ECG;
-        DDS_Start();  /* 启动DDS输出ECG波形 */
-        
-        /* 设置ADC采样率：2500Hz (50Hz ECG × 50倍过采样) */
-        TIMER3_SetSampleRate(2500);
-        
-        uart_stream_enable = 1;  /* 启用数据流 */
-        uart_timestamp = 0;
-        printf("OK:TYPE:ECG\r\n");
-    }
-    /* FREQ_TEST:xxx - 频率测试（Web兼容）*/
-    else if(str_compare(uart_rx_buffer, "FREQ_TEST:", 10) == 0)
+    while(len)
     {
-        uint32_t freq = str_to_uint(uart_rx_buffer + 10);
-        DDS_SetFrequency(freq);
-        /* 开启数据流 */
-        uart_stream_enable = 1;
-        uart_timestamp = 0;
-        printf("OK:FREQ_TEST_STARTED:%uHz\r\n", (unsigned int)freq);
-    }
-    /* START - 开始数据流（Web应用兼容） */
-    else if(str_compare(uart_rx_buffer, "START", 5) == 0)
-    {
-        uart_stream_enable = 1;
-        uart_timestamp = 0;
-        printf("OK:STREAM_STARTED\r\n");
-    }
-    /* STOP - 停止数据流（Web应用兼容） */
-    else if(str_compare(uart_rx_buffer, "STOP", 4) == 0)
-    {
-        uart_stream_enable = 0;
-        printf("OK:STREAM_STOPPED\r\n");
-    }
-    /* STREAM:START - 开始数据流（兼容旧命令） */
-    else if(str_compare(uart_rx_buffer, "STREAM:START", 12) == 0)
-    {
-        uart_stream_enable = 1;
-        uart_timestamp = 0;
-        printf("OK:STREAM_STARTED\r\n");
-    }
-    /* STREAM:STOP - 停止数据流（兼容旧命令） */
-    else if(str_compare(uart_rx_buffer, "STREAM:STOP", 11) == 0)
-    {
-        uart_stream_enable = 0;
-        printf("OK:STREAM_STOPPED\r\n");
-    }
-    /* STATUS - 查询状态 */
-    else if(str_compare(uart_rx_buffer, "STATUS", 6) == 0)
-    {
-        extern uint32_t DDS_GetFrequency(void);
-        extern uint8_t DDS_IsEnabled(void);
-        uint32_t freq = DDS_GetFrequency();
-        printf("\r\n========================================\r\n");
-        printf("  Bode Plot Analyzer Status\r\n");
-        printf("========================================\r\n");
-        printf("Frequency: %u Hz\r\n", (unsigned int)freq);
-        printf("Signal Path: DDS -> SPI1 -> DAC5311 -> PB1\r\n");
-        printf("DDS Enabled: %s\r\n", DDS_IsEnabled() ? "YES" : "NO");
-        printf("Stream: %s\r\n", uart_stream_enable ? "ON" : "OFF");
-        printf("========================================\r\n\r\n");
-    }
-    /* DEBUG - 调试DDS状态 */
-    else if(str_compare(uart_rx_buffer, "DEBUG", 5) == 0)
-    {
-        extern uint8_t DDS_IsEnabled(void);
-        extern uint32_t TIMER2_GetInterruptCount(void);
-        extern uint32_t DDS_GetFrequency(void);
-        extern uint8_t DDS_GetSineIndex(void);
-        extern uint32_t DDS_GetPhaseAccumulator(void);
-        extern uint32_t DDS_GetPhaseIncrement(void);
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
         
-        printf("\r\n======== BODE ANALYZER DEBUG ========\r\n");
-        printf("Frequency: %u Hz\r\n", (unsigned int)DDS_GetFrequency());
-        printf("DDS Enabled: %u (1=ON, 0=OFF)\r\n", (unsigned int)DDS_IsEnabled());
-        printf("Sine Index: %u / 255\r\n", (unsigned int)DDS_GetSineIndex());
-        printf("Phase Acc: 0x%08lX\r\n", (unsigned long)DDS_GetPhaseAccumulator());
-        printf("Phase Inc: 0x%08lX\r\n", (unsigned long)DDS_GetPhaseIncrement());
+        UART_TxService();
         
-        /* TIMER2中断计数测试（DDS更新） */
-        uint32_t count1 = TIMER2_GetInterruptCount();
-        delay_ms(100);  /* 等待100ms */
-        uint32_t count2 = TIMER2_GetInterruptCount();
-        printf("\r\nTIMER2 DDS Update Test (100ms interval):\r\n");
-        printf("  Count1: %u\r\n", (unsigned int)count1);
-        printf("  Count2: %u\r\n", (unsigned int)count2);
-        printf("  Delta:  %u (should be ~5000 for 50kHz)\r\n", (unsigned int)(count2-count1));
-        
-        printf("\r\nDiagnosis:\r\n");
-        
-        /* 检查TIMER2中断 */
-        if((count2 - count1) < 100)
+        uint16_t head = uart_tx_head;
+        uint16_t free = (uint16_t)(UART_TX_MASK - UART_TX_USED());
+        if(free == 0)
         {
-            printf("❌ TIMER2 interrupt NOT running! (delta=%u, expected~5000)\r\n", (unsigned int)(count2-count1));
-            printf("   Check: 1) NVIC configuration\r\n");
-            printf("          2) Timer enable status\r\n");
-            printf("          3) Interrupt vector table\r\n");
-        }
-        else
-        {
-            printf("✓ TIMER2 DDS update is running! (delta=%u)\r\n", (unsigned int)(count2-count1));
-            printf("✓ PB1 should output sine wave via DAC5311\r\n");
-            printf("  - Frequency: %u Hz\r\n", (unsigned int)DDS_GetFrequency());
-            printf("  - Signal path: SPI1 -> DAC5311 -> Filter -> PB1\r\n");
-        }
-        
-        /* 检查DDS使能 */
-        if(DDS_IsEnabled() == 0)
-        {
-            printf("❌ DDS is DISABLED! Call DDS_Start() to enable.\r\n");
-        }
-        else
-        {
-            printf("✓ DDS is enabled.\r\n");
-        }
-        printf("========================================\r\n\r\n");
-    }
-    /* MEASURE - 立即测量一次 */
-    else if(str_compare(uart_rx_buffer, "MEASURE", 7) == 0)
-    {
-        extern void ProcessADCData(void);
-        printf("OK:MEASURING...\r\n");
-        ProcessADCData();
-    }
-    /* WAVE - 快速获取原始波形数据（用于实时显示） */
-    else if(str_compare(uart_rx_buffer, "WAVE", 4) == 0)
-    {
-        extern uint32_t adc_buffer[];
-        extern uint32_t DDS_GetFrequency(void);
-        uint32_t freq = DDS_GetFrequency();
-        uint32_t sr = freq * 10;  /* 采样率 */
-        
-        /* 只发送64个点，足够显示几个周期，速度快 */
-        printf("WAVE:%u,%u\r\n", (unsigned int)freq, (unsigned int)sr);
-        printf("D:");
-        for(uint32_t i = 0; i < 64; i++)
-        {
-            uint16_t ch0 = (uint16_t)(adc_buffer[i] & 0xFFFF);
-            uint16_t ch1 = (uint16_t)((adc_buffer[i] >> 16) & 0xFFFF);
-            printf("%u,%u", ch0, ch1);
-            if(i < 63) printf(";");
-        }
-        printf("\r\n");
-    }
-    /* UWAVE:freq,sr - 真实欠采样波形（硬件实际以低采样率采集，双通道） */
-    else if(str_compare(uart_rx_buffer, "UWAVE:", 6) == 0)
-    {
-        extern void DDS_SetFrequency(uint32_t freq_hz);
-        extern void DDS_Start(void);
-        extern void TIMER3_SetSampleRate(uint32_t sample_rate_hz);
-        extern void ADC_DMA_Restart(uint32_t sample_count);
-        extern uint32_t adc_buffer[];
-        
-        char *ptr = uart_rx_buffer + 6;
-        uint32_t signal_freq = str_to_uint(ptr);
-        while(*ptr >= '0' && *ptr <= '9') ptr++;
-        if(*ptr == ',') ptr++;
-        uint32_t sample_rate = str_to_uint(ptr);  /* 真实欠采样率 */
-        
-        if(signal_freq >= 10 && signal_freq <= 2000 && sample_rate >= 10 && sample_rate <= 50000)
-        {
-            DDS_SetFrequency(signal_freq);
-            DDS_Start();
-            
-            /* 设置欠采样率 */
-            TIMER3_SetSampleRate(sample_rate);
-            
-            /* 调试：计算实际的prescaler和period值 */
-            uint32_t psc = 0, prd = (72000000 / sample_rate) - 1;
-            while(prd > 65535 && psc < 65535) { psc++; prd = (72000000 / (psc + 1) / sample_rate) - 1; }
-            uint32_t actual_sr = 72000000 / (psc + 1) / (prd + 1);
-            printf("[DBG] freq=%u, sr=%u, psc=%u, prd=%u, actual_sr=%u\r\n", 
-                   (unsigned int)signal_freq, (unsigned int)sample_rate, 
-                   (unsigned int)psc, (unsigned int)prd, (unsigned int)actual_sr);
-            
-            /* 等待信号稳定 */
-            delay_ms(30);
-            
-            /* ⭐ 重启DMA，确保从缓冲区开头采集连续的64个新点 */
-            ADC_DMA_Restart(64);
-            
-            /* 等待64个采样点完成 */
-            uint32_t buffer_fill_ms = (64 * 1000) / sample_rate + 5;  /* 64点采集时间+小余量 */
-            if(buffer_fill_ms > 2000) buffer_fill_ms = 2000;  /* 最长2s */
-            delay_ms(buffer_fill_ms);
-            
-            /* 立即禁用DMA，防止循环模式覆盖数据 */
-            dma_channel_disable(DMA0, DMA_CH0);
-            
-            /* 复制数据到本地缓冲区 */
-            static uint16_t local_ch0[64];
-            static uint16_t local_ch1[64];
-            for(uint32_t i = 0; i < 64; i++)
+            __set_PRIMASK(primask);
+            if(!UART_TxCanWait())
             {
-                uint32_t raw = adc_buffer[i];
-                local_ch0[i] = (uint16_t)(raw & 0xFFFF);
-                local_ch1[i] = (uint16_t)((raw >> 16) & 0xFFFF);
+                uart_tx_stats.dropped += len;
+                return;
             }
-            
-            /* 恢复默认采样率和DMA循环模式 */
-            TIMER3_SetSampleRate(10000);
-            ADC_DMA_Restart(512);  /* 恢复512点循环采集 */
-            
-            /* 发送64点真实欠采样数据（双通道：PA6和PB1） */
-            printf("UWAVE:%u,%u\r\n", (unsigned int)signal_freq, (unsigned int)sample_rate);
-            printf("D:");
-            for(uint32_t i = 0; i < 64; i++)
+            if(!waited)
             {
-                printf("%u,%u", local_ch0[i], local_ch1[i]);
-                if(i < 63) printf(";");
+                uart_tx_stats.overflows++;
+                waited = 1;
             }
-            printf("\r\n");
+            continue;
         }
-    }
-    /* SWEEP - 自动扫频测量 */
-    else if(str_compare(uart_rx_buffer, "SWEEP", 5) == 0)
-    {
-        extern void AutoSweep(void);
-        printf("OK:STARTING_SWEEP\r\n");
-        AutoSweep();
-    }
-    /* CALIBRATE - 系统校准 */
-    else if(str_compare(uart_rx_buffer, "CALIBRATE", 9) == 0 || 
-            str_compare(uart_rx_buffer, "CALIB", 5) == 0)
-    {
-        extern void AutoCalibration(void);
-        printf("OK:STARTING_CALIBRATION\r\n");
-        AutoCalibration();
-    }
-    /* CAPTURE:freq,sample_rate - 欠采样波形采集（独立功能） */
-    else if(str_compare(uart_rx_buffer, "CAPTURE:", 8) == 0)
-    {
-        extern void CaptureWaveform(uint32_t signal_freq, uint32_t sample_rate);
-        /* 解析参数：CAPTURE:freq,sample_rate */
-        char *ptr = uart_rx_buffer + 8;
-        uint32_t signal_freq = str_to_uint(ptr);
         
-        /* 找到逗号 */
-        while(*ptr && *ptr != ',') ptr++;
-        if(*ptr == ',') ptr++;
-        uint32_t sample_rate = str_to_uint(ptr);
+        /* 本次复制不超过空闲空间和到缓冲区末尾的连续空间 */
+        uint16_t n = (uint16_t)(UART_TX_BUFFER_SIZE - head);
+        if(n > free) n = free;
+        if(n > len) n = (uint16_t)len;
         
-        /* 参数检查 */
-        if(signal_freq >= 10 && signal_freq <= 2000 && 
-           sample_rate >= 10 && sample_rate <= 50000)
+        for(uint16_t i = 0; i < n; i++)
         {
-            printf("OK:CAPTURE_START:freq=%uHz,sr=%uHz\r\n", 
-                   (unsigned int)signal_freq, (unsigned int)sample_rate);
-            CaptureWaveform(signal_freq, sample_rate);
+            uart_tx_buffer[head + i] = data[i];
         }
-        else
+        uart_tx_head = (uint16_t)((head + n) & UART_TX_MASK);
+        data += n;
+        len -= n;
+        
+        if(UART_TX_USED() > uart_tx_stats.high_water)
         {
-            printf("ERROR:CAPTURE (freq:10-2000Hz, sample_rate:10-50000Hz)\r\n");
-            printf("Usage: CAPTURE:freq,sample_rate\r\n");
-            printf("Example: CAPTURE:100,500 (100Hz signal, 500Hz sampling)\r\n");
+            uart_tx_stats.high_water = UART_TX_USED();
         }
+        
+        UART_TxStartDMA();
+        __set_PRIMASK(primask);
     }
-    /* LED:x - 设置LED模式 */
-    else if(str_compare(uart_rx_buffer, "LED:", 4) == 0)
+}
+
+/* 重定向printf函数（入队后立即返回） */
+int fputc(int ch, FILE *f)
+{
+    uint8_t c = (uint8_t)ch;
+    PROF_BEGIN(prof_t);
+    UART_TxEnqueue(&c, 1);
+    PROF_END(PROF_UART_TX, prof_t);
+    return ch;
+}
+
+/*!
+ * \brief   发送一段原始字节（二进制帧使用，不经过printf格式化）
+ * \param   data 数据指针
+ * \param   len  字节数
+ */
+void UART_Write(const uint8_t *data, uint32_t len)
+{
+    PROF_BEGIN(prof_t);
+    UART_TxEnqueue(data, len);
+    PROF_END(PROF_UART_TX, prof_t);
+}
+
+/*!
+ * \brief   等待发送缓冲区排空且最后一个字节移出移位寄存器
+ */
+void UART_Flush(void)
+{
+    while(1)
     {
-        extern void LED_Set_Mode(uint8_t mode);
-        uint32_t mode = str_to_uint(uart_rx_buffer + 4);
-        if(mode <= 6)
-        {
-            LED_Set_Mode(mode);
-            const char *mode_names[] = {"OFF", "Flow", "Breath", "Blink", "Specific", "Rotate", "Alarm"};
-            printf("OK:LED_MODE:%s\r\n", mode_names[mode]);
-        }
-        else
-        {
-            printf("ERROR:LED_MODE (0-6)\r\n");
-        }
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        UART_TxService();
+        uint8_t empty = (uart_tx_dma_len == 0 && uart_tx_head == uart_tx_tail);
+        __set_PRIMASK(primask);
+        if(empty) break;
     }
-    /* LED_BRIGHT:x - 设置LED亮度 */
-    else if(str_compare(uart_rx_buffer, "LED_BRIGHT:", 11) == 0)
+    while(RESET == usart_flag_get(USART0, USART_FLAG_TC));
+}
+
+/*!
+ * \brief   读取发送缓冲区统计
+ */
+void UART_GetTxStats(UART_TxStats_t *stats)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *stats = uart_tx_stats;
+    stats->used = UART_TX_USED();
+    __set_PRIMASK(primask);
+}
+
+/*!
+ * \brief   DMA0通道3中断 - USART0发送完成，继续发送缓冲区剩余数据
+ */
+void DMA0_Channel3_IRQHandler(void)
+{
+    MON_IRQ_ENTER(mon_t, 0);
+    if(dma_interrupt_flag_get(DMA0, DMA_CH3, DMA_INT_FLAG_FTF) != RESET)
     {
-        extern void LED_Set_Brightness(uint8_t brightness);
-        uint32_t brightness = str_to_uint(uart_rx_buffer + 11);
-        if(brightness <= 100)
-        {
-            LED_Set_Brightness((uint8_t)brightness);
-            printf("OK:LED_BRIGHTNESS:%u%%\r\n", (unsigned int)brightness);
-        }
-        else
-        {
-            printf("ERROR:LED_BRIGHTNESS (0-100)\r\n");
-        }
+        UART_TxService();
+        /* 已被轮询路径处理过的残留标志 */
+        if(uart_tx_dma_len == 0) dma_flag_clear(DMA0, DMA_CH3, DMA_FLAG_G);
     }
-    /* LED_FREQ:x - 设置LED频率/间隔 */
-    else if(str_compare(uart_rx_buffer, "LED_FREQ:", 9) == 0)
+    MON_IRQ_EXIT(MON_IRQ_DMA_UART_TX, mon_t);
+}
+
+/*!
+ * \brief   配置USART0发送DMA（DMA0_CH3，内存→USART_DATA，单次模式）
+ */
+static void USART0_TxDMA_Init(void)
+{
+    dma_parameter_struct dma_struct;
+    
+    rcu_periph_clock_enable(RCU_DMA0);
+    dma_deinit(DMA0, DMA_CH3);
+    dma_struct_para_init(&dma_struct);
+    
+    dma_struct.direction    = DMA_MEMORY_TO_PERIPHERAL;
+    dma_struct.memory_addr  = (uint32_t)uart_tx_buffer;
+    dma_struct.memory_inc   = DMA_MEMORY_INCREASE_ENABLE;
+    dma_struct.memory_width = DMA_MEMORY_WIDTH_8BIT;
+    dma_struct.number       = 0;
+    dma_struct.periph_addr  = (uint32_t)(&USART_DATA(USART0));
+    dma_struct.periph_inc   = DMA_PERIPH_INCREASE_DISABLE;
+    dma_struct.periph_width = DMA_PERIPHERAL_WIDTH_8BIT;
+    dma_struct.priority     = DMA_PRIORITY_LOW;
+    dma_init(DMA0, DMA_CH3, &dma_struct);
+    
+    dma_circulation_disable(DMA0, DMA_CH3);
+    dma_memory_to_memory_disable(DMA0, DMA_CH3);
+    
+    /* 抢占优先级0：回显在USART0中断(1,1)中等待时也能继续排空；处理函数只有几条寄存器操作 */
+    nvic_irq_enable(DMA0_Channel3_IRQn, 0, 1);
+    dma_interrupt_enable(DMA0, DMA_CH3, DMA_INT_FTF);
+    
+    usart_dma_transmit_config(USART0, USART_DENT_ENABLE);
+}
+
+static uint32_t uart_baudrate = 115200;  /* 当前波特率 */
+
+/*!
+ * \brief   检查波特率是否可用
+ * \details USART0挂在APB2(72MHz)，16倍过采样：分频值=round(PCLK/rate)须>=16，
+ *          量化后的实际波特率与目标误差须<2%
+ */
+uint8_t UART_BaudValid(uint32_t rate)
+{
+    uint32_t pclk = rcu_clock_freq_get(CK_APB2);
+    uint32_t udiv, actual, err;
+    
+    if(rate < UART_BAUD_MIN || rate > UART_BAUD_MAX) return 0;
+    
+    udiv = (pclk + rate / 2) / rate;
+    if(udiv < 16) return 0;
+    
+    actual = pclk / udiv;
+    err = (actual > rate) ? (actual - rate) : (rate - actual);
+    return (err * 1000U / rate) < 20;
+}
+
+/*!
+ * \brief   切换波特率（调用前须UART_Flush，保证旧波特率数据已发完）
+ */
+void UART_SetBaudrate(uint32_t rate)
+{
+    usart_disable(USART0);
+    usart_baudrate_set(USART0, rate);
+    usart_enable(USART0);
+    uart_baudrate = rate;
+}
+
+uint32_t UART_GetBaudrate(void)
+{
+    return uart_baudrate;
+}
+
+/*!
+ * \brief   在新波特率下等待主机发送PING
+ * \details 在主循环的命令处理中调用，接收仍由DMA和中断完成，这里只从行队列取行；
+ *          切换瞬间可能收到乱码，只要行以PING结尾即可
+ * \return  1=收到PING，0=超时
+ */
+uint8_t UART_WaitPing(uint32_t timeout_ms)
+{
+    char line[UART_RX_LINE_SIZE];
+    uint32_t deadline = Timebase_Deadline(timeout_ms);
+    
+    while(!Timebase_Expired(deadline))
     {
-        extern void LED_Set_Interval(uint16_t interval_ms);
-        uint32_t freq = str_to_uint(uart_rx_buffer + 9);
-        if(freq >= 1 && freq <= 30000)
+        if(UART_ReadLine(line, sizeof(line)))
         {
-            LED_Set_Interval((uint16_t)freq);
-            printf("OK:LED_INTERVAL:%ums\r\n", (unsigned int)freq);
+            uint32_t len = strlen(line);
+            if(len >= 4 && strcmp(line + len - 4, "PING") == 0) return 1;
         }
         else
         {
-            printf("ERROR:LED_INTERVAL (1-30000ms)\r\n");
+            __WFI();    /* 下一行到达或1ms节拍唤醒 */
         }
     }
-    /* LED_MASK:x - 设置特定LED掩码 (bit0-4对应LED3,LED7,LED4,LED6,LED5) */
-    else if(str_compare(uart_rx_buffer, "LED_MASK:", 9) == 0)
+    return 0;
+}
+
+void USART0_Init(uint32_t baudrate)
+{
+    uart_baudrate = baudrate;
+    rcu_periph_clock_enable(RCU_GPIOA);
+    rcu_periph_clock_enable(RCU_USART0);
+    
+    gpio_init(GPIOA,GPIO_MODE_AF_PP,GPIO_OSPEED_50MHZ,GPIO_PIN_9);//TX
+    gpio_init(GPIOA,GPIO_MODE_IN_FLOATING,GPIO_OSPEED_50MHZ,GPIO_PIN_10);//RX  
+    //96N81
+    usart_baudrate_set( USART0,  baudrate);
+    usart_parity_config( USART0,  USART_PM_NONE);
+    usart_word_length_set( USART0,  USART_WL_8BIT);
+    usart_stop_bit_set( USART0,  USART_STB_1BIT);
+    usart_hardware_flow_rts_config(USART0, USART_RTS_DISABLE);
+    usart_hardware_flow_cts_config(USART0, USART_CTS_DISABLE);
+    
+    usart_transmit_config( USART0,  USART_TRANSMIT_ENABLE);
+    usart_receive_config( USART0,  USART_RECEIVE_ENABLE);
+    usart_interrupt_enable( USART0, USART_INT_IDLE);   /* 空闲线：一帧字节收完即取出 */
+    usart_dma_receive_config(USART0, USART_DENR_ENABLE);
+    USART0_DMA_Init(uart_rx_dma_buffer, UART_RX_DMA_SIZE);
+    USART0_TxDMA_Init();
+    
+    /* UART优先级低于TIMER2 (1,1) < (0,0)，确保DDS波形生成不被阻塞 */
+    nvic_irq_enable(USART0_IRQn,1, 1);
+    usart_enable(USART0);
+}
+
+
+/*!
+ * \brief   处理一个接收字节：行结束时放入行队列
+ */
+static void UART_RxChar(char c)
+{
+    if(c == '\r' || c == '\n')
     {
-        extern void LED_Set_Specific_LED(uint8_t led_mask);
-        uint32_t mask = str_to_uint(uart_rx_buffer + 9);
-        if(mask <= 0x1F)  // 5位掩码，最大31
-        {
-            LED_Set_Specific_LED((uint8_t)mask);
-            printf("OK:LED_MASK:0x%02X\r\n", (unsigned int)mask);
-        }
-        else
+        if(uart_rx_index == 0) return;
+        uart_rx_line[uart_rx_index] = '\0';
+        uart_rx_index = 0;
+        
+        uint8_t next = (uint8_t)((uart_rx_q_head + 1) % UART_RX_QUEUE_DEPTH);
+        if(next == uart_rx_q_tail)
         {
-            printf("ERROR:LED_MASK (0-31, 0x00-0x1F)\r\n");
+            /* 主循环被长命令（MEASURE/UWAVE等）占用且积压已满 */
+            printf("\r\n[ERROR] Command queue full, dropped: %s\r\n", uart_rx_line);
+            return;
         }
+        strcpy(uart_rx_queue[uart_rx_q_head], uart_rx_line);
+        uart_rx_q_head = next;
+        Sched_Post(SCHED_TASK_COMMAND);
     }
-    /* HELP - 帮助信息 */
-    else if(str_compare(uart_rx_buffer, "HELP", 4) == 0)
+    else if(uart_rx_index < UART_RX_LINE_SIZE - 1)
     {
-        printf("\r\n========================================\r\n");
-        printf("  Bode Plot Analyzer Commands\r\n");
-        printf("========================================\r\n");
-        printf("Frequency Control:\r\n");
-        printf("  FREQ:xxx      - Set frequency (10-2000Hz)\r\n");
-        printf("                  Example: FREQ:100\r\n\r\n");
-        printf("Output Control:\r\n");
-        printf("  START         - Start DDS output\r\n");
-        printf("  STOP          - Stop DDS output\r\n\r\n");
-        printf("Measurement:\r\n");
-        printf("  MEASURE       - Measure H(ω) and θ(ω)\r\n");
-        printf("  SWEEP         - Auto sweep 10Hz-2kHz (200pts)\r\n");
-        printf("  CALIBRATE     - System calibration\r\n");
-        printf("  CAPTURE:f,sr  - Waveform capture (undersampling demo)\r\n");
-        printf("                  f=signal freq, sr=sample rate\r\n");
-        printf("                  Example: CAPTURE:100,500\r\n\r\n");
-        printf("Status:\r\n");
-        printf("  STATUS        - Query system status\r\n");
-        printf("  DEBUG         - Show debug info\r\n");
-        printf("  HELP          - Show this help\r\n\r\n");
-        printf("LED Control:\r\n");
-        printf("  LED:0-6       - Set LED mode\r\n");
-        printf("                  0=OFF, 1=Flow, 2=Breath, 3=Blink\r\n");
-        printf("                  4=Specific, 5=Rotate, 6=Alarm\r\n");
-        printf("  LED_BRIGHT:x  - Set brightness (0-100%%)\r\n");
-        printf("  LED_FREQ:x    - Set interval (1-30000ms)\r\n");
-        printf("  LED_MASK:x    - Set LED mask for Specific mode (0-31)\r\n");
-        printf("                  bit0=LED3, bit1=LED7, bit2=LED4\r\n");
-        printf("                  bit3=LED6, bit4=LED5\r\n\r\n");
-        printf("Hardware:\r\n");
-        printf("  Signal Out: PB1 (DAC5311 filtered output)\r\n");
-        printf("  ADC Input: PA6 (Input reference K)\r\n");
-        printf("  ADC Output: PB1 (DUT output K₁)\r\n");
-        printf("  LED: GPIOB (PB11-PB15)\r\n");
-        printf("========================================\r\n\r\n");
+        uart_rx_line[uart_rx_index++] = c;
     }
     else
     {
-        printf("Unknown: %s (len=%d, first=0x%02X) (type HELP for commands)\r\n", 
-               uart_rx_buffer, uart_rx_index, (unsigned char)uart_rx_buffer[0]);
+        /* 缓冲区满，输出警告并复位 */
+        printf("\r\n[ERROR] Command too long! Max %d chars.\r\n", UART_RX_LINE_SIZE);
+        uart_rx_index = 0;
     }
 }
 
 /*!
- * \brief   发送数据流（在TIMER2中断中调用）
- * \param   sample DDS采样值
- * \param   adc0   ADC0数据 (PA6)
- * \param   adc1   ADC1数据 (PB1)
+ * \brief   取出DMA已接收的新字节（USART0空闲中断和DMA0_CH4半满/全满中断中调用）
+ * \details 两个中断同为抢占优先级1，不会互相打断
  */
-void UART_SendStreamData(uint8_t sample, uint16_t adc0, uint16_t adc1)
+void UART_RxDrain(void)
 {
-    if(uart_stream_enable == 0) return;
-    
-    extern uint32_t DDS_GetFrequency(void);
-    uint32_t freq;
+    uint16_t write = (uint16_t)(UART_RX_DMA_SIZE - dma_transfer_number_get(DMA0, DMA_CH4));
+    if(write >= UART_RX_DMA_SIZE) write = 0;
     
-    /* ECG模式下使用心率对应的频率（86 BPM约= 1.43 Hz，简化为1 Hz） */
-    if(g_signal_type == SIGNAL_TYPE_ECG)
-    {
-        freq = 1;  /* ECG心率频率标识，前端可用于判断显示模式 */
-    }
-    else
+    while(uart_rx_read != write)
     {
-        freq = DDS_GetFrequency();
+        /* 连续段：回显（经发送缓冲区，避免与DMA争用数据寄存器）后逐字节分行 */
+        uint16_t end = (write > uart_rx_read) ? write : UART_RX_DMA_SIZE;
+        UART_Write(&uart_rx_dma_buffer[uart_rx_read], (uint32_t)(end - uart_rx_read));
+        for(uint16_t i = uart_rx_read; i < end; i++)
+        {
+            UART_RxChar((char)uart_rx_dma_buffer[i]);
+        }
+        uart_rx_read = (end == UART_RX_DMA_SIZE) ? 0 : end;
     }
+}
+
+/*!
+ * \brief   从行队列取出一行命令
+ * \param   dst  目标缓冲区
+ * \param   size 缓冲区大小
+ * \return  1=取到一行，0=队列为空
+ */
+uint8_t UART_ReadLine(char *dst, uint32_t size)
+{
+    uint8_t tail = uart_rx_q_tail;
+    if(tail == uart_rx_q_head) return 0;
     
-    /* 发送符合网页端 WAVEFORM 格式的数据: WAVEFORM:freq,sampleRate,input|output */
-    /* ECG模式2500Hz，正弦波500Hz (由 timer.c 中的 stream_divisor 控制) */
-    uint16_t sample_rate = (g_signal_type == SIGNAL_TYPE_ECG) ? 2500 : 500;
-    
-    /* 测试：ECG 200Hz，发送真实ADC值看能否通过高通滤波器 */
-    printf("WAVEFORM:%u,%u,%u|%u\r\n", (unsigned int)freq, sample_rate, adc0, adc1);
+    strncpy(dst, uart_rx_queue[tail], size - 1);
+    dst[size - 1] = '\0';
+    uart_rx_q_tail = (uint8_t)((tail + 1) % UART_RX_QUEUE_DEPTH);
+    return 1;
 }
 
 void USART0_IRQHandler(void)
 {
-    uint16_t data = 0;
-    if(usart_flag_get(USART0,USART_FLAG_RBNE) != RESET)
+    MON_IRQ_ENTER(mon_t, 0);
+    if(usart_interrupt_flag_get(USART0, USART_INT_FLAG_IDLE) != RESET)
     {
-        usart_flag_clear(USART0,USART_FLAG_RBNE);
-        usart_interrupt_flag_clear(USART0,USART_INT_RBNE);
-        data = usart_data_receive(USART0);
-        
-        /* 回显 */
-        usart_data_transmit(USART0,data);
-        
-        /* 接收命令 */
-        char received_char = (char)(data & 0xFF);
-        if(received_char == '\r' || received_char == '\n')
-        {
-            if(uart_rx_index > 0)
-            {
-                uart_rx_buffer[uart_rx_index] = '\0';
-                process_uart_command();
-                uart_rx_index = 0;
-            }
-        }
-        else if(uart_rx_index < UART_RX_BUFFER_SIZE - 1)
-        {
-            uart_rx_buffer[uart_rx_index++] = received_char;
-        }
-        else
-        {
-            /* 缓冲区满，输出警告并复位 */
-            printf("\r\n[ERROR] Command too long! Max %d chars.\r\n", UART_RX_BUFFER_SIZE);
-            uart_rx_index = 0;
-        }
+        /* 先读STAT（上面已读）再读DATA清除IDLE标志 */
+        (void)usart_data_receive(USART0);
+        UART_RxDrain();
     }
+    MON_IRQ_EXIT(MON_IRQ_USART0, mon_t);
 }
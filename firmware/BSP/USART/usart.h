@@ -3,7 +3,36 @@
 
 #include "main.h"
 
+/* 发送环形缓冲区大小（2的幂，可容纳两帧512点RAW16波形，printf很少需要等待） */
+#define UART_TX_BUFFER_SIZE 4096
+
+/* 接收：DMA循环缓冲区、单行长度、待执行命令行队列深度 */
+#define UART_RX_DMA_SIZE    128
+#define UART_RX_LINE_SIZE   64
+#define UART_RX_QUEUE_DEPTH 4
+
+/* 波特率协商范围（APB2 72MHz，16倍过采样上限4.5Mbaud） */
+#define UART_BAUD_MIN               9600
+#define UART_BAUD_MAX               4500000
+#define UART_BAUD_PING_TIMEOUT_MS   2000
+
+/* 发送缓冲区统计 */
+typedef struct {
+    uint16_t used;          /* 当前待发送字节数 */
+    uint16_t high_water;    /* 历史最高占用 */
+    uint32_t overflows;     /* 缓冲区满导致等待的次数 */
+    uint32_t dropped;       /* 实时中断中缓冲区满被丢弃的字节数 */
+} UART_TxStats_t;
+
 void USART0_Init(uint32_t baudrate);
-void UART_SendStreamData(uint8_t sample, uint16_t adc0, uint16_t adc1);
+void UART_Write(const uint8_t *data, uint32_t len);
+void UART_Flush(void);
+uint32_t UART_GetBaudrate(void);
+uint8_t UART_BaudValid(uint32_t rate);
+void UART_SetBaudrate(uint32_t rate);
+uint8_t UART_WaitPing(uint32_t timeout_ms);
+void UART_RxDrain(void);
+uint8_t UART_ReadLine(char *dst, uint32_t size);
+void UART_GetTxStats(UART_TxStats_t *stats);
 
 #endif
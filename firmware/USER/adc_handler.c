@@ -6,7 +6,14 @@
  */
 
 #include "adc_handler.h"
+#include "telemetry.h"
+#include "../BSP/USART/usart.h"
 #include "signal_processing.h"
+#include "profile.h"
+#include "scratch.h"
+#include "decimator.h"
+#include "../BSP/ADC/adc.h"
+#include "../BSP/TIMEBASE/timebase.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
@@ -17,6 +24,131 @@ extern uint32_t adc_buffer[ADC_BUFFER_SIZE];
 /* 外部DDS函数 */
 extern uint32_t DDS_GetFrequency(void);
 
+/* 外部TIMER函数 */
+extern uint32_t TIMER3_SetSampleRate(uint32_t sample_rate_hz);
+extern uint32_t TIMER3_GetSampleRate(void);
+extern uint32_t TIMER3_SetPeriodTicks(uint32_t ticks);
+extern uint32_t TIMER3_GetPeriodTicks(void);
+
+/* 外部DDS幅度控制 */
+extern void DDS_SetAmplitude(uint16_t amplitude_q8);
+extern uint16_t DDS_GetAmplitude(void);
+
+/* 外部延时函数 */
+extern void delay_ms(uint32_t ms);
+
+/* 自动量程使能标志 */
+static uint8_t adc_autorange_enable = 1;
+
+/* 过采样-抽取模式使能标志 */
+static uint8_t adc_oversample_enable = 0;
+
+/* 多节点扫描：ADC通道按信号链顺序排列，节点0为参考（默认即原PA6/PB1两通道） */
+static uint8_t adc_scan_nodes[ADC_SCAN_MAX_NODES] = {ADC_CHANNEL_6, ADC_CHANNEL_9};
+static uint8_t adc_scan_count = 2;
+static uint8_t adc_scan_ranks = 0;          /* 0=未在扫描 */
+static uint32_t adc_scan_saved_rate = 0;    /* 扫描前的有效采样率 */
+
+/*!
+ * \brief   设置有效采样率（过采样模式下只改抽取比）
+ */
+uint32_t ADC_SetSampleRate(uint32_t sample_rate)
+{
+    uint32_t ratio = adc_oversample_enable ? Decim_PlanRatio(sample_rate) : 0;
+    
+    if(ratio) return Decim_Start(ratio);
+    return ADC_SetSampleRateDirect(sample_rate);
+}
+
+/*!
+ * \brief   直接设置TIMER3采样率（停止抽取）
+ */
+uint32_t ADC_SetSampleRateDirect(uint32_t sample_rate)
+{
+    Decim_Stop();
+    return TIMER3_SetSampleRate(sample_rate);
+}
+
+/*!
+ * \brief   按72MHz时钟数设置TIMER3周期（停止抽取）
+ */
+uint32_t ADC_SetSamplePeriod(uint32_t ticks)
+{
+    Decim_Stop();
+    return TIMER3_SetPeriodTicks(ticks);
+}
+
+uint32_t ADC_GetSampleRate(void)
+{
+    return Decim_IsActive() ? Decim_GetOutputRate() : TIMER3_GetSampleRate();
+}
+
+uint32_t ADC_GetSamplePeriodTicks(void)
+{
+    if(Decim_IsActive()) return TIMER3_GetPeriodTicks() * 2 * Decim_GetRatio();
+    return TIMER3_GetPeriodTicks();
+}
+
+/*!
+ * \brief   使能/禁用过采样-抽取模式
+ */
+void ADC_SetOversample(uint8_t enable)
+{
+    uint32_t sample_rate = ADC_GetSampleRate();
+    
+    adc_oversample_enable = enable ? 1 : 0;
+    ADC_SetSampleRate(sample_rate);
+}
+
+uint8_t ADC_GetOversample(void)
+{
+    return adc_oversample_enable;
+}
+
+/*!
+ * \brief   规划ADC采样率
+ * \param   signal_freq - 信号频率(Hz)
+ * \return  请求的采样率(Hz)
+ * \details 10Hz-2kHz保持10倍采样（与扫频/校准一致）；
+ *          20kHz时为200kHz，仍在双ADC并行模式的转换能力之内
+ */
+uint32_t ADC_PlanSampleRate(uint32_t signal_freq)
+{
+    uint32_t sample_rate = signal_freq * ADC_OVERSAMPLE_RATIO;
+    
+    if(sample_rate > ADC_MAX_SAMPLE_RATE) sample_rate = ADC_MAX_SAMPLE_RATE;
+    if(sample_rate == 0) sample_rate = ADC_OVERSAMPLE_RATIO;
+    
+    return sample_rate;
+}
+
+/*!
+ * \brief   规划记录长度（整周期截断）
+ * \param   sample_rate - 实际采样率(Hz)
+ * \param   signal_freq - 信号频率(Hz)
+ * \return  样本数
+ * \details 取缓冲区内能容纳的最大整周期数，TIMER3量化后的采样率不再是频率的整数倍，
+ *          按整周期截断可避免单频DFT在高频段的泄漏误差
+ */
+uint32_t ADC_PlanRecordLength(uint32_t sample_rate, uint32_t signal_freq)
+{
+    return ADC_PlanRecordLengthMax(sample_rate, signal_freq, ADC_BUFFER_SIZE);
+}
+
+uint32_t ADC_PlanRecordLengthMax(uint32_t sample_rate, uint32_t signal_freq, uint32_t max_length)
+{
+    if(sample_rate == 0 || signal_freq == 0) return max_length;
+    
+    uint32_t cycles = (uint32_t)(((uint64_t)max_length * signal_freq) / sample_rate);
+    if(cycles == 0) return max_length;
+    
+    uint32_t length = (uint32_t)(((uint64_t)cycles * sample_rate + signal_freq / 2) / signal_freq);
+    if(length > max_length) length = max_length;
+    if(length < ADC_MIN_RECORD_LENGTH) length = ADC_MIN_RECORD_LENGTH;
+    
+    return length;
+}
+
 /*!
  * \brief   从DMA缓冲区提取双通道ADC数据
  * \param   adc0_data - 输出：ADC0数据数组（输入参考）
@@ -25,6 +157,7 @@ extern uint32_t DDS_GetFrequency(void);
  */
 void ExtractADCData(uint16_t *adc0_data, uint16_t *adc1_data, uint32_t count)
 {
+    PROF_BEGIN(prof_t);
     for(uint32_t i = 0; i < count && i < ADC_BUFFER_SIZE; i++)
     {
         /* ⚠️ 实际硬件数据格式（实测验证）：
@@ -41,29 +174,152 @@ void ExtractADCData(uint16_t *adc0_data, uint16_t *adc1_data, uint32_t count)
         adc0_data[i] = (uint16_t)(adc_buffer[i] & 0xFFFF);           /* ADC0(PA6): 低16位 */
         adc1_data[i] = (uint16_t)((adc_buffer[i] >> 16) & 0xFFFF);   /* ADC1(PB1): 高16位（有削波）*/
     }
+    PROF_END(PROF_EXTRACT_ADC, prof_t);
+}
+
+/*!
+ * \brief   使能/禁用自动量程
+ */
+void ADC_SetAutoRange(uint8_t enable)
+{
+    adc_autorange_enable = enable ? 1 : 0;
+    if(!adc_autorange_enable) DDS_SetAmplitude(DDS_AMPLITUDE_FULL);
+}
+
+/*!
+ * \brief   查询自动量程是否使能
+ */
+uint8_t ADC_GetAutoRange(void)
+{
+    return adc_autorange_enable;
+}
+
+/*!
+ * \brief   统计DMA缓冲区中双通道的最大峰峰值和最大峰值（不拷贝数据）
+ */
+static void ADC_MeasureSwing(uint32_t count, uint16_t *pp, uint16_t *peak)
+{
+    uint16_t min0 = 4095, max0 = 0, min1 = 4095, max1 = 0;
+    
+    for(uint32_t i = 0; i < count && i < ADC_BUFFER_SIZE; i++)
+    {
+        uint16_t ch0 = (uint16_t)(adc_buffer[i] & 0xFFFF);
+        uint16_t ch1 = (uint16_t)((adc_buffer[i] >> 16) & 0xFFFF);
+        if(ch0 < min0) min0 = ch0;
+        if(ch0 > max0) max0 = ch0;
+        if(ch1 < min1) min1 = ch1;
+        if(ch1 > max1) max1 = ch1;
+    }
+    
+    uint16_t pp0 = max0 - min0;
+    uint16_t pp1 = max1 - min1;
+    *pp = (pp0 > pp1) ? pp0 : pp1;
+    *peak = (max0 > max1) ? max0 : max1;
+}
+
+/*!
+ * \brief   自动量程单步：测量当前摆幅并调整一次DDS幅度
+ * \param   signal_freq - 信号频率(Hz)
+ * \param   sample_rate - 实际采样率(Hz)
+ * \param   count - 记录长度（样本）
+ * \return  0=已在目标范围内（或已到幅度边界），否则为幅度改变后需等待的时间(ms)
+ * \details 统计adc_buffer中的摆幅后由ADC_AutoRangeAdjust调整
+ */
+uint32_t ADC_AutoRangeStep(uint32_t signal_freq, uint32_t sample_rate, uint32_t count)
+{
+    if(!adc_autorange_enable || signal_freq == 0 || sample_rate == 0)
+    {
+        return 0;
+    }
+    
+    uint16_t pp, peak;
+    ADC_MeasureSwing(count, &pp, &peak);
+    if(!ADC_AutoRangeAdjust(pp, peak)) return 0;
+    
+    /* 幅度变化后的等待：DUT稳定约5个周期 + 2个完整记录（DMA循环覆盖） */
+    uint32_t wait_ms = 5000 / signal_freq + (2 * count * 1000) / sample_rate + 2;
+    if(wait_ms > 500) wait_ms = 500;
+    return wait_ms;
+}
+
+/*!
+ * \brief   按摆幅调整一次DDS幅度
+ * \details 削波时幅度减半，否则按 目标/实测 比例缩放；
+ *          激励最大为满幅，低增益DUT只能恢复到满幅而无法进一步放大
+ */
+uint8_t ADC_AutoRangeAdjust(uint16_t pp, uint16_t peak)
+{
+    if(!adc_autorange_enable) return 0;
+    
+    uint16_t amplitude = DDS_GetAmplitude();
+    uint32_t next;
+    if(peak >= ADC_AUTORANGE_CLIP_LEVEL)
+    {
+        next = amplitude / 2;
+    }
+    else
+    {
+        if(pp == 0) pp = 1;
+        uint32_t low = ADC_AUTORANGE_TARGET_PP * (100 - ADC_AUTORANGE_TOLERANCE) / 100;
+        uint32_t high = ADC_AUTORANGE_TARGET_PP * (100 + ADC_AUTORANGE_TOLERANCE) / 100;
+        if(pp >= low && pp <= high) return 0;
+        
+        next = ((uint32_t)amplitude * ADC_AUTORANGE_TARGET_PP) / pp;
+    }
+    
+    if(next < DDS_AMPLITUDE_MIN) next = DDS_AMPLITUDE_MIN;
+    if(next > DDS_AMPLITUDE_FULL) next = DDS_AMPLITUDE_FULL;
+    if(next == amplitude) return 0;  /* 已到边界，无法继续调整 */
+    
+    DDS_SetAmplitude((uint16_t)next);
+    return 1;
+}
+
+/*!
+ * \brief   自动量程：调整DDS幅度使ADC峰峰值接近目标（阻塞）
+ * \param   signal_freq - 信号频率(Hz)
+ * \param   sample_rate - 实际采样率(Hz)
+ * \param   count - 记录长度（样本）
+ * \return  最终DDS幅度（Q8）
+ * \details 从当前幅度开始（相邻扫频点增益接近，通常1-2次收敛），
+ *          最多ADC_AUTORANGE_MAX_ITER步；后台扫频直接按步调用ADC_AutoRangeStep
+ */
+uint16_t ADC_AutoRange(uint32_t signal_freq, uint32_t sample_rate, uint32_t count)
+{
+    for(uint8_t iter = 0; iter < ADC_AUTORANGE_MAX_ITER; iter++)
+    {
+        uint32_t wait_ms = ADC_AutoRangeStep(signal_freq, sample_rate, count);
+        if(wait_ms == 0) break;
+        delay_ms(wait_ms);
+    }
+    
+    return DDS_GetAmplitude();
 }
 
 /*!
  * \brief   处理ADC数据并计算幅频/相频特性
+ * \param   adc0_data - ADC0数据缓存（PA6: 输入参考），至少ADC_BUFFER_SIZE点
+ * \param   adc1_data - ADC1数据缓存（PB1: 输出测量），至少ADC_BUFFER_SIZE点
  * \details 测量真实电路的频率响应（外部反馈）
  */
-void ProcessADCData(void)
+static void ProcessADCData_Record(uint16_t *adc0_data, uint16_t *adc1_data)
 {
-    static uint16_t adc0_data[512];  /* ADC0数据缓存（PA6: 输入参考）*/
-    static uint16_t adc1_data[512];  /* ADC1数据缓存（PB1: 输出测量）*/
-    
     /* 获取当前频率 */
     uint32_t current_freq = DDS_GetFrequency();
     
-    /* ⭐ 计算自适应采样率（严格10倍频率） */
-    uint32_t adaptive_sample_rate = current_freq * 10;
+    /* ⭐ 使用实际采样率（由FREQ命令按ADC_PlanSampleRate设置，过采样时为抽取输出速率） */
+    uint32_t adaptive_sample_rate = ADC_GetSampleRate();
+    uint32_t count = ADC_PlanRecordLength(adaptive_sample_rate, current_freq);
+    
+    /* 0. 自动量程：调整激励幅度使信号接近目标峰峰值 */
+    uint16_t amplitude = ADC_AutoRange(current_freq, adaptive_sample_rate, count);
     
     /* 1. 提取ADC数据（双通道反馈）*/
-    ExtractADCData(adc0_data, adc1_data, 512);
+    ExtractADCData(adc0_data, adc1_data, count);
     
     /* 2. 使用RMS能量法计算信号幅度（使用自适应采样率） */
-    float amp_ch1 = CalculateAmplitude_DFT(adc0_data, 512, adaptive_sample_rate, current_freq);
-    float amp_ch2 = CalculateAmplitude_DFT(adc1_data, 512, adaptive_sample_rate, current_freq);
+    float amp_ch1 = CalculateAmplitude_DFT(adc0_data, count, adaptive_sample_rate, current_freq);
+    float amp_ch2 = CalculateAmplitude_DFT(adc1_data, count, adaptive_sample_rate, current_freq);
     
     /* 转换为整数以便后续处理（ADC单位）*/
     uint16_t pp_ch1 = (uint16_t)amp_ch1;
@@ -88,9 +344,12 @@ void ProcessADCData(void)
         printf("[WARNING] Signal clipping! CH1=%d, CH2=%d ADC\r\n", pp_ch1, pp_ch2);
     }
     
-    /* 4. 转换为电压（mV，峰值幅度，RMS能量法） */
-    uint32_t voltage_ch1_mv = ((uint32_t)pp_ch1 * 3300) / 4096;
-    uint32_t voltage_ch2_mv = ((uint32_t)pp_ch2 * 3300) / 4096;
+    /* 4. 转换为电压（mV，峰值幅度，RMS能量法）
+     *    按DDS幅度折算回满幅激励，使不同量程下的K/K₁可直接比较；
+     *    H=K₁/K为比值，缩放在两通道中相互抵消
+     */
+    uint32_t voltage_ch1_mv = ((uint32_t)pp_ch1 * 3300 * DDS_AMPLITUDE_FULL) / (4096UL * amplitude);
+    uint32_t voltage_ch2_mv = ((uint32_t)pp_ch2 * 3300 * DDS_AMPLITUDE_FULL) / (4096UL * amplitude);
     
     /* 5. 计算幅频特性 H(ω) = K₁/K (CH1=输入K, CH2=输出K₁) */
     uint32_t H_x10000 = 0;
@@ -105,16 +364,17 @@ void ProcessADCData(void)
     }
     
     /* 6. 计算相位差（使用DFT方法，使用自适应采样率） */
-    int32_t phase_x100 = EstimatePhaseShift_Int(adc0_data, adc1_data, 512, adaptive_sample_rate, current_freq);
+    int32_t phase_x100 = EstimatePhaseShift_Int(adc0_data, adc1_data, count, adaptive_sample_rate, current_freq);
     
     /* 7. 计算直流偏移 */
-    uint16_t dc_ch1 = CalculateDCOffset(adc0_data, 512);
-    uint16_t dc_ch2 = CalculateDCOffset(adc1_data, 512);
+    uint16_t dc_ch1 = CalculateDCOffset(adc0_data, count);
+    uint16_t dc_ch2 = CalculateDCOffset(adc1_data, count);
     
     /* 8. 输出结果 */
     printf("========================================\r\n");
     printf("Mode: External Feedback Monitoring\r\n");
     printf("Frequency: %d Hz\r\n", DDS_GetFrequency());
+    printf("Excitation: %d/256 (auto-range %s)\r\n", amplitude, adc_autorange_enable ? "ON" : "OFF");
     printf("CH1 (PA6): %d.%02d mV (RMS×√2), ADC=%d, DC=%d\r\n", 
            voltage_ch1_mv/100, voltage_ch1_mv%100, pp_ch1, dc_ch1);
     printf("CH2 (PB1): %d.%02d mV (RMS×√2), ADC=%d, DC=%d\r\n", 
@@ -126,7 +386,18 @@ void ProcessADCData(void)
            (phase_x100<0)?"-":"", abs(phase_x100/100), abs(phase_x100%100));
     printf("========================================\r\n");
     
-    /* 9. 输出Web界面格式 (FREQ_RESP) */
+    /* 9. 输出Web界面格式 (FREQ_RESP)：二进制帧直接发送全部样本，无需降采样 */
+    if(Telemetry_IsBinary())
+    {
+        Telemetry_SendFreqResp(DDS_GetFrequency(),
+                               (float)voltage_ch1_mv / 1000.0f, (float)voltage_ch2_mv / 1000.0f,
+                               (float)H_x10000 / 10000.0f, (float)phase_x100 / 100.0f,
+                               (float)H_x10000 / 10000.0f, (float)phase_x100 / 100.0f, 0);
+        Telemetry_SendWaveform(DDS_GetFrequency(), adaptive_sample_rate, adc0_data, adc1_data, (uint16_t)count,
+                               TELEMETRY_SRC_MEASURE);
+        return;
+    }
+    
     printf("FREQ_RESP:%d,%d.%02d,%d.%02d,%d.%04d,%s%d.%02d\r\n", 
            DDS_GetFrequency(),
            voltage_ch1_mv/100, voltage_ch1_mv%100,        /* K (CH1输入，mV) */
@@ -148,6 +419,9 @@ void ProcessADCData(void)
         skip = 1;   /* 中高频及以上：全部发送，确保波形精确 */
     }
     
+    /* BAUD协商到高波特率后链路带宽足够，不再降采样 */
+    if(UART_GetBaudrate() >= 921600) skip = 1;
+    
     /* 调试：检查PA6数据质量 */
     uint16_t zero_count_pa6 = 0;
     uint16_t zero_count_pb1 = 0;
@@ -155,7 +429,7 @@ void ProcessADCData(void)
     uint16_t min_pa6 = 4095, max_pa6 = 0;
     uint16_t min_pb1 = 4095, max_pb1 = 0;
     
-    for(uint32_t i = 0; i < 512; i++) {
+    for(uint32_t i = 0; i < count; i++) {
         if(adc0_data[i] == 0) zero_count_pa6++;
         if(adc1_data[i] == 0) zero_count_pb1++;
         
@@ -172,8 +446,8 @@ void ProcessADCData(void)
     /* 如果发现异常，输出详细诊断信息 */
     if(zero_count_pa6 > 50 || repeat_count_pa6 > 300) {
         printf("[WARNING] PA6 Data Quality Issues:\r\n");
-        printf("  - Zeros: %d/512\r\n", zero_count_pa6);
-        printf("  - Repeats: %d/512\r\n", repeat_count_pa6);
+        printf("  - Zeros: %d/%d\r\n", zero_count_pa6, count);
+        printf("  - Repeats: %d/%d\r\n", repeat_count_pa6, count);
         printf("  - Range: %d - %d (pp=%d)\r\n", min_pa6, max_pa6, max_pa6 - min_pa6);
         printf("  - PB1 Range: %d - %d (pp=%d)\r\n", min_pb1, max_pb1, max_pb1 - min_pb1);
         printf("  - First 10 samples PA6: ");
@@ -191,19 +465,19 @@ void ProcessADCData(void)
     printf("WAVEFORM:%d,%d,", freq, adaptive_sample_rate);
     
     /* 发送输入信号波形（PA6）*/
-    for(uint32_t i = 0; i < 512; i += skip)
+    for(uint32_t i = 0; i < count; i += skip)
     {
         printf("%d", adc0_data[i]);
-        if(i + skip < 512) printf(",");
+        if(i + skip < count) printf(",");
     }
     
     printf("|");  /* 分隔符 */
     
     /* 发送输出信号波形（PB1）*/
-    for(uint32_t i = 0; i < 512; i += skip)
+    for(uint32_t i = 0; i < count; i += skip)
     {
         printf("%d", adc1_data[i]);
-        if(i + skip < 512) printf(",");
+        if(i + skip < count) printf(",");
     }
     
     printf("\r\n");
@@ -211,70 +485,291 @@ void ProcessADCData(void)
 }
 
 /*!
- * \brief   欠采样波形采集（独立功能）
+ * \brief   MEASURE命令：借用临时缓冲区后测量一次
+ */
+void ProcessADCData(void)
+{
+    uint16_t *adc0_data, *adc1_data;
+    
+    if(!Scratch_BorrowPair(ADC_BUFFER_SIZE, "MEASURE", &adc0_data, &adc1_data)) return;
+    ProcessADCData_Record(adc0_data, adc1_data);
+    Scratch_Release(adc0_data);
+}
+
+/*!
+ * \brief   欠采样波形采集 - 第一阶段：设置频率和采样率
  * \param   signal_freq - 信号频率(Hz)
- * \param   sample_rate - 采样率(Hz)，可以低于信号频率（欠采样）
- * \details 用于演示欠采样效果和波形可视化
+ * \param   sample_rate - 输入请求采样率，输出TIMER3量化后的实际采样率(Hz)
+ * \return  信号稳定 + DMA缓冲区填满所需等待时间(ms)
  */
-void CaptureWaveform(uint32_t signal_freq, uint32_t sample_rate)
+uint32_t CaptureWaveform_Begin(uint32_t signal_freq, uint32_t *sample_rate)
 {
     extern void DDS_SetFrequency(uint32_t freq_hz);
     extern void DDS_Start(void);
-    extern void TIMER3_SetSampleRate(uint32_t sample_rate_hz);
-    extern void delay_ms(uint32_t ms);
-    
-    static uint16_t capture_ch0[512];  /* PA6 输入信号 */
-    static uint16_t capture_ch1[512];  /* PB1 输出信号 */
     
     /* 1. 设置信号频率并启动DDS */
     DDS_SetFrequency(signal_freq);
     DDS_Start();
     
-    /* 2. 设置采样率 */
-    TIMER3_SetSampleRate(sample_rate);
+    /* 2. 设置采样率（后续计算与上报均使用量化后的实际采样率；欠采样需要混叠，不经过抽取） */
+    *sample_rate = ADC_SetSampleRateDirect(*sample_rate);
     
     /* 3. 等待信号稳定 + DMA缓冲区填满 */
     /* DMA循环模式下，等待足够时间让512个采样点采集完成 */
-    uint32_t capture_time_ms = (512 * 1000) / sample_rate;  /* 采集512点所需时间 */
+    uint32_t capture_time_ms = (512 * 1000) / *sample_rate;  /* 采集512点所需时间 */
     uint32_t settle_time_ms = 50;  /* 信号稳定时间 */
     
     /* 确保等待时间足够：采集时间 + 稳定时间 + 余量 */
     uint32_t total_wait = settle_time_ms + capture_time_ms + 100;
     if(total_wait < 200) total_wait = 200;  /* 最少200ms */
-    delay_ms(total_wait);
+    return total_wait;
+}
+
+/*!
+ * \brief   欠采样波形采集 - 第二阶段：提取并发送数据，恢复默认采样率
+ * \param   signal_freq - 信号频率(Hz)
+ * \param   sample_rate - CaptureWaveform_Begin返回的实际采样率(Hz)
+ * \details 用于演示欠采样效果和波形可视化
+ */
+void CaptureWaveform_Finish(uint32_t signal_freq, uint32_t sample_rate)
+{
+    uint16_t *capture_ch0;  /* PA6 输入信号 */
+    uint16_t *capture_ch1;  /* PB1 输出信号 */
+    
+    if(Scratch_BorrowPair(512, "CAPTURE", &capture_ch0, &capture_ch1))
+    {
+        /* 4. 提取数据（DMA已自动填充adc_buffer）*/
+        ExtractADCData(capture_ch0, capture_ch1, 512);
+        
+        /* 5. 计算实际采样时间 */
+        float total_time_ms = (512.0f * 1000.0f) / sample_rate;
+        
+        /* 6. 发送数据 */
+        if(Telemetry_IsBinary())
+        {
+            Telemetry_SendWaveform(signal_freq, sample_rate, capture_ch0, capture_ch1, 512, TELEMETRY_SRC_CAPTURE);
+        }
+        else
+        {
+            printf("RAWWAVE:%u,%u,%.2f\r\n", 
+                   (unsigned int)signal_freq, 
+                   (unsigned int)sample_rate,
+                   total_time_ms);
+            
+            /* 发送PA6数据 */
+            printf("CH0:");
+            for(uint32_t i = 0; i < 512; i++)
+            {
+                printf("%u", capture_ch0[i]);
+                if(i < 511) printf(",");
+            }
+            printf("\r\n");
+            
+            /* 发送PB1数据 */
+            printf("CH1:");
+            for(uint32_t i = 0; i < 512; i++)
+            {
+                printf("%u", capture_ch1[i]);
+                if(i < 511) printf(",");
+            }
+            printf("\r\n");
+        }
+        
+        Scratch_Release(capture_ch0);
+        printf("OK:CAPTURE_COMPLETE\r\n");
+    }
     
-    /* 4. 提取数据（DMA已自动填充adc_buffer）*/
-    ExtractADCData(capture_ch0, capture_ch1, 512);
+    /* 7. 恢复默认采样率（10kHz，过采样使能时恢复抽取），避免影响后续MEASURE功能 */
+    ADC_SetSampleRate(10000);
+}
+
+/*!
+ * \brief   快速交替采集：单节点以ADC_FAST_SAMPLE_RATE采集count个样本对
+ * \details 停止抽取，DMA单次传输到adc_buffer（期间不产生块中断），
+ *          之后恢复规则并行模式、循环DMA和原采样率。512对约0.6ms，直接轮询
+ */
+uint32_t ADC_FastCapture(uint8_t node, uint16_t *phase_a, uint16_t *phase_b, uint32_t count)
+{
+    uint32_t saved_rate = ADC_GetSampleRate();
+    uint8_t done;
+    
+    if(count > ADC_BUFFER_SIZE) count = ADC_BUFFER_SIZE;
+    
+    Decim_Stop();
+    ADC_Interleave_Start(node);
+    ADC_DMA_OneShot(adc_buffer, count);
+    adc_software_trigger_enable(ADC0, ADC_REGULAR_CHANNEL);    /* ADC1随ADC0启动 */
     
-    /* 5. 计算实际采样时间 */
-    float total_time_ms = (512.0f * 1000.0f) / sample_rate;
+    uint32_t start = Timebase_Micros();
+    while(!(done = ADC_DMA_OneShotDone()) && (Timebase_Micros() - start) < 10000);
     
-    /* 6. 发送数据 */
-    printf("RAWWAVE:%u,%u,%.2f\r\n", 
-           (unsigned int)signal_freq, 
-           (unsigned int)sample_rate,
-           total_time_ms);
+    ADC_Interleave_Stop();
     
-    /* 发送PA6数据 */
-    printf("CH0:");
-    for(uint32_t i = 0; i < 512; i++)
+    /* 高16位ADC1先转换（相位A），低16位ADC0滞后半个样本周期（相位B） */
+    for(uint32_t i = 0; i < count; i++)
     {
-        printf("%u", capture_ch0[i]);
-        if(i < 511) printf(",");
+        phase_a[i] = (uint16_t)((adc_buffer[i] >> 16) & 0x0FFF);
+        phase_b[i] = (uint16_t)(adc_buffer[i] & 0x0FFF);
     }
-    printf("\r\n");
     
-    /* 发送PB1数据 */
-    printf("CH1:");
-    for(uint32_t i = 0; i < 512; i++)
+    ADC_DMA_Restart(ADC_BUFFER_SIZE);
+    ADC_SetSampleRate(saved_rate);
+    
+    return done ? ADC_FAST_SAMPLE_RATE : 0;
+}
+
+/*!
+ * \brief   两个ADC相位间的失配（主机据此校正，交替采样的失配表现为fs/2附近的杂散）
+ * \param   offset - 输出：相位B均值 - 相位A均值（LSB）
+ * \param   gain   - 输出：相位B交流RMS / 相位A交流RMS
+ */
+void ADC_InterleaveMismatch(const uint16_t *phase_a, const uint16_t *phase_b, uint32_t count,
+                            float *offset, float *gain)
+{
+    float mean_a = 0.0f, mean_b = 0.0f;
+    float var_a = 0.0f, var_b = 0.0f;
+    
+    for(uint32_t i = 0; i < count; i++)
     {
-        printf("%u", capture_ch1[i]);
-        if(i < 511) printf(",");
+        mean_a += phase_a[i];
+        mean_b += phase_b[i];
+    }
+    mean_a /= count;
+    mean_b /= count;
+    
+    for(uint32_t i = 0; i < count; i++)
+    {
+        float da = phase_a[i] - mean_a;
+        float db = phase_b[i] - mean_b;
+        var_a += da * da;
+        var_b += db * db;
+    }
+    
+    *offset = mean_b - mean_a;
+    *gain = (var_a > 0.0f) ? sqrtf(var_b / var_a) : 1.0f;
+}
+
+uint8_t ADC_SetScanNodes(const uint8_t *channels, uint8_t count)
+{
+    if(count < 2 || count > ADC_SCAN_MAX_NODES) return 0;
+    
+    for(uint8_t i = 0; i < count; i++)
+    {
+        if(!ADC_Scan_ChannelValid(channels[i])) return 0;
+        for(uint8_t j = 0; j < i; j++)
+        {
+            if(channels[j] == channels[i]) return 0;
+        }
     }
-    printf("\r\n");
     
-    printf("OK:CAPTURE_COMPLETE\r\n");
+    for(uint8_t i = 0; i < count; i++) adc_scan_nodes[i] = channels[i];
+    adc_scan_count = count;
+    return 1;
+}
+
+uint8_t ADC_GetScanNodes(const uint8_t **channels)
+{
+    *channels = adc_scan_nodes;
+    return adc_scan_count;
+}
+
+/*!
+ * \brief   多节点扫描 - 第一阶段：切换为扫描序列并重新开始填充adc_buffer
+ * \details 每次触发转换R=⌈N/2⌉个rank，采样率上限降为ADC_MAX_SAMPLE_RATE/R；
+ *          扫描时DMA字不是两通道格式，直接用TIMER3采样（不经过抽取）
+ */
+uint32_t ScanNodes_Begin(uint32_t signal_freq, uint32_t *sample_rate, uint32_t *frames)
+{
+    uint32_t ranks = (adc_scan_count + 1) / 2;
+    uint32_t rate = ADC_PlanSampleRate(signal_freq);
+    
+    if(rate > ADC_MAX_SAMPLE_RATE / ranks) rate = ADC_MAX_SAMPLE_RATE / ranks;
     
-    /* 7. 恢复默认采样率（10kHz），避免影响后续MEASURE功能 */
-    TIMER3_SetSampleRate(10000);
+    adc_scan_saved_rate = ADC_GetSampleRate();
+    *sample_rate = ADC_SetSampleRateDirect(rate);
+    *frames = ADC_PlanRecordLengthMax(*sample_rate, signal_freq, ADC_BUFFER_SIZE / ranks);
+    
+    /* ADC禁用期间重新定位DMA，第一个字即为第一帧的rank 0 */
+    adc_scan_ranks = ADC_Scan_Config(adc_scan_nodes, adc_scan_count);
+    ADC_DMA_Restart(*frames * adc_scan_ranks);
+    ADC_Dual_Enable();
+    
+    uint32_t fill_ms = (*frames * 1000) / *sample_rate;
+    return fill_ms + 20;
+}
+
+/*!
+ * \brief   退出扫描，恢复两通道配置和原采样率
+ */
+void ScanNodes_Abort(void)
+{
+    if(adc_scan_ranks == 0) return;
+    
+    adc_scan_ranks = 0;
+    ADC_Scan_Stop();
+    ADC_DMA_Restart(ADC_BUFFER_SIZE);
+    ADC_SetSampleRate(adc_scan_saved_rate);
+}
+
+/*!
+ * \brief   多节点扫描 - 第二阶段：一次DFT求出所有节点，输出各节点及逐级的H和θ
+ */
+void ScanNodes_Finish(uint32_t signal_freq, uint32_t sample_rate, uint32_t frames)
+{
+    float amp[ADC_SCAN_MAX_NODES];
+    float phase[ADC_SCAN_MAX_NODES];
+    float amp_v[ADC_SCAN_MAX_NODES];
+    float h[ADC_SCAN_MAX_NODES];
+    float theta[ADC_SCAN_MAX_NODES];
+    uint8_t n = adc_scan_count;
+    uint16_t amplitude = DDS_GetAmplitude();
+    
+    /* 按16位看adc_buffer：每帧2R个样本，节点n在帧内第n个 */
+    CalculateFundamental_Multi((const uint16_t *)adc_buffer, 2UL * adc_scan_ranks, n,
+                               frames, sample_rate, signal_freq, amp, phase);
+    ScanNodes_Abort();
+    
+    if(amp[0] < 10.0f)
+    {
+        printf("[ERROR] Reference node CH%u too weak (%.1f ADC)\r\n", adc_scan_nodes[0], amp[0]);
+        printf("OK:SCAN_COMPLETE\r\n");
+        return;
+    }
+    
+    /* rank k比rank 0晚k×26个ADC时钟采样，折算为相位超前后扣除 */
+    float rank_rad = 2.0f * 3.14159265f * signal_freq * ADC_SCAN_RANK_CYCLES / (float)ADC_SCAN_CLOCK_HZ;
+    for(uint8_t i = 0; i < n; i++)
+    {
+        phase[i] -= rank_rad * (i / 2);
+        
+        amp_v[i] = amp[i] * 3.3f * DDS_AMPLITUDE_FULL / (4096.0f * amplitude);
+        h[i] = amp[i] / amp[0];
+        
+        float deg = (phase[i] - phase[0]) * 57.2957795f;
+        while(deg > 180.0f) deg -= 360.0f;
+        while(deg < -180.0f) deg += 360.0f;
+        theta[i] = deg;
+    }
+    
+    if(Telemetry_IsBinary())
+    {
+        Telemetry_SendScan(signal_freq, sample_rate, n, adc_scan_nodes, amp_v, h, theta);
+    }
+    else
+    {
+        /* NODE:序号,通道,幅度mV,H,θ(相对节点0),H级,θ级(相对前一节点) */
+        printf("SCAN:%u,%u,%u\r\n", (unsigned int)signal_freq, (unsigned int)sample_rate, (unsigned int)n);
+        for(uint8_t i = 0; i < n; i++)
+        {
+            float h_stage = (i > 0 && h[i - 1] > 0.0f) ? h[i] / h[i - 1] : 1.0f;
+            float theta_stage = (i > 0) ? theta[i] - theta[i - 1] : 0.0f;
+            while(theta_stage > 180.0f) theta_stage -= 360.0f;
+            while(theta_stage < -180.0f) theta_stage += 360.0f;
+            
+            printf("NODE:%u,%u,%.2f,%.4f,%.2f,%.4f,%.2f\r\n",
+                   (unsigned int)i, (unsigned int)adc_scan_nodes[i], amp_v[i] * 1000.0f,
+                   h[i], theta[i], h_stage, theta_stage);
+        }
+    }
+    printf("OK:SCAN_COMPLETE\r\n");
 }
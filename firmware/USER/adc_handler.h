@@ -11,8 +11,75 @@
 #include "gd32f10x.h"
 #include "../BSP/DMA/dma.h"  /* 使用dma.h中的ADC_BUFFER_SIZE定义 */
 
+/* 采集规划参数 */
+#define ADC_OVERSAMPLE_RATIO  10        /* 采样率 = 信号频率 × 10 */
+#define ADC_MAX_SAMPLE_RATE   200000UL  /* 6MHz ADC时钟，(13.5+12.5)周期 ≈ 230ksps，留余量 */
+#define ADC_MIN_RECORD_LENGTH 64        /* 最短记录长度（样本） */
+
+/* 自动量程参数（数字幅度缩放） */
+#define ADC_AUTORANGE_TARGET_PP  2800   /* 目标峰峰值（约68%满量程，留出谐波余量） */
+#define ADC_AUTORANGE_CLIP_LEVEL 4080   /* 任一通道峰值达到此值视为削波 */
+#define ADC_AUTORANGE_TOLERANCE  20     /* 目标容差（%） */
+#define ADC_AUTORANGE_MAX_ITER   4      /* 最大迭代次数 */
+
 /* 函数声明 */
 
+/*!
+ * \brief   设置有效采样率
+ * \param   sample_rate - 请求的采样率(Hz)
+ * \return  实际采样率(Hz)：过采样模式下为抽取输出速率，否则为TIMER3量化后的速率
+ * \details 过采样使能且请求值不高于DECIM_ADC_RATE/4时，ADC固定高速采样并抽取，
+ *          只改变抽取比而不再重编程TIMER3
+ */
+uint32_t ADC_SetSampleRate(uint32_t sample_rate);
+
+/*!
+ * \brief   直接设置TIMER3采样率（欠采样演示需要混叠，不经过抗混叠抽取）
+ */
+uint32_t ADC_SetSampleRateDirect(uint32_t sample_rate);
+
+/*!
+ * \brief   按72MHz时钟数精确设置TIMER3周期（等效时间采样，不经过抽取）
+ * \return  实际周期（时钟数）
+ */
+uint32_t ADC_SetSamplePeriod(uint32_t ticks);
+
+/*!
+ * \brief   当前有效采样率(Hz)，即adc_buffer中样本的速率
+ */
+uint32_t ADC_GetSampleRate(void);
+
+/*!
+ * \brief   当前有效采样周期（72MHz时钟数，过采样时为抽取输出周期），不受采样率取整影响
+ */
+uint32_t ADC_GetSamplePeriodTicks(void);
+
+/*!
+ * \brief   使能/禁用过采样-抽取模式（按当前采样率立即切换）
+ */
+void ADC_SetOversample(uint8_t enable);
+uint8_t ADC_GetOversample(void);
+
+/*!
+ * \brief   规划ADC采样率
+ * \param   signal_freq - 信号频率(Hz)
+ * \return  请求的采样率(Hz)，= 信号频率 × ADC_OVERSAMPLE_RATIO，不超过ADC_MAX_SAMPLE_RATE
+ */
+uint32_t ADC_PlanSampleRate(uint32_t signal_freq);
+
+/*!
+ * \brief   规划记录长度（整周期截断，减少DFT频谱泄漏）
+ * \param   sample_rate - 实际采样率(Hz)
+ * \param   signal_freq - 信号频率(Hz)
+ * \return  样本数（不超过ADC_BUFFER_SIZE）
+ */
+uint32_t ADC_PlanRecordLength(uint32_t sample_rate, uint32_t signal_freq);
+
+/*!
+ * \brief   规划不超过max_length的整周期记录长度（长记录用）
+ */
+uint32_t ADC_PlanRecordLengthMax(uint32_t sample_rate, uint32_t signal_freq, uint32_t max_length);
+
 /*!
  * \brief   从DMA缓冲区提取双通道ADC数据
  * \param   adc0_data - 输出：ADC0数据数组（输入参考）
@@ -21,6 +88,40 @@
  */
 void ExtractADCData(uint16_t *adc0_data, uint16_t *adc1_data, uint32_t count);
 
+/*!
+ * \brief   使能/禁用自动量程
+ * \param   enable - 1=使能（默认），0=固定满幅激励
+ */
+void ADC_SetAutoRange(uint8_t enable);
+
+/*!
+ * \brief   查询自动量程是否使能
+ */
+uint8_t ADC_GetAutoRange(void);
+
+/*!
+ * \brief   按已测得的摆幅调整一次DDS幅度（长记录/DDC用记录自身的最值）
+ * \param   pp   - 两通道中较大的峰峰值
+ * \param   peak - 两通道中较大的峰值
+ * \return  1=幅度已改变（需等待DUT稳定后重新测量），0=已收敛/已到边界/未使能
+ */
+uint8_t ADC_AutoRangeAdjust(uint16_t pp, uint16_t peak);
+
+/*!
+ * \brief   自动量程单步：测量一次摆幅并调整DDS幅度
+ * \return  0=已收敛，否则为幅度改变后需等待的时间(ms)
+ */
+uint32_t ADC_AutoRangeStep(uint32_t signal_freq, uint32_t sample_rate, uint32_t count);
+
+/*!
+ * \brief   自动量程：调整DDS幅度使ADC峰峰值接近目标
+ * \param   signal_freq - 信号频率(Hz)
+ * \param   sample_rate - 实际采样率(Hz)
+ * \param   count - 记录长度（样本）
+ * \return  最终DDS幅度（Q8，256=满幅），测量结果需按此折算回满幅激励
+ */
+uint16_t ADC_AutoRange(uint32_t signal_freq, uint32_t sample_rate, uint32_t count);
+
 /*!
  * \brief   处理ADC数据并计算幅频/相频特性
  * \details 测量真实电路的频率响应（外部反馈）
@@ -28,11 +129,45 @@ void ExtractADCData(uint16_t *adc0_data, uint16_t *adc1_data, uint32_t count);
 void ProcessADCData(void);
 
 /*!
- * \brief   欠采样波形采集（独立功能）
- * \param   signal_freq - 信号频率(Hz)
- * \param   sample_rate - 采样率(Hz)，可以低于信号频率（欠采样）
- * \details 用于演示欠采样效果和波形可视化
+ * \brief   欠采样波形采集（分两阶段，中间由调用者等待，不阻塞主循环）
+ * \details Begin设置频率和采样率并返回需等待的毫秒数，sample_rate改写为实际采样率；
+ *          Finish提取512点双通道数据发送（RAWWAVE文本或CAPTURE二进制帧）
+ */
+uint32_t CaptureWaveform_Begin(uint32_t signal_freq, uint32_t *sample_rate);
+void CaptureWaveform_Finish(uint32_t signal_freq, uint32_t sample_rate);
+
+/*!
+ * \brief   快速交替采集（单节点，两个ADC错开半个样本周期转换同一通道）
+ * \param   node    - 0=PA6，1=PB1
+ * \param   phase_a - 输出：ADC1样本（每对中先转换的一个）
+ * \param   phase_b - 输出：ADC0样本，合成顺序为a[0],b[0],a[1],b[1]...
+ * \param   count   - 样本对数（不超过ADC_BUFFER_SIZE）
+ * \return  合成采样率(Hz)，0=DMA超时
+ */
+uint32_t ADC_FastCapture(uint8_t node, uint16_t *phase_a, uint16_t *phase_b, uint32_t count);
+
+/*!
+ * \brief   计算交替采样两相位的偏置差和增益比
+ */
+void ADC_InterleaveMismatch(const uint16_t *phase_a, const uint16_t *phase_b, uint32_t count,
+                            float *offset, float *gain);
+
+/*!
+ * \brief   设置多节点扫描的节点（ADC通道，按信号链顺序，节点0为参考）
+ * \param   count - 2~ADC_SCAN_MAX_NODES，通道各不相同且不占用SPI引脚
+ * \return  1=成功，0=参数无效（保持原设置）
+ */
+uint8_t ADC_SetScanNodes(const uint8_t *channels, uint8_t count);
+uint8_t ADC_GetScanNodes(const uint8_t **channels);
+
+/*!
+ * \brief   多节点扫描（分两阶段，中间由调用者等待，不阻塞主循环）
+ * \details Begin切换为扫描序列，sample_rate/frames改写为实际采样率和每节点样本数，返回需等待的毫秒数；
+ *          Finish计算并输出各节点幅度及相对节点0/前一节点的H和θ，恢复两通道配置；
+ *          Abort只恢复配置（作业中止时）
  */
-void CaptureWaveform(uint32_t signal_freq, uint32_t sample_rate);
+uint32_t ScanNodes_Begin(uint32_t signal_freq, uint32_t *sample_rate, uint32_t *frames);
+void ScanNodes_Finish(uint32_t signal_freq, uint32_t sample_rate, uint32_t frames);
+void ScanNodes_Abort(void);
 
 #endif /* __ADC_HANDLER_H */
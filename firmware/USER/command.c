@@ -0,0 +1,1065 @@
+/*!
+ * \file    command.c
+ * \brief   串口命令分发
+ * \author  GD32 Bode Analyzer
+ * \version v1.0
+ */
+
+#include "command.h"
+#include "main.h"
+#include "adc_handler.h"
+#include "measurement.h"
+#include "telemetry.h"
+#include "stream.h"
+#include "scheduler.h"
+#include "profile.h"
+#include "monitor.h"
+#include "scratch.h"
+#include "record.h"
+#include "decimator.h"
+#include "ets.h"
+#include "track.h"
+#include "lockin.h"
+#include "../BSP/DDS/dds.h"
+#include "../BSP/ADC/adc.h"
+#include "../BSP/USART/usart.h"
+#include <stdio.h>
+#include <string.h>
+
+/* 命令名最大长度（不含参数） */
+#define CMD_NAME_SIZE   16
+
+/* FREQ */
+static void Cmd_Freq(const Cmd_Args_t *arg)
+{
+    uint32_t freq = arg->value[0];
+    if(freq >= DDS_MIN_FREQ && freq <= DDS_HS_MAX_FREQ)
+    {
+        DDS_SetFrequency(freq);  /* >2kHz自动切换到400kHz高速引擎 */
+        DDS_Start();  /* 自动启动DDS，确保有信号输出 */
+        
+        /* 设置自适应采样率（10倍频率，上限ADC_MAX_SAMPLE_RATE） */
+        ADC_SetSampleRate(ADC_PlanSampleRate(freq));
+        
+        printf("OK:FREQ:%uHz (DAC5311 -> PB1)\r\n", (unsigned int)freq);
+    }
+    else
+    {
+        printf("ERROR:FREQ_RANGE (%u-%uHz)\r\n", (unsigned int)DDS_MIN_FREQ, (unsigned int)DDS_HS_MAX_FREQ);
+    }
+}
+
+/* TYPE:SINE */
+static void Cmd_TypeSine(const Cmd_Args_t *arg)
+{
+    extern volatile SignalType_t g_signal_type;
+    g_signal_type = SIGNAL_TYPE_SINE;
+    printf("OK:TYPE:SINE\r\n");
+}
+
+/* TYPE:ECG */
+static void Cmd_TypeEcg(const Cmd_Args_t *arg)
+{
+    extern volatile SignalType_t g_signal_type;
+    extern void DDS_Start(void);
+    
+    g_signal_type = SIGNAL_TYPE_ECG;
+    DDS_Start();  /* 启动DDS输出ECG波形 */
+    
+    /* 设置ADC采样率：2500Hz (50Hz ECG × 50倍过采样) */
+    ADC_SetSampleRate(2500);
+    
+    Stream_Start();  /* 启用数据流 */
+    printf("OK:TYPE:ECG\r\n");
+}
+
+/* FREQ_TEST */
+static void Cmd_FreqTest(const Cmd_Args_t *arg)
+{
+    uint32_t freq = arg->value[0];
+    DDS_SetFrequency(freq);
+    ADC_SetSampleRate(ADC_PlanSampleRate(DDS_GetFrequency()));
+    /* 开启数据流 */
+    Stream_Start();
+    printf("OK:FREQ_TEST_STARTED:%uHz\r\n", (unsigned int)freq);
+}
+
+/* START */
+static void Cmd_Start(const Cmd_Args_t *arg)
+{
+    Stream_Start();
+    printf("OK:STREAM_STARTED\r\n");
+}
+
+/* STOP */
+static void Cmd_Stop(const Cmd_Args_t *arg)
+{
+    Stream_Stop();
+    printf("OK:STREAM_STOPPED\r\n");
+}
+
+/* STREAM:START */
+static void Cmd_StreamStart(const Cmd_Args_t *arg)
+{
+    Stream_Start();
+    printf("OK:STREAM_STARTED\r\n");
+}
+
+/* STREAM:STOP */
+static void Cmd_StreamStop(const Cmd_Args_t *arg)
+{
+    Stream_Stop();
+    printf("OK:STREAM_STOPPED\r\n");
+}
+
+/* STREAM:RATE */
+static void Cmd_StreamRate(const Cmd_Args_t *arg)
+{
+    uint32_t rate = arg->value[0];
+    if(rate <= ADC_MAX_SAMPLE_RATE)
+    {
+        Stream_SetRate(rate);
+        if(rate == 0) printf("OK:STREAM_RATE:AUTO\r\n");
+        else printf("OK:STREAM_RATE:%u\r\n", (unsigned int)rate);
+    }
+    else
+    {
+        printf("ERROR:STREAM_RATE (0-%u, 0=auto)\r\n", (unsigned int)ADC_MAX_SAMPLE_RATE);
+    }
+}
+
+/* STATUS */
+static void Cmd_Status(const Cmd_Args_t *arg)
+{
+    extern uint32_t DDS_GetFrequency(void);
+    extern uint8_t DDS_IsEnabled(void);
+    uint32_t freq = DDS_GetFrequency();
+    printf("\r\n========================================\r\n");
+    printf("  Bode Plot Analyzer Status\r\n");
+    printf("========================================\r\n");
+    printf("Frequency: %u Hz\r\n", (unsigned int)freq);
+    printf("DDS Engine: %s, %s\r\n", DDS_IsHighRate() ? "400kHz DMA" : "50kHz ISR",
+           DDS_GetInterpolation() ? "12-bit interpolated" : "8-bit table");
+    printf("Excitation: %u/256 (auto-range %s)\r\n", (unsigned int)DDS_GetAmplitude(), ADC_GetAutoRange() ? "ON" : "OFF");
+    printf("Signal Path: DDS -> SPI1 -> DAC5311 -> PB1\r\n");
+    if(Decim_IsActive())
+    {
+        printf("Sample Rate: %u Hz (ADC %u Hz, CIC R=%u, FIR /2)\r\n", (unsigned int)ADC_GetSampleRate(),
+               (unsigned int)DECIM_ADC_RATE, (unsigned int)Decim_GetRatio());
+    }
+    else
+    {
+        printf("Sample Rate: %u Hz (oversample %s)\r\n", (unsigned int)ADC_GetSampleRate(),
+               ADC_GetOversample() ? "ON, rate too high" : "OFF");
+    }
+    printf("DDS Enabled: %s\r\n", DDS_IsEnabled() ? "YES" : "NO");
+    Stream_Stats_t st;
+    Stream_GetStats(&st);
+    printf("Stream: %s (%u Hz, decimation %u, sent %u, dropped %u)\r\n", Stream_IsEnabled() ? "ON" : "OFF",
+           (unsigned int)st.rate, (unsigned int)st.decimation, (unsigned int)st.sent, (unsigned int)st.dropped);
+    printf("Job: %s\r\n", Measure_JobName(Measure_GetJob()));
+    if(Measure_GetDDC()) printf("Sweep Acquisition: DDC (fixed %u Hz, I/Q lock-in)\r\n", (unsigned int)MEASURE_DDC_SAMPLE_RATE);
+    else                 printf("Sweep Acquisition: adaptive (fs = f x %u per point)\r\n", (unsigned int)ADC_OVERSAMPLE_RATIO);
+    if(Measure_GetRecordLength()) printf("Record: %u samples (streamed)\r\n", (unsigned int)Measure_GetRecordLength());
+    else                          printf("Record: AUTO (%u-sample buffer)\r\n", (unsigned int)ADC_BUFFER_SIZE);
+    const uint8_t *scan_nodes;
+    uint8_t scan_count = ADC_GetScanNodes(&scan_nodes);
+    printf("Track Rate: %u Hz\r\n", (unsigned int)Track_GetRate());
+    printf("Lock-in Order: %u (%udB/oct)\r\n", (unsigned int)Lockin_GetOrder(), (unsigned int)(Lockin_GetOrder() * 6));
+    printf("Scan Nodes:");
+    for(uint8_t i = 0; i < scan_count; i++) printf(" CH%u", (unsigned int)scan_nodes[i]);
+    printf("\r\n");
+    Sched_Stats_t sc;
+    Sched_GetStats(&sc);
+    printf("Scheduler: idle %u, runs", (unsigned int)sc.idle);
+    for(uint32_t i = 0; i < SCHED_TASK_COUNT; i++)
+    {
+        printf(" %s=%u", Sched_TaskName((Sched_TaskId_t)i), (unsigned int)sc.runs[i]);
+    }
+    printf("\r\n");
+    Mon_Load_t load;
+    Monitor_GetLoad(&load);
+    printf("CPU Load: %u.%u%% (peak %u.%u%%)\r\n",
+           (unsigned int)(load.load_permille / 10), (unsigned int)(load.load_permille % 10),
+           (unsigned int)(load.peak_permille / 10), (unsigned int)(load.peak_permille % 10));
+    printf("Baud Rate: %u\r\n", (unsigned int)UART_GetBaudrate());
+    printf("Protocol: %s (wave encoding %s)\r\n", Telemetry_IsBinary() ? "BIN" : "TEXT",
+           Telemetry_WaveEncodingName(Telemetry_GetWaveEncoding()));
+    UART_TxStats_t tx;
+    UART_GetTxStats(&tx);
+    Scratch_Stats_t scr;
+    Scratch_GetStats(&scr);
+    printf("Scratch: %u/%u bytes (peak %u by %s, %u blocks, failures %u)\r\n",
+           (unsigned int)scr.used, (unsigned int)scr.size, (unsigned int)scr.high_water,
+           scr.high_water_owner, (unsigned int)scr.blocks, (unsigned int)scr.failures);
+    printf("TX Buffer: %u/%u (peak %u, waits %u, dropped %u)\r\n",
+           (unsigned int)tx.used, (unsigned int)UART_TX_BUFFER_SIZE, (unsigned int)tx.high_water,
+           (unsigned int)tx.overflows, (unsigned int)tx.dropped);
+    printf("========================================\r\n\r\n");
+    if(Telemetry_IsBinary()) Telemetry_SendStatus();
+}
+
+/* DEBUG */
+static void Cmd_Debug(const Cmd_Args_t *arg)
+{
+    extern uint8_t DDS_IsEnabled(void);
+    extern uint32_t TIMER2_GetInterruptCount(void);
+    extern uint32_t DDS_GetFrequency(void);
+    extern uint8_t DDS_GetSineIndex(void);
+    extern uint32_t DDS_GetPhaseAccumulator(void);
+    extern uint32_t DDS_GetPhaseIncrement(void);
+    
+    printf("\r\n======== BODE ANALYZER DEBUG ========\r\n");
+    printf("Frequency: %u Hz\r\n", (unsigned int)DDS_GetFrequency());
+    printf("DDS Enabled: %u (1=ON, 0=OFF)\r\n", (unsigned int)DDS_IsEnabled());
+    printf("Sine Index: %u / 255\r\n", (unsigned int)DDS_GetSineIndex());
+    printf("Phase Acc: 0x%08lX\r\n", (unsigned long)DDS_GetPhaseAccumulator());
+    printf("Phase Inc: 0x%08lX\r\n", (unsigned long)DDS_GetPhaseIncrement());
+    
+    /* TIMER2中断计数测试（DDS更新） */
+    uint32_t count1 = TIMER2_GetInterruptCount();
+    delay_ms(100);  /* 等待100ms */
+    uint32_t count2 = TIMER2_GetInterruptCount();
+    printf("\r\nTIMER2 DDS Update Test (100ms interval):\r\n");
+    printf("  Count1: %u\r\n", (unsigned int)count1);
+    printf("  Count2: %u\r\n", (unsigned int)count2);
+    printf("  Delta:  %u (should be ~5000 for 50kHz)\r\n", (unsigned int)(count2-count1));
+    
+    printf("\r\nDiagnosis:\r\n");
+    
+    /* 检查TIMER2中断 */
+    if((count2 - count1) < 100)
+    {
+        printf("❌ TIMER2 interrupt NOT running! (delta=%u, expected~5000)\r\n", (unsigned int)(count2-count1));
+        printf("   Check: 1) NVIC configuration\r\n");
+        printf("          2) Timer enable status\r\n");
+        printf("          3) Interrupt vector table\r\n");
+    }
+    else
+    {
+        printf("✓ TIMER2 DDS update is running! (delta=%u)\r\n", (unsigned int)(count2-count1));
+        printf("✓ PB1 should output sine wave via DAC5311\r\n");
+        printf("  - Frequency: %u Hz\r\n", (unsigned int)DDS_GetFrequency());
+        printf("  - Signal path: SPI1 -> DAC5311 -> Filter -> PB1\r\n");
+    }
+    
+    /* 检查DDS使能 */
+    if(DDS_IsEnabled() == 0)
+    {
+        printf("❌ DDS is DISABLED! Call DDS_Start() to enable.\r\n");
+    }
+    else
+    {
+        printf("✓ DDS is enabled.\r\n");
+    }
+    printf("========================================\r\n\r\n");
+}
+
+/* MEASURE */
+static void Cmd_Measure(const Cmd_Args_t *arg)
+{
+    extern void ProcessADCData(void);
+    printf("OK:MEASURING...\r\n");
+    if(Measure_GetRecordLength() || Measure_GetDDC())
+    {
+        Measure_StartPoint();   /* 长记录/DDC：后台累加，完成时输出结果 */
+        return;
+    }
+    ProcessADCData();
+}
+
+/* WAVE */
+static void Cmd_Wave(const Cmd_Args_t *arg)
+{
+    extern uint32_t adc_buffer[];
+    extern uint32_t DDS_GetFrequency(void);
+    uint32_t freq = DDS_GetFrequency();
+    uint32_t sr = ADC_GetSampleRate();  /* 实际采样率 */
+    
+    /* TRACK把DMA循环块缩短到每段2倍，缓冲区前64点大部分不再更新 */
+    if(Track_IsActive())
+    {
+        printf("ERROR:BUSY:%s (ABORT to cancel)\r\n", Measure_JobName(Measure_GetJob()));
+        return;
+    }
+    
+    /* 只发送64个点，足够显示几个周期，速度快 */
+    if(Telemetry_IsBinary())
+    {
+        uint16_t *wave_ch0, *wave_ch1;
+        if(!Scratch_BorrowPair(64, "WAVE", &wave_ch0, &wave_ch1)) return;
+        for(uint32_t i = 0; i < 64; i++)
+        {
+            wave_ch0[i] = (uint16_t)(adc_buffer[i] & 0xFFFF);
+            wave_ch1[i] = (uint16_t)((adc_buffer[i] >> 16) & 0xFFFF);
+        }
+        Telemetry_SendWaveform(freq, sr, wave_ch0, wave_ch1, 64, TELEMETRY_SRC_WAVE);
+        Scratch_Release(wave_ch0);
+        return;
+    }
+    printf("WAVE:%u,%u\r\n", (unsigned int)freq, (unsigned int)sr);
+    printf("D:");
+    for(uint32_t i = 0; i < 64; i++)
+    {
+        uint16_t ch0 = (uint16_t)(adc_buffer[i] & 0xFFFF);
+        uint16_t ch1 = (uint16_t)((adc_buffer[i] >> 16) & 0xFFFF);
+        printf("%u,%u", ch0, ch1);
+        if(i < 63) printf(";");
+    }
+    printf("\r\n");
+}
+
+/*!
+ * \brief   快速交替采集并输出（CAPTURE:FAST/WAVE:FAST共用）
+ * \param   count  - 样本对数（合成样本数为2×count）
+ * \param   source - TELEMETRY_SRC_CAPTURE/TELEMETRY_SRC_WAVE
+ */
+static void Cmd_FastCapture(uint32_t node, uint32_t count, uint8_t source)
+{
+    extern uint32_t DDS_GetFrequency(void);
+    uint32_t freq = DDS_GetFrequency();
+    uint16_t *phase_a, *phase_b;
+    float offset, gain;
+    
+    if(node > 1)
+    {
+        printf("ERROR:NODE (0=PA6, 1=PB1)\r\n");
+        return;
+    }
+    if(!Scratch_BorrowPair(count, "FASTCAP", &phase_a, &phase_b)) return;
+    
+    uint32_t sr = ADC_FastCapture((uint8_t)node, phase_a, phase_b, count);
+    if(sr == 0)
+    {
+        Scratch_Release(phase_a);
+        printf("ERROR:FASTCAP_TIMEOUT\r\n");
+        return;
+    }
+    ADC_InterleaveMismatch(phase_a, phase_b, count, &offset, &gain);
+    
+    if(Telemetry_IsBinary())
+    {
+        source |= TELEMETRY_SRC_INTERLEAVED;
+        if(node) source |= TELEMETRY_SRC_NODE_PB1;
+        Telemetry_SendWaveform(freq, sr, phase_a, phase_b, (uint16_t)count, source);
+    }
+    else
+    {
+        printf("FASTCAP:%u,%u,%u\r\n", (unsigned int)freq, (unsigned int)sr, (unsigned int)node);
+        printf("A:");
+        for(uint32_t i = 0; i < count; i++)
+        {
+            printf("%u", phase_a[i]);
+            if(i < count - 1) printf(",");
+        }
+        printf("\r\nB:");
+        for(uint32_t i = 0; i < count; i++)
+        {
+            printf("%u", phase_b[i]);
+            if(i < count - 1) printf(",");
+        }
+        printf("\r\n");
+    }
+    Scratch_Release(phase_a);
+    
+    printf("OK:FASTCAP:offset=%.2f,gain=%.5f\r\n", offset, gain);
+}
+
+/* WAVE:FAST */
+static void Cmd_WaveFast(const Cmd_Args_t *arg)
+{
+    Cmd_FastCapture(arg->value[0], 64, TELEMETRY_SRC_WAVE);
+}
+
+/* UWAVE */
+static void Cmd_Uwave(const Cmd_Args_t *arg)
+{
+    extern void DDS_SetFrequency(uint32_t freq_hz);
+    extern void DDS_Start(void);
+    extern void ADC_DMA_Restart(uint32_t sample_count);
+    extern uint32_t adc_buffer[];
+    
+    uint32_t signal_freq = arg->value[0];
+    uint32_t sample_rate = arg->value[1];  /* 真实欠采样率 */
+    
+    if(signal_freq >= DDS_MIN_FREQ && signal_freq <= DDS_HS_MAX_FREQ &&
+       sample_rate >= 10 && sample_rate <= ADC_MAX_SAMPLE_RATE)
+    {
+        DDS_SetFrequency(signal_freq);
+        DDS_Start();
+        
+        /* 设置欠采样率（需要混叠，不经过抽取） */
+        ADC_SetSampleRateDirect(sample_rate);
+        
+        /* 等待信号稳定 */
+        delay_ms(30);
+        
+        /* ⭐ 重启DMA，确保从缓冲区开头采集连续的64个新点 */
+        ADC_DMA_Restart(64);
+        
+        /* 等待64个采样点完成 */
+        uint32_t buffer_fill_ms = (64 * 1000) / sample_rate + 5;  /* 64点采集时间+小余量 */
+        if(buffer_fill_ms > 2000) buffer_fill_ms = 2000;  /* 最长2s */
+        delay_ms(buffer_fill_ms);
+        
+        /* 立即禁用DMA，防止循环模式覆盖数据 */
+        dma_channel_disable(DMA0, DMA_CH0);
+        
+        /* 复制数据到临时缓冲区（恢复循环采集会覆盖adc_buffer） */
+        uint16_t *local_ch0, *local_ch1;
+        uint8_t borrowed = Scratch_BorrowPair(64, "UWAVE", &local_ch0, &local_ch1);
+        for(uint32_t i = 0; borrowed && i < 64; i++)
+        {
+            uint32_t raw = adc_buffer[i];
+            local_ch0[i] = (uint16_t)(raw & 0xFFFF);
+            local_ch1[i] = (uint16_t)((raw >> 16) & 0xFFFF);
+        }
+        
+        /* 恢复DMA循环模式和默认采样率（过采样使能时恢复抽取） */
+        ADC_DMA_Restart(512);  /* 恢复512点循环采集 */
+        ADC_SetSampleRate(10000);
+        
+        if(!borrowed) return;
+        
+        /* 发送64点真实欠采样数据（双通道：PA6和PB1） */
+        if(Telemetry_IsBinary())
+        {
+            Telemetry_SendWaveform(signal_freq, sample_rate, local_ch0, local_ch1, 64, TELEMETRY_SRC_UWAVE);
+        }
+        else
+        {
+            printf("UWAVE:%u,%u\r\n", (unsigned int)signal_freq, (unsigned int)sample_rate);
+            printf("D:");
+            for(uint32_t i = 0; i < 64; i++)
+            {
+                printf("%u,%u", local_ch0[i], local_ch1[i]);
+                if(i < 63) printf(";");
+            }
+            printf("\r\n");
+        }
+        Scratch_Release(local_ch0);
+    }
+}
+
+/* SWEEP */
+static void Cmd_Sweep(const Cmd_Args_t *arg)
+{
+    printf("OK:STARTING_SWEEP\r\n");
+    AutoSweep();
+}
+
+/* ETS */
+static void Cmd_Ets(const Cmd_Args_t *arg)
+{
+    /* 参数：ETS:freq,averages */
+    uint32_t signal_freq = arg->value[0];
+    uint32_t averages = arg->value[1];
+    
+    if(signal_freq < DDS_MIN_FREQ || signal_freq > DDS_HS_MAX_FREQ ||
+       averages < 1 || averages > ETS_AVG_MAX)
+    {
+        printf("ERROR:ETS (freq:10-20000Hz, averages:1-%u)\r\n", (unsigned int)ETS_AVG_MAX);
+        return;
+    }
+    if(Stream_IsEnabled())
+    {
+        printf("ERROR:ETS (STOP the live stream first)\r\n");
+        return;
+    }
+    
+    printf("OK:ETS_START:freq=%uHz,eq_rate=%uHz\r\n",
+           (unsigned int)signal_freq, (unsigned int)(signal_freq * ETS_BINS));
+    Measure_StartEts(signal_freq, averages);
+}
+
+/* TRACK */
+static void Cmd_Track(const Cmd_Args_t *arg)
+{
+    uint32_t signal_freq = arg->value[0];
+    
+    if(signal_freq < DDS_MIN_FREQ || signal_freq > DDS_HS_MAX_FREQ)
+    {
+        printf("ERROR:TRACK (freq:%u-%uHz)\r\n", (unsigned int)DDS_MIN_FREQ, (unsigned int)DDS_HS_MAX_FREQ);
+        return;
+    }
+    Measure_StartTrack(signal_freq);
+}
+
+/* TRACK:RATE */
+static void Cmd_TrackRate(const Cmd_Args_t *arg)
+{
+    Track_SetRate(arg->value[0]);
+    printf("OK:TRACK:RATE:%uHz\r\n", (unsigned int)Track_GetRate());
+}
+
+/* LOCKIN */
+static void Cmd_Lockin(const Cmd_Args_t *arg)
+{
+    /* 参数：LOCKIN:freq,tc_ms */
+    uint32_t signal_freq = arg->value[0];
+    uint32_t tc_ms = arg->value[1];
+    
+    if(signal_freq < DDS_MIN_FREQ || signal_freq > DDS_HS_MAX_FREQ ||
+       tc_ms < LOCKIN_TC_MIN_MS || tc_ms > LOCKIN_TC_MAX_MS)
+    {
+        printf("ERROR:LOCKIN (freq:%u-%uHz, tc:%u-%ums)\r\n", (unsigned int)DDS_MIN_FREQ, (unsigned int)DDS_HS_MAX_FREQ,
+               (unsigned int)LOCKIN_TC_MIN_MS, (unsigned int)LOCKIN_TC_MAX_MS);
+        return;
+    }
+    Measure_StartLockin(signal_freq, tc_ms);
+}
+
+/* LOCKIN:ORDER */
+static void Cmd_LockinOrder(const Cmd_Args_t *arg)
+{
+    Lockin_SetOrder(arg->value[0]);
+    printf("OK:LOCKIN:ORDER:%u (%udB/oct)\r\n", (unsigned int)Lockin_GetOrder(), (unsigned int)(Lockin_GetOrder() * 6));
+}
+
+/* SCAN */
+static void Cmd_Scan(const Cmd_Args_t *arg)
+{
+    if(Stream_IsEnabled())
+    {
+        printf("ERROR:SCAN (STOP the live stream first)\r\n");
+        return;
+    }
+    printf("OK:STARTING_SCAN\r\n");
+    Measure_StartScan();
+}
+
+/* SCAN:NODES */
+static void Cmd_ScanNodes(const Cmd_Args_t *arg)
+{
+    uint8_t channels[ADC_SCAN_MAX_NODES + 1];
+    uint8_t count = 0;
+    const char *p = arg->text;
+    
+    /* 逗号分隔的ADC通道号，按信号链顺序 */
+    while(*p && count <= ADC_SCAN_MAX_NODES)
+    {
+        uint32_t ch = 0;
+        if(*p < '0' || *p > '9') break;
+        while(*p >= '0' && *p <= '9') ch = ch * 10 + (uint32_t)(*p++ - '0');
+        channels[count++] = (ch > 255) ? 255 : (uint8_t)ch;
+        if(*p == ',') p++;
+    }
+    
+    if(*p != '\0' || !ADC_SetScanNodes(channels, count))
+    {
+        printf("ERROR:SCAN:NODES (2-%u distinct channels 0-15, not 4/5/7)\r\n", (unsigned int)ADC_SCAN_MAX_NODES);
+        return;
+    }
+    
+    printf("OK:SCAN:NODES:");
+    for(uint8_t i = 0; i < count; i++)
+    {
+        printf("%u%s", (unsigned int)channels[i], (i < count - 1) ? "," : "\r\n");
+    }
+}
+
+/* CALIBRATE / CALIB / CALIBRATION */
+static void Cmd_Calibrate(const Cmd_Args_t *arg)
+{
+    printf("OK:STARTING_CALIBRATION\r\n");
+    AutoCalibration();
+}
+
+/* CAPTURE:FAST */
+static void Cmd_CaptureFast(const Cmd_Args_t *arg)
+{
+    Cmd_FastCapture(arg->value[0], ADC_BUFFER_SIZE, TELEMETRY_SRC_CAPTURE);
+}
+
+/* CAPTURE */
+static void Cmd_Capture(const Cmd_Args_t *arg)
+{
+    /* 参数：CAPTURE:freq,sample_rate */
+    uint32_t signal_freq = arg->value[0];
+    uint32_t sample_rate = arg->value[1];
+    
+    /* 参数检查 */
+    if(signal_freq >= DDS_MIN_FREQ && signal_freq <= DDS_HS_MAX_FREQ && 
+       sample_rate >= 10 && sample_rate <= ADC_MAX_SAMPLE_RATE)
+    {
+        printf("OK:CAPTURE_START:freq=%uHz,sr=%uHz\r\n", 
+               (unsigned int)signal_freq, (unsigned int)sample_rate);
+        Measure_StartCapture(signal_freq, sample_rate);
+    }
+    else
+    {
+        printf("ERROR:CAPTURE (freq:10-20000Hz, sample_rate:10-200000Hz)\r\n");
+        printf("Usage: CAPTURE:freq,sample_rate\r\n");
+        printf("Example: CAPTURE:100,500 (100Hz signal, 500Hz sampling)\r\n");
+    }
+}
+
+/* ABORT */
+static void Cmd_Abort(const Cmd_Args_t *arg)
+{
+    if(Measure_GetJob() == MEASURE_JOB_NONE)
+    {
+        printf("OK:ABORT:IDLE\r\n");
+        return;
+    }
+    Measure_Abort();
+}
+
+/* AUTORANGE */
+static void Cmd_Autorange(const Cmd_Args_t *arg)
+{
+    uint32_t enable = arg->value[0];
+    ADC_SetAutoRange((uint8_t)(enable ? 1 : 0));
+    printf("OK:AUTORANGE:%s\r\n", ADC_GetAutoRange() ? "ON" : "OFF");
+}
+
+/* DDC */
+static void Cmd_Ddc(const Cmd_Args_t *arg)
+{
+    uint32_t enable = arg->value[0];
+    Measure_SetDDC((uint8_t)(enable ? 1 : 0));
+    printf("OK:DDC:%s\r\n", Measure_GetDDC() ? "ON" : "OFF");
+}
+
+/* OVERSAMPLE */
+static void Cmd_Oversample(const Cmd_Args_t *arg)
+{
+    uint32_t enable = arg->value[0];
+    ADC_SetOversample((uint8_t)(enable ? 1 : 0));
+    printf("OK:OVERSAMPLE:%s (%u Hz)\r\n", ADC_GetOversample() ? "ON" : "OFF", (unsigned int)ADC_GetSampleRate());
+}
+
+/* BAUD */
+static void Cmd_Baud(const Cmd_Args_t *arg)
+{
+    uint32_t rate = arg->value[0];
+    uint32_t old_rate = UART_GetBaudrate();
+    
+    if(!UART_BaudValid(rate))
+    {
+        printf("ERROR:BAUD (%u-%u, error<2%%)\r\n", (unsigned int)UART_BAUD_MIN, (unsigned int)UART_BAUD_MAX);
+    }
+    else
+    {
+        printf("OK:BAUD:%u\r\n", (unsigned int)rate);
+        UART_Flush();
+        UART_SetBaudrate(rate);
+        
+        if(UART_WaitPing(UART_BAUD_PING_TIMEOUT_MS))
+        {
+            printf("PONG\r\n");
+            printf("OK:BAUD_LOCKED:%u\r\n", (unsigned int)rate);
+        }
+        else
+        {
+            UART_SetBaudrate(old_rate);
+            printf("WARN:BAUD_REVERTED:%u\r\n", (unsigned int)old_rate);
+        }
+    }
+}
+
+/* PING */
+static void Cmd_Ping(const Cmd_Args_t *arg)
+{
+    printf("PONG\r\n");
+}
+
+/* LOAD */
+static void Cmd_Load(const Cmd_Args_t *arg)
+{
+    Monitor_Report();
+}
+
+/* LOAD:AUTO */
+static void Cmd_LoadAuto(const Cmd_Args_t *arg)
+{
+    Monitor_SetAuto(arg->value[0] ? 1 : 0);
+    printf("OK:LOAD:AUTO:%s\r\n", Monitor_GetAuto() ? "ON" : "OFF");
+}
+
+/* LOAD:RESET */
+static void Cmd_LoadReset(const Cmd_Args_t *arg)
+{
+    Monitor_Reset();
+    printf("OK:LOAD:RESET\r\n");
+}
+
+/* PROF */
+static void Cmd_Prof(const Cmd_Args_t *arg)
+{
+    Prof_Report();
+}
+
+/* PROF:RESET */
+static void Cmd_ProfReset(const Cmd_Args_t *arg)
+{
+    Prof_Reset();
+    printf("OK:PROF:RESET\r\n");
+}
+
+/* PROTO:BIN */
+static void Cmd_ProtoBin(const Cmd_Args_t *arg)
+{
+    Telemetry_SetBinary(1);
+    printf("OK:PROTO:BIN\r\n");
+}
+
+/* PROTO:TEXT */
+static void Cmd_ProtoText(const Cmd_Args_t *arg)
+{
+    Telemetry_SetBinary(0);
+    printf("OK:PROTO:TEXT\r\n");
+}
+
+/* RECORD */
+static void Cmd_Record(const Cmd_Args_t *arg)
+{
+    uint32_t length = arg->value[0];
+    if(length != 0 && (length < RECORD_MIN_LENGTH || length > RECORD_MAX_LENGTH))
+    {
+        printf("ERROR:RECORD (0=auto, %u-%u)\r\n", (unsigned int)RECORD_MIN_LENGTH, (unsigned int)RECORD_MAX_LENGTH);
+        return;
+    }
+    
+    Measure_SetRecordLength(length);
+    if(length) printf("OK:RECORD:%u\r\n", (unsigned int)length);
+    else       printf("OK:RECORD:AUTO\r\n");
+}
+
+/* WAVEENC */
+static void Cmd_Waveenc(const Cmd_Args_t *arg)
+{
+    if(strcmp(arg->text, "RAW") == 0)         Telemetry_SetWaveEncoding(TELEMETRY_WAVE_RAW16);
+    else if(strcmp(arg->text, "PACK12") == 0) Telemetry_SetWaveEncoding(TELEMETRY_WAVE_PACK12);
+    else if(strcmp(arg->text, "DELTA") == 0)  Telemetry_SetWaveEncoding(TELEMETRY_WAVE_DELTA);
+    else if(strcmp(arg->text, "AUTO") == 0)   Telemetry_SetWaveEncoding(TELEMETRY_WAVE_AUTO);
+    else
+    {
+        printf("ERROR:WAVEENC (RAW/PACK12/DELTA/AUTO)\r\n");
+        return;
+    }
+    printf("OK:WAVEENC:%s\r\n", arg->text);
+}
+
+/* DDSINTERP */
+static void Cmd_Ddsinterp(const Cmd_Args_t *arg)
+{
+    uint32_t enable = arg->value[0];
+    DDS_SetInterpolation((uint8_t)(enable ? 1 : 0));
+    printf("OK:DDSINTERP:%s\r\n", DDS_GetInterpolation() ? "ON" : "OFF");
+}
+
+/* LED */
+static void Cmd_Led(const Cmd_Args_t *arg)
+{
+    extern void LED_Set_Mode(uint8_t mode);
+    uint32_t mode = arg->value[0];
+    if(mode <= 6)
+    {
+        LED_Set_Mode(mode);
+        const char *mode_names[] = {"OFF", "Flow", "Breath", "Blink", "Specific", "Rotate", "Alarm"};
+        printf("OK:LED_MODE:%s\r\n", mode_names[mode]);
+    }
+    else
+    {
+        printf("ERROR:LED_MODE (0-6)\r\n");
+    }
+}
+
+/* LED_BRIGHT */
+static void Cmd_LedBright(const Cmd_Args_t *arg)
+{
+    extern void LED_Set_Brightness(uint8_t brightness);
+    uint32_t brightness = arg->value[0];
+    if(brightness <= 100)
+    {
+        LED_Set_Brightness((uint8_t)brightness);
+        printf("OK:LED_BRIGHTNESS:%u%%\r\n", (unsigned int)brightness);
+    }
+    else
+    {
+        printf("ERROR:LED_BRIGHTNESS (0-100)\r\n");
+    }
+}
+
+/* LED_FREQ */
+static void Cmd_LedFreq(const Cmd_Args_t *arg)
+{
+    extern void LED_Set_Interval(uint16_t interval_ms);
+    uint32_t freq = arg->value[0];
+    if(freq >= 1 && freq <= 30000)
+    {
+        LED_Set_Interval((uint16_t)freq);
+        printf("OK:LED_INTERVAL:%ums\r\n", (unsigned int)freq);
+    }
+    else
+    {
+        printf("ERROR:LED_INTERVAL (1-30000ms)\r\n");
+    }
+}
+
+/* LED_MASK */
+static void Cmd_LedMask(const Cmd_Args_t *arg)
+{
+    extern void LED_Set_Specific_LED(uint8_t led_mask);
+    uint32_t mask = arg->value[0];
+    if(mask <= 0x1F)  // 5位掩码，最大31
+    {
+        LED_Set_Specific_LED((uint8_t)mask);
+        printf("OK:LED_MASK:0x%02X\r\n", (unsigned int)mask);
+    }
+    else
+    {
+        printf("ERROR:LED_MASK (0-31, 0x00-0x1F)\r\n");
+    }
+}
+
+/* HELP */
+static void Cmd_Help(const Cmd_Args_t *arg)
+{
+    printf("\r\n========================================\r\n");
+    printf("  Bode Plot Analyzer Commands\r\n");
+    printf("========================================\r\n");
+    printf("Frequency Control:\r\n");
+    printf("  FREQ:xxx      - Set frequency (10-20000Hz)\r\n");
+    printf("                  >2000Hz uses 400kHz DMA DDS engine\r\n");
+    printf("                  Example: FREQ:100\r\n\r\n");
+    printf("Output Control:\r\n");
+    printf("  START         - Start live waveform stream\r\n");
+    printf("  STOP          - Stop live waveform stream\r\n");
+    printf("  STREAM:RATE:x - Stream sample rate (0=auto, ~15 pts/cycle)\r\n\r\n");
+    printf("Measurement:\r\n");
+    printf("  MEASURE       - Measure H(ω) and θ(ω)\r\n");
+    printf("  SWEEP         - Auto sweep 10Hz-20kHz (380pts, 10Hz/100Hz step), METRICS at end\r\n");
+    printf("  RECORD:n      - Record length for MEASURE/SWEEP (0=auto, %u-%u)\r\n",
+           (unsigned int)RECORD_MIN_LENGTH, (unsigned int)RECORD_MAX_LENGTH);
+    printf("  DDC:0/1       - Fixed-rate I/Q downconversion for SWEEP/MEASURE\r\n");
+    printf("  TRACK:f       - Continuous H/theta at f from a sliding DFT window (ABORT stops)\r\n");
+    printf("  TRACK:RATE:x  - TRACK update rate (%u-%uHz, default %u)\r\n",
+           (unsigned int)TRACK_RATE_MIN, (unsigned int)TRACK_RATE_MAX, (unsigned int)TRACK_RATE_DEFAULT);
+    printf("  LOCKIN:f,tc   - Lock-in H/theta at f, tc=%u-%ums, sub-LSB outputs (ABORT stops)\r\n",
+           (unsigned int)LOCKIN_TC_MIN_MS, (unsigned int)LOCKIN_TC_MAX_MS);
+    printf("  LOCKIN:ORDER:n- Lock-in low-pass stages 1-%u (6dB/oct each, default %u)\r\n",
+           (unsigned int)LOCKIN_ORDER_MAX, (unsigned int)LOCKIN_ORDER_DEFAULT);
+    printf("  SCAN          - H/theta of every scan node vs node 0 and per stage, one pass\r\n");
+    printf("  SCAN:NODES:a,b,...- ADC channels along the chain (2-%u, default 6,9)\r\n", (unsigned int)ADC_SCAN_MAX_NODES);
+    printf("  CALIBRATE     - System calibration\r\n");
+    printf("  ABORT         - Cancel running SWEEP/CALIBRATE/CAPTURE/SCAN/ETS/TRACK/LOCKIN\r\n");
+    printf("  AUTORANGE:0/1 - Auto-scale excitation to target ADC swing\r\n");
+    printf("  DDSINTERP:0/1 - 12-bit interpolated sine / 8-bit table DDS\r\n");
+    printf("  OVERSAMPLE:0/1- Fixed 100kHz ADC + CIC/FIR decimation to the sample rate\r\n");
+    printf("  BAUD:rate     - Switch baud rate (host must send PING within 2s)\r\n");
+    printf("  PROTO:BIN     - Binary frames for FREQ_RESP/WAVEFORM/CALIB/STATUS/PROFILE/LOAD/TRACK/LOCKIN/METRICS\r\n");
+    printf("  PROTO:TEXT    - Text lines (default)\r\n");
+    printf("  WAVEENC:x     - Binary waveform encoding RAW/PACK12/DELTA/AUTO\r\n");
+    printf("  CAPTURE:f,sr  - Waveform capture (undersampling demo)\r\n");
+    printf("                  f=signal freq, sr=sample rate\r\n");
+    printf("                  Example: CAPTURE:100,500\r\n");
+    printf("  ETS:f,avg     - Equivalent-time single period, %u points (f x %u eq. rate)\r\n",
+           (unsigned int)ETS_BINS, (unsigned int)ETS_BINS);
+    printf("  CAPTURE:FAST:n- 1.7MHz interleaved dual-ADC capture of node n (0=PA6, 1=PB1)\r\n");
+    printf("  WAVE:FAST:n   - Same, 128 samples\r\n\r\n");
+    printf("Status:\r\n");
+    printf("  STATUS        - Query system status\r\n");
+    printf("  DEBUG         - Show debug info\r\n");
+    printf("  LOAD          - CPU load, IRQ latency/exec time (LOAD:RESET clears max)\r\n");
+    printf("  LOAD:AUTO:0/1 - Report LOAD every second\r\n");
+    printf("  PROF          - Cycle counts of profiled code (PROF:RESET clears)\r\n");
+    printf("  HELP          - Show this help\r\n\r\n");
+    printf("LED Control:\r\n");
+    printf("  LED:0-6       - Set LED mode\r\n");
+    printf("                  0=OFF, 1=Flow, 2=Breath, 3=Blink\r\n");
+    printf("                  4=Specific, 5=Rotate, 6=Alarm\r\n");
+    printf("  LED_BRIGHT:x  - Set brightness (0-100%%)\r\n");
+    printf("  LED_FREQ:x    - Set interval (1-30000ms)\r\n");
+    printf("  LED_MASK:x    - Set LED mask for Specific mode (0-31)\r\n");
+    printf("                  bit0=LED3, bit1=LED7, bit2=LED4\r\n");
+    printf("                  bit3=LED6, bit4=LED5\r\n\r\n");
+    printf("Hardware:\r\n");
+    printf("  Signal Out: PB1 (DAC5311 filtered output)\r\n");
+    printf("  ADC Input: PA6 (Input reference K)\r\n");
+    printf("  ADC Output: PB1 (DUT output K₁)\r\n");
+    printf("  LED: GPIOB (PB11-PB15)\r\n");
+    printf("========================================\r\n\r\n");
+}
+
+/* 命令表：按名称字典序排列（Cmd_Find二分查找） */
+static const Cmd_Entry_t cmd_table[] = {
+    {"ABORT",        CMD_ARG_NONE,  0,                Cmd_Abort,       "ABORT"},
+    {"AUTORANGE",    CMD_ARG_UINT,  0,                Cmd_Autorange,   "AUTORANGE:0/1"},
+    {"BAUD",         CMD_ARG_UINT,  0,                Cmd_Baud,        "BAUD:rate"},
+    {"CALIB",        CMD_ARG_NONE,  CMD_FLAG_ACQUIRE, Cmd_Calibrate,   "CALIB"},
+    {"CALIBRATE",    CMD_ARG_NONE,  CMD_FLAG_ACQUIRE, Cmd_Calibrate,   "CALIBRATE"},
+    {"CALIBRATION",  CMD_ARG_NONE,  CMD_FLAG_ACQUIRE, Cmd_Calibrate,   "CALIBRATION"},
+    {"CAPTURE",      CMD_ARG_UINT2, CMD_FLAG_ACQUIRE, Cmd_Capture,     "CAPTURE:freq,sample_rate"},
+    {"CAPTURE:FAST", CMD_ARG_UINT,  CMD_FLAG_ACQUIRE, Cmd_CaptureFast, "CAPTURE:FAST:0/1"},
+    {"DDC",          CMD_ARG_UINT,  CMD_FLAG_ACQUIRE, Cmd_Ddc,         "DDC:0/1"},
+    {"DDSINTERP",    CMD_ARG_UINT,  CMD_FLAG_ACQUIRE, Cmd_Ddsinterp,   "DDSINTERP:0/1"},
+    {"DEBUG",        CMD_ARG_NONE,  0,                Cmd_Debug,       "DEBUG"},
+    {"ETS",          CMD_ARG_UINT2, CMD_FLAG_ACQUIRE, Cmd_Ets,         "ETS:freq,averages"},
+    {"FREQ",         CMD_ARG_UINT,  CMD_FLAG_ACQUIRE, Cmd_Freq,        "FREQ:hz"},
+    {"FREQ_TEST",    CMD_ARG_UINT,  CMD_FLAG_ACQUIRE, Cmd_FreqTest,    "FREQ_TEST:hz"},
+    {"HELP",         CMD_ARG_NONE,  0,                Cmd_Help,        "HELP"},
+    {"LED",          CMD_ARG_UINT,  0,                Cmd_Led,         "LED:0-6"},
+    {"LED_BRIGHT",   CMD_ARG_UINT,  0,                Cmd_LedBright,   "LED_BRIGHT:0-100"},
+    {"LED_FREQ",     CMD_ARG_UINT,  0,                Cmd_LedFreq,     "LED_FREQ:1-30000"},
+    {"LED_MASK",     CMD_ARG_UINT,  0,                Cmd_LedMask,     "LED_MASK:0-31"},
+    {"LOAD",         CMD_ARG_NONE,  0,                Cmd_Load,        "LOAD"},
+    {"LOAD:AUTO",    CMD_ARG_UINT,  0,                Cmd_LoadAuto,    "LOAD:AUTO:0/1"},
+    {"LOAD:RESET",   CMD_ARG_NONE,  0,                Cmd_LoadReset,   "LOAD:RESET"},
+    {"LOCKIN",       CMD_ARG_UINT2, CMD_FLAG_ACQUIRE, Cmd_Lockin,      "LOCKIN:freq,tc_ms"},
+    {"LOCKIN:ORDER", CMD_ARG_UINT,  0,                Cmd_LockinOrder, "LOCKIN:ORDER:1-4"},
+    {"MEASURE",      CMD_ARG_NONE,  CMD_FLAG_ACQUIRE, Cmd_Measure,     "MEASURE"},
+    {"OVERSAMPLE",   CMD_ARG_UINT,  CMD_FLAG_ACQUIRE, Cmd_Oversample,  "OVERSAMPLE:0/1"},
+    {"PING",         CMD_ARG_NONE,  0,                Cmd_Ping,        "PING"},
+    {"PROF",         CMD_ARG_NONE,  0,                Cmd_Prof,        "PROF"},
+    {"PROF:RESET",   CMD_ARG_NONE,  0,                Cmd_ProfReset,   "PROF:RESET"},
+    {"PROTO:BIN",    CMD_ARG_NONE,  0,                Cmd_ProtoBin,    "PROTO:BIN"},
+    {"PROTO:TEXT",   CMD_ARG_NONE,  0,                Cmd_ProtoText,   "PROTO:TEXT"},
+    {"RECORD",       CMD_ARG_UINT,  CMD_FLAG_ACQUIRE, Cmd_Record,      "RECORD:0/1024-65536"},
+    {"SCAN",         CMD_ARG_NONE,  CMD_FLAG_ACQUIRE, Cmd_Scan,        "SCAN"},
+    {"SCAN:NODES",   CMD_ARG_TEXT,  CMD_FLAG_ACQUIRE, Cmd_ScanNodes,   "SCAN:NODES:ch,ch,..."},
+    {"START",        CMD_ARG_NONE,  0,                Cmd_Start,       "START"},
+    {"STATUS",       CMD_ARG_NONE,  0,                Cmd_Status,      "STATUS"},
+    {"STOP",         CMD_ARG_NONE,  0,                Cmd_Stop,        "STOP"},
+    {"STREAM:RATE",  CMD_ARG_UINT,  0,                Cmd_StreamRate,  "STREAM:RATE:hz (0=auto)"},
+    {"STREAM:START", CMD_ARG_NONE,  0,                Cmd_StreamStart, "STREAM:START"},
+    {"STREAM:STOP",  CMD_ARG_NONE,  0,                Cmd_StreamStop,  "STREAM:STOP"},
+    {"SWEEP",        CMD_ARG_NONE,  CMD_FLAG_ACQUIRE, Cmd_Sweep,       "SWEEP"},
+    {"TRACK",        CMD_ARG_UINT,  CMD_FLAG_ACQUIRE, Cmd_Track,       "TRACK:freq"},
+    {"TRACK:RATE",   CMD_ARG_UINT,  0,                Cmd_TrackRate,   "TRACK:RATE:hz"},
+    {"TYPE:ECG",     CMD_ARG_NONE,  CMD_FLAG_ACQUIRE, Cmd_TypeEcg,     "TYPE:ECG"},
+    {"TYPE:SINE",    CMD_ARG_NONE,  0,                Cmd_TypeSine,    "TYPE:SINE"},
+    {"UWAVE",        CMD_ARG_UINT2, CMD_FLAG_ACQUIRE, Cmd_Uwave,       "UWAVE:freq,sample_rate"},
+    {"WAVE",         CMD_ARG_NONE,  0,                Cmd_Wave,        "WAVE"},
+    {"WAVE:FAST",    CMD_ARG_UINT,  CMD_FLAG_ACQUIRE, Cmd_WaveFast,    "WAVE:FAST:0/1"},
+    {"WAVEENC",      CMD_ARG_TEXT,  0,                Cmd_Waveenc,     "WAVEENC:RAW/PACK12/DELTA/AUTO"},
+};
+
+#define CMD_TABLE_COUNT (sizeof(cmd_table) / sizeof(cmd_table[0]))
+
+/*!
+ * \brief   按名称二分查找命令
+ * \return  表项指针，未找到返回NULL
+ */
+static const Cmd_Entry_t *Cmd_Find(const char *name)
+{
+    int32_t lo = 0;
+    int32_t hi = (int32_t)CMD_TABLE_COUNT - 1;
+    
+    while(lo <= hi)
+    {
+        int32_t mid = (lo + hi) / 2;
+        int cmp = strcmp(name, cmd_table[mid].name);
+        if(cmp == 0) return &cmd_table[mid];
+        if(cmp < 0) hi = mid - 1;
+        else lo = mid + 1;
+    }
+    return NULL;
+}
+
+/*!
+ * \brief   解析十进制无符号整数
+ * \return  指向第一个非数字字符，没有数字时返回NULL
+ */
+static const char *Cmd_ParseUint(const char *str, uint32_t *value)
+{
+    const char *start = str;
+    uint32_t result = 0;
+    
+    while(*str >= '0' && *str <= '9')
+    {
+        result = result * 10 + (uint32_t)(*str - '0');
+        str++;
+    }
+    *value = result;
+    return (str == start) ? NULL : str;
+}
+
+/*!
+ * \brief   按表项参数类型解析参数
+ * \return  1=成功，0=格式错误
+ */
+static uint8_t Cmd_ParseArgs(const Cmd_Entry_t *cmd, const char *text, Cmd_Args_t *args)
+{
+    const char *p;
+    
+    args->value[0] = 0;
+    args->value[1] = 0;
+    args->text = text;
+    
+    switch(cmd->arg_type)
+    {
+    case CMD_ARG_UINT:
+        p = Cmd_ParseUint(text, &args->value[0]);
+        return (p != NULL && *p == '\0');
+    case CMD_ARG_UINT2:
+        p = Cmd_ParseUint(text, &args->value[0]);
+        if(p == NULL || *p != ',') return 0;
+        p = Cmd_ParseUint(p + 1, &args->value[1]);
+        return (p != NULL && *p == '\0');
+    case CMD_ARG_TEXT:
+        return (*text != '\0');
+    default:
+        return 1;
+    }
+}
+
+/*!
+ * \brief   执行一行命令
+ * \details 先按整行查找，找不到时逐段去掉最后一个':'之后的部分再查找，
+ *          因此"STREAM:RATE:500"匹配"STREAM:RATE"，参数为"500"
+ */
+void Command_Dispatch(const char *line)
+{
+    char name[CMD_NAME_SIZE];
+    const Cmd_Entry_t *cmd = NULL;
+    uint32_t len = strlen(line);
+    Cmd_Args_t args;
+    
+    while(len > 0)
+    {
+        if(len < CMD_NAME_SIZE)
+        {
+            memcpy(name, line, len);
+            name[len] = '\0';
+            cmd = Cmd_Find(name);
+            if(cmd != NULL) break;
+        }
+        /* 退到上一个':' */
+        while(len > 0 && line[len - 1] != ':') len--;
+        if(len > 0) len--;
+    }
+    
+    if(cmd == NULL)
+    {
+        printf("Unknown: %s (type HELP for commands)\r\n", line);
+        return;
+    }
+    
+    if((cmd->flags & CMD_FLAG_ACQUIRE) && Measure_GetJob() != MEASURE_JOB_NONE)
+    {
+        printf("ERROR:BUSY:%s (ABORT to cancel)\r\n", Measure_JobName(Measure_GetJob()));
+        return;
+    }
+    
+    if(!Cmd_ParseArgs(cmd, (line[len] == ':') ? line + len + 1 : line + len, &args))
+    {
+        printf("ERROR:ARGS %s\r\n", cmd->usage);
+        return;
+    }
+    cmd->handler(&args);
+}
+
+/*!
+ * \brief   调度器COMMAND任务：取出串口接收的完整命令行并执行
+ */
+void Command_Process(void)
+{
+    char line[UART_RX_LINE_SIZE];
+    
+    while(UART_ReadLine(line, sizeof(line)))
+    {
+        Command_Dispatch(line);
+    }
+}
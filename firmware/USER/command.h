@@ -0,0 +1,52 @@
+/*!
+ * \file    command.h
+ * \brief   串口命令分发
+ * \author  GD32 Bode Analyzer
+ * \version v1.0
+ * \details USART0中断只负责接收和分行，完整命令行由调度器COMMAND任务取出，
+ *          按命令表（名称字典序，二分查找）解析参数并执行
+ */
+
+#ifndef __COMMAND_H
+#define __COMMAND_H
+
+#include "gd32f10x.h"
+
+/* 命令参数类型 */
+typedef enum {
+    CMD_ARG_NONE = 0,   /* 无参数（多余参数忽略，兼容SWEEP:500等旧写法） */
+    CMD_ARG_UINT,       /* 一个无符号整数：CMD:123 */
+    CMD_ARG_UINT2,      /* 两个无符号整数：CMD:123,456 */
+    CMD_ARG_TEXT        /* 原样字符串：CMD:xxx */
+} Cmd_ArgType_t;
+
+/* 解析后的参数 */
+typedef struct {
+    uint32_t value[2];
+    const char *text;   /* ':'之后的原始参数（无参数时为空串） */
+} Cmd_Args_t;
+
+/* 命令标志 */
+#define CMD_FLAG_ACQUIRE    0x01    /* 改变DDS/ADC采集设置，后台测量作业运行时拒绝 */
+
+/* 命令表项 */
+typedef struct {
+    const char *name;                       /* 命令名（不含参数） */
+    Cmd_ArgType_t arg_type;
+    uint8_t flags;
+    void (*handler)(const Cmd_Args_t *arg);
+    const char *usage;                      /* 参数错误时的提示 */
+} Cmd_Entry_t;
+
+/*!
+ * \brief   执行一行命令
+ * \param   line - 以'\0'结尾的命令行（不含换行）
+ */
+void Command_Dispatch(const char *line);
+
+/*!
+ * \brief   调度器COMMAND任务：取出串口接收的完整命令行并执行
+ */
+void Command_Process(void);
+
+#endif /* __COMMAND_H */
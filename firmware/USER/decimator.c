@@ -0,0 +1,246 @@
+/*!
+ * \file    decimator.c
+ * \brief   过采样-抽取采集前端实现
+ * \author  GD32 Bode Analyzer
+ * \version v1.0
+ * \details CIC积分/梳状级用64位无符号数（模运算回绕，R=1000时增长30位也不会出错），
+ *          梳状输出按1/R³归一化为Q4（1/16 LSB），FIR系数Q15，输出仍为Q4。
+ *          两通道分两遍处理，每遍的积分器留在寄存器里；R=2（25kHz输出）时
+ *          每原始样本对约60周期，100kHz下约占CPU 8%，R越大FIR部分越少
+ */
+
+#include "decimator.h"
+#include "profile.h"
+#include "../BSP/DMA/dma.h"
+
+/* 外部TIMER函数 */
+extern uint32_t TIMER3_SetSampleRate(uint32_t sample_rate_hz);
+
+#define DECIM_FIR_HALF      ((DECIM_FIR_TAPS - 1) / 2)
+#define DECIM_MIDSCALE      2048
+
+/* 补偿FIR（Q15，对称，只存前半和中心）：通带0~0.2fs按1/sinc³提升，0.3fs以上衰减40dB以上；
+ * Kaiser窗(β=5)，直流增益32768。fs为CIC输出采样率 */
+static const int16_t decim_fir_coef[DECIM_FIR_HALF + 1] = {
+    -35, -2, 132, 7, -322, -19, 654, 45,
+    -1210, -109, 2173, 291, -4154, -1132, 10952, 18226
+};
+
+/* 单通道滤波器状态 */
+typedef struct {
+    uint64_t integ[DECIM_CIC_ORDER];
+    uint64_t comb[DECIM_CIC_ORDER];
+    int32_t fir[2 * DECIM_FIR_TAPS];    /* 双份延迟线，窗口总是连续的 */
+} Decim_Channel_t;
+
+/* DMA原始样本对（与adc_buffer格式相同） */
+static uint32_t decim_raw[DECIM_RAW_SIZE];
+
+/* 本次原始半块的Q4输出（adc_buffer格式），处理完即分发 */
+static uint32_t decim_out[DECIM_OUT_MAX];
+
+static Decim_Channel_t decim_ch[2];
+static volatile uint8_t decim_active = 0;
+static uint32_t decim_ratio = 0;
+static uint32_t decim_pre_shift = 0;    /* 归一化：先右移，再乘decim_gain后右移24位 */
+static uint32_t decim_gain = 0;
+
+/* 两通道共用的抽取相位（第二遍处理完后提交） */
+static uint32_t decim_phase = 0;        /* 当前CIC输出周期已积分的样本数 */
+static uint32_t decim_fir_pos = 0;      /* FIR延迟线写位置 */
+static uint32_t decim_fir_phase = 0;    /* FIR二抽一相位 */
+static uint32_t decim_out_pos = 0;      /* adc_buffer写位置 */
+static uint32_t decim_out_count = 0;    /* decim_out中的点数 */
+
+uint32_t Decim_PlanRatio(uint32_t sample_rate)
+{
+    uint32_t half_rate = DECIM_ADC_RATE / 2;
+
+    if(sample_rate == 0) return 0;
+
+    uint32_t ratio = half_rate / sample_rate;
+    if(ratio > DECIM_CIC_MAX) ratio = DECIM_CIC_MAX;
+
+    /* 取能整除的最大R，输出采样率为整数（DFT按整数采样率计算） */
+    while(ratio >= DECIM_CIC_MIN && (half_rate % ratio) != 0) ratio--;
+
+    return (ratio >= DECIM_CIC_MIN) ? ratio : 0;
+}
+
+/*!
+ * \brief   清零滤波器状态并计算归一化系数（调用者须已关中断）
+ */
+static void Decim_Reset(uint32_t ratio)
+{
+    uint64_t r3 = (uint64_t)ratio * ratio * ratio;
+    uint32_t log2_r3 = 0;
+
+    while((r3 >> (log2_r3 + 1)) != 0) log2_r3++;
+
+    /* 梳状输出 ≤ 2^11·R³：先右移到21位以内，增益落在2^19~2^20，精度约2ppm */
+    decim_pre_shift = (log2_r3 > 8) ? (log2_r3 - 8) : 0;
+    decim_gain = (uint32_t)(((1ULL << (decim_pre_shift + 4 + 24)) + r3 / 2) / r3);
+    decim_ratio = ratio;
+
+    for(uint32_t ch = 0; ch < 2; ch++)
+    {
+        for(uint32_t i = 0; i < DECIM_CIC_ORDER; i++)
+        {
+            decim_ch[ch].integ[i] = 0;
+            decim_ch[ch].comb[i] = 0;
+        }
+        for(uint32_t i = 0; i < 2 * DECIM_FIR_TAPS; i++)
+        {
+            decim_ch[ch].fir[i] = 0;
+        }
+    }
+    decim_phase = 0;
+    decim_fir_pos = 0;
+    decim_fir_phase = 0;
+}
+
+uint32_t Decim_Start(uint32_t ratio)
+{
+    if(ratio < DECIM_CIC_MIN) ratio = DECIM_CIC_MIN;
+    if(ratio > DECIM_CIC_MAX) ratio = DECIM_CIC_MAX;
+
+    if(decim_active && ratio == decim_ratio) return Decim_GetOutputRate();
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    Decim_Reset(ratio);
+    __set_PRIMASK(primask);
+
+    if(!decim_active)
+    {
+        TIMER3_SetSampleRate(DECIM_ADC_RATE);
+        ADC_DMA_Retarget(decim_raw, DECIM_RAW_SIZE);
+        decim_active = 1;
+        ADC_DMA_SetBlockIRQ(ADC_BLOCK_USER_DECIM, 1);
+    }
+
+    return Decim_GetOutputRate();
+}
+
+void Decim_Stop(void)
+{
+    if(!decim_active) return;
+
+    ADC_DMA_SetBlockIRQ(ADC_BLOCK_USER_DECIM, 0);
+    decim_active = 0;
+    ADC_DMA_Restart(ADC_BUFFER_SIZE);
+}
+
+uint8_t Decim_IsActive(void)
+{
+    return decim_active;
+}
+
+uint32_t Decim_GetRatio(void)
+{
+    return decim_active ? decim_ratio : 0;
+}
+
+uint32_t Decim_GetOutputRate(void)
+{
+    return decim_active ? DECIM_ADC_RATE / (2 * decim_ratio) : 0;
+}
+
+/*!
+ * \brief   FIR一个输出点（对称系数，乘法减半）
+ * \param   x - 最近DECIM_FIR_TAPS个Q4样本（连续）
+ * \return  Q4 ADC码（0~0xFFFF）
+ */
+static uint16_t Decim_Fir(const int32_t *x)
+{
+    int64_t acc = (int64_t)decim_fir_coef[DECIM_FIR_HALF] * x[DECIM_FIR_HALF];
+
+    for(uint32_t k = 0; k < DECIM_FIR_HALF; k++)
+    {
+        acc += (int64_t)decim_fir_coef[k] * (x[k] + x[DECIM_FIR_TAPS - 1 - k]);
+    }
+
+    /* Q4×Q15 → Q4，四舍五入 */
+    int32_t v = (int32_t)((acc + (1 << 14)) >> 15) + (DECIM_MIDSCALE << ADC_CODE_FRAC_BITS);
+    if(v < 0) v = 0;
+    if(v > 0xFFFF) v = 0xFFFF;
+    return (uint16_t)v;
+}
+
+/*!
+ * \brief   单通道处理一个原始块
+ * \param   shift - 0=ADC0（低16位），16=ADC1（高16位）
+ * \param   commit - 1=处理完后提交共用的抽取相位（第二遍）
+ */
+static void Decim_Channel(Decim_Channel_t *c, const uint32_t *raw, uint32_t count, uint32_t shift, uint8_t commit)
+{
+    uint64_t i0 = c->integ[0];
+    uint64_t i1 = c->integ[1];
+    uint64_t i2 = c->integ[2];
+    uint32_t phase = decim_phase;
+    uint32_t fir_pos = decim_fir_pos;
+    uint32_t fir_phase = decim_fir_phase;
+    uint32_t out_pos = decim_out_pos;
+    uint32_t out_n = 0;
+    uint16_t *out = (uint16_t *)adc_buffer + (shift ? 1 : 0);   /* 小端：低半字为ADC0 */
+    uint16_t *out_q4 = (uint16_t *)decim_out + (shift ? 1 : 0);
+
+    for(uint32_t i = 0; i < count; i++)
+    {
+        int32_t x = (int32_t)((raw[i] >> shift) & 0x0FFF) - DECIM_MIDSCALE;
+
+        /* 积分级（每个原始样本） */
+        i0 += (uint64_t)(int64_t)x;
+        i1 += i0;
+        i2 += i1;
+        if(++phase < decim_ratio) continue;
+        phase = 0;
+
+        /* 梳状级（每R个样本） */
+        uint64_t d0 = i2 - c->comb[0];
+        c->comb[0] = i2;
+        uint64_t d1 = d0 - c->comb[1];
+        c->comb[1] = d0;
+        uint64_t d2 = d1 - c->comb[2];
+        c->comb[2] = d1;
+
+        /* 除以R³，保留4位小数 */
+        int32_t y = (int32_t)((int64_t)d2 >> decim_pre_shift);
+        y = (int32_t)(((int64_t)y * decim_gain) >> 24);
+
+        c->fir[fir_pos] = y;
+        c->fir[fir_pos + DECIM_FIR_TAPS] = y;
+        if(++fir_pos >= DECIM_FIR_TAPS) fir_pos = 0;
+        if(++fir_phase < 2) continue;
+        fir_phase = 0;
+
+        uint16_t q4 = Decim_Fir(&c->fir[fir_pos]);
+        out_q4[2 * out_n++] = q4;
+        out[2 * out_pos] = ADC_Code12(q4, ADC_CODE_FRAC_BITS);
+        if(++out_pos >= ADC_BUFFER_SIZE) out_pos = 0;
+    }
+
+    c->integ[0] = i0;
+    c->integ[1] = i1;
+    c->integ[2] = i2;
+    decim_out_count = out_n;
+    if(commit)
+    {
+        decim_phase = phase;
+        decim_fir_pos = fir_pos;
+        decim_fir_phase = fir_phase;
+        decim_out_pos = out_pos;
+    }
+}
+
+void Decim_OnADCBlock(const uint32_t *raw, uint32_t count)
+{
+    if(!decim_active) return;
+
+    PROF_BEGIN(prof_t);
+    Decim_Channel(&decim_ch[0], raw, count, 0, 0);
+    Decim_Channel(&decim_ch[1], raw, count, 16, 1);
+    PROF_END(PROF_DECIMATE, prof_t);
+
+    if(decim_out_count) ADC_DMA_Dispatch(decim_out, decim_out_count, ADC_CODE_FRAC_BITS);
+}
@@ -0,0 +1,57 @@
+/*!
+ * \file    decimator.h
+ * \brief   过采样-抽取采集前端
+ * \author  GD32 Bode Analyzer
+ * \version v1.0
+ * \details 低频时fs=频率×10会把ADC触发降到100Hz，量化噪声和ADC本底噪声全部落在信号带内。
+ *          过采样模式下TIMER3固定为DECIM_ADC_RATE，DMA写入小的原始缓冲区，
+ *          半满/全满中断中经3阶CIC（抽取R）和补偿FIR（二抽一）降到目标采样率。
+ *          输出为Q4码（ADC_CODE_FRAC_BITS位小数），按adc_buffer格式（高16位ADC1，低16位ADC0）
+ *          直接分发给长记录/DDC、单频跟踪和锁相，带外噪声被滤除约10log10(2R)dB
+ *          （R=50时约20dB，约3位），这些小数位在累加结果中保留；
+ *          同时舍入为12位码循环写入adc_buffer，供WAVE/DSP函数等直接读缓冲区的使用者
+ */
+
+#ifndef __DECIMATOR_H
+#define __DECIMATOR_H
+
+#include "gd32f10x.h"
+
+#define DECIM_ADC_RATE      100000UL    /* 固定ADC采样率（72MHz/720，整数） */
+#define DECIM_CIC_ORDER     3
+#define DECIM_CIC_MIN       2           /* R<2时滤波收益太小，直接TIMER3采样 */
+#define DECIM_CIC_MAX       1000        /* 输出最低50Hz */
+#define DECIM_FIR_TAPS      31          /* CIC通带下垂补偿 + 二抽一抗混叠，对称 */
+#define DECIM_RAW_SIZE      64          /* 原始样本对DMA缓冲区（半满中断每32点） */
+#define DECIM_OUT_MAX       (DECIM_RAW_SIZE / (4 * DECIM_CIC_MIN) + 1)  /* 每个原始半块的最多输出点数 */
+
+/*!
+ * \brief   规划CIC抽取比
+ * \param   sample_rate - 请求的输出采样率(Hz)
+ * \return  R（0=不适合抽取）；输出采样率DECIM_ADC_RATE/(2R)为整数且不低于请求值
+ */
+uint32_t Decim_PlanRatio(uint32_t sample_rate);
+
+/*!
+ * \brief   启动/切换抽取（TIMER3固定为DECIM_ADC_RATE，DMA改写原始缓冲区）
+ * \param   ratio - Decim_PlanRatio的结果，与当前相同时不重置滤波器
+ * \return  实际输出采样率(Hz)
+ */
+uint32_t Decim_Start(uint32_t ratio);
+
+/*!
+ * \brief   停止抽取，DMA恢复直接写adc_buffer（TIMER3采样率由调用者设置）
+ */
+void Decim_Stop(void);
+
+uint8_t Decim_IsActive(void);
+uint32_t Decim_GetRatio(void);
+uint32_t Decim_GetOutputRate(void);
+
+/*!
+ * \brief   原始半缓冲区就绪（DMA0_CH0中断中调用）
+ * \details Q4输出交ADC_DMA_Dispatch分发给数据流/长记录等，12位码写入adc_buffer
+ */
+void Decim_OnADCBlock(const uint32_t *raw, uint32_t count);
+
+#endif /* __DECIMATOR_H */
@@ -0,0 +1,194 @@
+/*!
+ * \file    ets.c
+ * \brief   等效时间采样（ETS）波形重建实现
+ * \author  GD32 Bode Analyzer
+ * \version v1.0
+ * \details 累加器2×512个u16加512个u8（2.5KB静态RAM）；
+ *          中断中每样本对一次相位累加、移位取格和两次加法，200kHz时约占CPU 4%
+ */
+
+#include "ets.h"
+#include "../BSP/DMA/dma.h"
+
+typedef enum {
+    ETS_IDLE = 0,
+    ETS_RUNNING,
+    ETS_DONE
+} ETS_State_t;
+
+static volatile ETS_State_t ets_state = ETS_IDLE;
+static uint32_t ets_phase;          /* 信号相位（2^32=一周期），以第一个样本为0 */
+static uint32_t ets_phase_inc;      /* 每个采样周期前进的相位（取小数部分） */
+static uint32_t ets_remaining;
+
+static uint16_t ets_sum[2][ETS_BINS];
+static uint8_t ets_count[ETS_BINS];
+
+/*!
+ * \brief   每样本相位步进离最近的奇数个相位格有多远
+ * \return  偏差（相位格 × ETS_TIMER_CLOCK）
+ */
+static uint64_t ETS_StepDeviation(uint32_t signal_freq, uint32_t ticks)
+{
+    int64_t r = (int64_t)((((uint64_t)signal_freq * ticks) % ETS_TIMER_CLOCK) * ETS_BINS);
+    int64_t lo = r / ETS_TIMER_CLOCK;
+    uint64_t best = ~0ULL;
+    
+    if((lo & 1) == 0) lo--;         /* 不大于步进的奇数（可能为-1） */
+    if(lo >= 1) best = (uint64_t)(r - lo * ETS_TIMER_CLOCK);
+    if(lo + 2 < (int64_t)ETS_BINS)
+    {
+        uint64_t d = (uint64_t)((lo + 2) * ETS_TIMER_CLOCK - r);
+        if(d < best) best = d;
+    }
+    return best;
+}
+
+uint32_t ETS_PlanTicks(uint32_t signal_freq)
+{
+    if(signal_freq == 0) signal_freq = 1;
+    
+    /* 每样本前进q/ETS_BINS周期：q取使采样率不超过上限的最小奇数，采集最快 */
+    uint32_t q = (uint32_t)(((uint64_t)ETS_BINS * signal_freq + ETS_MAX_SAMPLE_RATE - 1) / ETS_MAX_SAMPLE_RATE);
+    if(q == 0) q = 1;
+    if((q & 1) == 0) q++;
+    
+    uint64_t den = (uint64_t)ETS_BINS * signal_freq;
+    uint64_t t0 = ((uint64_t)ETS_TIMER_CLOCK * q + den / 2) / den;
+    if(t0 < ETS_TIMER_CLOCK / ETS_MAX_SAMPLE_RATE) t0 = ETS_TIMER_CLOCK / ETS_MAX_SAMPLE_RATE;
+    if(t0 > 65536) t0 = 65536;
+    
+    /* 周期取整后步进偏离q格，每遍错开BINS×偏差格；向下（更慢）搜索偏差<1/BINS格的周期，
+     * 一遍即可覆盖所有格，找不到时取偏差最小者（靠多遍平均补齐） */
+    uint32_t best_ticks = (uint32_t)t0;
+    uint64_t best_dev = ETS_StepDeviation(signal_freq, best_ticks);
+    for(uint32_t t = (uint32_t)t0; t <= 65536 && t < t0 + 1024; t++)
+    {
+        uint64_t d = ETS_StepDeviation(signal_freq, t);
+        if(d < best_dev)
+        {
+            best_dev = d;
+            best_ticks = t;
+        }
+        if(best_dev * ETS_BINS < ETS_TIMER_CLOCK) break;
+    }
+    
+    return best_ticks;
+}
+
+uint32_t ETS_Start(uint32_t signal_freq, uint32_t ticks, uint32_t averages)
+{
+    if(averages < 1) averages = 1;
+    if(averages > ETS_AVG_MAX) averages = ETS_AVG_MAX;
+    
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    
+    /* 相位步进 = f×ticks/72MHz的小数部分，按2^32定点（f×ticks取模后再缩放，不丢整数部分以外的精度） */
+    uint64_t cycles_mod = ((uint64_t)signal_freq * ticks) % ETS_TIMER_CLOCK;
+    ets_phase_inc = (uint32_t)(((cycles_mod << 32) + ETS_TIMER_CLOCK / 2) / ETS_TIMER_CLOCK);
+    ets_phase = 0;
+    ets_remaining = ETS_BINS * averages;
+    for(uint32_t i = 0; i < ETS_BINS; i++)
+    {
+        ets_sum[0][i] = 0;
+        ets_sum[1][i] = 0;
+        ets_count[i] = 0;
+    }
+    ets_state = ETS_RUNNING;
+    
+    __set_PRIMASK(primask);
+    
+    ADC_DMA_SetBlockIRQ(ADC_BLOCK_USER_ETS, 1);
+    
+    /* 记录时长 + 等到第一个半缓冲区中断的时间 */
+    return (uint32_t)(((uint64_t)ets_remaining + ADC_BUFFER_SIZE / 2) * ticks / (ETS_TIMER_CLOCK / 1000)) + 1;
+}
+
+void ETS_Abort(void)
+{
+    ets_state = ETS_IDLE;
+    ADC_DMA_SetBlockIRQ(ADC_BLOCK_USER_ETS, 0);
+}
+
+uint8_t ETS_IsDone(void)
+{
+    return ets_state == ETS_DONE;
+}
+
+void ETS_OnADCBlock(const uint32_t *block, uint32_t count, uint32_t frac_bits)
+{
+    if(ets_state != ETS_RUNNING) return;
+    
+    uint32_t phase = ets_phase;
+    uint32_t inc = ets_phase_inc;
+    
+    if(count > ets_remaining) count = ets_remaining;
+    
+    for(uint32_t i = 0; i < count; i++)
+    {
+        uint32_t bin = phase >> (32 - ETS_BINS_LOG2);
+        phase += inc;
+        
+        /* 步进残差使个别格多得样本，满ETS_AVG_MAX后丢弃 */
+        if(ets_count[bin] >= ETS_AVG_MAX) continue;
+        ets_count[bin]++;
+        ets_sum[0][bin] += ADC_Code12(block[i] & 0xFFFF, frac_bits);   /* ADC0(PA6) */
+        ets_sum[1][bin] += ADC_Code12(block[i] >> 16, frac_bits);      /* ADC1(PB1) */
+    }
+    
+    ets_phase = phase;
+    ets_remaining -= count;
+    if(ets_remaining == 0)
+    {
+        ets_state = ETS_DONE;
+        ADC_DMA_SetBlockIRQ(ADC_BLOCK_USER_ETS, 0);
+    }
+}
+
+uint32_t ETS_GetWaveform(uint16_t *ch0, uint16_t *ch1)
+{
+    uint32_t filled = 0;
+    int32_t first = -1;
+    int32_t last = -1;
+    
+    if(ets_state != ETS_DONE) return 0;
+    
+    for(uint32_t i = 0; i < ETS_BINS; i++)
+    {
+        uint32_t n = ets_count[i];
+        if(n == 0) continue;
+        
+        ch0[i] = (uint16_t)((ets_sum[0][i] + n / 2) / n);
+        ch1[i] = (uint16_t)((ets_sum[1][i] + n / 2) / n);
+        
+        /* 与上一个有样本的格之间线性插值 */
+        if(last >= 0 && (int32_t)i - last > 1)
+        {
+            int32_t gap = (int32_t)i - last;
+            for(int32_t k = 1; k < gap; k++)
+            {
+                ch0[last + k] = (uint16_t)(ch0[last] + ((int32_t)ch0[i] - ch0[last]) * k / gap);
+                ch1[last + k] = (uint16_t)(ch1[last] + ((int32_t)ch1[i] - ch1[last]) * k / gap);
+            }
+        }
+        if(first < 0) first = (int32_t)i;
+        last = (int32_t)i;
+        filled++;
+    }
+    
+    /* 首尾跨周期边界的空格 */
+    if(filled > 0)
+    {
+        int32_t gap = first + (int32_t)ETS_BINS - last;
+        for(int32_t k = 1; k < gap; k++)
+        {
+            uint32_t idx = (uint32_t)(last + k) & (ETS_BINS - 1);
+            ch0[idx] = (uint16_t)(ch0[last] + ((int32_t)ch0[first] - ch0[last]) * k / gap);
+            ch1[idx] = (uint16_t)(ch1[last] + ((int32_t)ch1[first] - ch1[last]) * k / gap);
+        }
+    }
+    
+    ets_state = ETS_IDLE;
+    return filled;
+}
@@ -0,0 +1,55 @@
+/*!
+ * \file    ets.h
+ * \brief   等效时间采样（ETS）波形重建
+ * \author  GD32 Bode Analyzer
+ * \version v1.0
+ * \details 周期信号以略偏离其约数的采样率采集：相邻样本在信号周期内前进q/ETS_BINS周期
+ *          （q为奇数，与2的幂ETS_BINS互质），ETS_BINS个样本恰好遍历一周期内的全部相位点。
+ *          DMA半缓冲区中断中按相位累加器（TIMER3周期精确到72MHz时钟）把样本放入相位格并累加，
+ *          记录长度为ETS_BINS×平均次数，结束后每格取平均即得单周期波形，
+ *          等效采样率 = 信号频率×ETS_BINS（20kHz时10.24MS/s），实际ADC采样率不超过ETS_MAX_SAMPLE_RATE。
+ *          DDS与TIMER3同源72MHz，相位步进不随时间漂移
+ */
+
+#ifndef __ETS_H
+#define __ETS_H
+
+#include "gd32f10x.h"
+
+#define ETS_BINS_LOG2       9
+#define ETS_BINS            (1UL << ETS_BINS_LOG2)  /* 每周期相位点数 */
+#define ETS_AVG_MAX         16          /* 每格u16累加不溢出（16×4095） */
+#define ETS_MAX_SAMPLE_RATE 200000UL    /* 与ADC_MAX_SAMPLE_RATE一致 */
+#define ETS_TIMER_CLOCK     72000000UL
+
+/*!
+ * \brief   规划TIMER3周期
+ * \param   signal_freq - 信号频率(Hz)
+ * \return  TIMER3周期（72MHz时钟数），采样率72MHz/ticks不超过ETS_MAX_SAMPLE_RATE
+ */
+uint32_t ETS_PlanTicks(uint32_t signal_freq);
+
+/*!
+ * \brief   开始累加（从下一个DMA半缓冲区开始）
+ * \param   ticks    - 实际TIMER3周期
+ * \param   averages - 每个相位格的平均次数（1~ETS_AVG_MAX）
+ * \return  预计采集时间(ms)
+ */
+uint32_t ETS_Start(uint32_t signal_freq, uint32_t ticks, uint32_t averages);
+
+void ETS_Abort(void);
+uint8_t ETS_IsDone(void);
+
+/*!
+ * \brief   取出单周期波形（仅完成后有效），并回到空闲
+ * \param   ch0/ch1 - 输出：各ETS_BINS点，12位ADC码；没有样本的相位格按相邻格线性插值
+ * \return  有样本的相位格数
+ */
+uint32_t ETS_GetWaveform(uint16_t *ch0, uint16_t *ch1);
+
+/*!
+ * \brief   DMA0_CH0半传输/传输完成中断中调用
+ */
+void ETS_OnADCBlock(const uint32_t *block, uint32_t count, uint32_t frac_bits);
+
+#endif /* __ETS_H */
@@ -0,0 +1,222 @@
+/*!
+ * \file    lockin.c
+ * \brief   数字锁相放大实现
+ * \author  GD32 Bode Analyzer
+ * \version v1.0
+ * \details 每样本对的中断开销与长记录的正交累加相同；每个积分-清零周期（约1ms）
+ *          另做4次64位除法和4×级数次一阶低通更新：s += (x - y)·a，a为Q30。
+ *          每级状态s = y·2^30（比输入多30位小数），y = s>>30取舍入值送下一级；
+ *          若状态只保留整数位，每次更新的截断误差可达τ/周期个单位且偏向负值，
+ *          长τ下会吃掉亚LSB幅度（τ=30s时约0.1 LSB）
+ */
+
+#include "lockin.h"
+#include "../BSP/DMA/dma.h"
+#include "../BSP/DDS/dds.h"
+#include "../BSP/SINE/sine_table.h"
+#include <math.h>
+
+#ifndef PI
+#define PI 3.14159265358979323846f
+#endif
+
+#define LOCKIN_MIDSCALE     (2048 << ADC_CODE_FRAC_BITS)    /* Q4 */
+#define LOCKIN_QUARTER      0x40000000UL
+#define LOCKIN_TIMER_CLOCK  72000000UL
+
+/* 低通状态（Q30）舍入到输入单位 */
+#define LOCKIN_LPF_OUT(s)   (((s) + (1LL << 29)) >> 30)
+
+/* 低通输入 |x| ≤ 2^(11+Q4)·表幅度·2^FRAC，须小于2^31，(x - y)·a才不超出int64 */
+#if (11 + ADC_CODE_FRAC_BITS + 11 + LOCKIN_FRAC_BITS) > 31
+#error "LOCKIN_FRAC_BITS too large for the Q30 low-pass state"
+#endif
+
+/* n级相同一阶低通：等效噪声带宽×τ、99%建立时间/τ */
+static const float lockin_enbw_tau[LOCKIN_ORDER_MAX] = {0.25f, 0.125f, 0.09375f, 0.078125f};
+static const float lockin_settle_tau[LOCKIN_ORDER_MAX] = {4.61f, 6.64f, 8.41f, 10.05f};
+
+static uint32_t lockin_order = LOCKIN_ORDER_DEFAULT;
+static volatile uint8_t lockin_active = 0;
+
+/* 配置（开始时确定） */
+static uint32_t lockin_dump_len;        /* 积分-清零样本数（整周期） */
+static float lockin_dump_ms;            /* 积分-清零周期(ms) */
+static uint32_t lockin_tc_ms = 1;
+static uint32_t lockin_stages = LOCKIN_ORDER_DEFAULT;  /* 本次运行的低通级数（运行中改ORDER下次生效） */
+static int64_t lockin_alpha;            /* 低通系数，Q30 */
+
+/* 中断侧状态：下标0/1=ADC0正弦/余弦，2/3=ADC1正弦/余弦 */
+static uint32_t lockin_phase;
+static uint32_t lockin_phase_inc;
+static uint32_t lockin_n;
+static int64_t lockin_acc[4];
+static int64_t lockin_lpf[4][LOCKIN_ORDER_MAX];  /* Q30 */
+static uint32_t lockin_dumps;
+
+void Lockin_SetOrder(uint32_t order)
+{
+    if(order < 1) order = 1;
+    if(order > LOCKIN_ORDER_MAX) order = LOCKIN_ORDER_MAX;
+    lockin_order = order;
+}
+
+uint32_t Lockin_GetOrder(void)
+{
+    return lockin_order;
+}
+
+uint32_t Lockin_GetStages(void)
+{
+    return lockin_stages;
+}
+
+uint32_t Lockin_Start(uint32_t signal_freq, uint32_t sample_rate, uint32_t period_ticks, uint32_t tc_ms)
+{
+    if(signal_freq == 0) signal_freq = 1;
+    if(sample_rate == 0) sample_rate = 1;
+    if(period_ticks == 0) period_ticks = 1;
+
+    /* 积分-清零：整周期，且不短于LOCKIN_DUMP_US */
+    uint32_t cycles = (uint32_t)(((uint64_t)signal_freq * LOCKIN_DUMP_US + 999999) / 1000000);
+    if(cycles < 1) cycles = 1;
+    uint32_t dump_len = (uint32_t)(((uint64_t)sample_rate * cycles + signal_freq / 2) / signal_freq);
+    if(dump_len < 1) dump_len = 1;
+    float dump_ms = (float)dump_len * (float)period_ticks / (float)(LOCKIN_TIMER_CLOCK / 1000);
+
+    if(tc_ms < LOCKIN_TC_MIN_MS) tc_ms = LOCKIN_TC_MIN_MS;
+    if(tc_ms > LOCKIN_TC_MAX_MS) tc_ms = LOCKIN_TC_MAX_MS;
+    if((float)tc_ms < dump_ms) tc_ms = (uint32_t)ceilf(dump_ms);
+
+    /* 参考相位增量 = DDS每样本增量 × ADC周期/DDS周期（同一72MHz时钟，取模2^32） */
+    uint32_t phase_inc = (uint32_t)(((uint64_t)DDS_GetPhaseIncrement() * period_ticks) / DDS_GetPeriodTicks());
+
+    ADC_DMA_SetBlockIRQ(ADC_BLOCK_USER_LOCKIN, 0);
+
+    lockin_dump_len = dump_len;
+    lockin_dump_ms = dump_ms;
+    lockin_tc_ms = tc_ms;
+    lockin_stages = lockin_order;
+    lockin_alpha = (int64_t)((1.0f - expf(-dump_ms / (float)tc_ms)) * (float)(1UL << 30));
+    if(lockin_alpha < 1) lockin_alpha = 1;
+
+    lockin_phase = 0;
+    lockin_phase_inc = phase_inc;
+    lockin_n = 0;
+    lockin_dumps = 0;
+    for(uint32_t k = 0; k < 4; k++)
+    {
+        lockin_acc[k] = 0;
+        for(uint32_t j = 0; j < LOCKIN_ORDER_MAX; j++) lockin_lpf[k][j] = 0;
+    }
+    lockin_active = 1;
+
+    ADC_DMA_SetBlockIRQ(ADC_BLOCK_USER_LOCKIN, 1);
+    return tc_ms;
+}
+
+void Lockin_Stop(void)
+{
+    lockin_active = 0;
+    ADC_DMA_SetBlockIRQ(ADC_BLOCK_USER_LOCKIN, 0);
+}
+
+uint32_t Lockin_GetENBW_mHz(void)
+{
+    return (uint32_t)(lockin_enbw_tau[lockin_stages - 1] * 1000000.0f / (float)lockin_tc_ms);
+}
+
+uint32_t Lockin_GetSettleMs(void)
+{
+    return (uint32_t)(lockin_settle_tau[lockin_stages - 1] * (float)lockin_tc_ms + lockin_dump_ms);
+}
+
+void Lockin_GetResult(Lockin_Result_t *result)
+{
+    int64_t v[4];
+    uint32_t dumps;
+    float phase_rad[2];
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    for(uint32_t k = 0; k < 4; k++) v[k] = LOCKIN_LPF_OUT(lockin_lpf[k][lockin_stages - 1]);
+    dumps = lockin_dumps;
+    __set_PRIMASK(primask);
+
+    for(uint32_t ch = 0; ch < 2; ch++)
+    {
+        /* 低通输出 = A/2·表幅度·(cos, sin)，输入Q4再保留LOCKIN_FRAC_BITS位小数 */
+        float s = (float)v[2 * ch];
+        float c = (float)v[2 * ch + 1];
+        result->amplitude[ch] = 2.0f * sqrtf(s * s + c * c) /
+                                ((float)(1UL << (ADC_CODE_FRAC_BITS + LOCKIN_FRAC_BITS)) * SINE_QUARTER_PEAK);
+        phase_rad[ch] = atan2f(s, c);
+    }
+
+    /* 相位差PA6 - PB1，归一化到±180° */
+    float phase_deg = (phase_rad[0] - phase_rad[1]) * 18000.0f / PI;
+    while(phase_deg > 18000.0f) phase_deg -= 36000.0f;
+    while(phase_deg < -18000.0f) phase_deg += 36000.0f;
+    result->phase_x100 = (int32_t)phase_deg;
+    result->elapsed_ms = (uint32_t)((float)dumps * lockin_dump_ms);
+}
+
+/*!
+ * \brief   一个积分-清零周期结束：求平均后送入低通级联
+ */
+static void Lockin_Dump(void)
+{
+    for(uint32_t k = 0; k < 4; k++)
+    {
+        int64_t x = (lockin_acc[k] * (1 << LOCKIN_FRAC_BITS)) / (int64_t)lockin_dump_len;
+        for(uint32_t j = 0; j < lockin_stages; j++)
+        {
+            /* |x| < 2^31，a < 2^30，乘积不超出int64 */
+            lockin_lpf[k][j] += (x - LOCKIN_LPF_OUT(lockin_lpf[k][j])) * lockin_alpha;
+            x = LOCKIN_LPF_OUT(lockin_lpf[k][j]);
+        }
+        lockin_acc[k] = 0;
+    }
+    lockin_dumps++;
+}
+
+void Lockin_OnADCBlock(const uint32_t *block, uint32_t count, uint32_t frac_bits)
+{
+    if(!lockin_active) return;
+
+    uint32_t up = ADC_CODE_FRAC_BITS - frac_bits;
+    uint32_t phase = lockin_phase;
+    uint32_t inc = lockin_phase_inc;
+    uint32_t n = lockin_n;
+    int64_t s0 = lockin_acc[0], c0 = lockin_acc[1];
+    int64_t s1 = lockin_acc[2], c1 = lockin_acc[3];
+
+    for(uint32_t i = 0; i < count; i++)
+    {
+        uint32_t v = block[i];
+        int32_t xa = (int32_t)((v & 0xFFFF) << up) - LOCKIN_MIDSCALE;  /* ADC0(PA6) */
+        int32_t xb = (int32_t)((v >> 16) << up) - LOCKIN_MIDSCALE;     /* ADC1(PB1) */
+        int32_t sn = Sine_Quarter(phase);
+        int32_t cs = Sine_Quarter(phase + LOCKIN_QUARTER);
+
+        s0 += xa * sn;
+        c0 += xa * cs;
+        s1 += xb * sn;
+        c1 += xb * cs;
+        phase += inc;
+
+        if(++n >= lockin_dump_len)
+        {
+            lockin_acc[0] = s0;  lockin_acc[1] = c0;
+            lockin_acc[2] = s1;  lockin_acc[3] = c1;
+            Lockin_Dump();
+            s0 = c0 = s1 = c1 = 0;
+            n = 0;
+        }
+    }
+
+    lockin_phase = phase;
+    lockin_n = n;
+    lockin_acc[0] = s0;  lockin_acc[1] = c0;
+    lockin_acc[2] = s1;  lockin_acc[3] = c1;
+}
@@ -0,0 +1,73 @@
+/*!
+ * \file    lockin.h
+ * \brief   数字锁相放大（LOCKIN）
+ * \author  GD32 Bode Analyzer
+ * \version v1.0
+ * \details 扫频/MEASURE在通道摆幅低于5~10个ADC码时判为信号过弱并放弃，
+ *          衰减型DUT的输出常常就在这个量级。锁相模式中两通道与参考正弦/余弦相乘，
+ *          参考相位增量由DDS实际相位增量按72MHz时钟数换算（DDS与TIMER3同源，参考与激励
+ *          频率严格一致，长时间常数下也不旋转）；乘积先按整周期积分-清零（滤除2f分量），
+ *          再经LOCKIN_ORDER_MAX级以内的一阶定点低通级联，时间常数可选，
+ *          ADC噪声作为抖动，幅度分辨率可远低于1 LSB
+ */
+
+#ifndef __LOCKIN_H
+#define __LOCKIN_H
+
+#include "gd32f10x.h"
+
+#define LOCKIN_ORDER_MAX        4       /* 低通级数（每级6dB/oct） */
+#define LOCKIN_ORDER_DEFAULT    2
+#define LOCKIN_TC_MIN_MS        1
+#define LOCKIN_TC_MAX_MS        30000
+#define LOCKIN_DUMP_US          1000    /* 积分-清零至少1ms（整周期），低通在此速率下运行 */
+#define LOCKIN_FRAC_BITS        4       /* 积分-清零输出在Q4输入上再保留4位小数（共1/256 LSB·表幅度） */
+
+/* 锁相结果（下标0=ADC0/PA6输入参考，1=ADC1/PB1输出） */
+typedef struct {
+    float amplitude[2];         /* 基波峰值幅度（ADC码，可小于1） */
+    int32_t phase_x100;         /* 相位差CH0-CH1（度×100，与Record_Result_t一致） */
+    uint32_t elapsed_ms;        /* 开始累加以来的时间 */
+} Lockin_Result_t;
+
+/*!
+ * \brief   设置/读取低通级数（1~LOCKIN_ORDER_MAX，下次LOCKIN生效）
+ */
+void Lockin_SetOrder(uint32_t order);
+uint32_t Lockin_GetOrder(void);
+uint32_t Lockin_GetStages(void);     /* 当前（最近一次）运行的级数 */
+
+/*!
+ * \brief   开始锁相（从下一个DMA半缓冲区开始）
+ * \param   signal_freq  - 信号频率(Hz)，只用于选择积分-清零长度
+ * \param   sample_rate  - 实际ADC采样率(Hz)
+ * \param   period_ticks - 实际ADC采样周期（72MHz时钟数）
+ * \param   tc_ms        - 时间常数(ms)，不短于积分-清零周期
+ * \return  实际时间常数(ms)
+ */
+uint32_t Lockin_Start(uint32_t signal_freq, uint32_t sample_rate, uint32_t period_ticks, uint32_t tc_ms);
+
+void Lockin_Stop(void);
+
+/*!
+ * \brief   等效噪声带宽（mHz）：n级相同一阶低通，1/(4τ)、1/(8τ)、3/(32τ)、5/(64τ)
+ */
+uint32_t Lockin_GetENBW_mHz(void);
+
+/*!
+ * \brief   阶跃响应到99%的建立时间（ms）：4.6τ、6.6τ、8.4τ、10.0τ，另加一个积分-清零周期
+ */
+uint32_t Lockin_GetSettleMs(void);
+
+/*!
+ * \brief   读取低通输出（随时可读）
+ */
+void Lockin_GetResult(Lockin_Result_t *result);
+
+/*!
+ * \brief   DMA0_CH0半传输/传输完成中断中调用
+ * \param   frac_bits - 码值小数位（0或ADC_CODE_FRAC_BITS），内部统一为Q4累加
+ */
+void Lockin_OnADCBlock(const uint32_t *block, uint32_t count, uint32_t frac_bits);
+
+#endif /* __LOCKIN_H */
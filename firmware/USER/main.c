@@ -29,6 +29,10 @@
 #include "signal_processing.h"
 #include "adc_handler.h"
 #include "measurement.h"
+#include "scheduler.h"
+#include "../BSP/TIMEBASE/timebase.h"
+#include "profile.h"
+#include "monitor.h"
 
 /* 外部DDS函数 */
 extern void DDS_Init(void);
@@ -46,17 +50,16 @@ extern CalibrationData_t g_calibration;
 /* 全局信号类型变量 (默认正弦波, volatile: 在中断中使用) */
 volatile SignalType_t g_signal_type = SIGNAL_TYPE_SINE;
 
-/* 全局系统滴答计数（用于测量时间，1ms递增） */
-volatile uint32_t systick_ms = 0;
-
 /* 工具函数声明 */
 void delay_ms(uint32_t ms);
 void delay_us(uint16_t us);
 
 int main()
 {
-    /* 0. 初始化SysTick为1ms定时器（用于测量时间统计） */
-    SysTick_Config(SystemCoreClock / 1000);  /* 72MHz / 1000 = 1ms */
+    /* 0. 初始化TIMER5时间基准（delay、扫频计时、调度器定时都基于它） */
+    Timebase_Init();
+    Prof_Init();        /* DWT周期计数器（PROF命令） */
+    Monitor_Init();     /* CPU负载1秒窗口（LOAD命令） */
     
     /* 1. 初始化UART */
     USART0_Init(115200);
@@ -65,7 +68,7 @@ int main()
     printf("\r\n===========================================\r\n");
     printf("  GD32F103 Bode Plot Analyzer v5.6\r\n");
     printf("  Mode: External DAC5311 Signal Generator\r\n");
-    printf("  DDS Generator: 10Hz - 1kHz (via SPI0 → DAC5311)\r\n");
+    printf("  DDS Generator: 10Hz - 20kHz (via SPI0 → DAC5311)\r\n");
     printf("  Signal Output: PB1 (filtered sine wave)\r\n");
     printf("  ADC Sampling: PA6(Input K), PB1(Output K₁)\r\n");
     printf("  Amplitude Method: RMS Energy (RMS能量法)\r\n");
@@ -106,9 +109,9 @@ int main()
     LED_Init();
     printf("[OK] LED system initialized (GPIOB: PB11-PB15).\r\n");
     
-    /* 11. 初始化TIMER1（20kHz中断用于LED PWM）*/
-    TIM1_Init_LED(71, 49);  /* 72MHz/(71+1)/(49+1) = 20kHz */
-    printf("[OK] TIMER1 initialized (20kHz for LED PWM).\r\n");
+    /* 11. 初始化LED硬件PWM（TIMER0/TIMER1 10kHz PWM，1kHz模式节拍）*/
+    TIM_Init_LED();
+    printf("[OK] LED PWM initialized (hardware PWM, 1kHz tick).\r\n");
     
     /* 12. 设置默认LED状态为OFF */
     LED_Set_Mode(LED_MODE_OFF);
@@ -137,7 +140,7 @@ int main()
     printf("    - 低频(<20Hz)幅度小，信噪比低\r\n");
     printf("  \r\n");
     printf("  Commands:\r\n");
-    printf("    FREQ:100       - Set frequency to 100Hz\r\n");
+    printf("    FREQ:100       - Set frequency to 100Hz (10-20000Hz)\r\n");
     printf("    MEASURE        - Measure H(ω) and θ(ω)\r\n");
     printf("    SWEEP          - Auto sweep 10Hz-1kHz\r\n");
     printf("    SWEEP:500      - Custom sweep 10Hz-500Hz\r\n");
@@ -153,60 +156,47 @@ int main()
     printf("[INFO] System ready! PB1 outputting 100Hz sine wave.\r\n");
     printf("[INFO] Type 'HELP' for command list.\r\n\r\n");
     
-    /* 主循环 - 空闲等待UART命令 */
-    while(1)
-    {
-        /* UART命令处理在中断中完成 */
-        /* 波形生成在TIMER2中断中完成 */
-        /* ADC采样持续进行（DMA自动传输） */
-        
-        /* 空闲延迟，降低CPU使用率 */
-        delay_ms(100);
-        
-        /* 可选：定期输出心跳（调试用，正常使用可注释掉） */
-        // static uint32_t heartbeat = 0;
-        // if(++heartbeat >= 100) {  /* 每10秒一次 */
-        //     heartbeat = 0;
-        //     printf("[IDLE] Freq=%dHz, waiting for commands...\r\n", DDS_GetFrequency());
-        // }
-    }
+    /* 主循环 - 协作式调度器（不返回）
+     *   COMMAND: UART接收/分行在中断中完成，整行命令在此执行
+     *   STREAM:  ADC DMA半缓冲区凑满一块后发送（START模式）
+     *   MEASURE: 扫频/校准/采集分步执行，等待期间让出
+     * 波形生成在TIMER2中断中完成，ADC采样持续进行（DMA自动传输），
+     * 没有就绪任务时WFI休眠
+     */
+    Sched_Run();
 }
 
 /* ============== 工具函数实现 ============== */
 
 /**
  * @brief:  Millisecond delay
+ * @description: 线程模式下按截止时间WFI休眠（TIMER5每1ms唤醒），
+ *               中断中（按键消抖等）退化为忙等
  * @param {uint32_t} ms
  * @return {*}
  */
 void delay_ms(uint32_t ms)
 {
-	uint32_t i;
-	for(i=0;i < ms;i++)
+	if(__get_IPSR() != 0 || __get_PRIMASK() != 0)
+	{
+		Timebase_DelayUs(ms * 1000);
+		return;
+	}
+	
+	uint32_t deadline = Timebase_Deadline(ms);
+	while(!Timebase_Expired(deadline))
 	{
-		delay_us(1000);
+		__WFI();
 	}
 }
 
 /**
  * @brief: Microsecond delay
+ * @description: 读TIMER5计数，不再重新配置SysTick
  * @param {uint16_t} us
  * @return {*}
  */
 void delay_us(uint16_t us)
 {
-	SysTick->CTRL = 0; // Disable SysTick
-	SysTick->LOAD = SystemCoreClock/1000000 * us; // 24bit Reload register
-	SysTick->VAL = 0; // Clear current value as well as count flag
-	SysTick->CTRL = 5; // Enable SysTick timer with processor clock
-	while ((SysTick->CTRL & 0x00010000)==0);// Wait until count flag is set
-	SysTick->CTRL = 0; // Disable SysTick
-}
-
-/**
- * @brief: SysTick中断处理函数（每1ms触发一次，用于时间统计）
- */
-void SysTick_Handler(void)
-{
-	systick_ms++;
+	Timebase_DelayUs(us);
 }
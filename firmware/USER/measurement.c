@@ -8,6 +8,15 @@
 #include "measurement.h"
 #include "signal_processing.h"
 #include "adc_handler.h"
+#include "telemetry.h"
+#include "scheduler.h"
+#include "scratch.h"
+#include "record.h"
+#include "ets.h"
+#include "track.h"
+#include "lockin.h"
+#include "sweep_metrics.h"
+#include "../BSP/TIMEBASE/timebase.h"
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -17,26 +26,176 @@ CalibrationData_t g_calibration = {0};
 /* 外部DDS函数声明 */
 extern void DDS_SetFrequency(uint32_t freq);
 extern uint32_t DDS_GetFrequency(void);
+extern void DDS_SetAmplitude(uint16_t amplitude_q8);
 
 /* 外部TIMER函数声明 */
-extern void TIMER3_SetSampleRate(uint32_t sample_rate_hz);
 
-/* 外部延时函数声明 */
-extern void delay_ms(uint32_t ms);
 
-/* 外部系统滴答计数（用于测量时间）*/
-extern volatile uint32_t systick_ms;
+/* 扫频范围：2kHz以下步进10Hz，以上步进100Hz（相对分辨率不低于5%） */
+#define SWEEP_FREQ_START    10
+#define SWEEP_FREQ_STOP     20000
+#define SWEEP_FREQ_STEP     10
+#define SWEEP_FREQ_KNEE     2000
+#define SWEEP_FREQ_STEP_HIGH 100
+#define SWEEP_POINTS(stop)  ((((stop) < SWEEP_FREQ_KNEE ? (stop) : SWEEP_FREQ_KNEE) - SWEEP_FREQ_START) / SWEEP_FREQ_STEP + 1 + \
+                             ((stop) > SWEEP_FREQ_KNEE ? ((stop) - SWEEP_FREQ_KNEE) / SWEEP_FREQ_STEP_HIGH : 0))
+#define SWEEP_RECORD        512     /* 短记录借用的缓冲区（实际长度按整周期截断） */
+
+/* 作业单步返回值：作业结束 */
+#define MEASURE_STEP_DONE   0xFFFFFFFFUL
+
+/* 当前后台作业 */
+static Measure_Job_t measure_job = MEASURE_JOB_NONE;
+
+/* MEASURE/SWEEP记录长度：0=adc_buffer，否则为流式累加的长记录 */
+static uint32_t measure_record_length = 0;
+
+/* 固定采样率数字下变频：0=逐点自适应采样率 */
+static uint8_t measure_ddc = 0;
+
+/* 扫频阶段 */
+typedef enum {
+    SWEEP_SETUP = 0,    /* 设置频率/采样率，等待稳定 */
+    SWEEP_AUTORANGE,    /* 自动量程，每调整一次等待一次 */
+    SWEEP_ACQUIRE,      /* 一次采集（多次平均时每次之间等待） */
+    SWEEP_REPORT        /* 计算并输出本频率点 */
+} Sweep_Phase_t;
+
+/* 扫频上下文（原AutoSweep循环中的局部变量） */
+static struct {
+    Sweep_Phase_t phase;
+    uint32_t freq;
+    uint32_t stop;          /* 最后一个频率点 */
+    uint8_t single;         /* 1=MEASURE单点（不恢复默认频率） */
+    uint8_t recording;      /* 长记录采集进行中 */
+    uint32_t sample_rate;
+    uint16_t amplitude;
+    uint8_t range_iter;
+    uint8_t m;
+    uint8_t measurement_count;
+    uint32_t sum_pp_ch1;
+    uint32_t sum_pp_ch2;
+    int64_t sum_phase;
+    
+    /* 相位unwrapping */
+    int32_t phase_offset;
+    int32_t last_phase_raw;
+    uint8_t is_first_point;
+    
+    /* 失真统计 */
+    uint16_t distortion_count;
+    uint16_t total_points;
+    
+    /* 测量时间统计 */
+    uint32_t start_time;
+    uint32_t point_start_time;
+    uint32_t total_measurement_time;
+} sweep;
+
+/* 校准上下文 */
+static struct {
+    uint8_t started;        /* 0=提示阶段 */
+    uint8_t settled;        /* 当前频率点已等待稳定 */
+    uint32_t freq_idx;
+    uint32_t sample_rate;
+} calib;
+
+/* 采集上下文 */
+static struct {
+    uint8_t started;
+    uint32_t signal_freq;
+    uint32_t sample_rate;
+} capture;
+
+/* 多节点扫描上下文 */
+static struct {
+    uint8_t started;
+    uint32_t signal_freq;
+    uint32_t sample_rate;
+    uint32_t frames;
+} scan;
+
+/* 等效时间采样上下文 */
+static struct {
+    uint8_t phase;          /* 0=设置，1=开始累加，2=等待完成 */
+    uint32_t signal_freq;
+    uint32_t averages;
+    uint32_t ticks;
+} ets;
+
+/* 连续输出（TRACK/LOCKIN）的相位展开状态 */
+typedef struct {
+    int32_t offset;
+    int32_t last;
+    uint8_t is_first;
+} Phase_Unwrap_t;
+
+/* 单频跟踪上下文 */
+static struct {
+    uint8_t phase;          /* 0=设置，1=开始累加，2=跟踪中 */
+    uint32_t signal_freq;
+    uint32_t sample_rate;
+    Phase_Unwrap_t unwrap;  /* 相对上一次输出展开 */
+} tracking;
+
+/* 锁相上下文 */
+static struct {
+    uint8_t phase;          /* 0=设置，1=开始，2=运行中 */
+    uint32_t signal_freq;
+    uint32_t sample_rate;
+    uint32_t tc_ms;
+    Phase_Unwrap_t unwrap;
+} lockin;
+
+static void Sweep_Init(uint32_t start, uint32_t stop, uint8_t single);
+
+/*!
+ * \brief   启动后台作业（调用者已确认空闲）
+ */
+static void Measure_Begin(Measure_Job_t job)
+{
+    measure_job = job;
+    Sched_Post(SCHED_TASK_MEASURE);
+}
+
+Measure_Job_t Measure_GetJob(void)
+{
+    return measure_job;
+}
+
+const char *Measure_JobName(Measure_Job_t job)
+{
+    switch(job)
+    {
+    case MEASURE_JOB_SWEEP:       return "SWEEP";
+    case MEASURE_JOB_CALIBRATION: return "CALIBRATION";
+    case MEASURE_JOB_CAPTURE:     return "CAPTURE";
+    case MEASURE_JOB_POINT:       return "MEASURE";
+    case MEASURE_JOB_SCAN:        return "SCAN";
+    case MEASURE_JOB_ETS:         return "ETS";
+    case MEASURE_JOB_TRACK:       return "TRACK";
+    case MEASURE_JOB_LOCKIN:      return "LOCKIN";
+    default:                      return "NONE";
+    }
+}
 
 /*!
- * \brief   自动扫频测量（10Hz ~ 2kHz）
- * \details 每隔10Hz测量一次，输出完整的频率响应曲线
+ * \brief   自动扫频测量（10Hz ~ 20kHz）
+ * \details 2kHz以下每隔10Hz、以上每隔100Hz测量一次，输出完整的频率响应曲线。
+ *          DDC固定采样率只覆盖到2kHz，DDC扫频在2kHz结束。
+ *          只打印表头并启动后台作业，测量由调度器MEASURE任务分步执行，
+ *          稳定/量程/平均之间的等待期间可继续处理命令
  */
 void AutoSweep(void)
 {
+    uint32_t stop = measure_ddc ? SWEEP_FREQ_KNEE : SWEEP_FREQ_STOP;
+    
     printf("\r\n");
     printf("================================================\r\n");
-    printf("  AUTO FREQUENCY SWEEP: 10Hz - 2000Hz\r\n");
-    printf("  Step: 10Hz, Total: 200 points\r\n");
+    printf("  AUTO FREQUENCY SWEEP: %uHz - %uHz\r\n", (unsigned int)SWEEP_FREQ_START, (unsigned int)stop);
+    printf("  Step: %uHz (<=%uHz), %uHz above, Total: %u points\r\n",
+           (unsigned int)SWEEP_FREQ_STEP, (unsigned int)SWEEP_FREQ_KNEE, (unsigned int)SWEEP_FREQ_STEP_HIGH,
+           (unsigned int)SWEEP_POINTS(stop));
     printf("  Mode: External Feedback with Adaptive Sampling\r\n");
     printf("  Amplitude Method: RMS Energy (RMS能量法)\r\n");
     printf("  Phase Algorithm: Float DFT + atan2f\r\n");
@@ -47,251 +206,441 @@ void AutoSweep(void)
     printf("    100Hz → 1kHz采样\r\n");
     printf("    1kHz  → 10kHz采样\r\n");
     printf("    2kHz  → 20kHz采样\r\n");
+    printf("  Background: STATUS/ABORT/LED commands stay available\r\n");
     printf("================================================\r\n");
+    if(measure_record_length)
+    {
+        printf("  Record: %u samples/point (streamed, no waveforms)\r\n", (unsigned int)measure_record_length);
+    }
+    if(measure_ddc)
+    {
+        printf("  DDC: fixed %uHz sampling, I/Q mix + integrate >=%u cycles\r\n",
+               (unsigned int)MEASURE_DDC_SAMPLE_RATE, (unsigned int)MEASURE_DDC_MIN_CYCLES);
+    }
     printf("OK:SWEEP_START\r\n");
     printf("================================================\r\n\r\n");
     
-    /* 相位unwrapping变量 */
-    int32_t phase_offset = 0;
-    int32_t last_phase_raw = 0;
-    uint8_t is_first_point = 1;
+    Sweep_Init(SWEEP_FREQ_START, stop, 0);
     
-    /* 失真统计 */
-    uint16_t distortion_count = 0;
-    uint16_t total_points = 0;
+    /* 自动量程从满幅开始，之后每点沿用上一点的幅度 */
+    DDS_SetAmplitude(DDS_AMPLITUDE_FULL);
     
-    /* 测量时间统计 */
-    uint32_t sweep_start_time = systick_ms;
-    uint32_t total_measurement_time = 0;
+    Measure_Begin(MEASURE_JOB_SWEEP);
+}
+
+/*!
+ * \brief   单点测量：复用扫频流程（稳定/量程/长记录/校准修正），只测当前频率
+ */
+void Measure_StartPoint(void)
+{
+    uint32_t freq = DDS_GetFrequency();
     
-    for(uint32_t freq = 10; freq <= 2000; freq += 10)
+    if(measure_ddc)
     {
-        /* 记录本频率点测量开始时间 */
-        uint32_t freq_start_time = systick_ms;
-        
-        /* 设置频率 */
-        DDS_SetFrequency(freq);
-        
-        /* ⭐ 自适应采样率：采样率 = 信号频率 × 10 */
-        uint32_t adaptive_sample_rate = freq * 10;
-        TIMER3_SetSampleRate(adaptive_sample_rate);
-        
-        printf("[INFO] %dHz: 采样率设置为 %dHz (10倍频率)\r\n", freq, adaptive_sample_rate);
-        
-        /* 调试输出 */
-        if(freq >= 750) {
-            printf("[DEBUG] Starting measurement at %d Hz\r\n", freq);
-        }
+        printf("[INFO] MEASURE %uHz: DDC at %uHz\r\n", (unsigned int)freq, (unsigned int)MEASURE_DDC_SAMPLE_RATE);
+    }
+    else
+    {
+        printf("[INFO] MEASURE %uHz: %u-sample record\r\n", (unsigned int)freq, (unsigned int)measure_record_length);
+    }
+    Sweep_Init(freq, freq, 1);
+    Measure_Begin(MEASURE_JOB_POINT);
+}
+
+void Measure_SetRecordLength(uint32_t length)
+{
+    measure_record_length = length;
+}
+
+uint32_t Measure_GetRecordLength(void)
+{
+    return measure_record_length;
+}
+
+void Measure_SetDDC(uint8_t enable)
+{
+    measure_ddc = enable ? 1 : 0;
+}
+
+uint8_t Measure_GetDDC(void)
+{
+    return measure_ddc;
+}
+
+/*!
+ * \brief   初始化扫频上下文
+ */
+static void Sweep_Init(uint32_t start, uint32_t stop, uint8_t single)
+{
+    sweep.phase = SWEEP_SETUP;
+    sweep.freq = start;
+    sweep.stop = stop;
+    sweep.single = single;
+    sweep.recording = 0;
+    sweep.phase_offset = 0;
+    sweep.last_phase_raw = 0;
+    sweep.is_first_point = 1;
+    sweep.distortion_count = 0;
+    sweep.total_points = 0;
+    sweep.start_time = Timebase_Millis();
+    sweep.total_measurement_time = 0;
+    
+    if(!single)
+    {
+        Metrics_Begin();
+    }
+    
+    /* DDC：采样率只在开始时设置一次，第一个点的稳定等待同时覆盖DMA/抽取器重新同步 */
+    if(measure_ddc)
+    {
+        ADC_SetSampleRate(MEASURE_DDC_SAMPLE_RATE);
+    }
+}
+
+/*!
+ * \brief   扫频：设置频率点
+ * \return  稳定等待时间(ms)
+ */
+static uint32_t Sweep_Setup(void)
+{
+    uint32_t freq = sweep.freq;
+    
+    /* 记录本频率点测量开始时间 */
+    sweep.point_start_time = Timebase_Millis();
+    
+    /* 设置频率 */
+    DDS_SetFrequency(freq);
+    
+    /* DDC：采样率不变，只等DUT稳定约5个周期 */
+    if(measure_ddc)
+    {
+        sweep.sample_rate = ADC_GetSampleRate();
+        sweep.range_iter = 0;
+        sweep.phase = SWEEP_AUTORANGE;
+        return 5000 / freq + 10;
+    }
+    
+    /* ⭐ 自适应采样率：采样率 = 信号频率 × 10（使用量化后的实际值，过采样时只改抽取比） */
+    sweep.sample_rate = ADC_SetSampleRate(ADC_PlanSampleRate(freq));
+    
+    printf("[INFO] %dHz: 采样率设置为 %dHz (10倍频率)\r\n", freq, sweep.sample_rate);
+    
+    /* 调试输出 */
+    if(freq >= 750) {
+        printf("[DEBUG] Starting measurement at %d Hz\r\n", freq);
+    }
+    
+    /* 自适应稳定时间 */
+    uint32_t settle_time_ms;
+    if(freq <= 20) {
+        settle_time_ms = (15000 / freq) + 200;
+    } else if(freq <= 50) {
+        settle_time_ms = (10000 / freq) + 100;
+    } else if(freq <= 200) {
+        settle_time_ms = (5000 / freq) + 50;
+    } else {
+        settle_time_ms = (3000 / freq) + 50;
+    }
+    if(settle_time_ms < 100) settle_time_ms = 100;
+    
+    sweep.range_iter = 0;
+    sweep.phase = SWEEP_AUTORANGE;
+    return settle_time_ms;
+}
+
+/*!
+ * \brief   扫频：一次采集，累加幅度/相位并发送波形
+ * \return  0=临时缓冲区不足
+ */
+static uint8_t Sweep_Acquire(void)
+{
+    uint32_t freq = sweep.freq;
+    uint32_t adaptive_sample_rate = sweep.sample_rate;
+    uint32_t count = ADC_PlanRecordLength(adaptive_sample_rate, freq);   /* 整周期截断 */
+    uint16_t *adc0_data;
+    uint16_t *adc1_data;
+    
+    /* 采集数据只在本步内使用，用完即归还 */
+    if(!Scratch_BorrowPair(SWEEP_RECORD, "SWEEP", &adc0_data, &adc1_data)) return 0;
+    
+    /* 采集双通道反馈数据 */
+    ExtractADCData(adc0_data, adc1_data, count);
+    
+    /* ⭐ 使用自适应采样率进行计算（重要！） */
+    float amp_ch1_single = CalculateAmplitude_DFT(adc0_data, count, adaptive_sample_rate, freq);
+    float amp_ch2_single = CalculateAmplitude_DFT(adc1_data, count, adaptive_sample_rate, freq);
+    
+    uint16_t pp_ch1_single = (uint16_t)amp_ch1_single;
+    uint16_t pp_ch2_single = (uint16_t)amp_ch2_single;
+    
+    /* 调试输出 */
+    if(freq >= 750 && sweep.m == 0) {
+        printf("[DEBUG] %dHz ADC: CH1=%d, CH2=%d, sample[0]=%d,%d\r\n", 
+               freq, pp_ch1_single, pp_ch2_single, adc0_data[0], adc1_data[0]);
+    }
+    
+    /* ⭐ 计算相位差（使用自适应采样率） */
+    int32_t phase_single = EstimatePhaseShift_Int(adc0_data, adc1_data, count, adaptive_sample_rate, freq);
+    
+    /* 计算失真度（使用自适应采样率） */
+    if(sweep.m == 0) {
+        float distortion_input = CalculateDistortion(adc0_data, count, freq, adaptive_sample_rate);
+        float distortion_output = CalculateDistortion(adc1_data, count, freq, adaptive_sample_rate);
         
-        /* 自适应稳定时间 */
-        uint32_t settle_time_ms;
-        if(freq <= 20) {
-            settle_time_ms = (15000 / freq) + 200;
-        } else if(freq <= 50) {
-            settle_time_ms = (10000 / freq) + 100;
-        } else if(freq <= 200) {
-            settle_time_ms = (5000 / freq) + 50;
-        } else {
-            settle_time_ms = (3000 / freq) + 50;
+        sweep.total_points++;
+        if(distortion_output > 15.0f) {
+            sweep.distortion_count++;
         }
-        if(settle_time_ms < 100) settle_time_ms = 100;
         
-        delay_ms(settle_time_ms);
-        
-        /* 自适应多次测量平均 */
-        uint8_t measurement_count;
-        if(freq <= 20) {
-            measurement_count = 3;
-        } else if(freq <= 50) {
-            measurement_count = 2;
-        } else {
-            measurement_count = 1;
-        }
-        
-        uint32_t sum_pp_ch1 = 0;
-        uint32_t sum_pp_ch2 = 0;
-        int64_t sum_phase = 0;
-        
-        /* ADC数据缓冲区 */
-        static uint16_t adc0_data[512];
-        static uint16_t adc1_data[512];
-        
-        for(uint8_t m = 0; m < measurement_count; m++)
-        {
-            /* 采集双通道反馈数据 */
-            ExtractADCData(adc0_data, adc1_data, 512);
-            
-            /* ⭐ 使用自适应采样率进行计算（重要！） */
-            float amp_ch1_single = CalculateAmplitude_DFT(adc0_data, 512, adaptive_sample_rate, freq);
-            float amp_ch2_single = CalculateAmplitude_DFT(adc1_data, 512, adaptive_sample_rate, freq);
-            
-            uint16_t pp_ch1_single = (uint16_t)amp_ch1_single;
-            uint16_t pp_ch2_single = (uint16_t)amp_ch2_single;
-            
-            /* 调试输出 */
-            if(freq >= 750 && m == 0) {
-                printf("[DEBUG] %dHz ADC: CH1=%d, CH2=%d, sample[0]=%d,%d\r\n", 
-                       freq, pp_ch1_single, pp_ch2_single, adc0_data[0], adc1_data[0]);
-            }
-            
-            /* ⭐ 计算相位差（使用自适应采样率） */
-            int32_t phase_single = EstimatePhaseShift_Int(adc0_data, adc1_data, 512, adaptive_sample_rate, freq);
-            
-            /* 计算失真度（使用自适应采样率） */
-            if(m == 0) {
-                float distortion_input = CalculateDistortion(adc0_data, 512, freq, adaptive_sample_rate);
-                float distortion_output = CalculateDistortion(adc1_data, 512, freq, adaptive_sample_rate);
-                
-                total_points++;
-                if(distortion_output > 15.0f) {
-                    distortion_count++;
-                }
-                
-                if(distortion_output > 15.0f) {
-                    printf("[WARN] %dHz: 输出信号失真严重! THD=%.1f%% (输入THD=%.1f%%)\r\n", 
-                           freq, distortion_output, distortion_input);
-                    printf("       建议：降低测试频率上限或改进运放电路\r\n");
-                }
-            }
-            
-            sum_pp_ch1 += pp_ch1_single;
-            sum_pp_ch2 += pp_ch2_single;
-            sum_phase += phase_single;
-            
-            /* 每次测量后发送波形数据（包含真实采样率） */
-            {
-                uint32_t skip = 1;
-                
-                printf("WAVEFORM:%d,%d,", freq, adaptive_sample_rate);
-                
-                for(uint32_t i = 0; i < 512; i += skip)
-                {
-                    printf("%d", adc0_data[i]);
-                    if(i + skip < 512) printf(",");
-                }
-                
-                printf("|");
-                
-                for(uint32_t i = 0; i < 512; i += skip)
-                {
-                    printf("%d", adc1_data[i]);
-                    if(i + skip < 512) printf(",");
-                }
-                
-                printf("\r\n");
-            }
-            
-            /* 多次测量之间等待 */
-            if(m < measurement_count - 1) {
-                uint32_t wait_time = (1000 / freq) + 10;
-                if(wait_time < 20) wait_time = 20;
-                if(wait_time > 100) wait_time = 100;
-                delay_ms(wait_time);
-            }
-        }
-        
-        /* 计算平均值 */
-        uint16_t pp_ch1 = sum_pp_ch1 / measurement_count;
-        uint16_t pp_ch2 = sum_pp_ch2 / measurement_count;
-        int32_t phase_raw = (int32_t)(sum_phase / measurement_count);
-        
-        /* 检查信号有效性 */
-        if(pp_ch1 < 5 || pp_ch2 < 5)
-        {
-            printf("[WARN] Weak signal at %dHz: CH1=%d, CH2=%d\r\n", freq, pp_ch1, pp_ch2);
+        if(distortion_output > 15.0f) {
+            printf("[WARN] %dHz: 输出信号失真严重! THD=%.1f%% (输入THD=%.1f%%)\r\n", 
+                   freq, distortion_output, distortion_input);
+            printf("       建议：降低测试频率上限或改进运放电路\r\n");
         }
+    }
+    
+    sweep.sum_pp_ch1 += pp_ch1_single;
+    sweep.sum_pp_ch2 += pp_ch2_single;
+    sweep.sum_phase += phase_single;
+    
+    /* 每次测量后发送波形数据（包含真实采样率） */
+    if(Telemetry_IsBinary())
+    {
+        Telemetry_SendWaveform(freq, adaptive_sample_rate, adc0_data, adc1_data, (uint16_t)count,
+                               TELEMETRY_SRC_MEASURE);
+    }
+    else
+    {
+        uint32_t skip = 1;
         
-        /* 转换为电压 */
-        float voltage_ch1 = ((float)pp_ch1 * 3.3f) / 4096.0f;
-        float voltage_ch2 = ((float)pp_ch2 * 3.3f) / 4096.0f;
+        printf("WAVEFORM:%d,%d,", freq, adaptive_sample_rate);
         
-        /* 计算幅频特性 */
-        float H = 0.0f;
-        if(voltage_ch1 > 0.001f)
+        for(uint32_t i = 0; i < count; i += skip)
         {
-            H = voltage_ch2 / voltage_ch1;
+            printf("%d", adc0_data[i]);
+            if(i + skip < count) printf(",");
         }
         
-        /* 应用校准修正 */
-        float H_corrected = H;
-        int32_t phase_corrected = phase_raw;
+        printf("|");
         
-        if(g_calibration.valid && freq >= 10 && freq <= 1000 && (freq % 10) == 0)
+        for(uint32_t i = 0; i < count; i += skip)
         {
-            uint32_t freq_idx = (freq / 10) - 1;
-            
-            float correction_factor = (float)g_calibration.gain_correction[freq_idx] / 10000.0f;
-            H_corrected = H * correction_factor;
-            
-            phase_corrected = phase_raw + g_calibration.phase_correction[freq_idx];
+            printf("%d", adc1_data[i]);
+            if(i + skip < count) printf(",");
         }
         
-        /* 相位Unwrapping */
-        if(!is_first_point)
-        {
-            int32_t phase_diff = phase_corrected - last_phase_raw;
-            
-            if(phase_diff > 18000)
-            {
-                phase_offset -= 36000;
-            }
-            else if(phase_diff < -18000)
-            {
-                phase_offset += 36000;
-            }
-        }
+        printf("\r\n");
+    }
+    
+    Scratch_Release(adc0_data);
+    return 1;
+}
+
+/*!
+ * \brief   扫频：本点的累加记录长度（整周期）
+ * \details 指定了RECORD长度时用它；否则DDC按至少MEASURE_DDC_MIN_CYCLES个周期且至少MEASURE_DDC_MIN_MS
+ */
+static uint32_t Sweep_RecordLength(void)
+{
+    uint32_t length = measure_record_length;
+    
+    if(length == 0)
+    {
+        uint32_t min_time = sweep.sample_rate * MEASURE_DDC_MIN_MS / 1000;
+        length = (uint32_t)(((uint64_t)sweep.sample_rate * MEASURE_DDC_MIN_CYCLES + sweep.freq - 1) / sweep.freq);
+        if(length < min_time) length = min_time;
+        if(length > RECORD_MAX_LENGTH) length = RECORD_MAX_LENGTH;
+    }
+    
+    return ADC_PlanRecordLengthMax(sweep.sample_rate, sweep.freq, length);
+}
+
+/*!
+ * \brief   扫频：累加一条长记录的结果（流式累加，无波形输出）
+ * \details DDC取正交混频后的基波（锁相输出，谐波和噪声被整周期积分滤除），
+ *          否则取去直流RMS（与短记录CalculateAmplitude_DFT口径一致）
+ */
+static void Sweep_AddRecord(const Record_Result_t *r)
+{
+    uint32_t freq = sweep.freq;
+    const float *amplitude = measure_ddc ? r->fundamental : r->amplitude;
+    
+    sweep.total_points++;
+    if(r->thd[1] > 15.0f)
+    {
+        sweep.distortion_count++;
+        printf("[WARN] %dHz: 输出信号失真严重! THD=%.1f%% (输入THD=%.1f%%)\r\n",
+               freq, r->thd[1], r->thd[0]);
+    }
+    
+    sweep.sum_pp_ch1 += (uint16_t)amplitude[0];
+    sweep.sum_pp_ch2 += (uint16_t)amplitude[1];
+    sweep.sum_phase += r->phase_x100;
+}
+
+/*!
+ * \brief   扫频：计算平均值、校准修正、相位展开并输出本频率点
+ */
+static void Sweep_Report(void)
+{
+    uint32_t freq = sweep.freq;
+    uint8_t measurement_count = sweep.measurement_count;
+    
+    /* 计算平均值 */
+    uint16_t pp_ch1 = sweep.sum_pp_ch1 / measurement_count;
+    uint16_t pp_ch2 = sweep.sum_pp_ch2 / measurement_count;
+    int32_t phase_raw = (int32_t)(sweep.sum_phase / measurement_count);
+    
+    /* 检查信号有效性 */
+    if(pp_ch1 < 5 || pp_ch2 < 5)
+    {
+        printf("[WARN] Weak signal at %dHz: CH1=%d, CH2=%d\r\n", freq, pp_ch1, pp_ch2);
+    }
+    
+    /* 转换为电压（按激励幅度折算回满幅，H为比值不受影响） */
+    float amplitude_scale = (float)DDS_AMPLITUDE_FULL / (float)sweep.amplitude;
+    float voltage_ch1 = ((float)pp_ch1 * 3.3f) / 4096.0f * amplitude_scale;
+    float voltage_ch2 = ((float)pp_ch2 * 3.3f) / 4096.0f * amplitude_scale;
+    
+    /* 计算幅频特性 */
+    float H = 0.0f;
+    if(voltage_ch1 > 0.001f)
+    {
+        H = voltage_ch2 / voltage_ch1;
+    }
+    
+    /* 应用校准修正 */
+    float H_corrected = H;
+    int32_t phase_corrected = phase_raw;
+    
+    if(g_calibration.valid && freq >= 10 && freq <= 1000 && (freq % 10) == 0)
+    {
+        uint32_t freq_idx = (freq / 10) - 1;
         
-        int32_t phase_unwrapped = phase_corrected + phase_offset;
+        float correction_factor = (float)g_calibration.gain_correction[freq_idx] / 10000.0f;
+        H_corrected = H * correction_factor;
         
-        /* 更新历史记录 */
-        last_phase_raw = phase_corrected;
-        is_first_point = 0;
+        phase_corrected = phase_raw + g_calibration.phase_correction[freq_idx];
+    }
+    
+    /* 相位Unwrapping */
+    if(!sweep.is_first_point)
+    {
+        int32_t phase_diff = phase_corrected - sweep.last_phase_raw;
         
-        /* 输出频率响应数据 */
-        if(g_calibration.valid)
-        {
-            printf("FREQ_RESP:%d,%.4f,%.4f,%.6f,%s%.2f,%.6f,%s%.2f\r\n", 
-                   freq,
-                   voltage_ch1, voltage_ch2,
-                   H, (phase_raw<0)?"-":"", (float)abs(phase_raw)/100.0f,
-                   H_corrected, (phase_unwrapped<0)?"-":"", (float)abs(phase_unwrapped)/100.0f);
-        }
-        else
+        if(phase_diff > 18000)
         {
-            printf("FREQ_RESP:%d,%.4f,%.4f,%.6f,%s%.2f\r\n", 
-                   freq,
-                   voltage_ch1, voltage_ch2,
-                   H, (phase_unwrapped<0)?"-":"", (float)abs(phase_unwrapped)/100.0f);
+            sweep.phase_offset -= 36000;
         }
-        
-        /* 计算本频率点测量耗时 */
-        uint32_t freq_elapsed_time = systick_ms - freq_start_time;
-        total_measurement_time += freq_elapsed_time;
-        
-        /* 进度显示（包含测量时间） */
-        if(freq % 50 == 0)
+        else if(phase_diff < -18000)
         {
-            printf("# Progress: %d/1000 Hz (CH1=%d, CH2=%d, Time=%dms)\r\n", 
-                   freq, pp_ch1, pp_ch2, freq_elapsed_time);
-        }
-        
-        if(freq >= 800) {
-            printf("[DEBUG] Completed %d Hz measurement (耗时%dms)\r\n", freq, freq_elapsed_time);
+            sweep.phase_offset += 36000;
         }
     }
     
+    int32_t phase_unwrapped = phase_corrected + sweep.phase_offset;
+    
+    /* 更新历史记录 */
+    sweep.last_phase_raw = phase_corrected;
+    sweep.is_first_point = 0;
+    
+    /* 导出指标增量更新 */
+    if(!sweep.single)
+    {
+        Metrics_AddPoint(freq, H_corrected, phase_unwrapped);
+    }
+    
+    /* 输出频率响应数据 */
+    if(Telemetry_IsBinary())
+    {
+        Telemetry_SendFreqResp(freq, voltage_ch1, voltage_ch2,
+                               H, (float)phase_raw / 100.0f,
+                               H_corrected, (float)phase_unwrapped / 100.0f,
+                               g_calibration.valid);
+    }
+    else if(g_calibration.valid)
+    {
+        printf("FREQ_RESP:%d,%.4f,%.4f,%.6f,%s%.2f,%.6f,%s%.2f\r\n", 
+               freq,
+               voltage_ch1, voltage_ch2,
+               H, (phase_raw<0)?"-":"", (float)abs(phase_raw)/100.0f,
+               H_corrected, (phase_unwrapped<0)?"-":"", (float)abs(phase_unwrapped)/100.0f);
+    }
+    else
+    {
+        printf("FREQ_RESP:%d,%.4f,%.4f,%.6f,%s%.2f\r\n", 
+               freq,
+               voltage_ch1, voltage_ch2,
+               H, (phase_unwrapped<0)?"-":"", (float)abs(phase_unwrapped)/100.0f);
+    }
+    
+    /* 计算本频率点测量耗时 */
+    uint32_t freq_elapsed_time = Timebase_Millis() - sweep.point_start_time;
+    sweep.total_measurement_time += freq_elapsed_time;
+    
+    /* 进度显示（包含测量时间） */
+    if(freq % 50 == 0)
+    {
+        printf("# Progress: %d/%d Hz (CH1=%d, CH2=%d, Time=%dms)\r\n", 
+               freq, sweep.stop, pp_ch1, pp_ch2, freq_elapsed_time);
+    }
+    
+    if(freq >= 800) {
+        printf("[DEBUG] Completed %d Hz measurement (耗时%dms)\r\n", freq, freq_elapsed_time);
+    }
+}
+
+/*!
+ * \brief   扫频：输出导出指标汇总（未找到的项为0，以flags为准）
+ */
+static void Sweep_ReportMetrics(void)
+{
+    Metrics_Summary_t s;
+    
+    Metrics_Finish(&s);
+    
+    if(Telemetry_IsBinary())
+    {
+        Telemetry_SendMetrics(&s);
+    }
+    else
+    {
+        printf("METRICS:%u,%u,%u,%u,%.2f,%.1f,%.1f,%.2f,%.2f,%.1f,%.1f,%.1f,%.2f,%.4f,%.4f,%.4f,%.1f\r\n",
+               (unsigned int)s.start, (unsigned int)s.stop, (unsigned int)s.points, (unsigned int)s.flags,
+               s.ref_gain_db, s.bw_hz, s.peak_freq, s.peak_gain_db, s.q,
+               s.gc_freq, s.phase_margin, s.pc_freq, s.gain_margin,
+               s.gd_low_ms, s.gd_mean_ms, s.gd_max_ms, s.gd_max_freq);
+    }
+}
+
+/*!
+ * \brief   扫频：输出总结并恢复默认设置
+ */
+static void Sweep_Finish(void)
+{
     /* 计算总耗时 */
-    uint32_t total_elapsed = systick_ms - sweep_start_time;
+    uint32_t total_elapsed = Timebase_Millis() - sweep.start_time;
+    
+    /* 单点测量保持当前频率和量程，与短记录MEASURE一致 */
+    if(sweep.single)
+    {
+        /* DDC固定采样率不留给之后的STREAM/非DDC测量，按当前频率恢复 */
+        if(measure_ddc) ADC_SetSampleRate(ADC_PlanSampleRate(DDS_GetFrequency()));
+        printf("OK:MEASURE_COMPLETE (%ums)\r\n", (unsigned int)total_elapsed);
+        return;
+    }
+    uint16_t distortion_count = sweep.distortion_count;
+    uint16_t total_points = sweep.total_points;
     
     printf("\r\n");
     printf("[DEBUG] Loop完成！准备输出结束信息...\r\n");
     printf("================================================\r\n");
     printf("OK:SWEEP_COMPLETE\r\n");
-    printf("  Total Points: 200\r\n");
-    printf("  Frequency Range: 10-2000 Hz\r\n");
+    printf("  Total Points: %u\r\n", (unsigned int)SWEEP_POINTS(sweep.stop));
+    printf("  Frequency Range: %u-%u Hz\r\n", (unsigned int)SWEEP_FREQ_START, (unsigned int)sweep.stop);
     printf("  Algorithm: Adaptive DFT Phase Detection\r\n");
     printf("  ⏱️  Total Measurement Time: %.2f seconds\r\n", total_elapsed / 1000.0f);
-    printf("  ⏱️  Average Time per Point: %d ms\r\n", total_measurement_time / 100);
+    printf("  ⏱️  Average Time per Point: %d ms\r\n", total_points ? sweep.total_measurement_time / total_points : 0);
     printf("  \r\n");
     printf("  📊 信号质量统计:\r\n");
     printf("    高失真点 (THD>15%%): %d / %d (%.1f%%)\r\n", 
@@ -305,13 +654,123 @@ void AutoSweep(void)
     }
     printf("================================================\r\n\r\n");
     
-    /* 恢复到默认频率 */
+    Sweep_ReportMetrics();
+    
+    /* 恢复到默认频率和满幅激励 */
     DDS_SetFrequency(100);
+    DDS_SetAmplitude(DDS_AMPLITUDE_FULL);
+    if(measure_ddc)
+    {
+        ADC_SetSampleRate(ADC_PlanSampleRate(100));
+    }
+}
+
+/*!
+ * \brief   扫频作业单步
+ * \return  到下一步的等待时间(ms)，MEASURE_STEP_DONE=结束
+ */
+static uint32_t Sweep_Step(void)
+{
+    switch(sweep.phase)
+    {
+    case SWEEP_SETUP:
+        return Sweep_Setup();
+    
+    case SWEEP_AUTORANGE:
+        /* 自动量程：调整激励幅度，避免高增益DUT削波（DDC按记录自身的最值在采集后调整） */
+        if(!measure_ddc && sweep.range_iter < ADC_AUTORANGE_MAX_ITER)
+        {
+            uint32_t wait_ms = ADC_AutoRangeStep(sweep.freq, sweep.sample_rate, ADC_PlanRecordLength(sweep.sample_rate, sweep.freq));
+            sweep.range_iter++;
+            if(wait_ms) return wait_ms;
+        }
+        sweep.amplitude = DDS_GetAmplitude();
+        if(sweep.amplitude < DDS_AMPLITUDE_FULL) {
+            printf("[INFO] %dHz: 自动量程 激励=%d/256\r\n", sweep.freq, sweep.amplitude);
+        }
+        
+        /* 自适应多次测量平均（长记录本身已包含足够多周期，不再平均） */
+        if(measure_record_length || measure_ddc) {
+            sweep.measurement_count = 1;
+        } else if(sweep.freq <= 20) {
+            sweep.measurement_count = 3;
+        } else if(sweep.freq <= 50) {
+            sweep.measurement_count = 2;
+        } else {
+            sweep.measurement_count = 1;
+        }
+        sweep.m = 0;
+        sweep.sum_pp_ch1 = 0;
+        sweep.sum_pp_ch2 = 0;
+        sweep.sum_phase = 0;
+        sweep.phase = SWEEP_ACQUIRE;
+        return 0;
+    
+    case SWEEP_ACQUIRE:
+        if(measure_record_length || measure_ddc)
+        {
+            /* 长记录/DDC：启动累加后等待采集时间，之后每10ms查询一次 */
+            if(!sweep.recording)
+            {
+                sweep.recording = 1;
+                return Record_Start(Sweep_RecordLength(), sweep.freq, sweep.sample_rate);
+            }
+            
+            Record_Result_t result;
+            if(!Record_GetResult(&result)) return 10;
+            sweep.recording = 0;
+            
+            /* DDC：量程按本条记录的最值调整，调整后等DUT稳定再重新记录 */
+            if(measure_ddc && sweep.range_iter < ADC_AUTORANGE_MAX_ITER)
+            {
+                uint16_t pp = (result.pp[0] > result.pp[1]) ? result.pp[0] : result.pp[1];
+                uint16_t peak = (result.peak[0] > result.peak[1]) ? result.peak[0] : result.peak[1];
+                if(ADC_AutoRangeAdjust(pp, peak))
+                {
+                    sweep.range_iter++;
+                    sweep.amplitude = DDS_GetAmplitude();
+                    printf("[INFO] %dHz: 自动量程 激励=%d/256\r\n", sweep.freq, sweep.amplitude);
+                    return 5000 / sweep.freq + 2;
+                }
+            }
+            Sweep_AddRecord(&result);
+        }
+        else if(!Sweep_Acquire())
+        {
+            DDS_SetFrequency(100);
+            DDS_SetAmplitude(DDS_AMPLITUDE_FULL);
+            return MEASURE_STEP_DONE;
+        }
+        
+        /* 多次测量之间等待 */
+        if(++sweep.m < sweep.measurement_count) {
+            uint32_t wait_time = (1000 / sweep.freq) + 10;
+            if(wait_time < 20) wait_time = 20;
+            if(wait_time > 100) wait_time = 100;
+            return wait_time;
+        }
+        sweep.phase = SWEEP_REPORT;
+        return 0;
+    
+    case SWEEP_REPORT:
+    default:
+        Sweep_Report();
+        
+        sweep.freq += (sweep.freq < SWEEP_FREQ_KNEE) ? SWEEP_FREQ_STEP : SWEEP_FREQ_STEP_HIGH;
+        if(sweep.freq > sweep.stop)
+        {
+            Sweep_Finish();
+            return MEASURE_STEP_DONE;
+        }
+        sweep.phase = SWEEP_SETUP;
+        return 0;
+    }
 }
 
 /*!
  * \brief   自动校准系统（直通测试）
- * \details 要求：将PA6直接短接到PB1
+ * \details 要求：将PA6直接短接到PB1。
+ *          打印提示后启动后台作业，3秒后开始逐点测量，期间可用ABORT取消
  */
 void AutoCalibration(void)
 {
@@ -323,76 +782,115 @@ void AutoCalibration(void)
     printf("  理论结果：H(ω)≈1.0, θ(ω)≈0°\r\n");
     printf("  测试范围：10Hz - 1000Hz (100 points)\r\n");
     printf("================================================\r\n");
-    printf("按任意键开始校准，或输入CANCEL取消...\r\n");
-    
-    delay_ms(3000);
-    
-    printf("\r\n[INFO] 开始校准测量...\r\n");
-    printf("OK:CALIBRATION_START\r\n");
+    printf("3秒后开始校准，输入ABORT取消...\r\n");
     
-    /* 清空校准数据 */
-    g_calibration.valid = 0;
-    for(uint8_t i = 0; i < CALIBRATION_POINTS; i++)
+    calib.started = 0;
+    Measure_Begin(MEASURE_JOB_CALIBRATION);
+}
+
+/*!
+ * \brief   校准作业单步
+ * \return  到下一步的等待时间(ms)，MEASURE_STEP_DONE=结束
+ */
+static uint32_t Calibration_Step(void)
+{
+    if(!calib.started)
     {
-        g_calibration.gain_correction[i] = 10000;
-        g_calibration.phase_correction[i] = 0;
+        calib.started = 1;
+        calib.settled = 0;
+        calib.freq_idx = 0;
+        return 3000;
     }
     
-    /* 扫频校准 */
-    for(uint32_t freq_idx = 0; freq_idx < CALIBRATION_POINTS; freq_idx++)
+    if(calib.freq_idx == 0 && !calib.settled)
     {
-        uint32_t freq = (freq_idx + 1) * 10;
+        printf("\r\n[INFO] 开始校准测量...\r\n");
+        printf("OK:CALIBRATION_START\r\n");
         
+        /* 直通校准使用满幅激励 */
+        DDS_SetAmplitude(DDS_AMPLITUDE_FULL);
+        
+        /* 清空校准数据 */
+        g_calibration.valid = 0;
+        for(uint8_t i = 0; i < CALIBRATION_POINTS; i++)
+        {
+            g_calibration.gain_correction[i] = 10000;
+            g_calibration.phase_correction[i] = 0;
+        }
+    }
+    
+    uint32_t freq_idx = calib.freq_idx;
+    uint32_t freq = (freq_idx + 1) * 10;
+    
+    if(!calib.settled)
+    {
         DDS_SetFrequency(freq);
         
         /* ⭐ 自适应采样率（校准时也使用10倍频率） */
-        uint32_t adaptive_sample_rate = freq * 10;
-        TIMER3_SetSampleRate(adaptive_sample_rate);
+        calib.sample_rate = ADC_SetSampleRate(ADC_PlanSampleRate(freq));
         
         /* 等待信号稳定 */
         uint32_t settle_time_ms = (freq <= 50) ? (10000 / freq + 100) : (5000 / freq + 50);
         if(settle_time_ms < 100) settle_time_ms = 100;
-        delay_ms(settle_time_ms);
-        
-        /* 采集数据 */
-        static uint16_t adc0_data[512];
-        static uint16_t adc1_data[512];
-        ExtractADCData(adc0_data, adc1_data, 512);
-        
-        /* 计算幅度和相位（使用自适应采样率） */
-        uint16_t pp_ch1 = CalculatePeakToPeak(adc0_data, 512);
-        uint16_t pp_ch2 = CalculatePeakToPeak(adc1_data, 512);
-        int32_t phase_raw = EstimatePhaseShift_Int(adc0_data, adc1_data, 512, adaptive_sample_rate, freq);
-        
-        /* 检查有效性 */
-        if(pp_ch1 < 10 || pp_ch2 < 10)
-        {
-            printf("[ERROR] CALIB_FAIL:%d,signal_weak\r\n", freq);
-            printf("[提示] 请检查PA6和PB1是否正确连接！\r\n");
-            return;
-        }
-        
-        /* 计算校准系数 */
-        uint32_t H_measured = ((uint32_t)pp_ch2 * 10000) / pp_ch1;
-        
-        uint32_t correction = 100000000UL / H_measured;
-        if(correction > 65535) correction = 65535;
-        g_calibration.gain_correction[freq_idx] = (uint16_t)correction;
-        
-        g_calibration.phase_correction[freq_idx] = (int16_t)(-phase_raw);
-        
-        /* 输出校准数据 */
+        calib.settled = 1;
+        return settle_time_ms;
+    }
+    
+    /* 采集数据（临时缓冲区只在计算期间借用） */
+    uint16_t *calib_ch0, *calib_ch1;
+    if(!Scratch_BorrowPair(SWEEP_RECORD, "CALIBRATION", &calib_ch0, &calib_ch1))
+    {
+        DDS_SetFrequency(100);
+        return MEASURE_STEP_DONE;
+    }
+    uint32_t count = ADC_PlanRecordLength(calib.sample_rate, freq);
+    ExtractADCData(calib_ch0, calib_ch1, count);
+    
+    /* 计算幅度和相位（使用自适应采样率） */
+    uint16_t pp_ch1 = CalculatePeakToPeak(calib_ch0, count);
+    uint16_t pp_ch2 = CalculatePeakToPeak(calib_ch1, count);
+    int32_t phase_raw = EstimatePhaseShift_Int(calib_ch0, calib_ch1, count, calib.sample_rate, freq);
+    Scratch_Release(calib_ch0);
+    
+    /* 检查有效性 */
+    if(pp_ch1 < 10 || pp_ch2 < 10)
+    {
+        printf("[ERROR] CALIB_FAIL:%d,signal_weak\r\n", freq);
+        printf("[提示] 请检查PA6和PB1是否正确连接！\r\n");
+        DDS_SetFrequency(100);
+        return MEASURE_STEP_DONE;
+    }
+    
+    /* 计算校准系数 */
+    uint32_t H_measured = ((uint32_t)pp_ch2 * 10000) / pp_ch1;
+    
+    uint32_t correction = 100000000UL / H_measured;
+    if(correction > 65535) correction = 65535;
+    g_calibration.gain_correction[freq_idx] = (uint16_t)correction;
+    
+    g_calibration.phase_correction[freq_idx] = (int16_t)(-phase_raw);
+    
+    /* 输出校准数据 */
+    if(Telemetry_IsBinary())
+    {
+        Telemetry_SendCalib(freq, (float)H_measured / 10000.0f, (float)phase_raw / 100.0f);
+    }
+    else
+    {
         printf("CALIB_DATA:%d,%d.%04d,%s%d.%02d\r\n", 
                freq,
                H_measured/10000, H_measured%10000,
                (phase_raw<0)?"-":"", abs(phase_raw/100), abs(phase_raw%100));
-        
-        if(freq % 100 == 0)
-        {
-            printf("# Calibration Progress: %d/1000 Hz\r\n", freq);
-        }
     }
     
+    if(freq % 100 == 0)
+    {
+        printf("# Calibration Progress: %d/1000 Hz\r\n", freq);
+    }
+    
+    calib.settled = 0;
+    if(++calib.freq_idx < CALIBRATION_POINTS) return 0;
+    
     /* 标记校准数据有效 */
     g_calibration.valid = 1;
     
@@ -410,4 +908,426 @@ void AutoCalibration(void)
     printf("================================================\r\n\r\n");
     
     DDS_SetFrequency(100);
+    return MEASURE_STEP_DONE;
+}
+
+/*!
+ * \brief   启动后台波形采集（CAPTURE命令）
+ */
+void Measure_StartCapture(uint32_t signal_freq, uint32_t sample_rate)
+{
+    capture.started = 0;
+    capture.signal_freq = signal_freq;
+    capture.sample_rate = sample_rate;
+    Measure_Begin(MEASURE_JOB_CAPTURE);
+}
+
+/*!
+ * \brief   采集作业单步：先设置并等待DMA填满，再提取发送
+ */
+static uint32_t Capture_Step(void)
+{
+    if(!capture.started)
+    {
+        capture.started = 1;
+        return CaptureWaveform_Begin(capture.signal_freq, &capture.sample_rate);
+    }
+    
+    CaptureWaveform_Finish(capture.signal_freq, capture.sample_rate);
+    return MEASURE_STEP_DONE;
+}
+
+/*!
+ * \brief   启动多节点扫描（SCAN命令），使用当前DDS频率和幅度
+ */
+void Measure_StartScan(void)
+{
+    scan.started = 0;
+    scan.signal_freq = DDS_GetFrequency();
+    Measure_Begin(MEASURE_JOB_SCAN);
+}
+
+/*!
+ * \brief   扫描作业单步：先切换扫描序列并等待DMA填满，再计算输出
+ */
+static uint32_t Scan_Step(void)
+{
+    if(!scan.started)
+    {
+        scan.started = 1;
+        return ScanNodes_Begin(scan.signal_freq, &scan.sample_rate, &scan.frames);
+    }
+    
+    ScanNodes_Finish(scan.signal_freq, scan.sample_rate, scan.frames);
+    return MEASURE_STEP_DONE;
+}
+
+/*!
+ * \brief   启动等效时间采样（ETS命令）
+ */
+void Measure_StartEts(uint32_t signal_freq, uint32_t averages)
+{
+    ets.phase = 0;
+    ets.signal_freq = signal_freq;
+    ets.averages = averages;
+    Measure_Begin(MEASURE_JOB_ETS);
+}
+
+/*!
+ * \brief   输出重建的单周期波形
+ */
+static void Ets_Report(void)
+{
+    uint16_t *ch0, *ch1;
+    uint32_t eq_rate = ets.signal_freq * ETS_BINS;
+    
+    if(!Scratch_BorrowPair(ETS_BINS, "ETS", &ch0, &ch1)) return;
+    
+    uint32_t filled = ETS_GetWaveform(ch0, ch1);
+    
+    if(Telemetry_IsBinary())
+    {
+        Telemetry_SendWaveform(ets.signal_freq, eq_rate, ch0, ch1, ETS_BINS, TELEMETRY_SRC_ETS);
+    }
+    else
+    {
+        printf("ETS:%u,%u,%u,%u\r\n", (unsigned int)ets.signal_freq, (unsigned int)eq_rate,
+               (unsigned int)(ETS_TIMER_CLOCK / ets.ticks), (unsigned int)ETS_BINS);
+        printf("E0:");
+        for(uint32_t i = 0; i < ETS_BINS; i++)
+        {
+            printf("%u%s", (unsigned int)ch0[i], (i < ETS_BINS - 1) ? "," : "\r\n");
+        }
+        printf("E1:");
+        for(uint32_t i = 0; i < ETS_BINS; i++)
+        {
+            printf("%u%s", (unsigned int)ch1[i], (i < ETS_BINS - 1) ? "," : "\r\n");
+        }
+    }
+    Scratch_Release(ch0);
+    
+    printf("OK:ETS_COMPLETE:eq_rate=%uHz,filled=%u/%u\r\n",
+           (unsigned int)eq_rate, (unsigned int)filled, (unsigned int)ETS_BINS);
+}
+
+/*!
+ * \brief   等效时间采样作业单步：设置频率和精确采样周期 → 稳定后开始累加 → 完成后输出
+ */
+static uint32_t Ets_Step(void)
+{
+    extern void DDS_Start(void);
+    
+    switch(ets.phase)
+    {
+    case 0:
+        DDS_SetFrequency(ets.signal_freq);
+        DDS_Start();
+        ets.ticks = ADC_SetSamplePeriod(ETS_PlanTicks(ets.signal_freq));
+        ets.phase = 1;
+        return 50;      /* 信号稳定 */
+        
+    case 1:
+        ets.phase = 2;
+        return ETS_Start(ets.signal_freq, ets.ticks, ets.averages);
+        
+    default:
+        if(!ETS_IsDone()) return 10;
+        Ets_Report();
+        ADC_SetSampleRate(10000);
+        return MEASURE_STEP_DONE;
+    }
+}
+
+/*!
+ * \brief   启动单频跟踪（TRACK命令）
+ */
+void Measure_StartTrack(uint32_t signal_freq)
+{
+    tracking.phase = 0;
+    tracking.signal_freq = signal_freq;
+    tracking.unwrap.offset = 0;
+    tracking.unwrap.is_first = 1;
+    Measure_Begin(MEASURE_JOB_TRACK);
+}
+
+/*!
+ * \brief   按校准表修正H和相位（与扫频相同，只在10Hz~1kHz的10Hz整数倍有校准点）
+ */
+static float Measure_ApplyCalibration(uint32_t freq, float H, int32_t *phase_x100)
+{
+    if(g_calibration.valid && freq >= 10 && freq <= 1000 && (freq % 10) == 0)
+    {
+        uint32_t freq_idx = (freq / 10) - 1;
+        H = H * (float)g_calibration.gain_correction[freq_idx] / 10000.0f;
+        *phase_x100 += g_calibration.phase_correction[freq_idx];
+    }
+    return H;
+}
+
+/*!
+ * \brief   相对上一次输出展开相位（调试DUT时相位连续变化）
+ * \return  展开后的相位（度×100）
+ */
+static int32_t Measure_UnwrapPhase(Phase_Unwrap_t *u, int32_t phase_x100)
+{
+    if(!u->is_first)
+    {
+        int32_t phase_diff = phase_x100 - u->last;
+        if(phase_diff > 18000) u->offset -= 36000;
+        else if(phase_diff < -18000) u->offset += 36000;
+    }
+    u->last = phase_x100;
+    u->is_first = 0;
+    return phase_x100 + u->offset;
+}
+
+/*!
+ * \brief   输出一个滑动窗口的H/θ（与FREQ_RESP相同的校准和展开，幅度为ADC端峰值电压）
+ */
+static void Track_Report(const Track_Result_t *r)
+{
+    uint32_t freq = tracking.signal_freq;
+    float voltage_in = r->amplitude[0] * 3.3f / 4096.0f;
+    float voltage_out = r->amplitude[1] * 3.3f / 4096.0f;
+    float H = (voltage_in > 0.001f) ? voltage_out / voltage_in : 0.0f;
+    int32_t phase = r->phase_x100;
+    
+    H = Measure_ApplyCalibration(freq, H, &phase);
+    float theta = (float)Measure_UnwrapPhase(&tracking.unwrap, phase) / 100.0f;
+    
+    if(Telemetry_IsBinary())
+    {
+        Telemetry_SendTrack(r->seq, freq, voltage_in, voltage_out, H, theta);
+    }
+    else
+    {
+        printf("TRACK:%u,%u,%.4f,%.4f,%.6f,%.2f\r\n", (unsigned int)r->seq, (unsigned int)freq,
+               voltage_in, voltage_out, H, theta);
+    }
+}
+
+/*!
+ * \brief   单频跟踪作业单步：设置频率和采样率 → 稳定后开始累加 → 每个新窗口输出一次
+ * \details 新窗口由DMA中断唤醒MEASURE任务，返回的等待时间只是保底轮询
+ */
+static uint32_t Track_Step(void)
+{
+    extern void DDS_Start(void);
+    Track_Result_t r;
+    
+    switch(tracking.phase)
+    {
+    case 0:
+        DDS_SetFrequency(tracking.signal_freq);
+        DDS_Start();
+        tracking.sample_rate = ADC_SetSampleRate(ADC_PlanSampleRate(tracking.signal_freq));
+        tracking.phase = 1;
+        return 50;      /* 信号稳定 */
+        
+    case 1:
+    {
+        uint32_t window = Track_Start(tracking.signal_freq, tracking.sample_rate);
+        uint32_t update = Track_GetUpdateRate_mHz();
+        printf("OK:TRACK_START:freq=%uHz,fs=%uHz,window=%u,update=%u.%03uHz\r\n",
+               (unsigned int)tracking.signal_freq, (unsigned int)tracking.sample_rate, (unsigned int)window,
+               (unsigned int)(update / 1000), (unsigned int)(update % 1000));
+        tracking.phase = 2;
+        return 500;
+    }
+        
+    default:
+        if(Track_GetResult(&r)) Track_Report(&r);
+        return 500;
+    }
+}
+
+/*!
+ * \brief   启动锁相测量（LOCKIN命令）
+ */
+void Measure_StartLockin(uint32_t signal_freq, uint32_t tc_ms)
+{
+    lockin.phase = 0;
+    lockin.signal_freq = signal_freq;
+    lockin.tc_ms = tc_ms;
+    lockin.unwrap.offset = 0;
+    lockin.unwrap.is_first = 1;
+    Measure_Begin(MEASURE_JOB_LOCKIN);
+}
+
+/*!
+ * \brief   输出一次锁相结果（带等效噪声带宽和建立时间估计）
+ * \details 不做"信号过弱"判断：输出通道小于1 LSB也照常给出，只有输入参考通道
+ *          低于LOCKIN_REF_MIN时H/θ无意义，置REF_WEAK标志
+ */
+static void Lockin_Report(void)
+{
+    Lockin_Result_t r;
+    uint32_t freq = lockin.signal_freq;
+    uint32_t settle_ms = Lockin_GetSettleMs();
+    uint32_t enbw_mhz = Lockin_GetENBW_mHz();
+    uint8_t flags = 0;
+    
+    Lockin_GetResult(&r);
+    
+    float voltage_in = r.amplitude[0] * 3.3f / 4096.0f;
+    float voltage_out = r.amplitude[1] * 3.3f / 4096.0f;
+    float H = 0.0f;
+    float theta = 0.0f;
+    int32_t phase = r.phase_x100;
+    
+    if(r.elapsed_ms >= settle_ms) flags |= TELEMETRY_LI_SETTLED;
+    if(r.amplitude[0] < LOCKIN_REF_MIN)
+    {
+        /* 相位无意义，不参与展开（否则参考恢复时可能多出±360°） */
+        flags |= TELEMETRY_LI_REF_WEAK;
+    }
+    else
+    {
+        H = Measure_ApplyCalibration(freq, r.amplitude[1] / r.amplitude[0], &phase);
+        theta = (float)Measure_UnwrapPhase(&lockin.unwrap, phase) / 100.0f;
+    }
+    
+    if(Telemetry_IsBinary())
+    {
+        Telemetry_SendLockin(freq, lockin.tc_ms, settle_ms, r.elapsed_ms, (float)enbw_mhz / 1000.0f,
+                             (uint8_t)Lockin_GetStages(), flags, voltage_in, voltage_out, H, theta);
+    }
+    else
+    {
+        /* 幅度以uV输出，远低于1 LSB（806uV）时仍有有效数字 */
+        printf("LOCKIN:%u,%.1f,%.3f,%.4e,%.2f,%u.%03u,%u,%u,%s\r\n", (unsigned int)freq,
+               voltage_in * 1e6f, voltage_out * 1e6f, H, theta,
+               (unsigned int)(enbw_mhz / 1000), (unsigned int)(enbw_mhz % 1000),
+               (unsigned int)r.elapsed_ms, (unsigned int)settle_ms,
+               (flags & TELEMETRY_LI_REF_WEAK) ? "REF_WEAK" : ((flags & TELEMETRY_LI_SETTLED) ? "SETTLED" : "SETTLING"));
+    }
+}
+
+/*!
+ * \brief   锁相作业单步：设置频率和采样率 → 稳定后按DDS相位增量锁定参考 → 周期输出
+ * \details 输出间隔为时间常数（限制在LOCKIN_REPORT_MIN_MS~LOCKIN_REPORT_MAX_MS）
+ */
+static uint32_t Lockin_Step(void)
+{
+    extern void DDS_Start(void);
+    uint32_t interval = lockin.tc_ms;
+    
+    if(interval < LOCKIN_REPORT_MIN_MS) interval = LOCKIN_REPORT_MIN_MS;
+    if(interval > LOCKIN_REPORT_MAX_MS) interval = LOCKIN_REPORT_MAX_MS;
+    
+    switch(lockin.phase)
+    {
+    case 0:
+        DDS_SetFrequency(lockin.signal_freq);
+        DDS_Start();
+        lockin.sample_rate = ADC_SetSampleRate(ADC_PlanSampleRate(lockin.signal_freq));
+        lockin.phase = 1;
+        return 50;      /* 信号稳定，DDS新相位增量已在周期边界生效 */
+        
+    case 1:
+    {
+        lockin.tc_ms = Lockin_Start(lockin.signal_freq, lockin.sample_rate, ADC_GetSamplePeriodTicks(), lockin.tc_ms);
+        uint32_t enbw_mhz = Lockin_GetENBW_mHz();
+        printf("OK:LOCKIN_START:freq=%uHz,fs=%uHz,tc=%ums,order=%u,enbw=%u.%03uHz,settle=%ums\r\n",
+               (unsigned int)lockin.signal_freq, (unsigned int)lockin.sample_rate, (unsigned int)lockin.tc_ms,
+               (unsigned int)Lockin_GetStages(), (unsigned int)(enbw_mhz / 1000), (unsigned int)(enbw_mhz % 1000),
+               (unsigned int)Lockin_GetSettleMs());
+        lockin.phase = 2;
+        return interval;
+    }
+        
+    default:
+        Lockin_Report();
+        return interval;
+    }
+}
+
+/*!
+ * \brief   中止后台作业并恢复默认设置
+ */
+void Measure_Abort(void)
+{
+    Measure_Job_t job = measure_job;
+    
+    if(job == MEASURE_JOB_NONE) return;
+    
+    measure_job = MEASURE_JOB_NONE;
+    Sched_Cancel(SCHED_TASK_MEASURE);
+    
+    if(Record_GetState() != RECORD_IDLE)
+    {
+        Record_Abort();
+    }
+    
+    if(job == MEASURE_JOB_CAPTURE)
+    {
+        ADC_SetSampleRate(10000);
+    }
+    else if(job == MEASURE_JOB_POINT)
+    {
+        /* 单点测量只停止累加，保持当前频率；DDC采样率与完成时相同恢复 */
+        if(measure_ddc) ADC_SetSampleRate(ADC_PlanSampleRate(DDS_GetFrequency()));
+    }
+    else if(job == MEASURE_JOB_SCAN)
+    {
+        ScanNodes_Abort();
+    }
+    else if(job == MEASURE_JOB_ETS)
+    {
+        ETS_Abort();
+        ADC_SetSampleRate(10000);
+    }
+    else if(job == MEASURE_JOB_TRACK)
+    {
+        /* 保持跟踪频率，便于接着MEASURE/START */
+        Track_Stop();
+    }
+    else if(job == MEASURE_JOB_LOCKIN)
+    {
+        Lockin_Stop();
+    }
+    else
+    {
+        /* 校准中途取消时，已清空的校准数据保持无效 */
+        DDS_SetFrequency(100);
+        DDS_SetAmplitude(DDS_AMPLITUDE_FULL);
+        if(measure_ddc)
+        {
+            /* DDC扫频固定在MEASURE_DDC_SAMPLE_RATE，与Sweep_Finish相同恢复 */
+            ADC_SetSampleRate(ADC_PlanSampleRate(100));
+        }
+    }
+    
+    printf("OK:%s_ABORTED\r\n", Measure_JobName(job));
+}
+
+/*!
+ * \brief   调度器MEASURE任务：执行当前作业的一步，按返回值安排下一步
+ */
+void Measure_Process(void)
+{
+    uint32_t wait_ms;
+    
+    switch(measure_job)
+    {
+    case MEASURE_JOB_SWEEP:
+    case MEASURE_JOB_POINT:       wait_ms = Sweep_Step();       break;
+    case MEASURE_JOB_CALIBRATION: wait_ms = Calibration_Step(); break;
+    case MEASURE_JOB_CAPTURE:     wait_ms = Capture_Step();     break;
+    case MEASURE_JOB_SCAN:        wait_ms = Scan_Step();        break;
+    case MEASURE_JOB_ETS:         wait_ms = Ets_Step();         break;
+    case MEASURE_JOB_TRACK:       wait_ms = Track_Step();       break;
+    case MEASURE_JOB_LOCKIN:      wait_ms = Lockin_Step();      break;
+    default: return;
+    }
+    
+    if(wait_ms == MEASURE_STEP_DONE)
+    {
+        measure_job = MEASURE_JOB_NONE;
+    }
+    else
+    {
+        /* wait_ms=0时也经调度器重新排队，先让命令任务运行 */
+        Sched_PostDelayed(SCHED_TASK_MEASURE, wait_ms);
+    }
 }
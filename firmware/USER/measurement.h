@@ -10,6 +10,16 @@
 
 #include "gd32f10x.h"
 
+/* 数字下变频（DDC）测量配置 */
+#define MEASURE_DDC_SAMPLE_RATE 25000   /* 整个扫频不变：≥2kHz五次谐波的2倍，过采样时正好R=2 */
+#define MEASURE_DDC_MIN_CYCLES  10      /* 至少积分10个整周期（sinc低通的零点落在各次谐波上） */
+#define MEASURE_DDC_MIN_MS      50      /* 且至少50ms */
+
+/* 锁相（LOCKIN）输出配置 */
+#define LOCKIN_REF_MIN          1.0f    /* 输入参考通道最小幅度（ADC码），低于此H/θ无意义 */
+#define LOCKIN_REPORT_MIN_MS    100     /* 输出间隔=时间常数，限制在100ms~1s */
+#define LOCKIN_REPORT_MAX_MS    1000
+
 /* 校准系统配置 */
 #define CALIBRATION_POINTS  100  /* 校准点数量：10Hz-1000Hz，步进10Hz */
 
@@ -23,18 +33,96 @@ typedef struct {
 /* 外部校准数据声明 */
 extern CalibrationData_t g_calibration;
 
+/* 后台测量作业（调度器MEASURE任务分步执行，同一时刻只有一个） */
+typedef enum {
+    MEASURE_JOB_NONE = 0,
+    MEASURE_JOB_SWEEP,
+    MEASURE_JOB_CALIBRATION,
+    MEASURE_JOB_CAPTURE,
+    MEASURE_JOB_POINT,          /* 长记录单点测量（MEASURE） */
+    MEASURE_JOB_SCAN,           /* 多节点扫描（SCAN） */
+    MEASURE_JOB_ETS,            /* 等效时间采样（ETS） */
+    MEASURE_JOB_TRACK,          /* 单频实时跟踪（TRACK，ABORT前一直运行） */
+    MEASURE_JOB_LOCKIN          /* 数字锁相（LOCKIN，ABORT前一直运行） */
+} Measure_Job_t;
+
 /* 函数声明 */
 
 /*!
- * \brief   自动扫频测量（10Hz ~ 1kHz）
+ * \brief   启动自动扫频测量（10Hz ~ 2kHz），立即返回
  * \details 每隔10Hz测量一次，输出完整的频率响应曲线
  */
 void AutoSweep(void);
 
 /*!
- * \brief   自动校准系统（测量直连环路响应）
+ * \brief   启动自动校准（测量直连环路响应），立即返回
  * \details 测量100个频率点的传输特性，保存校准系数
  */
 void AutoCalibration(void);
 
+/*!
+ * \brief   启动后台欠采样波形采集，立即返回
+ */
+void Measure_StartCapture(uint32_t signal_freq, uint32_t sample_rate);
+
+/*!
+ * \brief   启动等效时间采样波形重建，立即返回
+ * \param   averages - 每个相位格的平均次数（1~ETS_AVG_MAX）
+ */
+void Measure_StartEts(uint32_t signal_freq, uint32_t averages);
+
+/*!
+ * \brief   启动单频实时跟踪，立即返回（ABORT停止）
+ * \details 每个滑动窗口输出一次H/θ（TRACK_RATE_MIN~TRACK_RATE_MAX Hz）
+ */
+void Measure_StartTrack(uint32_t signal_freq);
+
+/*!
+ * \brief   启动数字锁相测量，立即返回（ABORT停止）
+ * \param   tc_ms - 低通时间常数(ms)
+ */
+void Measure_StartLockin(uint32_t signal_freq, uint32_t tc_ms);
+
+/*!
+ * \brief   启动当前频率的多节点扫描作业，立即返回
+ */
+void Measure_StartScan(void);
+
+/*!
+ * \brief   启动当前频率的单点测量作业（长记录时MEASURE使用），立即返回
+ */
+void Measure_StartPoint(void);
+
+/*!
+ * \brief   设置MEASURE/SWEEP的记录长度
+ * \param   length - 0=自动（adc_buffer内整周期），否则为长记录样本数
+ *                   （RECORD_MIN_LENGTH~RECORD_MAX_LENGTH，按整周期向下取整）
+ */
+void Measure_SetRecordLength(uint32_t length);
+uint32_t Measure_GetRecordLength(void);
+
+/*!
+ * \brief   使能/禁用固定采样率数字下变频（DDC）测量
+ * \details 使能后SWEEP/MEASURE整个过程采样率固定为MEASURE_DDC_SAMPLE_RATE，
+ *          每点用DDS频率的正交参考混频后积分整周期（数字锁相），不再逐点重设TIMER3
+ */
+void Measure_SetDDC(uint8_t enable);
+uint8_t Measure_GetDDC(void);
+
+/*!
+ * \brief   中止当前作业（恢复默认频率/幅度/采样率）
+ */
+void Measure_Abort(void);
+
+/*!
+ * \brief   查询当前作业
+ */
+Measure_Job_t Measure_GetJob(void);
+const char *Measure_JobName(Measure_Job_t job);
+
+/*!
+ * \brief   调度器MEASURE任务：执行当前作业的一步
+ */
+void Measure_Process(void);
+
 #endif /* __MEASUREMENT_H */
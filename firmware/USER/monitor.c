@@ -0,0 +1,198 @@
+/*!
+ * \file    monitor.c
+ * \brief   CPU负载与中断延迟监视实现
+ * \author  GD32 Bode Analyzer
+ * \version v1.0
+ */
+
+#include "monitor.h"
+#include "scheduler.h"
+#include "telemetry.h"
+#include "../BSP/TIMEBASE/timebase.h"
+#include <stdio.h>
+
+/* 中断名称与入口延迟换算：每个定时器计数对应的内核周期（预分频+1），0=不可测 */
+typedef struct {
+    const char *name;
+    uint32_t cycles_per_count;
+} Mon_IrqInfo_t;
+
+/* 顺序与Mon_Irq_t一致 */
+static const Mon_IrqInfo_t mon_irq_info[MON_IRQ_COUNT] = {
+    {"TIMER0_UP",   72},    /* 1MHz计数 */
+    {"TIMER2",      1},     /* 72MHz计数 */
+    {"TIMER5",      72},    /* 1MHz计数 */
+    {"USART0",      0},
+    {"DMA_ADC",     0},
+    {"DMA_UART_TX", 0},
+    {"DMA_UART_RX", 0},
+    {"DMA_DDS",     0},
+};
+
+/* 当前窗口累加值 */
+static uint32_t mon_count_acc[MON_IRQ_COUNT];
+static uint32_t mon_exec_acc[MON_IRQ_COUNT];
+static uint32_t mon_idle_acc = 0;
+static uint32_t mon_window_start = 0;
+
+/* 上一窗口结果与最大值 */
+static Mon_IrqStat_t mon_irq[MON_IRQ_COUNT];
+static Mon_Load_t mon_load = {0};
+
+static uint8_t mon_auto = 0;
+static Timebase_Timer_t mon_timer;
+
+/*!
+ * \brief   1秒窗口结算（TIMER5中断中，软件定时器回调已关中断）
+ */
+static void Monitor_WindowExpired(uint32_t arg)
+{
+    uint32_t now = Timebase_Micros();
+    uint32_t window = now - mon_window_start;
+    mon_window_start = now;
+
+    for(uint32_t i = 0; i < MON_IRQ_COUNT; i++)
+    {
+        mon_irq[i].count = mon_count_acc[i];
+        mon_irq[i].exec_cycles = mon_exec_acc[i];
+        mon_count_acc[i] = 0;
+        mon_exec_acc[i] = 0;
+    }
+
+    uint32_t idle = mon_idle_acc;
+    mon_idle_acc = 0;
+    if(idle > window) idle = window;
+
+    mon_load.window_us = window;
+    mon_load.idle_us = idle;
+    mon_load.load_permille = window ? (uint16_t)((uint64_t)(window - idle) * 1000 / window) : 0;
+    if(mon_load.load_permille > mon_load.peak_permille)
+    {
+        mon_load.peak_permille = mon_load.load_permille;
+    }
+
+    if(mon_auto) Sched_Post(SCHED_TASK_MONITOR);
+}
+
+void Monitor_Init(void)
+{
+    Monitor_Reset();
+    mon_window_start = Timebase_Micros();
+    Timebase_TimerStart(&mon_timer, 1000, 1000, Monitor_WindowExpired, 0);
+}
+
+void Monitor_IrqRecord(Mon_Irq_t irq, uint32_t cnt, uint32_t cycles)
+{
+    Mon_IrqStat_t *s = &mon_irq[irq];
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    mon_count_acc[irq]++;
+    mon_exec_acc[irq] += cycles;
+    if(cycles > s->exec_max) s->exec_max = cycles;
+
+    if(mon_irq_info[irq].cycles_per_count)
+    {
+        uint32_t latency = cnt * mon_irq_info[irq].cycles_per_count;
+        if(s->latency_max == MON_LATENCY_NONE || latency > s->latency_max)
+        {
+            s->latency_max = latency;
+        }
+    }
+
+    __set_PRIMASK(primask);
+}
+
+void Monitor_AddIdle(uint32_t us)
+{
+    mon_idle_acc += us;
+}
+
+void Monitor_Reset(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    for(uint32_t i = 0; i < MON_IRQ_COUNT; i++)
+    {
+        mon_irq[i].exec_max = 0;
+        mon_irq[i].latency_max = MON_LATENCY_NONE;
+    }
+    mon_load.peak_permille = mon_load.load_permille;
+
+    __set_PRIMASK(primask);
+}
+
+void Monitor_SetAuto(uint8_t enable)
+{
+    mon_auto = enable ? 1 : 0;
+}
+
+uint8_t Monitor_GetAuto(void)
+{
+    return mon_auto;
+}
+
+void Monitor_GetLoad(Mon_Load_t *load)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *load = mon_load;
+    __set_PRIMASK(primask);
+}
+
+void Monitor_GetIrq(Mon_Irq_t irq, Mon_IrqStat_t *stat)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *stat = mon_irq[irq];
+    __set_PRIMASK(primask);
+}
+
+const char *Monitor_IrqName(Mon_Irq_t irq)
+{
+    return (irq < MON_IRQ_COUNT) ? mon_irq_info[irq].name : "?";
+}
+
+void Monitor_Report(void)
+{
+    Mon_Load_t load;
+    Mon_IrqStat_t s;
+    uint32_t cycles_per_window;
+
+    Monitor_GetLoad(&load);
+    /* 窗口内总周期数，用于各中断占用率 */
+    cycles_per_window = (uint32_t)((uint64_t)SystemCoreClock * load.window_us / 1000000);
+    if(cycles_per_window == 0) cycles_per_window = 1;
+
+    printf("LOAD:CPU %u.%u%% (peak %u.%u%%, idle %uus/%uus)\r\n",
+           (unsigned int)(load.load_permille / 10), (unsigned int)(load.load_permille % 10),
+           (unsigned int)(load.peak_permille / 10), (unsigned int)(load.peak_permille % 10),
+           (unsigned int)load.idle_us, (unsigned int)load.window_us);
+    printf("  IRQ          n/s    lat_max  exec_max  share (cycles)\r\n");
+    for(uint32_t i = 0; i < MON_IRQ_COUNT; i++)
+    {
+        Monitor_GetIrq((Mon_Irq_t)i, &s);
+        uint32_t share = (uint32_t)((uint64_t)s.exec_cycles * 1000 / cycles_per_window);
+
+        if(s.latency_max == MON_LATENCY_NONE)
+        {
+            printf("  %-12s %-6u %-8s %-9u %u.%u%%\r\n", mon_irq_info[i].name,
+                   (unsigned int)s.count, "-", (unsigned int)s.exec_max,
+                   (unsigned int)(share / 10), (unsigned int)(share % 10));
+        }
+        else
+        {
+            printf("  %-12s %-6u %-8u %-9u %u.%u%%\r\n", mon_irq_info[i].name,
+                   (unsigned int)s.count, (unsigned int)s.latency_max, (unsigned int)s.exec_max,
+                   (unsigned int)(share / 10), (unsigned int)(share % 10));
+        }
+    }
+
+    if(Telemetry_IsBinary()) Telemetry_SendLoad();
+}
+
+void Monitor_Process(void)
+{
+    if(mon_auto) Monitor_Report();
+}
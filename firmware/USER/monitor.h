@@ -0,0 +1,104 @@
+/*!
+ * \file    monitor.h
+ * \brief   CPU负载与中断延迟监视
+ * \author  GD32 Bode Analyzer
+ * \version v1.0
+ * \details 调度器WFI休眠时间按TIMER5微秒计时，每秒结算一次CPU占用率；
+ *          各中断入口/出口读DWT->CYCCNT得到执行时间（含被更高优先级抢占的时间），
+ *          定时器中断入口读计数器值（更新事件后计数器从0开始）得到入口延迟。
+ *          USART0/DMA中断没有硬件时间戳，只统计执行时间
+ */
+
+#ifndef __MONITOR_H
+#define __MONITOR_H
+
+#include "gd32f10x.h"
+
+/* 0=中断探针编译为空 */
+#ifndef MONITOR_ENABLE
+#define MONITOR_ENABLE  1
+#endif
+
+/* 被监视的中断 */
+typedef enum {
+    MON_IRQ_TIMER0_UP = 0,  /* LED模式节拍1kHz（LED PWM由TIMER0/TIMER1硬件输出，TIMER1无中断） */
+    MON_IRQ_TIMER2,         /* DDS 50kHz */
+    MON_IRQ_TIMER5,         /* 时间基准1kHz */
+    MON_IRQ_USART0,         /* 串口IDLE */
+    MON_IRQ_DMA_ADC,        /* DMA0_CH0 ADC数据流半缓冲 */
+    MON_IRQ_DMA_UART_TX,    /* DMA0_CH3 串口发送完成 */
+    MON_IRQ_DMA_UART_RX,    /* DMA0_CH4 串口接收半缓冲 */
+    MON_IRQ_DMA_DDS,        /* DMA0_CH5 高速DDS半缓冲 */
+    MON_IRQ_COUNT
+} Mon_Irq_t;
+
+/* 单个中断统计（单位：内核时钟周期） */
+typedef struct {
+    uint32_t count;         /* 上一秒进入次数 */
+    uint32_t exec_cycles;   /* 上一秒执行时间合计 */
+    uint32_t exec_max;      /* 最大执行时间（LOAD:RESET清零） */
+    uint32_t latency_max;   /* 最大入口延迟，不可测时为MON_LATENCY_NONE */
+} Mon_IrqStat_t;
+
+/* CPU占用统计 */
+typedef struct {
+    uint32_t window_us;     /* 上一统计窗口长度 */
+    uint32_t idle_us;       /* 其中WFI休眠时间 */
+    uint16_t load_permille; /* 占用率（‰） */
+    uint16_t peak_permille; /* 最高占用率（LOAD:RESET清零） */
+} Mon_Load_t;
+
+#define MON_LATENCY_NONE    0xFFFFFFFFUL
+
+#if MONITOR_ENABLE
+/* cnt: 定时器中断传入TIMER_CNT(x)，其他中断传0 */
+#define MON_IRQ_ENTER(t, cnt)   uint32_t t = DWT->CYCCNT; uint32_t t##_cnt = (cnt)
+#define MON_IRQ_EXIT(irq, t)    Monitor_IrqRecord((irq), t##_cnt, DWT->CYCCNT - (t))
+#else
+#define MON_IRQ_ENTER(t, cnt)
+#define MON_IRQ_EXIT(irq, t)
+#endif
+
+/*!
+ * \brief   启动1秒统计窗口（须在Prof_Init使能DWT、Timebase_Init之后调用）
+ */
+void Monitor_Init(void);
+
+/*!
+ * \brief   记录一次中断（中断中调用）
+ * \param   cnt    - 入口处定时器计数值（按定时器分频换算为周期）
+ * \param   cycles - 执行时间
+ */
+void Monitor_IrqRecord(Mon_Irq_t irq, uint32_t cnt, uint32_t cycles);
+
+/*!
+ * \brief   累计空闲时间（调度器关中断WFI前后调用）
+ */
+void Monitor_AddIdle(uint32_t us);
+
+/*!
+ * \brief   清零最大值统计
+ */
+void Monitor_Reset(void);
+
+/*!
+ * \brief   设置每秒自动输出（0=关闭）
+ */
+void Monitor_SetAuto(uint8_t enable);
+uint8_t Monitor_GetAuto(void);
+
+void Monitor_GetLoad(Mon_Load_t *load);
+void Monitor_GetIrq(Mon_Irq_t irq, Mon_IrqStat_t *stat);
+const char *Monitor_IrqName(Mon_Irq_t irq);
+
+/*!
+ * \brief   输出负载报告：文本表，二进制模式下另发LOAD帧
+ */
+void Monitor_Report(void);
+
+/*!
+ * \brief   调度器MONITOR任务：自动输出模式下每秒输出一次报告
+ */
+void Monitor_Process(void);
+
+#endif /* __MONITOR_H */
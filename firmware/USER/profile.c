@@ -0,0 +1,113 @@
+/*!
+ * \file    profile.c
+ * \brief   DWT周期计数性能探针实现
+ * \author  GD32 Bode Analyzer
+ * \version v1.0
+ */
+
+#include "profile.h"
+#include "telemetry.h"
+#include <stdio.h>
+
+/* 探针名称：顺序与Prof_Id_t一致 */
+static const char *const prof_names[PROF_COUNT] = {
+    "EXTRACT_ADC",
+    "PEAK_TO_PEAK",
+    "DC_OFFSET",
+    "AMPLITUDE_DFT",
+    "PHASE_SHIFT",
+    "DISTORTION",
+    "DAC_WRITE",
+    "TIMER2_IRQ",
+    "LED_PROCESS",
+    "UART_TX",
+    "DECIMATE",
+};
+
+static Prof_Stat_t prof_stats[PROF_COUNT];
+
+void Prof_Init(void)
+{
+    /* TRCENA使能DWT，CYCCNT自由运行（72MHz约59.6s回绕，差值计算不受影响） */
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    Prof_Reset();
+}
+
+void Prof_Record(Prof_Id_t id, uint32_t cycles)
+{
+    Prof_Stat_t *s = &prof_stats[id];
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    if(s->count == 0 || cycles < s->min) s->min = cycles;
+    if(cycles > s->max) s->max = cycles;
+    s->total += cycles;
+    s->count++;
+
+    __set_PRIMASK(primask);
+}
+
+void Prof_Reset(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    for(uint32_t i = 0; i < PROF_COUNT; i++)
+    {
+        prof_stats[i].count = 0;
+        prof_stats[i].min = 0;
+        prof_stats[i].max = 0;
+        prof_stats[i].total = 0;
+    }
+
+    __set_PRIMASK(primask);
+}
+
+void Prof_Get(Prof_Id_t id, Prof_Stat_t *stat)
+{
+    /* total为64位，关中断读取保证一致 */
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *stat = prof_stats[id];
+    __set_PRIMASK(primask);
+}
+
+const char *Prof_Name(Prof_Id_t id)
+{
+    return (id < PROF_COUNT) ? prof_names[id] : "?";
+}
+
+void Prof_Report(void)
+{
+#if PROFILE_ENABLE
+    uint32_t mhz = SystemCoreClock / 1000000;
+    Prof_Stat_t s;
+
+    if(mhz == 0) mhz = 1;
+
+    printf("PROF:CYCLES @%uMHz (count min/mean/max, mean us)\r\n", (unsigned int)mhz);
+    for(uint32_t i = 0; i < PROF_COUNT; i++)
+    {
+        Prof_Get((Prof_Id_t)i, &s);
+        if(s.count == 0)
+        {
+            printf("  %-14s -\r\n", prof_names[i]);
+            continue;
+        }
+
+        uint32_t mean = (uint32_t)(s.total / s.count);
+        printf("  %-14s %u %u/%u/%u %u.%02u\r\n", prof_names[i],
+               (unsigned int)s.count, (unsigned int)s.min,
+               (unsigned int)mean, (unsigned int)s.max,
+               (unsigned int)(mean / mhz),
+               (unsigned int)((mean % mhz) * 100 / mhz));
+    }
+
+    if(Telemetry_IsBinary()) Telemetry_SendProfile();
+#else
+    printf("PROF:DISABLED (PROFILE_ENABLE=0)\r\n");
+#endif
+}
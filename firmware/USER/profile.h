@@ -0,0 +1,72 @@
+/*!
+ * \file    profile.h
+ * \brief   DWT周期计数性能探针
+ * \author  GD32 Bode Analyzer
+ * \version v1.0
+ * \details Cortex-M3 DWT->CYCCNT以内核时钟（72MHz）计数，探针记录代码段耗时的
+ *          次数/最小/最大/均值（周期），PROF命令输出文本表或PROFILE二进制帧。
+ *          探针嵌套时各自计入完整耗时（如AmplitudeDFT包含其内部的DCOffset）
+ */
+
+#ifndef __PROFILE_H
+#define __PROFILE_H
+
+#include "gd32f10x.h"
+
+/* 0=探针编译为空（不占用周期） */
+#ifndef PROFILE_ENABLE
+#define PROFILE_ENABLE  1
+#endif
+
+/* 探针编号 */
+typedef enum {
+    PROF_EXTRACT_ADC = 0,   /* ExtractADCData */
+    PROF_PEAK_TO_PEAK,      /* CalculatePeakToPeak */
+    PROF_DC_OFFSET,         /* CalculateDCOffset */
+    PROF_AMPLITUDE_DFT,     /* CalculateAmplitude_DFT */
+    PROF_PHASE_SHIFT,       /* EstimatePhaseShift_Int */
+    PROF_DISTORTION,        /* CalculateDistortion */
+    PROF_DAC_WRITE,         /* DAC5311_Write12（50kHz DDS每样本一次） */
+    PROF_TIMER2_IRQ,        /* TIMER2_IRQHandler（50kHz DDS） */
+    PROF_LED_PROCESS,       /* LED_Process（1kHz） */
+    PROF_UART_TX,           /* printf/UART_Write入队 */
+    PROF_DECIMATE,          /* Decim_OnADCBlock（过采样时每32个原始样本对） */
+    PROF_COUNT
+} Prof_Id_t;
+
+/* 单个探针统计（单位：内核时钟周期） */
+typedef struct {
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t total;
+} Prof_Stat_t;
+
+#if PROFILE_ENABLE
+#define PROF_BEGIN(t)       uint32_t t = DWT->CYCCNT
+#define PROF_END(id, t)     Prof_Record((id), DWT->CYCCNT - (t))
+#else
+#define PROF_BEGIN(t)
+#define PROF_END(id, t)
+#endif
+
+/*!
+ * \brief   使能DWT周期计数器并清零统计
+ */
+void Prof_Init(void);
+
+/*!
+ * \brief   记录一次耗时（中断安全）
+ */
+void Prof_Record(Prof_Id_t id, uint32_t cycles);
+
+void Prof_Reset(void);
+void Prof_Get(Prof_Id_t id, Prof_Stat_t *stat);
+const char *Prof_Name(Prof_Id_t id);
+
+/*!
+ * \brief   输出统计：文本表，二进制模式下另发PROFILE帧
+ */
+void Prof_Report(void);
+
+#endif /* __PROFILE_H */
@@ -0,0 +1,68 @@
+/*!
+ * \file    record.h
+ * \brief   长记录流式累加测量
+ * \author  GD32 Bode Analyzer
+ * \version v1.0
+ * \details adc_buffer只有ADC_BUFFER_SIZE点，低频时整周期数太少。长记录不保存样本：
+ *          DMA0_CH0半缓冲区中断中逐点累加两通道的和、平方和、最值以及
+ *          与参考正弦/余弦（相位累加器查1/4周期表）的乘积，
+ *          记录长度只受采集时间限制，结果与DSP函数（RMS幅度、DFT相位）口径一致
+ */
+
+#ifndef __RECORD_H
+#define __RECORD_H
+
+#include "gd32f10x.h"
+#include "../BSP/DMA/dma.h"
+
+#define RECORD_MIN_LENGTH   (2 * ADC_BUFFER_SIZE)   /* 更短的记录直接用adc_buffer */
+#define RECORD_MAX_LENGTH   65536UL     /* 累加器按此上限选择位宽 */
+
+/* 记录状态 */
+typedef enum {
+    RECORD_IDLE = 0,
+    RECORD_RUNNING,
+    RECORD_DONE
+} Record_State_t;
+
+/* 记录结果（下标0=ADC0/PA6输入参考，1=ADC1/PB1输出） */
+typedef struct {
+    uint32_t count;             /* 实际样本数 */
+    uint16_t dc[2];             /* 均值 */
+    uint16_t pp[2];             /* 峰峰值 */
+    uint16_t peak[2];           /* 最大值（削波检测） */
+    float amplitude[2];         /* 去直流RMS×√2（与CalculateAmplitude_DFT一致） */
+    float fundamental[2];       /* DFT基波峰值幅度 */
+    float thd[2];               /* 总谐波失真（%），由总RMS与基波RMS求得 */
+    int32_t phase_x100;         /* 相位差CH0-CH1（度×100，与EstimatePhaseShift_Int一致） */
+} Record_Result_t;
+
+/*!
+ * \brief   开始一条长记录（从下一个DMA半缓冲区开始累加）
+ * \param   length      - 样本数（不超过RECORD_MAX_LENGTH）
+ * \param   signal_freq - 参考正弦频率(Hz)
+ * \param   sample_rate - 实际ADC采样率(Hz)
+ * \return  预计采集时间(ms)
+ */
+uint32_t Record_Start(uint32_t length, uint32_t signal_freq, uint32_t sample_rate);
+
+/*!
+ * \brief   中止记录并关闭累加
+ */
+void Record_Abort(void);
+
+Record_State_t Record_GetState(void);
+
+/*!
+ * \brief   计算结果（仅RECORD_DONE时有效），并回到空闲
+ * \return  0=记录未完成
+ */
+uint8_t Record_GetResult(Record_Result_t *result);
+
+/*!
+ * \brief   DMA0_CH0半传输/传输完成中断中调用
+ * \param   frac_bits - 码值小数位（0或ADC_CODE_FRAC_BITS），内部统一为Q4累加
+ */
+void Record_OnADCBlock(const uint32_t *block, uint32_t count, uint32_t frac_bits);
+
+#endif /* __RECORD_H */
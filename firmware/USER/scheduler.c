@@ -0,0 +1,107 @@
+/*!
+ * \file    scheduler.c
+ * \brief   主循环协作式调度器实现
+ * \author  GD32 Bode Analyzer
+ * \version v1.0
+ */
+
+#include "scheduler.h"
+#include "command.h"
+#include "stream.h"
+#include "measurement.h"
+#include "monitor.h"
+#include "../BSP/TIMEBASE/timebase.h"
+
+/* 任务表项 */
+typedef struct {
+    const char *name;
+    void (*run)(void);
+} Sched_Task_t;
+
+/* 任务表：顺序与Sched_TaskId_t一致 */
+static const Sched_Task_t sched_tasks[SCHED_TASK_COUNT] = {
+    {"COMMAND", Command_Process},
+    {"STREAM",  Stream_Process},
+    {"MEASURE", Measure_Process},
+    {"MONITOR", Monitor_Process},
+};
+
+static volatile uint32_t sched_ready = 0;           /* 就绪位图 */
+static Timebase_Timer_t sched_timers[SCHED_TASK_COUNT];  /* 延时就绪（TIMER5软件定时器） */
+static Sched_Stats_t sched_stats = {0};
+
+void Sched_Post(Sched_TaskId_t id)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    sched_ready |= (1UL << id);
+    __set_PRIMASK(primask);
+}
+
+/*!
+ * \brief   软件定时器到期回调（TIMER5中断中）
+ */
+static void Sched_TimerExpired(uint32_t id)
+{
+    Sched_Post((Sched_TaskId_t)id);
+}
+
+void Sched_PostDelayed(Sched_TaskId_t id, uint32_t delay_ms)
+{
+    if(delay_ms == 0)
+    {
+        Timebase_TimerStop(&sched_timers[id]);
+        Sched_Post(id);
+        return;
+    }
+
+    Timebase_TimerStart(&sched_timers[id], delay_ms, 0, Sched_TimerExpired, id);
+}
+
+void Sched_Cancel(Sched_TaskId_t id)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    Timebase_TimerStop(&sched_timers[id]);
+    sched_ready &= ~(1UL << id);
+    __set_PRIMASK(primask);
+}
+
+void Sched_Run(void)
+{
+    while(1)
+    {
+        __disable_irq();
+        uint32_t ready = sched_ready;
+        if(ready == 0)
+        {
+            /* 关中断后检查再WFI：检查与休眠之间到达的中断挂起后仍能唤醒；
+             * 唤醒后先计时再开中断，休眠时间不含中断处理（CPU负载统计） */
+            sched_stats.idle++;
+            uint32_t sleep_start = Timebase_Micros();
+            __WFI();
+            Monitor_AddIdle(Timebase_Micros() - sleep_start);
+            __enable_irq();
+            continue;
+        }
+
+        /* 最低位=最高优先级 */
+        uint32_t id = 0;
+        while(!(ready & (1UL << id))) id++;
+        sched_ready &= ~(1UL << id);
+        __enable_irq();
+
+        sched_stats.runs[id]++;
+        sched_tasks[id].run();
+    }
+}
+
+void Sched_GetStats(Sched_Stats_t *stats)
+{
+    *stats = sched_stats;
+}
+
+const char *Sched_TaskName(Sched_TaskId_t id)
+{
+    return (id < SCHED_TASK_COUNT) ? sched_tasks[id].name : "?";
+}
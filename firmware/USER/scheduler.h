@@ -0,0 +1,55 @@
+/*!
+ * \file    scheduler.h
+ * \brief   主循环协作式调度器
+ * \author  GD32 Bode Analyzer
+ * \version v1.0
+ * \details 固定任务表，任务函数运行到返回（不可抢占）。中断或任务自身通过
+ *          Sched_Post/Sched_PostDelayed（TIMER5软件定时器）置就绪，主循环每次运行
+ *          优先级最高的就绪任务；没有就绪任务时WFI休眠，由下一个中断（至少1ms节拍）唤醒
+ */
+
+#ifndef __SCHEDULER_H
+#define __SCHEDULER_H
+
+#include "gd32f10x.h"
+
+/* 任务编号，数值越小优先级越高 */
+typedef enum {
+    SCHED_TASK_COMMAND = 0,     /* 串口命令（扫频进行中也能执行STATUS/ABORT/LED等） */
+    SCHED_TASK_STREAM,          /* 实时数据流块输出 */
+    SCHED_TASK_MEASURE,         /* 后台测量作业（扫频/校准/采集），每步之间让出 */
+    SCHED_TASK_MONITOR,         /* LOAD:AUTO每秒负载报告 */
+    SCHED_TASK_COUNT
+} Sched_TaskId_t;
+
+/* 调度统计 */
+typedef struct {
+    uint32_t runs[SCHED_TASK_COUNT];    /* 各任务运行次数 */
+    uint32_t idle;                      /* WFI休眠次数 */
+} Sched_Stats_t;
+
+/*!
+ * \brief   置任务就绪（中断安全）
+ */
+void Sched_Post(Sched_TaskId_t id);
+
+/*!
+ * \brief   延时置任务就绪（中断安全，覆盖之前的定时）
+ * \param   delay_ms - 0等同Sched_Post
+ */
+void Sched_PostDelayed(Sched_TaskId_t id, uint32_t delay_ms);
+
+/*!
+ * \brief   取消任务的就绪状态和定时
+ */
+void Sched_Cancel(Sched_TaskId_t id);
+
+/*!
+ * \brief   主循环：运行就绪任务，空闲时WFI（不返回）
+ */
+void Sched_Run(void);
+
+void Sched_GetStats(Sched_Stats_t *stats);
+const char *Sched_TaskName(Sched_TaskId_t id);
+
+#endif /* __SCHEDULER_H */
@@ -0,0 +1,106 @@
+/*!
+ * \file    scratch.c
+ * \brief   测量临时缓冲区实现
+ * \author  GD32 Bode Analyzer
+ * \version v1.0
+ */
+
+#include "scratch.h"
+#include <stdio.h>
+
+/* 借出块记录 */
+typedef struct {
+    uint32_t offset;
+    uint32_t size;          /* 0=空闲 */
+    const char *owner;
+} Scratch_Block_t;
+
+static uint32_t scratch_pool[SCRATCH_SIZE / sizeof(uint32_t)];
+static Scratch_Block_t scratch_blocks[SCRATCH_MAX_BLOCKS];
+static Scratch_Stats_t scratch_stats = {SCRATCH_SIZE, 0, 0, "-", 0, 0};
+
+/*!
+ * \brief   当前占用的末端（新块从这里开始分配）
+ */
+static uint32_t Scratch_Top(void)
+{
+    uint32_t top = 0;
+    for(uint32_t i = 0; i < SCRATCH_MAX_BLOCKS; i++)
+    {
+        uint32_t end = scratch_blocks[i].offset + scratch_blocks[i].size;
+        if(scratch_blocks[i].size && end > top) top = end;
+    }
+    return top;
+}
+
+void *Scratch_Borrow(uint32_t bytes, const char *owner)
+{
+    uint32_t top = Scratch_Top();
+    Scratch_Block_t *slot = NULL;
+
+    bytes = (bytes + 3) & ~3UL;
+
+    for(uint32_t i = 0; i < SCRATCH_MAX_BLOCKS; i++)
+    {
+        if(scratch_blocks[i].size == 0)
+        {
+            slot = &scratch_blocks[i];
+            break;
+        }
+    }
+
+    if(slot == NULL || bytes == 0 || bytes > SCRATCH_SIZE - top)
+    {
+        scratch_stats.failures++;
+        printf("[ERROR] Scratch: %s needs %u bytes (%u/%u used)\r\n", owner,
+               (unsigned int)bytes, (unsigned int)top, (unsigned int)SCRATCH_SIZE);
+        return NULL;
+    }
+
+    slot->offset = top;
+    slot->size = bytes;
+    slot->owner = owner;
+
+    scratch_stats.blocks++;
+    scratch_stats.used = top + bytes;
+    if(scratch_stats.used > scratch_stats.high_water)
+    {
+        scratch_stats.high_water = scratch_stats.used;
+        scratch_stats.high_water_owner = owner;
+    }
+
+    return (uint8_t *)scratch_pool + top;
+}
+
+uint8_t Scratch_BorrowPair(uint32_t count, const char *owner, uint16_t **ch0, uint16_t **ch1)
+{
+    uint16_t *p = (uint16_t *)Scratch_Borrow(count * 2 * sizeof(uint16_t), owner);
+    if(p == NULL) return 0;
+
+    *ch0 = p;
+    *ch1 = p + count;
+    return 1;
+}
+
+void Scratch_Release(const void *block)
+{
+    if(block == NULL) return;
+    
+    uint32_t offset = (uint32_t)((const uint8_t *)block - (const uint8_t *)scratch_pool);
+
+    for(uint32_t i = 0; i < SCRATCH_MAX_BLOCKS; i++)
+    {
+        if(scratch_blocks[i].size && scratch_blocks[i].offset == offset)
+        {
+            scratch_blocks[i].size = 0;
+            scratch_stats.blocks--;
+            scratch_stats.used = Scratch_Top();
+            return;
+        }
+    }
+}
+
+void Scratch_GetStats(Scratch_Stats_t *stats)
+{
+    *stats = scratch_stats;
+}
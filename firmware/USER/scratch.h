@@ -0,0 +1,52 @@
+/*!
+ * \file    scratch.h
+ * \brief   测量临时缓冲区（共享内存池）
+ * \author  GD32 Bode Analyzer
+ * \version v1.0
+ * \details MEASURE、扫频/校准单步、CAPTURE、WAVE/UWAVE原先各自持有静态双通道数组，
+ *          但它们都只在一次命令或一个作业单步内使用数据，不会同时运行，
+ *          因此改为从同一块内存借用、用完归还。
+ *          只能在线程模式（命令/调度器任务）中使用，不可在中断中调用
+ */
+
+#ifndef __SCRATCH_H
+#define __SCRATCH_H
+
+#include "gd32f10x.h"
+#include "../BSP/DMA/dma.h"
+
+/* 内存池大小：一整条ADC记录的双通道u16数据 */
+#define SCRATCH_SIZE        (ADC_BUFFER_SIZE * 2 * sizeof(uint16_t))
+#define SCRATCH_MAX_BLOCKS  4       /* 同时借出的块数上限 */
+
+/* 使用统计 */
+typedef struct {
+    uint32_t size;
+    uint32_t used;                  /* 当前占用（字节，含对齐） */
+    uint32_t high_water;            /* 最大占用 */
+    const char *high_water_owner;   /* 达到最大占用时申请的使用者 */
+    uint32_t failures;              /* 空间不足次数 */
+    uint8_t blocks;                 /* 当前借出块数 */
+} Scratch_Stats_t;
+
+/*!
+ * \brief   借用一块内存（4字节对齐）
+ * \param   owner - 使用者名称（统计与错误提示用）
+ * \return  NULL=空间不足（已打印错误）
+ */
+void *Scratch_Borrow(uint32_t bytes, const char *owner);
+
+/*!
+ * \brief   借用count点的双通道u16缓冲区，ch1紧跟在ch0之后
+ * \return  1=成功，0=空间不足；归还时Scratch_Release(*ch0)
+ */
+uint8_t Scratch_BorrowPair(uint32_t count, const char *owner, uint16_t **ch0, uint16_t **ch1);
+
+/*!
+ * \brief   归还内存块（顺序不限）
+ */
+void Scratch_Release(const void *block);
+
+void Scratch_GetStats(Scratch_Stats_t *stats);
+
+#endif /* __SCRATCH_H */
@@ -6,6 +6,7 @@
  */
 
 #include "signal_processing.h"
+#include "profile.h"
 #include <math.h>
 #include <stddef.h>  /* 包含NULL定义 */
 
@@ -25,6 +26,7 @@ uint16_t CalculatePeakToPeak(uint16_t *data, uint32_t count)
     /* 边界检查 */
     if(count == 0 || data == NULL) return 0;
     
+    PROF_BEGIN(prof_t);
     uint16_t min = 4095;
     uint16_t max = 0;
     
@@ -34,6 +36,7 @@ uint16_t CalculatePeakToPeak(uint16_t *data, uint32_t count)
         if(data[i] > max) max = data[i];
     }
     
+    PROF_END(PROF_PEAK_TO_PEAK, prof_t);
     return (max - min);
 }
 
@@ -48,6 +51,7 @@ uint16_t CalculateDCOffset(uint16_t *data, uint32_t count)
     /* 边界检查 */
     if(count == 0 || data == NULL) return 0;
     
+    PROF_BEGIN(prof_t);
     uint32_t sum = 0;
     
     for(uint32_t i = 0; i < count; i++)
@@ -55,6 +59,7 @@ uint16_t CalculateDCOffset(uint16_t *data, uint32_t count)
         sum += data[i];
     }
     
+    PROF_END(PROF_DC_OFFSET, prof_t);
     return (uint16_t)(sum / count);
 }
 
@@ -71,6 +76,8 @@ float CalculateAmplitude_DFT(uint16_t *signal, uint32_t count, uint32_t sample_r
     /* 边界检查 */
     if(count == 0 || signal == NULL) return 0.0f;
     
+    PROF_BEGIN(prof_t);
+    
     /* 去除直流偏移 */
     uint16_t dc = CalculateDCOffset(signal, count);
     
@@ -96,6 +103,7 @@ float CalculateAmplitude_DFT(uint16_t *signal, uint32_t count, uint32_t sample_r
      */
     float amplitude = rms * 1.414213562f;  /* √2 ≈ 1.414213562 */
     
+    PROF_END(PROF_AMPLITUDE_DFT, prof_t);
     return amplitude;
 }
 
@@ -114,6 +122,8 @@ int32_t EstimatePhaseShift_Int(uint16_t *signal1, uint16_t *signal2, uint32_t co
     /* 边界检查 */
     if(count == 0 || signal1 == NULL || signal2 == NULL || sample_rate == 0) return 0;
     
+    PROF_BEGIN(prof_t);
+    
     /* 去除直流偏移 */
     uint16_t dc1 = CalculateDCOffset(signal1, count);
     uint16_t dc2 = CalculateDCOffset(signal2, count);
@@ -160,6 +170,7 @@ int32_t EstimatePhaseShift_Int(uint16_t *signal1, uint16_t *signal2, uint32_t co
     while(phase_diff_deg > 18000.0f) phase_diff_deg -= 36000.0f;
     while(phase_diff_deg < -18000.0f) phase_diff_deg += 36000.0f;
     
+    PROF_END(PROF_PHASE_SHIFT, prof_t);
     return (int32_t)phase_diff_deg;
 }
 
@@ -177,6 +188,8 @@ float CalculateDistortion(uint16_t *data, uint32_t count, uint32_t freq, uint32_
     /* 边界检查 */
     if(count == 0 || data == NULL || sample_rate == 0) return 100.0f;
     
+    PROF_BEGIN(prof_t);
+    
     /* 去除直流偏移 */
     uint16_t dc = CalculateDCOffset(data, count);
     
@@ -205,7 +218,11 @@ float CalculateDistortion(uint16_t *data, uint32_t count, uint32_t freq, uint32_
     total_energy = sqrtf(total_energy / count);
     
     /* 失真度 = sqrt(总能量^2 - 基波能量^2) / 基波能量 */
-    if(fundamental < 1.0f) return 100.0f;
+    if(fundamental < 1.0f)
+    {
+        PROF_END(PROF_DISTORTION, prof_t);
+        return 100.0f;
+    }
     
     float fundamental_rms = fundamental / sqrtf(2.0f * count);
     
@@ -221,5 +238,63 @@ float CalculateDistortion(uint16_t *data, uint32_t count, uint32_t freq, uint32_
     if(thd < 0.0f) thd = 0.0f;
     if(thd > 100.0f) thd = 100.0f;
     
+    PROF_END(PROF_DISTORTION, prof_t);
     return thd;
 }
+
+/*!
+ * \brief   多通道单频点DFT（按帧交错的样本）
+ * \param   samples   - 第i帧通道n的样本在samples[i×stride + n]
+ * \param   stride    - 每帧样本数（≥channels）
+ * \param   channels  - 通道数（不超过SP_MAX_CHANNELS）
+ * \param   count     - 帧数
+ * \param   sample_rate - 帧率（Hz）
+ * \param   signal_freq - 信号频率（Hz）
+ * \param   amplitude - 输出：各通道基波峰值幅度（ADC值）
+ * \param   phase_rad - 输出：各通道基波相位（弧度，x=A·cos(ωt+φ)中的φ）
+ * \details 每帧只计算一次sin/cos，各通道共用；先求各通道直流再去除
+ */
+void CalculateFundamental_Multi(const uint16_t *samples, uint32_t stride, uint32_t channels,
+                                uint32_t count, uint32_t sample_rate, uint32_t signal_freq,
+                                float *amplitude, float *phase_rad)
+{
+    uint32_t dc_sum[SP_MAX_CHANNELS] = {0};
+    float dc[SP_MAX_CHANNELS];
+    float re[SP_MAX_CHANNELS] = {0.0f};
+    float im[SP_MAX_CHANNELS] = {0.0f};
+    
+    if(channels > SP_MAX_CHANNELS) channels = SP_MAX_CHANNELS;
+    if(count == 0 || samples == NULL || sample_rate == 0) return;
+    
+    for(uint32_t i = 0; i < count; i++)
+    {
+        for(uint32_t n = 0; n < channels; n++)
+        {
+            dc_sum[n] += samples[i * stride + n];
+        }
+    }
+    for(uint32_t n = 0; n < channels; n++)
+    {
+        dc[n] = (float)dc_sum[n] / (float)count;
+    }
+    
+    float omega = 2.0f * PI * signal_freq / (float)sample_rate;
+    for(uint32_t i = 0; i < count; i++)
+    {
+        float sin_val = sinf(omega * i);
+        float cos_val = cosf(omega * i);
+        
+        for(uint32_t n = 0; n < channels; n++)
+        {
+            float val = (float)samples[i * stride + n] - dc[n];
+            re[n] += val * cos_val;
+            im[n] -= val * sin_val;
+        }
+    }
+    
+    for(uint32_t n = 0; n < channels; n++)
+    {
+        amplitude[n] = 2.0f * sqrtf(re[n] * re[n] + im[n] * im[n]) / (float)count;
+        phase_rad[n] = atan2f(im[n], re[n]);
+    }
+}
@@ -60,4 +60,14 @@ int32_t EstimatePhaseShift_Int(uint16_t *signal1, uint16_t *signal2, uint32_t co
  */
 float CalculateDistortion(uint16_t *data, uint32_t count, uint32_t freq, uint32_t sample_rate);
 
+/*!
+ * \brief   多通道单频点DFT（多节点扫描，按帧交错的样本）
+ * \param   samples - 第i帧通道n的样本在samples[i×stride + n]
+ * \param   amplitude/phase_rad - 输出：各通道基波峰值幅度（ADC值）和相位（弧度）
+ */
+#define SP_MAX_CHANNELS  8
+void CalculateFundamental_Multi(const uint16_t *samples, uint32_t stride, uint32_t channels,
+                                uint32_t count, uint32_t sample_rate, uint32_t signal_freq,
+                                float *amplitude, float *phase_rad);
+
 #endif /* __SIGNAL_PROCESSING_H */
@@ -0,0 +1,252 @@
+/*!
+ * \file    stream.c
+ * \brief   实时波形数据流实现
+ * \author  GD32 Bode Analyzer
+ * \version v1.0
+ * \details 原实现在50kHz的TIMER2中断里每个点调用一次printf，且读取的adc_buffer位置
+ *          与DMA写入位置无关、上报的采样率为固定值。现改为：
+ *          - DMA0_CH0半传输/传输完成中断中处理刚填满的半个缓冲区，按降采样比做均值
+ *          - 结果写入样本对环形缓冲区，满时计数丢弃
+ *          - 凑满一块（约50ms）时唤醒调度器的STREAM任务发送，采样率=ADC实际采样率/降采样比
+ */
+
+#include "stream.h"
+#include "telemetry.h"
+#include "scheduler.h"
+#include "main.h"
+#include "../BSP/DMA/dma.h"
+#include "../BSP/DDS/dds.h"
+#include <stdio.h>
+
+/* 外部采样率函数声明（过采样时为抽取输出速率） */
+extern uint32_t ADC_GetSampleRate(void);
+
+#define STREAM_RING_MASK    (STREAM_RING_SIZE - 1)
+
+static volatile uint8_t stream_enable = 0;
+static uint32_t stream_requested_rate = 0;      /* 0=自动 */
+
+/* 当前降采样配置（主循环写，中断读） */
+static volatile uint16_t stream_decimation = 1;
+static uint32_t stream_adc_rate = 0;
+static uint32_t stream_rate = 0;
+static uint16_t stream_block = STREAM_BLOCK_MIN;
+
+/* 中断侧均值累加器 */
+static uint32_t stream_acc0 = 0;
+static uint32_t stream_acc1 = 0;
+static uint16_t stream_acc_n = 0;
+
+/* 样本对环形缓冲区（与adc_buffer相同格式：高16位ADC1，低16位ADC0） */
+static uint32_t stream_ring[STREAM_RING_SIZE];
+static volatile uint16_t stream_head = 0;       /* 中断写 */
+static volatile uint16_t stream_tail = 0;       /* 主循环读 */
+
+static volatile uint32_t stream_dropped = 0;
+static uint32_t stream_dropped_reported = 0;
+static uint32_t stream_sent = 0;
+
+/*!
+ * \brief   清空缓冲区和累加器（调用者须已关中断）
+ */
+static void Stream_Reset(void)
+{
+    stream_acc0 = 0;
+    stream_acc1 = 0;
+    stream_acc_n = 0;
+    stream_tail = stream_head;
+}
+
+/*!
+ * \brief   根据当前ADC采样率和请求速率计算降采样比
+ * \details ADC采样率或信号频率改变后重新计算，并丢弃按旧速率采集的样本
+ */
+static void Stream_Configure(void)
+{
+    uint32_t adc_rate = ADC_GetSampleRate();
+    uint32_t target = stream_requested_rate;
+    uint32_t decim;
+    
+    if(adc_rate == 0) return;
+    
+    if(target == 0)
+    {
+        if(g_signal_type == SIGNAL_TYPE_ECG)
+        {
+            target = adc_rate;
+        }
+        else
+        {
+            target = DDS_GetFrequency() * STREAM_POINTS_PER_CYCLE;
+            if(target < STREAM_RATE_MIN) target = STREAM_RATE_MIN;
+            if(target > STREAM_RATE_MAX) target = STREAM_RATE_MAX;
+        }
+    }
+    
+    decim = (adc_rate + target / 2) / target;
+    if(decim < 1) decim = 1;
+    if(decim > 0xFFFF) decim = 0xFFFF;
+    
+    if(decim == stream_decimation && adc_rate == stream_adc_rate) return;
+    
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    stream_decimation = (uint16_t)decim;
+    Stream_Reset();
+    __set_PRIMASK(primask);
+    
+    stream_adc_rate = adc_rate;
+    stream_rate = adc_rate / decim;
+    
+    /* 每块约50ms数据 */
+    stream_block = (uint16_t)(stream_rate / 20);
+    if(stream_block < STREAM_BLOCK_MIN) stream_block = STREAM_BLOCK_MIN;
+    if(stream_block > STREAM_BLOCK_MAX) stream_block = STREAM_BLOCK_MAX;
+}
+
+void Stream_Start(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    Stream_Reset();
+    stream_dropped = 0;
+    __set_PRIMASK(primask);
+    
+    stream_dropped_reported = 0;
+    stream_sent = 0;
+    stream_adc_rate = 0;    /* 强制重新计算降采样比 */
+    Stream_Configure();
+    
+    stream_enable = 1;
+    ADC_DMA_SetBlockIRQ(ADC_BLOCK_USER_STREAM, 1);
+}
+
+void Stream_Stop(void)
+{
+    stream_enable = 0;
+    ADC_DMA_SetBlockIRQ(ADC_BLOCK_USER_STREAM, 0);
+}
+
+uint8_t Stream_IsEnabled(void)
+{
+    return stream_enable;
+}
+
+void Stream_SetRate(uint32_t rate_hz)
+{
+    stream_requested_rate = rate_hz;
+}
+
+uint32_t Stream_GetRequestedRate(void)
+{
+    return stream_requested_rate;
+}
+
+void Stream_OnADCBlock(const uint32_t *block, uint32_t count, uint32_t frac_bits)
+{
+    uint16_t decim = stream_decimation;
+    uint16_t head = stream_head;
+    
+    if(!stream_enable) return;
+    
+    /* 网页端按12位码显示，抽取输出的小数位在此舍入 */
+    for(uint32_t i = 0; i < count; i++)
+    {
+        uint32_t v = block[i];
+        stream_acc0 += ADC_Code12(v & 0xFFFF, frac_bits);
+        stream_acc1 += ADC_Code12(v >> 16, frac_bits);
+        
+        if(++stream_acc_n >= decim)
+        {
+            uint16_t next = (uint16_t)((head + 1) & STREAM_RING_MASK);
+            if(next == stream_tail)
+            {
+                stream_dropped++;
+            }
+            else
+            {
+                stream_ring[head] = (stream_acc0 / decim) | ((stream_acc1 / decim) << 16);
+                head = next;
+            }
+            stream_acc0 = 0;
+            stream_acc1 = 0;
+            stream_acc_n = 0;
+        }
+    }
+    stream_head = head;
+    
+    /* 凑满一块（或有新的丢弃需要上报）时唤醒主循环发送 */
+    if((uint16_t)((head - stream_tail) & STREAM_RING_MASK) >= stream_block || stream_dropped != stream_dropped_reported)
+    {
+        Sched_Post(SCHED_TASK_STREAM);
+    }
+}
+
+/*!
+ * \brief   发送一块样本（文本WAVEFORM行或二进制WAVEFORM帧）
+ */
+static void Stream_SendBlock(const uint16_t *ch0, const uint16_t *ch1, uint16_t count)
+{
+    /* ECG模式频率字段固定为1，网页端据此切换显示模式 */
+    uint32_t freq = (g_signal_type == SIGNAL_TYPE_ECG) ? 1 : DDS_GetFrequency();
+    
+    if(Telemetry_IsBinary())
+    {
+        Telemetry_SendWaveform(freq, stream_rate, ch0, ch1, count, TELEMETRY_SRC_STREAM);
+        return;
+    }
+    
+    printf("WAVEFORM:%u,%u,", (unsigned int)freq, (unsigned int)stream_rate);
+    for(uint16_t i = 0; i < count; i++)
+    {
+        printf(i ? ",%u" : "%u", ch0[i]);
+    }
+    printf("|");
+    for(uint16_t i = 0; i < count; i++)
+    {
+        printf(i ? ",%u" : "%u", ch1[i]);
+    }
+    printf("\r\n");
+}
+
+void Stream_Process(void)
+{
+    static uint16_t block_ch0[STREAM_BLOCK_MAX];
+    static uint16_t block_ch1[STREAM_BLOCK_MAX];
+    
+    if(!stream_enable) return;
+    
+    Stream_Configure();
+    
+    while((uint16_t)((stream_head - stream_tail) & STREAM_RING_MASK) >= stream_block)
+    {
+        uint16_t tail = stream_tail;
+        
+        for(uint16_t i = 0; i < stream_block; i++)
+        {
+            uint32_t v = stream_ring[tail];
+            block_ch0[i] = (uint16_t)(v & 0xFFFF);
+            block_ch1[i] = (uint16_t)(v >> 16);
+            tail = (uint16_t)((tail + 1) & STREAM_RING_MASK);
+        }
+        stream_tail = tail;
+        
+        Stream_SendBlock(block_ch0, block_ch1, stream_block);
+        stream_sent += stream_block;
+    }
+    
+    if(stream_dropped != stream_dropped_reported)
+    {
+        stream_dropped_reported = stream_dropped;
+        printf("WARN:STREAM_DROPPED:%u\r\n", (unsigned int)stream_dropped_reported);
+    }
+}
+
+void Stream_GetStats(Stream_Stats_t *stats)
+{
+    stats->rate = stream_rate;
+    stats->decimation = stream_decimation;
+    stats->pending = (uint16_t)((stream_head - stream_tail) & STREAM_RING_MASK);
+    stats->sent = stream_sent;
+    stats->dropped = stream_dropped;
+}
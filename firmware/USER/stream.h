@@ -0,0 +1,61 @@
+/*!
+ * \file    stream.h
+ * \brief   实时波形数据流（START/STREAM:START）
+ * \author  GD32 Bode Analyzer
+ * \version v1.0
+ * \details ADC DMA半传输/传输完成中断中对整块样本做均值降采样写入环形缓冲区，
+ *          主循环中按块打包为WAVEFORM（文本行或二进制帧）经发送缓冲区输出
+ */
+
+#ifndef __STREAM_H
+#define __STREAM_H
+
+#include "gd32f10x.h"
+
+/* 数据流参数 */
+#define STREAM_RING_SIZE        512     /* 降采样后样本对环形缓冲区（2的幂） */
+#define STREAM_BLOCK_MAX        128     /* 每块最多样本对 */
+#define STREAM_BLOCK_MIN        8       /* 每块最少样本对 */
+#define STREAM_RATE_MIN         100     /* 自动速率下限（Hz） */
+#define STREAM_RATE_MAX         5000    /* 自动速率上限（Hz） */
+#define STREAM_POINTS_PER_CYCLE 15      /* 自动速率：每信号周期约15点 */
+
+/* 数据流统计 */
+typedef struct {
+    uint32_t rate;          /* 实际输出采样率（ADC采样率/降采样比） */
+    uint16_t decimation;    /* 降采样比 */
+    uint16_t pending;       /* 缓冲区中待发送样本对 */
+    uint32_t sent;          /* 已发送样本对 */
+    uint32_t dropped;       /* 缓冲区满丢弃的样本对 */
+} Stream_Stats_t;
+
+/*!
+ * \brief   开始/停止数据流
+ */
+void Stream_Start(void);
+void Stream_Stop(void);
+uint8_t Stream_IsEnabled(void);
+
+/*!
+ * \brief   设置请求的输出采样率
+ * \param   rate_hz - 0=自动（每周期约15点，ECG模式为ADC全速）
+ */
+void Stream_SetRate(uint32_t rate_hz);
+uint32_t Stream_GetRequestedRate(void);
+
+/*!
+ * \brief   ADC DMA块回调（DMA0_CH0半传输/传输完成中断中调用）
+ * \param   block     - adc_buffer中刚填满的一半（高16位ADC1，低16位ADC0）
+ * \param   count     - 样本数
+ * \param   frac_bits - 码值小数位（抽取输出时为ADC_CODE_FRAC_BITS），舍入为12位码发送
+ */
+void Stream_OnADCBlock(const uint32_t *block, uint32_t count, uint32_t frac_bits);
+
+/*!
+ * \brief   调度器STREAM任务：更新降采样配置并发送已就绪的数据块
+ */
+void Stream_Process(void);
+
+void Stream_GetStats(Stream_Stats_t *stats);
+
+#endif /* __STREAM_H */
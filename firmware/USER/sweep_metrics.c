@@ -0,0 +1,262 @@
+/*!
+ * \file    sweep_metrics.c
+ * \brief   扫频导出指标实现
+ * \author  GD32 Bode Analyzer
+ * \version v1.0
+ * \details 每点一次log10f和若干次浮点比较；交越点只取第一次跨越（扫频从低到高，
+ *          对低通/环路增益即为所需的点）。谐振Q优先用峰两侧-3dB点 f0/(f_hi-f_lo)，
+ *          峰值高出首点不到3dB（低频侧无-3dB点，即低Q的二阶低通峰化）时按峰值高度估计：
+ *          M = |H|pk/|H|首点 = Q/sqrt(1-1/(4Q²))，解得 Q² = (M² + M·sqrt(M²-1))/2
+ */
+
+#include "sweep_metrics.h"
+#include <math.h>
+
+/* 增益表（dB×100）与各点频率(Hz) */
+static int16_t metrics_gain[METRICS_POINTS_MAX];
+static uint16_t metrics_freq[METRICS_POINTS_MAX];
+
+/* 增量状态 */
+static struct {
+    uint32_t start;
+    uint32_t count;
+    uint8_t flags;
+
+    /* 上一点 */
+    uint32_t prev_freq;
+    float prev_gain;
+    int32_t prev_phase;
+
+    /* -3dB带宽（相对首点） */
+    float ref_gain;
+    float bw_hz;
+
+    /* 峰值与高频侧-3dB点（峰值更新后重新寻找） */
+    uint32_t peak_idx;
+    uint32_t peak_freq;
+    float peak_gain;
+    float hi_freq;
+    uint8_t hi_found;
+
+    /* 增益/相位交越 */
+    float gc_freq;
+    float phase_margin;
+    float pc_freq;
+    float gain_margin;
+
+    /* 群时延 */
+    float gd_low;
+    float gd_sum;
+    uint32_t gd_n;
+    float gd_max;
+    float gd_max_freq;
+} metrics;
+
+/*!
+ * \brief   在(x0,y0)-(x1,y1)之间线性插值出y=level处的x
+ */
+static float Metrics_Cross(float x0, float y0, float x1, float y1, float level)
+{
+    if(y1 == y0) return x0;
+    return x0 + (level - y0) * (x1 - x0) / (y1 - y0);
+}
+
+static float Metrics_TableGain(uint32_t idx)
+{
+    return (float)metrics_gain[idx] / 100.0f;
+}
+
+static float Metrics_TableFreq(uint32_t idx)
+{
+    return (float)metrics_freq[idx];
+}
+
+void Metrics_Begin(void)
+{
+    metrics.start = 0;
+    metrics.count = 0;
+    metrics.flags = 0;
+    metrics.ref_gain = 0.0f;
+    metrics.bw_hz = 0.0f;
+    metrics.peak_idx = 0;
+    metrics.peak_freq = 0;
+    metrics.peak_gain = METRICS_GAIN_FLOOR_DB;
+    metrics.hi_freq = 0.0f;
+    metrics.hi_found = 0;
+    metrics.gc_freq = 0.0f;
+    metrics.phase_margin = 0.0f;
+    metrics.pc_freq = 0.0f;
+    metrics.gain_margin = 0.0f;
+    metrics.gd_low = 0.0f;
+    metrics.gd_sum = 0.0f;
+    metrics.gd_n = 0;
+    metrics.gd_max = 0.0f;
+    metrics.gd_max_freq = 0.0f;
+}
+
+void Metrics_AddPoint(uint32_t freq, float h, int32_t phase_x100)
+{
+    float gain = (h > 0.0f) ? 20.0f * log10f(h) : METRICS_GAIN_FLOOR_DB;
+    if(gain < METRICS_GAIN_FLOOR_DB) gain = METRICS_GAIN_FLOOR_DB;
+
+    uint32_t idx = metrics.count++;
+    if(idx < METRICS_POINTS_MAX)
+    {
+        metrics_gain[idx] = (int16_t)(gain * 100.0f + ((gain >= 0.0f) ? 0.5f : -0.5f));
+        metrics_freq[idx] = (uint16_t)freq;
+    }
+
+    if(idx == 0)
+    {
+        metrics.start = freq;
+        metrics.peak_freq = freq;
+        metrics.ref_gain = gain;
+        metrics.peak_gain = gain;
+    }
+    else
+    {
+        float f0 = (float)metrics.prev_freq;
+        float f1 = (float)freq;
+        float g0 = metrics.prev_gain;
+        float p0 = (float)metrics.prev_phase / 100.0f;
+        float p1 = (float)phase_x100 / 100.0f;
+
+        /* 群时延 τ = -dθ/dω：度×100/Hz → ms */
+        if(freq > metrics.prev_freq)
+        {
+            float gd = -(float)(phase_x100 - metrics.prev_phase) / (36.0f * (f1 - f0));
+            if(metrics.gd_n == 0 || gd > metrics.gd_max)
+            {
+                metrics.gd_max = gd;
+                metrics.gd_max_freq = (f0 + f1) / 2.0f;
+            }
+            if(metrics.gd_n == 0) metrics.gd_low = gd;
+            metrics.gd_sum += gd;
+            metrics.gd_n++;
+        }
+
+        /* -3dB带宽：第一次降到首点以下3dB */
+        float bw_level = metrics.ref_gain - 3.0f;
+        if(!(metrics.flags & METRICS_VALID_BW) && g0 > bw_level && gain <= bw_level)
+        {
+            metrics.bw_hz = Metrics_Cross(f0, g0, f1, gain, bw_level);
+            metrics.flags |= METRICS_VALID_BW;
+        }
+
+        /* 增益交越：第一次从0dB以上降到以下，相位裕度 = 180° + θ(fc) */
+        if(!(metrics.flags & METRICS_VALID_GC) && g0 > 0.0f && gain <= 0.0f)
+        {
+            metrics.gc_freq = Metrics_Cross(f0, g0, f1, gain, 0.0f);
+            metrics.phase_margin = 180.0f + p0 + (p1 - p0) * (metrics.gc_freq - f0) / (f1 - f0);
+            metrics.flags |= METRICS_VALID_GC;
+        }
+
+        /* 相位交越：第一次滞后到-180°，增益裕度 = -G(fp) */
+        if(!(metrics.flags & METRICS_VALID_PC) && p0 > -180.0f && p1 <= -180.0f)
+        {
+            metrics.pc_freq = Metrics_Cross(f0, p0, f1, p1, -180.0f);
+            metrics.gain_margin = -(g0 + (gain - g0) * (metrics.pc_freq - f0) / (f1 - f0));
+            metrics.flags |= METRICS_VALID_PC;
+        }
+
+        /* 峰值；之后第一次降到峰值以下3dB为高频侧-3dB点 */
+        if(gain > metrics.peak_gain)
+        {
+            metrics.peak_gain = gain;
+            metrics.peak_idx = idx;
+            metrics.peak_freq = freq;
+            metrics.hi_found = 0;
+        }
+        else if(!metrics.hi_found && g0 > metrics.peak_gain - 3.0f && gain <= metrics.peak_gain - 3.0f)
+        {
+            metrics.hi_freq = Metrics_Cross(f0, g0, f1, gain, metrics.peak_gain - 3.0f);
+            metrics.hi_found = 1;
+        }
+    }
+
+    metrics.prev_freq = freq;
+    metrics.prev_gain = gain;
+    metrics.prev_phase = phase_x100;
+}
+
+/*!
+ * \brief   谐振峰：3点抛物线（dB）拟合峰值频率/增益，求Q
+ * \return  1=有谐振峰
+ */
+static uint8_t Metrics_FitPeak(Metrics_Summary_t *s)
+{
+    uint32_t k = metrics.peak_idx;
+
+    /* 峰须在表内且两侧都有点，并明显高于首点 */
+    if(k == 0 || k + 1 >= metrics.count || k + 1 >= METRICS_POINTS_MAX) return 0;
+    if(metrics.peak_gain < metrics.ref_gain + METRICS_PEAK_MIN_DB) return 0;
+
+    float a = Metrics_TableGain(k - 1);
+    float b = Metrics_TableGain(k);
+    float c = Metrics_TableGain(k + 1);
+    float curv = a - 2.0f * b + c;
+    if(curv >= 0.0f) return 0;
+
+    /* 按点序号拟合，偏移量换算到偏向一侧的实际间隔（步进变化处两侧不等） */
+    float delta = 0.5f * (a - c) / curv;
+    float f_k = Metrics_TableFreq(k);
+    float step = (delta >= 0.0f) ? (Metrics_TableFreq(k + 1) - f_k) : (f_k - Metrics_TableFreq(k - 1));
+    s->peak_freq = f_k + delta * step;
+    s->peak_gain_db = b - 0.25f * (a - c) * delta;
+
+    /* 低频侧-3dB点：从峰值向低频找第一个不高于峰值-3dB的点 */
+    float level = metrics.peak_gain - 3.0f;
+    float lo_freq = 0.0f;
+    uint8_t lo_found = 0;
+    for(uint32_t i = k; i > 0; i--)
+    {
+        float g = Metrics_TableGain(i - 1);
+        if(g <= level)
+        {
+            lo_freq = Metrics_Cross(Metrics_TableFreq(i - 1), g,
+                                    Metrics_TableFreq(i), Metrics_TableGain(i), level);
+            lo_found = 1;
+            break;
+        }
+    }
+
+    if(lo_found && metrics.hi_found && metrics.hi_freq > lo_freq)
+    {
+        s->q = s->peak_freq / (metrics.hi_freq - lo_freq);
+    }
+    else
+    {
+        float m = powf(10.0f, (s->peak_gain_db - metrics.ref_gain) / 20.0f);
+        s->q = sqrtf((m * m + m * sqrtf(m * m - 1.0f)) / 2.0f);
+        s->flags |= METRICS_Q_PEAKING;
+    }
+    return 1;
+}
+
+void Metrics_Finish(Metrics_Summary_t *summary)
+{
+    Metrics_Summary_t *s = summary;
+
+    s->start = metrics.start;
+    s->stop = metrics.count ? metrics.prev_freq : metrics.start;
+    s->points = (uint16_t)metrics.count;
+    s->flags = metrics.flags;
+    s->ref_gain_db = metrics.ref_gain;
+    s->bw_hz = metrics.bw_hz;
+    s->peak_freq = (float)metrics.peak_freq;
+    s->peak_gain_db = metrics.peak_gain;
+    s->q = 0.0f;
+    s->gc_freq = metrics.gc_freq;
+    s->phase_margin = metrics.phase_margin;
+    s->pc_freq = metrics.pc_freq;
+    s->gain_margin = metrics.gain_margin;
+    s->gd_low_ms = metrics.gd_low;
+    s->gd_mean_ms = metrics.gd_n ? metrics.gd_sum / (float)metrics.gd_n : 0.0f;
+    s->gd_max_ms = metrics.gd_max;
+    s->gd_max_freq = metrics.gd_max_freq;
+
+    if(Metrics_FitPeak(s))
+    {
+        s->flags |= METRICS_VALID_PEAK;
+    }
+}
@@ -0,0 +1,67 @@
+/*!
+ * \file    sweep_metrics.h
+ * \brief   扫频导出指标（群时延、-3dB带宽、增益/相位裕度、谐振Q）
+ * \author  GD32 Bode Analyzer
+ * \version v1.0
+ * \details 原先这些指标只能把FREQ_RESP导出后在别处计算。扫频每输出一个点即增量更新：
+ *          群时延为相邻两点展开相位的有限差分，各交越点在跨越阈值的两点间线性插值，
+ *          谐振峰在最大增益点附近按3点抛物线拟合。只保留int16增益表（dB×100）和
+ *          uint16频率表（扫频步进在2kHz处变粗，点不等间隔），每点4字节，
+ *          用于扫频结束时从峰值向低频一侧寻找-3dB点；其余均为O(1)状态
+ */
+
+#ifndef __SWEEP_METRICS_H
+#define __SWEEP_METRICS_H
+
+#include "gd32f10x.h"
+
+#define METRICS_POINTS_MAX      380     /* 表点数：10~2000Hz步进10Hz + 2.1k~20kHz步进100Hz */
+#define METRICS_PEAK_MIN_DB     1.0f    /* 峰值须高出首点1dB以上才按谐振峰计算Q */
+#define METRICS_GAIN_FLOOR_DB   (-120.0f)
+
+/* 有效标志 */
+#define METRICS_VALID_BW        0x01    /* 找到相对首点-3dB的下降点 */
+#define METRICS_VALID_PEAK      0x02    /* 有谐振峰，peak/Q有效 */
+#define METRICS_VALID_GC        0x04    /* 找到0dB增益交越点，相位裕度有效 */
+#define METRICS_VALID_PC        0x08    /* 找到-180°相位交越点，增益裕度有效 */
+#define METRICS_Q_PEAKING       0x10    /* 峰两侧-3dB点不全，Q按二阶低通峰值高度估计 */
+
+/* 扫频结束时的汇总 */
+typedef struct {
+    uint32_t start;             /* 首点/末点频率(Hz) */
+    uint32_t stop;
+    uint16_t points;
+    uint8_t flags;              /* METRICS_VALID_xxx */
+    float ref_gain_db;          /* 首点增益（-3dB带宽的参考） */
+    float bw_hz;                /* -3dB带宽 */
+    float peak_freq;            /* 拟合峰值频率(Hz) */
+    float peak_gain_db;
+    float q;
+    float gc_freq;              /* 增益交越频率(Hz)和相位裕度(deg) */
+    float phase_margin;
+    float pc_freq;              /* 相位交越频率(Hz)和增益裕度(dB) */
+    float gain_margin;
+    float gd_low_ms;            /* 最低两点间的群时延 */
+    float gd_mean_ms;
+    float gd_max_ms;
+    float gd_max_freq;          /* 最大群时延所在区间的中点频率 */
+} Metrics_Summary_t;
+
+/*!
+ * \brief   开始一次扫频（清空增益表和增量状态），各点须按频率递增到来
+ */
+void Metrics_Begin(void);
+
+/*!
+ * \brief   加入一个频率点（扫频输出FREQ_RESP时调用）
+ * \param   h           - 校准后的幅频比
+ * \param   phase_x100  - 校准并展开后的相位（度×100）
+ */
+void Metrics_AddPoint(uint32_t freq, float h, int32_t phase_x100);
+
+/*!
+ * \brief   扫频结束：补齐需要整张增益表的部分并给出汇总
+ */
+void Metrics_Finish(Metrics_Summary_t *summary);
+
+#endif /* __SWEEP_METRICS_H */
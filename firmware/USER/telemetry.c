@@ -0,0 +1,553 @@
+/*!
+ * \file    telemetry.c
+ * \brief   二进制帧遥测协议实现
+ * \author  GD32 Bode Analyzer
+ * \version v1.0
+ * \details 512点双通道波形文本约5KB，RAW16帧为2KB+22字节，PACK12约1.5KB，
+ *          慢变信号的DELTA编码每样本约1字节；
+ *          浮点按IEEE754小端原样发送，网页端用DataView直接解码
+ */
+
+#include "telemetry.h"
+#include "measurement.h"
+#include "adc_handler.h"
+#include "profile.h"
+#include "monitor.h"
+#include "main.h"
+#include "../BSP/DDS/dds.h"
+#include "../BSP/USART/usart.h"
+
+/* 外部采样率函数声明（过采样时为抽取输出速率） */
+extern uint32_t ADC_GetSampleRate(void);
+
+static uint8_t telemetry_binary = 0;    /* 0=文本行，1=二进制帧 */
+static uint16_t telemetry_seq = 0;      /* 帧序号（每帧+1，网页端据此检测丢帧） */
+static uint16_t telemetry_crc;          /* 当前帧的CRC累加值 */
+static uint8_t telemetry_wave_encoding = TELEMETRY_WAVE_AUTO;
+
+/* CRC16-CCITT半字节查找表（32字节） */
+static const uint16_t crc16_nibble_table[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+/*!
+ * \brief   CRC16-CCITT累加
+ */
+static uint16_t CRC16_Update(uint16_t crc, const uint8_t *data, uint32_t len)
+{
+    while(len--)
+    {
+        uint8_t b = *data++;
+        crc = (uint16_t)((crc << 4) ^ crc16_nibble_table[(crc >> 12) ^ (b >> 4)]);
+        crc = (uint16_t)((crc << 4) ^ crc16_nibble_table[(crc >> 12) ^ (b & 0x0F)]);
+    }
+    return crc;
+}
+
+/* 小端写入辅助函数（避免结构体对齐/打包问题） */
+static uint8_t *put_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    return p + 2;
+}
+
+static uint8_t *put_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+    return p + 4;
+}
+
+static uint8_t *put_f32(uint8_t *p, float v)
+{
+    union { float f; uint32_t u; } cvt;
+    cvt.f = v;
+    return put_u32(p, cvt.u);
+}
+
+/*!
+ * \brief   开始一帧：发送帧头并初始化CRC
+ * \param   type - 帧类型
+ * \param   len  - payload总长度（随后由Telemetry_Append分段发送）
+ */
+static void Telemetry_BeginFrame(uint8_t type, uint16_t len)
+{
+    uint8_t header[TELEMETRY_HEADER_SIZE];
+    uint8_t *p = header;
+
+    *p++ = TELEMETRY_SYNC0;
+    *p++ = TELEMETRY_SYNC1;
+    *p++ = TELEMETRY_VERSION;
+    *p++ = type;
+    p = put_u16(p, telemetry_seq++);
+    put_u16(p, len);
+
+    telemetry_crc = CRC16_Update(0xFFFF, header + 2, TELEMETRY_HEADER_SIZE - 2);
+    UART_Write(header, TELEMETRY_HEADER_SIZE);
+}
+
+/*!
+ * \brief   追加payload数据
+ */
+static void Telemetry_Append(const void *data, uint32_t len)
+{
+    telemetry_crc = CRC16_Update(telemetry_crc, (const uint8_t *)data, len);
+    UART_Write((const uint8_t *)data, len);
+}
+
+/*!
+ * \brief   结束一帧：发送CRC
+ */
+static void Telemetry_EndFrame(void)
+{
+    uint8_t crc[TELEMETRY_CRC_SIZE];
+    put_u16(crc, telemetry_crc);
+    UART_Write(crc, TELEMETRY_CRC_SIZE);
+}
+
+/*!
+ * \brief   追加u16样本数组（按小端字节序发送，与CPU字节序无关）
+ */
+static void Telemetry_AppendU16Array(const uint16_t *data, uint16_t count)
+{
+    uint8_t chunk[64];
+    uint16_t n = 0;
+
+    for(uint16_t i = 0; i < count; i++)
+    {
+        put_u16(chunk + n, data[i]);
+        n += 2;
+        if(n == sizeof(chunk))
+        {
+            Telemetry_Append(chunk, n);
+            n = 0;
+        }
+    }
+    if(n) Telemetry_Append(chunk, n);
+}
+
+/*!
+ * \brief   追加PACK12编码样本（调用前须确认样本均<=0xFFF）
+ */
+static void Telemetry_AppendPacked12(const uint16_t *data, uint16_t count)
+{
+    uint8_t chunk[63];
+    uint16_t n = 0;
+
+    for(uint16_t i = 0; i < count; i += 2)
+    {
+        uint16_t s0 = data[i];
+        uint16_t s1 = (i + 1 < count) ? data[i + 1] : 0;
+
+        chunk[n++] = (uint8_t)s0;
+        chunk[n++] = (uint8_t)(((s0 >> 8) & 0x0F) | ((s1 & 0x0F) << 4));
+        chunk[n++] = (uint8_t)(s1 >> 4);
+        if(n == sizeof(chunk))
+        {
+            Telemetry_Append(chunk, n);
+            n = 0;
+        }
+    }
+    if(n) Telemetry_Append(chunk, n);
+}
+
+/* zigzag：把有符号差值映射为小的无符号数（0,-1,1,-2 → 0,1,2,3） */
+static uint32_t zigzag(int32_t d)
+{
+    return ((uint32_t)d << 1) ^ (uint32_t)(d >> 31);
+}
+
+static uint8_t varint_len(uint32_t v)
+{
+    uint8_t n = 1;
+    while(v >= 0x80)
+    {
+        v >>= 7;
+        n++;
+    }
+    return n;
+}
+
+/*!
+ * \brief   DELTA编码后的字节数
+ */
+static uint32_t Telemetry_DeltaSize(const uint16_t *data, uint16_t count)
+{
+    uint32_t size = 0;
+    int32_t prev = 0;
+
+    for(uint16_t i = 0; i < count; i++)
+    {
+        size += varint_len(zigzag((int32_t)data[i] - prev));
+        prev = data[i];
+    }
+    return size;
+}
+
+/*!
+ * \brief   追加DELTA编码样本
+ */
+static void Telemetry_AppendDelta(const uint16_t *data, uint16_t count)
+{
+    uint8_t chunk[64];
+    uint16_t n = 0;
+    int32_t prev = 0;
+
+    for(uint16_t i = 0; i < count; i++)
+    {
+        uint32_t z = zigzag((int32_t)data[i] - prev);
+        prev = data[i];
+
+        while(z >= 0x80)
+        {
+            chunk[n++] = (uint8_t)(z | 0x80);
+            z >>= 7;
+        }
+        chunk[n++] = (uint8_t)z;
+
+        /* 单个样本最多3字节（u16差值zigzag后<2^17） */
+        if(n > sizeof(chunk) - 3)
+        {
+            Telemetry_Append(chunk, n);
+            n = 0;
+        }
+    }
+    if(n) Telemetry_Append(chunk, n);
+}
+
+static uint8_t Telemetry_Fits12(const uint16_t *data, uint16_t count)
+{
+    for(uint16_t i = 0; i < count; i++)
+    {
+        if(data[i] > 0x0FFF) return 0;
+    }
+    return 1;
+}
+
+/*!
+ * \brief   确定本帧编码及双通道样本字节数
+ * \details 指定PACK12但样本超过12位时退回RAW16；AUTO在可用编码中取最小
+ */
+static uint8_t Telemetry_SelectEncoding(const uint16_t *ch0, const uint16_t *ch1,
+                                        uint16_t count, uint32_t *size)
+{
+    uint32_t raw_size = 4U * count;
+    uint32_t pack_size = 6U * ((count + 1U) / 2U);
+    uint8_t fits12 = Telemetry_Fits12(ch0, count) && Telemetry_Fits12(ch1, count);
+    uint8_t enc = telemetry_wave_encoding;
+
+    if(enc == TELEMETRY_WAVE_DELTA)
+    {
+        *size = Telemetry_DeltaSize(ch0, count) + Telemetry_DeltaSize(ch1, count);
+        return TELEMETRY_WAVE_DELTA;
+    }
+    if(enc == TELEMETRY_WAVE_PACK12 && fits12)
+    {
+        *size = pack_size;
+        return TELEMETRY_WAVE_PACK12;
+    }
+    if(enc == TELEMETRY_WAVE_AUTO)
+    {
+        uint32_t delta_size = Telemetry_DeltaSize(ch0, count) + Telemetry_DeltaSize(ch1, count);
+
+        enc = TELEMETRY_WAVE_RAW16;
+        *size = raw_size;
+        if(fits12 && pack_size < *size)
+        {
+            enc = TELEMETRY_WAVE_PACK12;
+            *size = pack_size;
+        }
+        if(delta_size < *size)
+        {
+            enc = TELEMETRY_WAVE_DELTA;
+            *size = delta_size;
+        }
+        return enc;
+    }
+
+    *size = raw_size;
+    return TELEMETRY_WAVE_RAW16;
+}
+
+static void Telemetry_AppendSamples(uint8_t encoding, const uint16_t *data, uint16_t count)
+{
+    if(encoding == TELEMETRY_WAVE_PACK12)
+    {
+        Telemetry_AppendPacked12(data, count);
+    }
+    else if(encoding == TELEMETRY_WAVE_DELTA)
+    {
+        Telemetry_AppendDelta(data, count);
+    }
+    else
+    {
+        Telemetry_AppendU16Array(data, count);
+    }
+}
+
+void Telemetry_SetWaveEncoding(uint8_t encoding)
+{
+    telemetry_wave_encoding = encoding;
+}
+
+uint8_t Telemetry_GetWaveEncoding(void)
+{
+    return telemetry_wave_encoding;
+}
+
+const char *Telemetry_WaveEncodingName(uint8_t encoding)
+{
+    switch(encoding)
+    {
+        case TELEMETRY_WAVE_RAW16:  return "RAW";
+        case TELEMETRY_WAVE_PACK12: return "PACK12";
+        case TELEMETRY_WAVE_DELTA:  return "DELTA";
+        default:                    return "AUTO";
+    }
+}
+
+void Telemetry_SetBinary(uint8_t enable)
+{
+    telemetry_binary = enable ? 1 : 0;
+}
+
+uint8_t Telemetry_IsBinary(void)
+{
+    return telemetry_binary;
+}
+
+void Telemetry_SendFreqResp(uint32_t freq, float k_v, float k1_v,
+                            float h, float theta_deg,
+                            float h_cal, float theta_cal_deg, uint8_t calibrated)
+{
+    uint8_t payload[29];
+    uint8_t *p = payload;
+
+    p = put_u32(p, freq);
+    p = put_f32(p, k_v);
+    p = put_f32(p, k1_v);
+    p = put_f32(p, h);
+    p = put_f32(p, theta_deg);
+    p = put_f32(p, h_cal);
+    p = put_f32(p, theta_cal_deg);
+    *p++ = calibrated ? TELEMETRY_FR_CALIBRATED : 0;
+
+    Telemetry_BeginFrame(TELEMETRY_FREQ_RESP, (uint16_t)(p - payload));
+    Telemetry_Append(payload, (uint32_t)(p - payload));
+    Telemetry_EndFrame();
+}
+
+void Telemetry_SendWaveform(uint32_t freq, uint32_t sample_rate,
+                            const uint16_t *ch0, const uint16_t *ch1, uint16_t count,
+                            uint8_t source)
+{
+    uint8_t head[12];
+    uint8_t *p = head;
+    uint32_t samples_size;
+    uint8_t encoding = Telemetry_SelectEncoding(ch0, ch1, count, &samples_size);
+
+    p = put_u32(p, freq);
+    p = put_u32(p, sample_rate);
+    p = put_u16(p, count);
+    *p++ = encoding;
+    *p++ = source;
+
+    Telemetry_BeginFrame(TELEMETRY_WAVEFORM, (uint16_t)(sizeof(head) + samples_size));
+    Telemetry_Append(head, sizeof(head));
+    Telemetry_AppendSamples(encoding, ch0, count);
+    Telemetry_AppendSamples(encoding, ch1, count);
+    Telemetry_EndFrame();
+}
+
+void Telemetry_SendCalib(uint32_t freq, float h, float theta_deg)
+{
+    uint8_t payload[12];
+    uint8_t *p = payload;
+
+    p = put_u32(p, freq);
+    p = put_f32(p, h);
+    p = put_f32(p, theta_deg);
+
+    Telemetry_BeginFrame(TELEMETRY_CALIB_DATA, sizeof(payload));
+    Telemetry_Append(payload, sizeof(payload));
+    Telemetry_EndFrame();
+}
+
+void Telemetry_SendStatus(void)
+{
+    uint8_t payload[12];
+    uint8_t *p = payload;
+    uint8_t flags = 0;
+
+    if(DDS_IsHighRate())      flags |= 0x01;
+    if(DDS_GetInterpolation()) flags |= 0x02;
+    if(ADC_GetAutoRange())    flags |= 0x04;
+    if(g_calibration.valid)   flags |= 0x08;
+
+    p = put_u32(p, DDS_GetFrequency());
+    p = put_u32(p, ADC_GetSampleRate());
+    p = put_u16(p, DDS_GetAmplitude());
+    *p++ = (uint8_t)g_signal_type;
+    *p++ = flags;
+
+    Telemetry_BeginFrame(TELEMETRY_STATUS, sizeof(payload));
+    Telemetry_Append(payload, sizeof(payload));
+    Telemetry_EndFrame();
+}
+
+void Telemetry_SendProfile(void)
+{
+    uint8_t head[5];
+    uint8_t entry[17];
+    Prof_Stat_t s;
+
+    put_u32(head, SystemCoreClock);
+    head[4] = PROF_COUNT;
+
+    Telemetry_BeginFrame(TELEMETRY_PROFILE, (uint16_t)(sizeof(head) + PROF_COUNT * sizeof(entry)));
+    Telemetry_Append(head, sizeof(head));
+    for(uint32_t i = 0; i < PROF_COUNT; i++)
+    {
+        uint8_t *p = entry;
+        Prof_Get((Prof_Id_t)i, &s);
+        *p++ = (uint8_t)i;
+        p = put_u32(p, s.count);
+        p = put_u32(p, s.min);
+        p = put_u32(p, s.max);
+        put_u32(p, s.count ? (uint32_t)(s.total / s.count) : 0);
+        Telemetry_Append(entry, sizeof(entry));
+    }
+    Telemetry_EndFrame();
+}
+
+void Telemetry_SendLoad(void)
+{
+    uint8_t head[17];
+    uint8_t entry[17];
+    uint8_t *p = head;
+    Mon_Load_t load;
+    Mon_IrqStat_t s;
+
+    Monitor_GetLoad(&load);
+    p = put_u32(p, SystemCoreClock);
+    p = put_u32(p, load.window_us);
+    p = put_u32(p, load.idle_us);
+    p = put_u16(p, load.load_permille);
+    p = put_u16(p, load.peak_permille);
+    *p = MON_IRQ_COUNT;
+
+    Telemetry_BeginFrame(TELEMETRY_LOAD, (uint16_t)(sizeof(head) + MON_IRQ_COUNT * sizeof(entry)));
+    Telemetry_Append(head, sizeof(head));
+    for(uint32_t i = 0; i < MON_IRQ_COUNT; i++)
+    {
+        Monitor_GetIrq((Mon_Irq_t)i, &s);
+        p = entry;
+        *p++ = (uint8_t)i;
+        p = put_u32(p, s.count);
+        p = put_u32(p, s.exec_cycles);
+        p = put_u32(p, s.exec_max);
+        put_u32(p, s.latency_max);
+        Telemetry_Append(entry, sizeof(entry));
+    }
+    Telemetry_EndFrame();
+}
+
+void Telemetry_SendScan(uint32_t freq, uint32_t sample_rate, uint8_t n,
+                        const uint8_t *channels, const float *amplitude_v,
+                        const float *h, const float *theta_deg)
+{
+    uint8_t head[9];
+    uint8_t entry[13];
+    uint8_t *p = head;
+
+    p = put_u32(p, freq);
+    p = put_u32(p, sample_rate);
+    *p = n;
+
+    Telemetry_BeginFrame(TELEMETRY_SCAN, (uint16_t)(sizeof(head) + n * sizeof(entry)));
+    Telemetry_Append(head, sizeof(head));
+    for(uint32_t i = 0; i < n; i++)
+    {
+        p = entry;
+        *p++ = channels[i];
+        p = put_f32(p, amplitude_v[i]);
+        p = put_f32(p, h[i]);
+        put_f32(p, theta_deg[i]);
+        Telemetry_Append(entry, sizeof(entry));
+    }
+    Telemetry_EndFrame();
+}
+
+void Telemetry_SendTrack(uint32_t seq, uint32_t freq, float amp_in_v, float amp_out_v,
+                         float h, float theta_deg)
+{
+    uint8_t payload[24];
+    uint8_t *p = payload;
+
+    p = put_u32(p, seq);
+    p = put_u32(p, freq);
+    p = put_f32(p, amp_in_v);
+    p = put_f32(p, amp_out_v);
+    p = put_f32(p, h);
+    p = put_f32(p, theta_deg);
+
+    Telemetry_BeginFrame(TELEMETRY_TRACK, sizeof(payload));
+    Telemetry_Append(payload, sizeof(payload));
+    Telemetry_EndFrame();
+}
+
+void Telemetry_SendLockin(uint32_t freq, uint32_t tc_ms, uint32_t settle_ms, uint32_t elapsed_ms,
+                          float enbw_hz, uint8_t order, uint8_t flags,
+                          float amp_in_v, float amp_out_v, float h, float theta_deg)
+{
+    uint8_t payload[38];
+    uint8_t *p = payload;
+
+    p = put_u32(p, freq);
+    p = put_u32(p, tc_ms);
+    p = put_u32(p, settle_ms);
+    p = put_u32(p, elapsed_ms);
+    p = put_f32(p, enbw_hz);
+    *p++ = order;
+    *p++ = flags;
+    p = put_f32(p, amp_in_v);
+    p = put_f32(p, amp_out_v);
+    p = put_f32(p, h);
+    p = put_f32(p, theta_deg);
+
+    Telemetry_BeginFrame(TELEMETRY_LOCKIN, sizeof(payload));
+    Telemetry_Append(payload, sizeof(payload));
+    Telemetry_EndFrame();
+}
+
+void Telemetry_SendMetrics(const Metrics_Summary_t *s)
+{
+    uint8_t payload[63];
+    uint8_t *p = payload;
+
+    p = put_u32(p, s->start);
+    p = put_u32(p, s->stop);
+    p = put_u16(p, s->points);
+    *p++ = s->flags;
+    p = put_f32(p, s->ref_gain_db);
+    p = put_f32(p, s->bw_hz);
+    p = put_f32(p, s->peak_freq);
+    p = put_f32(p, s->peak_gain_db);
+    p = put_f32(p, s->q);
+    p = put_f32(p, s->gc_freq);
+    p = put_f32(p, s->phase_margin);
+    p = put_f32(p, s->pc_freq);
+    p = put_f32(p, s->gain_margin);
+    p = put_f32(p, s->gd_low_ms);
+    p = put_f32(p, s->gd_mean_ms);
+    p = put_f32(p, s->gd_max_ms);
+    p = put_f32(p, s->gd_max_freq);
+
+    Telemetry_BeginFrame(TELEMETRY_METRICS, sizeof(payload));
+    Telemetry_Append(payload, sizeof(payload));
+    Telemetry_EndFrame();
+}
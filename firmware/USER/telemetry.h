@@ -0,0 +1,165 @@
+/*!
+ * \file    telemetry.h
+ * \brief   二进制帧遥测协议
+ * \author  GD32 Bode Analyzer
+ * \version v1.0
+ * \details PROTO:BIN开启后，FREQ_RESP/WAVEFORM/CALIB_DATA/STATUS以二进制帧发送，
+ *          其余日志和命令应答仍为文本行。帧格式（小端）：
+ *
+ *          | 0xA5 0x5A | ver | type | seq(u16) | len(u16) | payload[len] | crc16(u16) |
+ *
+ *          CRC16-CCITT（多项式0x1021，初值0xFFFF），覆盖ver到payload末尾
+ */
+
+#ifndef __TELEMETRY_H
+#define __TELEMETRY_H
+
+#include "gd32f10x.h"
+#include "sweep_metrics.h"
+
+/* 帧参数 */
+#define TELEMETRY_SYNC0         0xA5
+#define TELEMETRY_SYNC1         0x5A
+#define TELEMETRY_VERSION       1
+#define TELEMETRY_HEADER_SIZE   8       /* 同步字(2) + ver + type + seq(2) + len(2) */
+#define TELEMETRY_CRC_SIZE      2
+
+/* 帧类型 */
+#define TELEMETRY_FREQ_RESP     0x01
+#define TELEMETRY_WAVEFORM      0x02
+#define TELEMETRY_CALIB_DATA    0x03
+#define TELEMETRY_STATUS        0x04
+#define TELEMETRY_PROFILE       0x05
+#define TELEMETRY_LOAD          0x06
+#define TELEMETRY_SCAN          0x07
+#define TELEMETRY_TRACK         0x08
+#define TELEMETRY_LOCKIN        0x09
+#define TELEMETRY_METRICS       0x0A
+
+/* WAVEFORM样本编码（每帧的encoding字节，各编码均为先CH0全部再CH1全部） */
+#define TELEMETRY_WAVE_RAW16    0       /* 每样本u16小端 */
+#define TELEMETRY_WAVE_PACK12   1       /* 每2个12位样本3字节：b0=s0[7:0] b1=s0[11:8]|s1[3:0]<<4 b2=s1[11:4]，奇数补0 */
+#define TELEMETRY_WAVE_DELTA    2       /* 与前一样本之差（首样本与0之差）zigzag后LEB128变长编码 */
+#define TELEMETRY_WAVE_AUTO     0xFF    /* 每帧选字节数最少的编码（仅作配置值，不出现在帧中） */
+
+/* WAVEFORM数据来源（帧头source字节） */
+#define TELEMETRY_SRC_MEASURE   0       /* MEASURE/SWEEP/数据流 */
+#define TELEMETRY_SRC_WAVE      1       /* WAVE快速波形 */
+#define TELEMETRY_SRC_UWAVE     2       /* UWAVE欠采样波形 */
+#define TELEMETRY_SRC_CAPTURE   3       /* CAPTURE采集 */
+#define TELEMETRY_SRC_STREAM    4       /* START实时数据流（连续块） */
+#define TELEMETRY_SRC_ETS       5       /* ETS等效时间采样单周期波形，sample_rate为等效采样率 */
+#define TELEMETRY_SRC_NODE_PB1  0x40    /* 标志：交替采集的节点为PB1（否则PA6） */
+#define TELEMETRY_SRC_INTERLEAVED 0x80  /* 标志：CAPTURE:FAST/WAVE:FAST快速交替采集，ch0/ch1为同一节点
+                                         * 两个ADC的相位A/B，时间顺序ch0[0],ch1[0],ch0[1]...，
+                                         * sample_rate为合成速率；两相位的偏置/增益失配由主机校正 */
+
+/* FREQ_RESP标志位 */
+#define TELEMETRY_FR_CALIBRATED 0x01    /* H_cal/theta_cal有效 */
+
+/*!
+ * \brief   协议模式切换
+ * \param   enable - 1=二进制帧，0=文本行（默认）
+ */
+void Telemetry_SetBinary(uint8_t enable);
+
+/*!
+ * \brief   是否处于二进制帧模式
+ */
+uint8_t Telemetry_IsBinary(void);
+
+/*!
+ * \brief   设置/读取波形编码（RAW16/PACK12/DELTA/AUTO）
+ */
+void Telemetry_SetWaveEncoding(uint8_t encoding);
+uint8_t Telemetry_GetWaveEncoding(void);
+const char *Telemetry_WaveEncodingName(uint8_t encoding);
+
+/*!
+ * \brief   发送频率响应帧
+ * \details payload: freq(u32) K(f32,V) K1(f32,V) H(f32) theta(f32,deg)
+ *                   H_cal(f32) theta_cal(f32,deg) flags(u8)
+ *          H_cal/theta_cal为最终显示值：未校准时等于H与展开后的相位
+ */
+void Telemetry_SendFreqResp(uint32_t freq, float k_v, float k1_v,
+                            float h, float theta_deg,
+                            float h_cal, float theta_cal_deg, uint8_t calibrated);
+
+/*!
+ * \brief   发送双通道波形帧
+ * \details payload: freq(u32) sample_rate(u32) count(u16) encoding(u8) source(u8)
+ *                   ch0[count] ch1[count]（按encoding编码）
+ */
+void Telemetry_SendWaveform(uint32_t freq, uint32_t sample_rate,
+                            const uint16_t *ch0, const uint16_t *ch1, uint16_t count,
+                            uint8_t source);
+
+/*!
+ * \brief   发送校准数据帧
+ * \details payload: freq(u32) H(f32) theta(f32,deg)
+ */
+void Telemetry_SendCalib(uint32_t freq, float h, float theta_deg);
+
+/*!
+ * \brief   发送状态帧
+ * \details payload: freq(u32) sample_rate(u32) amplitude(u16) signal_type(u8) flags(u8)
+ *                   flags: bit0=高速DDS bit1=插值DDS bit2=自动量程 bit3=校准有效
+ */
+void Telemetry_SendStatus(void);
+
+/*!
+ * \brief   发送性能探针统计帧
+ * \details payload: core_clock(u32) n(u8)，随后n项：id(u8) count(u32) min(u32) max(u32) mean(u32)
+ *                   单位为内核时钟周期，名称见profile.h中Prof_Id_t
+ */
+void Telemetry_SendProfile(void);
+
+/*!
+ * \brief   发送CPU负载帧
+ * \details payload: core_clock(u32) window_us(u32) idle_us(u32) load(u16,‰) peak(u16,‰) n(u8)，
+ *                   随后n项：id(u8) count(u32) exec_cycles(u32) exec_max(u32) latency_max(u32)
+ *                   latency_max=0xFFFFFFFF表示不可测，中断编号见monitor.h中Mon_Irq_t
+ */
+void Telemetry_SendLoad(void);
+
+/*!
+ * \brief   发送多节点扫描帧
+ * \details payload: freq(u32) sample_rate(u32) n(u8)，
+ *                   随后n项（信号链顺序）：channel(u8) amplitude(f32,V) H(f32) theta(f32,deg)
+ *                   H/theta相对节点0，第i级为节点i相对节点i-1（H_i/H_i-1，theta_i-theta_i-1）
+ */
+void Telemetry_SendScan(uint32_t freq, uint32_t sample_rate, uint8_t n,
+                        const uint8_t *channels, const float *amplitude_v,
+                        const float *h, const float *theta_deg);
+
+/*!
+ * \brief   发送单频跟踪帧（TRACK每个滑动窗口一帧）
+ * \details payload: seq(u32) freq(u32) amp_in(f32,V) amp_out(f32,V) H(f32) theta(f32,deg)
+ *                   theta已加校准并相对上一帧展开
+ */
+void Telemetry_SendTrack(uint32_t seq, uint32_t freq, float amp_in_v, float amp_out_v,
+                         float h, float theta_deg);
+
+/* LOCKIN标志位 */
+#define TELEMETRY_LI_SETTLED    0x01    /* 已超过建立时间 */
+#define TELEMETRY_LI_REF_WEAK   0x02    /* 输入参考通道过弱，H/theta无效 */
+
+/*!
+ * \brief   发送锁相结果帧
+ * \details payload: freq(u32) tc_ms(u32) settle_ms(u32) elapsed_ms(u32) enbw(f32,Hz) order(u8) flags(u8)
+ *                   amp_in(f32,V) amp_out(f32,V) H(f32) theta(f32,deg)
+ */
+void Telemetry_SendLockin(uint32_t freq, uint32_t tc_ms, uint32_t settle_ms, uint32_t elapsed_ms,
+                          float enbw_hz, uint8_t order, uint8_t flags,
+                          float amp_in_v, float amp_out_v, float h, float theta_deg);
+
+/*!
+ * \brief   发送扫频导出指标汇总帧（扫频结束时一帧）
+ * \details payload: start(u32) stop(u32) points(u16) flags(u8，见sweep_metrics.h中METRICS_xxx)
+ *                   ref_gain(f32,dB) bw(f32,Hz) peak_freq(f32,Hz) peak_gain(f32,dB) Q(f32)
+ *                   gc_freq(f32,Hz) phase_margin(f32,deg) pc_freq(f32,Hz) gain_margin(f32,dB)
+ *                   gd_low(f32,ms) gd_mean(f32,ms) gd_max(f32,ms) gd_max_freq(f32,Hz)
+ */
+void Telemetry_SendMetrics(const Metrics_Summary_t *s);
+
+#endif /* __TELEMETRY_H */
@@ -0,0 +1,67 @@
+/*!
+ * \file    track.h
+ * \brief   单频实时跟踪（TRACK）
+ * \author  GD32 Bode Analyzer
+ * \version v1.0
+ * \details 调试DUT时反复MEASURE，每次都要延时采集、512点浮点DFT并输出约6KB文本，
+ *          每秒不到一次结果。跟踪模式不保存样本：DMA半缓冲区中断中两通道与参考正弦/余弦
+ *          相乘后按段累加，滑动窗口为最近若干段之和（整周期，加入新段同时减去最旧段，
+ *          64位整数运算无累积误差），每段结束得到一个新窗口，主循环据此输出H/θ，
+ *          更新率TRACK_RATE_MIN~TRACK_RATE_MAX，与窗口长度（整周期数）无关
+ */
+
+#ifndef __TRACK_H
+#define __TRACK_H
+
+#include "gd32f10x.h"
+
+#define TRACK_SEG_MAX       16      /* 滑动窗口最多段数（10Hz、100Hz更新时窗口1周期为10段） */
+#define TRACK_MIN_CYCLES    1       /* 窗口至少1个整周期 */
+#define TRACK_RATE_MIN      20      /* 更新率(Hz) */
+#define TRACK_RATE_MAX      100
+#define TRACK_RATE_DEFAULT  50
+
+/* 一个滑动窗口的结果（下标0=ADC0/PA6输入参考，1=ADC1/PB1输出） */
+typedef struct {
+    uint32_t seq;               /* 窗口序号 */
+    uint32_t count;             /* 窗口样本数 */
+    uint32_t skipped;           /* 主循环来不及取用而被覆盖的窗口数（累计） */
+    float amplitude[2];         /* 基波峰值幅度（ADC码） */
+    int32_t phase_x100;         /* 相位差CH0-CH1（度×100，与Record_Result_t一致） */
+} Track_Result_t;
+
+/*!
+ * \brief   设置/读取更新率（下次TRACK生效）
+ */
+void Track_SetRate(uint32_t rate_hz);
+uint32_t Track_GetRate(void);
+
+/*!
+ * \brief   开始跟踪（从下一个DMA半缓冲区开始累加）
+ * \param   signal_freq - 参考正弦频率(Hz)
+ * \param   sample_rate - 实际ADC采样率(Hz)
+ * \return  窗口长度（样本数）
+ */
+uint32_t Track_Start(uint32_t signal_freq, uint32_t sample_rate);
+
+void Track_Stop(void);
+uint8_t Track_IsActive(void);
+
+/*!
+ * \brief   实际更新率（采样率×段数/窗口长度，mHz）
+ */
+uint32_t Track_GetUpdateRate_mHz(void);
+
+/*!
+ * \brief   取最新窗口的结果
+ * \return  1=有上次取用之后的新窗口
+ */
+uint8_t Track_GetResult(Track_Result_t *result);
+
+/*!
+ * \brief   DMA0_CH0半传输/传输完成中断中调用
+ * \param   frac_bits - 码值小数位（0或ADC_CODE_FRAC_BITS），内部统一为Q4累加
+ */
+void Track_OnADCBlock(const uint32_t *block, uint32_t count, uint32_t frac_bits);
+
+#endif /* __TRACK_H */
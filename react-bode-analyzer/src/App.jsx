@@ -32,7 +32,10 @@ function App() {
     connect, 
     disconnect, 
     sendCommand,
-    dataRate 
+    dataRate,
+    baudRate,
+    baudRates,
+    changeBaudRate
   } = useSerialPort()
   
   const { 
@@ -275,6 +278,9 @@ function App() {
           isConnected={isConnected}
           onConnect={handleConnect}
           onDisconnect={handleDisconnect}
+          baudRate={baudRate}
+          baudRates={baudRates}
+          onBaudRateChange={(rate) => changeBaudRate(rate, addLog)}
           onSweep={handleSweep}
           onFreqTest={handleFreqTest}
           onClearData={handleClearData}
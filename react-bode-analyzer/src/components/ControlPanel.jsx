@@ -5,6 +5,9 @@ function ControlPanel({
   isConnected, 
   onConnect, 
   onDisconnect, 
+  baudRate,
+  baudRates = [],
+  onBaudRateChange,
   onSweep,
   onFreqTest,
   onClearData,
@@ -17,7 +20,7 @@ function ControlPanel({
 
   const handleFreqChange = (e) => {
     const value = parseInt(e.target.value, 10) || 10
-    setSingleFreq(Math.max(10, Math.min(2000, value)))
+    setSingleFreq(Math.max(10, Math.min(20000, value)))
   }
 
   return (
@@ -48,10 +51,20 @@ function ControlPanel({
               className="btn-primary" 
               onClick={onConnect}
               disabled={isConnected}
-              title="连接GD32开发板串口，波特率115200（固定）"
+              title="连接GD32开发板串口，初始波特率115200，连接后可协商提速"
             >
-              连接串口 (115200)
+              连接串口 ({baudRate})
             </button>
+            <select
+              value={baudRate}
+              onChange={(e) => onBaudRateChange(parseInt(e.target.value, 10))}
+              disabled={!isConnected}
+              title="连接后切换波特率（BAUD命令握手，失败自动回退）"
+            >
+              {baudRates.map((rate) => (
+                <option key={rate} value={rate}>{rate}</option>
+              ))}
+            </select>
             <button 
               className="btn-danger" 
               onClick={onDisconnect}
@@ -74,10 +87,10 @@ function ControlPanel({
                 className="btn-success" 
                 onClick={onSweep}
                 disabled={!isConnected}
-                title="自动扫描10Hz到2000Hz频率范围，测量系统频率响应"
+                title="自动扫描10Hz到20kHz频率范围（2kHz以上步进100Hz），测量系统频率响应"
                 style={{width: '100%'}}
               >
-                开始频率扫描 (10-2000Hz)
+                开始频率扫描 (10Hz-20kHz)
               </button>
             </div>
             
@@ -87,10 +100,10 @@ function ControlPanel({
                 <input 
                   type="number" 
                   min="10" 
-                  max="2000" 
+                  max="20000" 
                   value={singleFreq}
                   onChange={handleFreqChange}
-                  placeholder="10-2000 Hz"
+                  placeholder="10-20000 Hz"
                   style={{flex: '1'}}
                 />
                 <button 
@@ -0,0 +1,417 @@
+// 固件二进制遥测帧（PROTO:BIN）解析
+// 帧格式（小端）：| 0xA5 0x5A | ver | type | seq(u16) | len(u16) | payload | crc16(u16) |
+// CRC16-CCITT（0x1021，初值0xFFFF），覆盖ver到payload末尾
+// 与固件 USER/telemetry.h 保持一致
+
+export const FRAME = {
+  SYNC0: 0xA5,
+  SYNC1: 0x5A,
+  VERSION: 1,
+  HEADER_SIZE: 8,
+  CRC_SIZE: 2,
+  MAX_PAYLOAD: 8192
+}
+
+export const FRAME_TYPE = {
+  FREQ_RESP: 0x01,
+  WAVEFORM: 0x02,
+  CALIB_DATA: 0x03,
+  STATUS: 0x04,
+  PROFILE: 0x05,
+  LOAD: 0x06,
+  SCAN: 0x07,
+  TRACK: 0x08,
+  LOCKIN: 0x09,
+  METRICS: 0x0A
+}
+
+// 扫频导出指标有效标志，与固件 USER/sweep_metrics.h 一致
+export const METRICS_FLAG = {
+  BW: 0x01,         // -3dB带宽
+  PEAK: 0x02,       // 谐振峰与Q
+  GC: 0x04,         // 增益交越/相位裕度
+  PC: 0x08,         // 相位交越/增益裕度
+  Q_PEAKING: 0x10   // Q按二阶低通峰值高度估计
+}
+
+// 扫频导出指标：values按METRICS帧/文本行字段顺序（start, stop, points, flags, 其后13个浮点）
+// 未找到的项为null
+export function metricsFromValues(values) {
+  const [start, stop, points, flags, refGain, bw, peakFreq, peakGain, q,
+    gcFreq, phaseMargin, pcFreq, gainMargin, gdLow, gdMean, gdMax, gdMaxFreq] = values
+  const has = bit => (flags & bit) !== 0
+  return {
+    kind: 'METRICS',
+    start,
+    stop,
+    points,
+    flags,
+    refGain,
+    bandwidth: has(METRICS_FLAG.BW) ? bw : null,
+    peak: has(METRICS_FLAG.PEAK)
+      ? { freq: peakFreq, gain: peakGain, q, qFromPeaking: has(METRICS_FLAG.Q_PEAKING) }
+      : null,
+    gainCrossover: has(METRICS_FLAG.GC) ? { freq: gcFreq, phaseMargin } : null,
+    phaseCrossover: has(METRICS_FLAG.PC) ? { freq: pcFreq, gainMargin } : null,
+    groupDelay: { low: gdLow, mean: gdMean, max: gdMax, maxFreq: gdMaxFreq }  // ms
+  }
+}
+
+// 性能探针名称，顺序与固件 USER/profile.h 的 Prof_Id_t 一致
+export const PROFILE_PROBES = [
+  'EXTRACT_ADC', 'PEAK_TO_PEAK', 'DC_OFFSET', 'AMPLITUDE_DFT', 'PHASE_SHIFT',
+  'DISTORTION', 'DAC_WRITE', 'TIMER2_IRQ', 'LED_PROCESS', 'UART_TX', 'DECIMATE'
+]
+
+// 负载监视中断名称，顺序与固件 USER/monitor.h 的 Mon_Irq_t 一致
+export const LOAD_IRQS = [
+  'TIMER0_UP', 'TIMER2', 'TIMER5', 'USART0',
+  'DMA_ADC', 'DMA_UART_TX', 'DMA_UART_RX', 'DMA_DDS'
+]
+
+export const WAVE_ENCODING = {
+  RAW16: 0,
+  PACK12: 1,  // 每2个12位样本3字节
+  DELTA: 2    // 相邻差值zigzag后LEB128变长编码
+}
+
+export const WAVE_SOURCE = {
+  MEASURE: 0,
+  WAVE: 1,
+  UWAVE: 2,
+  CAPTURE: 3,
+  STREAM: 4,  // START实时数据流，按块追加到波形缓冲
+  ETS: 5      // 等效时间采样：单周期重建波形，sampleRate为等效采样率
+}
+
+// source字节高两位为标志（CAPTURE:FAST/WAVE:FAST快速交替采集）
+export const WAVE_SOURCE_FLAG = {
+  NODE_PB1: 0x40,     // 交替采集的节点为PB1（否则PA6）
+  INTERLEAVED: 0x80   // input/output为同一节点两个ADC的相位A/B
+}
+
+// 交替采集两相位合成一路：相位B按相位A的均值/交流幅度校正偏置和增益失配后交错
+export function mergeInterleaved(a, b) {
+  const n = Math.min(a.length, b.length)
+  if (n === 0) return []
+  const mean = x => x.reduce((s, v) => s + v, 0) / n
+  const meanA = mean(a)
+  const meanB = mean(b)
+  let varA = 0
+  let varB = 0
+  for (let i = 0; i < n; i++) {
+    varA += (a[i] - meanA) ** 2
+    varB += (b[i] - meanB) ** 2
+  }
+  const gain = varB > 0 ? Math.sqrt(varA / varB) : 1
+  const out = new Array(2 * n)
+  for (let i = 0; i < n; i++) {
+    out[2 * i] = a[i]
+    out[2 * i + 1] = meanA + (b[i] - meanB) * gain
+  }
+  return out
+}
+
+export function crc16(bytes, crc = 0xFFFF) {
+  for (let i = 0; i < bytes.length; i++) {
+    crc ^= bytes[i] << 8
+    for (let b = 0; b < 8; b++) {
+      crc = (crc & 0x8000) ? ((crc << 1) ^ 0x1021) : (crc << 1)
+      crc &= 0xFFFF
+    }
+  }
+  return crc
+}
+
+// 串口字节流分离器：文本行交给onLine，校验通过的帧交给onFrame
+// 同步字可能偶然出现在UTF-8文本中，帧头/CRC不合法时按文本处理
+export function createFrameParser({ onLine, onFrame, onError }) {
+  const textDecoder = new TextDecoder()
+  let bytes = new Uint8Array(0)
+  let text = ''
+  let lastSeq = null
+
+  const emitText = (chunk) => {
+    if (chunk.length === 0) return
+    text += textDecoder.decode(chunk, { stream: true })
+    const lines = text.split('\n')
+    text = lines.pop()
+    for (const line of lines) {
+      const trimmed = line.trim()
+      if (trimmed) onLine(trimmed)
+    }
+  }
+
+  const findSync = (from) => {
+    for (let i = from; i < bytes.length - 1; i++) {
+      if (bytes[i] === FRAME.SYNC0 && bytes[i + 1] === FRAME.SYNC1) return i
+    }
+    return -1
+  }
+
+  const push = (chunk) => {
+    const merged = new Uint8Array(bytes.length + chunk.length)
+    merged.set(bytes)
+    merged.set(chunk, bytes.length)
+    bytes = merged
+
+    let pos = 0
+    while (pos < bytes.length) {
+      const s = findSync(pos)
+      if (s < 0) {
+        // 末尾单独的0xA5可能是下一帧同步字的前半，保留
+        const end = bytes[bytes.length - 1] === FRAME.SYNC0 ? bytes.length - 1 : bytes.length
+        emitText(bytes.subarray(pos, end))
+        pos = end
+        break
+      }
+
+      emitText(bytes.subarray(pos, s))
+      pos = s
+      if (bytes.length - s < FRAME.HEADER_SIZE) break
+
+      const view = new DataView(bytes.buffer, bytes.byteOffset + s)
+      const version = view.getUint8(2)
+      const length = view.getUint16(6, true)
+      if (version !== FRAME.VERSION || length > FRAME.MAX_PAYLOAD) {
+        emitText(bytes.subarray(s, s + 1))
+        pos = s + 1
+        continue
+      }
+
+      const total = FRAME.HEADER_SIZE + length + FRAME.CRC_SIZE
+      if (bytes.length - s < total) break
+
+      const crc = view.getUint16(FRAME.HEADER_SIZE + length, true)
+      if (crc16(bytes.subarray(s + 2, s + FRAME.HEADER_SIZE + length)) !== crc) {
+        if (onError) onError('CRC校验失败，丢弃帧')
+        emitText(bytes.subarray(s, s + 1))
+        pos = s + 1
+        continue
+      }
+
+      const type = view.getUint8(3)
+      const seq = view.getUint16(4, true)
+      if (lastSeq !== null && ((lastSeq + 1) & 0xFFFF) !== seq && onError) {
+        onError(`帧序号不连续: ${lastSeq} → ${seq}`)
+      }
+      lastSeq = seq
+
+      const payload = bytes.slice(s + FRAME.HEADER_SIZE, s + FRAME.HEADER_SIZE + length)
+      onFrame({ type, seq, payload: new DataView(payload.buffer) })
+      pos = s + total
+    }
+
+    bytes = bytes.slice(pos)
+  }
+
+  return { push }
+}
+
+// 各样本解码器返回 { samples, next }，next为下一通道数据的起始偏移
+const readRaw16 = (view, offset, count) => {
+  const samples = new Array(count)
+  for (let i = 0; i < count; i++) samples[i] = view.getUint16(offset + i * 2, true)
+  return { samples, next: offset + count * 2 }
+}
+
+const readPacked12 = (view, offset, count) => {
+  const samples = new Array(count)
+  let p = offset
+  for (let i = 0; i < count; i += 2) {
+    const b0 = view.getUint8(p)
+    const b1 = view.getUint8(p + 1)
+    const b2 = view.getUint8(p + 2)
+    samples[i] = b0 | ((b1 & 0x0F) << 8)
+    if (i + 1 < count) samples[i + 1] = (b1 >> 4) | (b2 << 4)
+    p += 3
+  }
+  return { samples, next: p }
+}
+
+const readDelta = (view, offset, count) => {
+  const samples = new Array(count)
+  let p = offset
+  let prev = 0
+  for (let i = 0; i < count; i++) {
+    let z = 0
+    let shift = 0
+    let b
+    do {
+      b = view.getUint8(p++)
+      z |= (b & 0x7F) << shift
+      shift += 7
+    } while (b & 0x80)
+    prev += (z >>> 1) ^ -(z & 1)
+    samples[i] = prev
+  }
+  return { samples, next: p }
+}
+
+const SAMPLE_READERS = {
+  [WAVE_ENCODING.RAW16]: readRaw16,
+  [WAVE_ENCODING.PACK12]: readPacked12,
+  [WAVE_ENCODING.DELTA]: readDelta
+}
+
+// 解码帧payload为与文本协议等价的对象
+export function decodeFrame(frame) {
+  const v = frame.payload
+  switch (frame.type) {
+    case FRAME_TYPE.FREQ_RESP: {
+      const isCalibrated = (v.getUint8(28) & 0x01) !== 0
+      return {
+        kind: 'FREQ_RESP',
+        freq: v.getUint32(0, true),
+        K: v.getFloat32(4, true),
+        K1: v.getFloat32(8, true),
+        H_raw: v.getFloat32(12, true),
+        theta_raw: v.getFloat32(16, true),
+        H_calibrated: v.getFloat32(20, true),
+        theta_calibrated: v.getFloat32(24, true),
+        isCalibrated
+      }
+    }
+    case FRAME_TYPE.WAVEFORM: {
+      const count = v.getUint16(8, true)
+      const read = SAMPLE_READERS[v.getUint8(10)]
+      if (!read) return null
+      const ch0 = read(v, 12, count)
+      const ch1 = read(v, ch0.next, count)
+      return {
+        kind: 'WAVEFORM',
+        freq: v.getUint32(0, true),
+        sampleRate: v.getUint32(4, true),
+        source: v.getUint8(11) & 0x3F,
+        interleaved: (v.getUint8(11) & WAVE_SOURCE_FLAG.INTERLEAVED) !== 0,
+        node: (v.getUint8(11) & WAVE_SOURCE_FLAG.NODE_PB1) ? 'PB1' : 'PA6',
+        input: ch0.samples,
+        output: ch1.samples
+      }
+    }
+    case FRAME_TYPE.CALIB_DATA:
+      return {
+        kind: 'CALIB_DATA',
+        freq: v.getUint32(0, true),
+        H: v.getFloat32(4, true),
+        theta: v.getFloat32(8, true)
+      }
+    case FRAME_TYPE.STATUS: {
+      const flags = v.getUint8(11)
+      return {
+        kind: 'STATUS',
+        freq: v.getUint32(0, true),
+        sampleRate: v.getUint32(4, true),
+        amplitude: v.getUint16(8, true),
+        signalType: v.getUint8(10) === 1 ? 'ecg' : 'sine',
+        highRateDds: (flags & 0x01) !== 0,
+        interpolatedDds: (flags & 0x02) !== 0,
+        autoRange: (flags & 0x04) !== 0,
+        calibrated: (flags & 0x08) !== 0
+      }
+    }
+    case FRAME_TYPE.PROFILE: {
+      // 单位为内核时钟周期
+      const coreClock = v.getUint32(0, true)
+      const n = v.getUint8(4)
+      const probes = []
+      for (let i = 0, p = 5; i < n; i++, p += 17) {
+        const id = v.getUint8(p)
+        probes.push({
+          name: PROFILE_PROBES[id] || `#${id}`,
+          count: v.getUint32(p + 1, true),
+          min: v.getUint32(p + 5, true),
+          max: v.getUint32(p + 9, true),
+          mean: v.getUint32(p + 13, true)
+        })
+      }
+      return { kind: 'PROFILE', coreClock, probes }
+    }
+    case FRAME_TYPE.LOAD: {
+      // 执行时间/延迟单位为内核时钟周期，latencyMax为null表示不可测
+      const n = v.getUint8(16)
+      const irqs = []
+      for (let i = 0, p = 17; i < n; i++, p += 17) {
+        const id = v.getUint8(p)
+        const latency = v.getUint32(p + 13, true)
+        irqs.push({
+          name: LOAD_IRQS[id] || `#${id}`,
+          count: v.getUint32(p + 1, true),
+          execCycles: v.getUint32(p + 5, true),
+          execMax: v.getUint32(p + 9, true),
+          latencyMax: latency === 0xFFFFFFFF ? null : latency
+        })
+      }
+      return {
+        kind: 'LOAD',
+        coreClock: v.getUint32(0, true),
+        windowUs: v.getUint32(4, true),
+        idleUs: v.getUint32(8, true),
+        load: v.getUint16(12, true) / 10,
+        peak: v.getUint16(14, true) / 10,
+        irqs
+      }
+    }
+    case FRAME_TYPE.SCAN: {
+      // 各节点H/θ相对节点0（信号链顺序），逐级结果由相邻节点求得
+      const n = v.getUint8(8)
+      const nodes = []
+      for (let i = 0, p = 9; i < n; i++, p += 13) {
+        const H = v.getFloat32(p + 5, true)
+        const theta = v.getFloat32(p + 9, true)
+        const prev = nodes[i - 1]
+        nodes.push({
+          channel: v.getUint8(p),
+          amplitude: v.getFloat32(p + 1, true),
+          H,
+          theta,
+          stageH: prev && prev.H > 0 ? H / prev.H : 1,
+          stageTheta: prev ? theta - prev.theta : 0
+        })
+      }
+      return {
+        kind: 'SCAN',
+        freq: v.getUint32(0, true),
+        sampleRate: v.getUint32(4, true),
+        nodes
+      }
+    }
+    case FRAME_TYPE.TRACK:
+      // TRACK滑动窗口：theta已校准并相对上一帧展开
+      return {
+        kind: 'TRACK',
+        seq: v.getUint32(0, true),
+        freq: v.getUint32(4, true),
+        amplitudeIn: v.getFloat32(8, true),
+        amplitudeOut: v.getFloat32(12, true),
+        H: v.getFloat32(16, true),
+        theta: v.getFloat32(20, true)
+      }
+    case FRAME_TYPE.LOCKIN: {
+      const flags = v.getUint8(21)
+      return {
+        kind: 'LOCKIN',
+        freq: v.getUint32(0, true),
+        tcMs: v.getUint32(4, true),
+        settleMs: v.getUint32(8, true),
+        elapsedMs: v.getUint32(12, true),
+        enbw: v.getFloat32(16, true),
+        order: v.getUint8(20),
+        settled: (flags & 0x01) !== 0,
+        refWeak: (flags & 0x02) !== 0,
+        amplitudeIn: v.getFloat32(22, true),
+        amplitudeOut: v.getFloat32(26, true),
+        H: v.getFloat32(30, true),
+        theta: v.getFloat32(34, true)
+      }
+    }
+    case FRAME_TYPE.METRICS: {
+      // 扫频结束汇总：start(u32) stop(u32) points(u16) flags(u8) 13×f32
+      const values = [v.getUint32(0, true), v.getUint32(4, true), v.getUint16(8, true), v.getUint8(10)]
+      for (let i = 0; i < 13; i++) values.push(v.getFloat32(11 + i * 4, true))
+      return metricsFromValues(values)
+    }
+    default:
+      return null
+  }
+}
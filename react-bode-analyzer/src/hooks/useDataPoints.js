@@ -1,8 +1,9 @@
 import { useState, useCallback, useMemo, useRef } from 'react'
+import { decodeFrame, WAVE_SOURCE, mergeInterleaved, metricsFromValues } from './binaryFrames'
 
 const CONFIG = {
   FREQ_MIN: 10,
-  FREQ_MAX: 2000,
+  FREQ_MAX: 20000,   // 固件>2kHz使用400kHz高速DDS引擎
   H_MIN: 0,
   H_MAX: 10,       // 增加到10，容许更大的增益（运放可能有放大）
   THETA_MIN: -200, // 扩大范围，容许相位计算的wrap现象
@@ -40,7 +41,241 @@ export function useDataPoints() {
   const lastUpdateTimeRef = useRef(0)  // 上次UI更新时间
   const updateIntervalMs = 50  // UI更新间隔（50ms = 20fps）
 
+  // 波形数据（文本WAVEFORM行与二进制WAVEFORM帧共用）
+  // 使用节流机制减少UI更新频率，防止卡顿
+  const pushWaveform = (freq, sampleRate, newInput, newOutput) => {
+    // 累积数据到待处理缓冲区
+    pendingDataRef.current.input.push(...newInput)
+    pendingDataRef.current.output.push(...newOutput)
+    pendingDataRef.current.freq = freq
+    pendingDataRef.current.sampleRate = sampleRate
+    
+    // 节流：每50ms才更新一次UI（20fps）
+    const now = Date.now()
+    if (now - lastUpdateTimeRef.current < updateIntervalMs) {
+      return  // 还没到更新时间，继续累积
+    }
+    lastUpdateTimeRef.current = now
+    
+    // 取出并清空待处理数据
+    const pendingInput = [...pendingDataRef.current.input]
+    const pendingOutput = [...pendingDataRef.current.output]
+    pendingDataRef.current.input = []
+    pendingDataRef.current.output = []
+    
+    // 检测变化
+    const freqChanged = waveformBuffer.freq !== 0 && waveformBuffer.freq !== freq
+    const sampleRateChanged = waveformBuffer.sampleRate !== 0 && waveformBuffer.sampleRate !== sampleRate
+    const shouldReset = freqChanged || sampleRateChanged
+    
+    // 更新缓冲区
+    setWaveformBuffer(prev => {
+      const isEcgMode = freq === 1
+      const maxPoints = isEcgMode ? 3000 : 500
+      
+      let combinedInput, combinedOutput
+      if (shouldReset || !prev.input || prev.input.length === 0) {
+        combinedInput = pendingInput
+        combinedOutput = pendingOutput
+      } else {
+        combinedInput = [...prev.input, ...pendingInput]
+        combinedOutput = [...prev.output, ...pendingOutput]
+      }
+      
+      const startIdx = combinedInput.length > maxPoints ? combinedInput.length - maxPoints : 0
+      const trimmedInput = combinedInput.slice(startIdx)
+      const trimmedOutput = combinedOutput.slice(startIdx)
+      
+      const newTimeStamps = trimmedInput.map((_, i) => (i / sampleRate) * 1000)
+      
+      const newBuffer = {
+        input: trimmedInput,
+        output: trimmedOutput,
+        timeStamps: newTimeStamps,
+        freq,
+        sampleRate
+      }
+      
+      // 更新显示数据
+      setWaveformData(newBuffer)
+      
+      return newBuffer
+    })
+  }
+
+  // 扫频导出指标汇总（文本METRICS行与二进制METRICS帧共用）
+  const reportMetrics = (m, addLog) => {
+    const parts = [`${m.start}-${m.stop}Hz ${m.points}点`]
+    if (m.bandwidth !== null) parts.push(`-3dB带宽=${m.bandwidth.toFixed(1)}Hz`)
+    if (m.peak) parts.push(`峰值=${m.peak.gain.toFixed(2)}dB@${m.peak.freq.toFixed(1)}Hz Q=${m.peak.q.toFixed(2)}`)
+    if (m.gainCrossover) parts.push(`PM=${m.gainCrossover.phaseMargin.toFixed(1)}°@${m.gainCrossover.freq.toFixed(1)}Hz`)
+    if (m.phaseCrossover) parts.push(`GM=${m.phaseCrossover.gainMargin.toFixed(2)}dB@${m.phaseCrossover.freq.toFixed(1)}Hz`)
+    parts.push(`群时延 低频=${m.groupDelay.low.toFixed(3)}ms 最大=${m.groupDelay.max.toFixed(3)}ms@${m.groupDelay.maxFreq.toFixed(0)}Hz`)
+    addLog(`METRICS: ${parts.join(', ')}`, 'success')
+    window.dispatchEvent(new CustomEvent('sweep-metrics', { detail: m }))
+  }
+
+  // 频率响应数据点（文本FREQ_RESP行与二进制FREQ_RESP帧共用）
+  const pushFreqResp = (point, addLog) => {
+    const { freq, K, K1, H, theta, H_raw, theta_raw, H_calibrated, theta_calibrated, isCalibrated } = point
+    
+    // 数据验证（更严格）
+    if (!isFinite(freq) || !isFinite(K) || !isFinite(K1) || !isFinite(H) || !isFinite(theta)) {
+      addLog(`数据无效(非有限数): freq=${freq}, K=${K}, K1=${K1}, H=${H}, theta=${theta}`, 'warning')
+      return
+    }
+    
+    if (freq < CONFIG.FREQ_MIN || freq > CONFIG.FREQ_MAX) {
+      addLog(`频率超出范围: ${freq}Hz`, 'warning')
+      return
+    }
+    
+    if (H < CONFIG.H_MIN || H > CONFIG.H_MAX) {
+      addLog(`幅频响应异常: ${H.toFixed(4)}`, 'warning')
+      return
+    }
+    
+    if (theta < CONFIG.THETA_MIN || theta > CONFIG.THETA_MAX) {
+      addLog(`相频响应异常: ${theta.toFixed(2)}°`, 'warning')
+      return
+    }
+
+    // 安全计算 dB 值，避免 log10(0) 或 log10(负数)
+    const safeLog10 = (value) => {
+      if (value <= 0) return -100  // 设置最小值为 -100dB
+      return 20 * Math.log10(value)
+    }
+    
+    const dataPoint = {
+      freq: freq,
+      omega: 2 * Math.PI * freq,
+      K: K,
+      K1: K1,
+      H: H,
+      H_dB: safeLog10(H),
+      theta: theta,
+      // 保存原始值和校准值（如果有）
+      isCalibrated: isCalibrated,
+      H_raw: H_raw,
+      theta_raw: theta_raw,
+      H_calibrated: isCalibrated ? H_calibrated : undefined,
+      theta_calibrated: isCalibrated ? theta_calibrated : undefined,
+      H_dB_raw: safeLog10(H_raw),
+      H_dB_calibrated: isCalibrated ? safeLog10(H_calibrated) : undefined
+    }
+
+    setDataPoints(prev => {
+      const existingIndex = prev.findIndex(p => p.freq === freq)
+      
+      if (existingIndex >= 0) {
+        const newPoints = [...prev]
+        newPoints[existingIndex] = dataPoint
+        return newPoints
+      } else {
+        const newPoints = [...prev, dataPoint].sort((a, b) => a.freq - b.freq)
+        
+        if (newPoints.length > CONFIG.MAX_DATA_POINTS) {
+          addLog(`数据点数超过${CONFIG.MAX_DATA_POINTS}，自动移除最旧数据`, 'warning')
+          return newPoints.slice(1)
+        }
+        
+        return newPoints
+      }
+    })
+
+    if (isCalibrated) {
+      addLog(`数据 [已校准]: f=${freq}Hz, H=${H_calibrated.toFixed(4)} (原始=${H_raw.toFixed(4)}), θ=${theta_calibrated.toFixed(2)}° (原始=${theta_raw.toFixed(2)}°)`, 'success')
+    } else {
+      addLog(`数据: f=${freq}Hz, H(ω)=${H.toFixed(4)}, θ(ω)=${theta.toFixed(2)}°`, 'success')
+    }
+  }
+
   const addDataPoint = useCallback((data, addLog, signalType = 'sine') => {
+    // 二进制帧（PROTO:BIN）：解码后走与文本协议相同的处理路径
+    if (typeof data !== 'string') {
+      const decoded = decodeFrame(data)
+      if (!decoded) return
+      if (decoded.kind === 'WAVEFORM') {
+        if (decoded.interleaved) {
+          // 快速交替采集：校正两ADC失配后合成一路，按合成采样率显示
+          const samples = mergeInterleaved(decoded.input, decoded.output)
+          addLog(`接收: 交替采集 ${decoded.node} 采样率=${decoded.sampleRate}Hz, ${samples.length}点`, 'info')
+          pushWaveform(decoded.freq, decoded.sampleRate, samples, samples)
+        } else if (decoded.source === WAVE_SOURCE.UWAVE) {
+          window.dispatchEvent(new CustomEvent('uwave-data', {
+            detail: {
+              signalFreq: decoded.freq,
+              sampleRate: decoded.sampleRate,
+              ch0: decoded.input,  // PA6
+              ch1: decoded.output  // PB1
+            }
+          }))
+        } else if (decoded.source === WAVE_SOURCE.ETS) {
+          addLog(`接收: ETS f=${decoded.freq}Hz, 等效采样率=${decoded.sampleRate}Hz, ${decoded.input.length}点`, 'info')
+          window.dispatchEvent(new CustomEvent('ets-data', {
+            detail: {
+              signalFreq: decoded.freq,
+              sampleRate: decoded.sampleRate,
+              ch0: decoded.input,
+              ch1: decoded.output
+            }
+          }))
+        } else if (decoded.source === WAVE_SOURCE.CAPTURE) {
+          // 与文本协议RAWWAVE相同的事件，同时按WAVE送入波形显示
+          addLog(`接收: CAPTURE f=${decoded.freq}Hz, 采样率=${decoded.sampleRate}Hz, ${decoded.input.length}点`, 'info')
+          window.dispatchEvent(new CustomEvent('rawwave-data', {
+            detail: {
+              signalFreq: decoded.freq,
+              sampleRate: decoded.sampleRate,
+              totalTime: decoded.input.length * 1000 / decoded.sampleRate,
+              ch0: decoded.input,
+              ch1: decoded.output
+            }
+          }))
+          pushWaveform(decoded.freq, decoded.sampleRate, decoded.input, decoded.output)
+        } else {
+          pushWaveform(decoded.freq, decoded.sampleRate, decoded.input, decoded.output)
+        }
+      } else if (decoded.kind === 'FREQ_RESP') {
+        if (signalType === 'ecg') return
+        // H_cal/theta_cal为最终显示值（未校准时等于H与展开后的相位）
+        pushFreqResp({
+          ...decoded,
+          H: decoded.H_calibrated,
+          theta: decoded.theta_calibrated
+        }, addLog)
+      } else if (decoded.kind === 'CALIB_DATA') {
+        addLog(`接收: CALIB_DATA f=${decoded.freq}Hz, H=${decoded.H.toFixed(4)}, θ=${decoded.theta.toFixed(2)}°`, 'info')
+      } else if (decoded.kind === 'STATUS') {
+        addLog(`接收: STATUS f=${decoded.freq}Hz, 采样率=${decoded.sampleRate}Hz, 激励=${decoded.amplitude}/256`, 'info')
+      } else if (decoded.kind === 'PROFILE') {
+        const mhz = decoded.coreClock / 1e6
+        decoded.probes.filter(p => p.count > 0).forEach(p => {
+          addLog(`PROF: ${p.name} n=${p.count} min/mean/max=${p.min}/${p.mean}/${p.max}周期 (${(p.mean / mhz).toFixed(2)}us)`, 'info')
+        })
+      } else if (decoded.kind === 'SCAN') {
+        decoded.nodes.forEach((node, i) => {
+          addLog(`SCAN ${decoded.freq}Hz 节点${i} CH${node.channel}: ${(node.amplitude * 1000).toFixed(1)}mV, H=${node.H.toFixed(4)}, θ=${node.theta.toFixed(2)}° | 本级 H=${node.stageH.toFixed(4)}, θ=${node.stageTheta.toFixed(2)}°`, 'info')
+        })
+      } else if (decoded.kind === 'TRACK') {
+        // 20-100Hz连续更新，不逐帧写日志，交给订阅者显示
+        window.dispatchEvent(new CustomEvent('track-data', { detail: decoded }))
+      } else if (decoded.kind === 'LOCKIN') {
+        const state = decoded.refWeak ? '参考过弱' : (decoded.settled ? '已建立' : `建立中 ${decoded.elapsedMs}/${decoded.settleMs}ms`)
+        addLog(`LOCKIN ${decoded.freq}Hz: 输出=${(decoded.amplitudeOut * 1e6).toFixed(2)}uV, H=${decoded.H.toExponential(3)}, θ=${decoded.theta.toFixed(2)}° (ENBW=${decoded.enbw.toFixed(3)}Hz, ${state})`, 'info')
+        window.dispatchEvent(new CustomEvent('lockin-data', { detail: decoded }))
+      } else if (decoded.kind === 'METRICS') {
+        reportMetrics(decoded, addLog)
+      } else if (decoded.kind === 'LOAD') {
+        addLog(`LOAD: CPU ${decoded.load.toFixed(1)}% (峰值 ${decoded.peak.toFixed(1)}%)`, 'info')
+        decoded.irqs.filter(q => q.count > 0).forEach(q => {
+          const lat = q.latencyMax === null ? '-' : q.latencyMax
+          addLog(`LOAD: ${q.name} ${q.count}/s 延迟max=${lat} 执行max=${q.execMax}周期`, 'info')
+        })
+      }
+      return
+    }
+    
     // 处理真实欠采样波形：UWAVE:freq,sampleRate
     if (data.includes('UWAVE:')) {
       try {
@@ -213,63 +448,7 @@ export function useDataPoints() {
         const newOutput = outputStr.split(',').map(v => parseInt(v, 10)).filter(v => !isNaN(v))
         
         if (newInput.length > 0 && newOutput.length > 0) {
-          // 累积数据到待处理缓冲区
-          pendingDataRef.current.input.push(...newInput)
-          pendingDataRef.current.output.push(...newOutput)
-          pendingDataRef.current.freq = freq
-          pendingDataRef.current.sampleRate = sampleRate
-          
-          // 节流：每50ms才更新一次UI（20fps）
-          const now = Date.now()
-          if (now - lastUpdateTimeRef.current < updateIntervalMs) {
-            return  // 还没到更新时间，继续累积
-          }
-          lastUpdateTimeRef.current = now
-          
-          // 取出并清空待处理数据
-          const pendingInput = [...pendingDataRef.current.input]
-          const pendingOutput = [...pendingDataRef.current.output]
-          pendingDataRef.current.input = []
-          pendingDataRef.current.output = []
-          
-          // 检测变化
-          const freqChanged = waveformBuffer.freq !== 0 && waveformBuffer.freq !== freq
-          const sampleRateChanged = waveformBuffer.sampleRate !== 0 && waveformBuffer.sampleRate !== sampleRate
-          const shouldReset = freqChanged || sampleRateChanged
-          
-          // 更新缓冲区
-          setWaveformBuffer(prev => {
-            const isEcgMode = freq === 1
-            const maxPoints = isEcgMode ? 3000 : 500
-            
-            let combinedInput, combinedOutput
-            if (shouldReset || !prev.input || prev.input.length === 0) {
-              combinedInput = pendingInput
-              combinedOutput = pendingOutput
-            } else {
-              combinedInput = [...prev.input, ...pendingInput]
-              combinedOutput = [...prev.output, ...pendingOutput]
-            }
-            
-            const startIdx = combinedInput.length > maxPoints ? combinedInput.length - maxPoints : 0
-            const trimmedInput = combinedInput.slice(startIdx)
-            const trimmedOutput = combinedOutput.slice(startIdx)
-            
-            const newTimeStamps = trimmedInput.map((_, i) => (i / sampleRate) * 1000)
-            
-            const newBuffer = {
-              input: trimmedInput,
-              output: trimmedOutput,
-              timeStamps: newTimeStamps,
-              freq,
-              sampleRate
-            }
-            
-            // 更新显示数据
-            setWaveformData(newBuffer)
-            
-            return newBuffer
-          })
+          pushWaveform(freq, sampleRate, newInput, newOutput)
         }
       } catch (e) {
         console.error('WAVEFORM解析错误:', e)
@@ -277,6 +456,15 @@ export function useDataPoints() {
       return
     }
     
+    // 扫频导出指标：METRICS:start,stop,points,flags,ref_db,bw,peak_f,peak_db,Q,gc_f,PM,pc_f,GM,gd_low,gd_mean,gd_max,gd_max_f
+    if (data.startsWith('METRICS:')) {
+      const values = data.substring(8).split(',').map(Number)
+      if (values.length === 17 && values.every(isFinite)) {
+        reportMetrics(metricsFromValues(values), addLog)
+      }
+      return
+    }
+    
     // 如果是ECG模式，忽略FREQ_RESP数据（不生成Bode图）
     if (signalType === 'ecg') {
       return
@@ -313,75 +501,9 @@ export function useDataPoints() {
       theta_raw = theta
     }
     
-    // 数据验证（更严格）
-    if (!isFinite(freq) || !isFinite(K) || !isFinite(K1) || !isFinite(H) || !isFinite(theta)) {
-      addLog(`数据无效(非有限数): freq=${freq}, K=${K}, K1=${K1}, H=${H}, theta=${theta}`, 'warning')
-      return
-    }
-    
-    if (freq < CONFIG.FREQ_MIN || freq > CONFIG.FREQ_MAX) {
-      addLog(`频率超出范围: ${freq}Hz`, 'warning')
-      return
-    }
-    
-    if (H < CONFIG.H_MIN || H > CONFIG.H_MAX) {
-      addLog(`幅频响应异常: ${H.toFixed(4)}`, 'warning')
-      return
-    }
-    
-    if (theta < CONFIG.THETA_MIN || theta > CONFIG.THETA_MAX) {
-      addLog(`相频响应异常: ${theta.toFixed(2)}°`, 'warning')
-      return
-    }
-
-    // 安全计算 dB 值，避免 log10(0) 或 log10(负数)
-    const safeLog10 = (value) => {
-      if (value <= 0) return -100  // 设置最小值为 -100dB
-      return 20 * Math.log10(value)
-    }
-    
-    const dataPoint = {
-      freq: freq,
-      omega: 2 * Math.PI * freq,
-      K: K,
-      K1: K1,
-      H: H,
-      H_dB: safeLog10(H),
-      theta: theta,
-      // 保存原始值和校准值（如果有）
-      isCalibrated: isCalibrated,
-      H_raw: H_raw,
-      theta_raw: theta_raw,
-      H_calibrated: isCalibrated ? H_calibrated : undefined,
-      theta_calibrated: isCalibrated ? theta_calibrated : undefined,
-      H_dB_raw: safeLog10(H_raw),
-      H_dB_calibrated: isCalibrated ? safeLog10(H_calibrated) : undefined
-    }
-
-    setDataPoints(prev => {
-      const existingIndex = prev.findIndex(p => p.freq === freq)
-      
-      if (existingIndex >= 0) {
-        const newPoints = [...prev]
-        newPoints[existingIndex] = dataPoint
-        return newPoints
-      } else {
-        const newPoints = [...prev, dataPoint].sort((a, b) => a.freq - b.freq)
-        
-        if (newPoints.length > CONFIG.MAX_DATA_POINTS) {
-          addLog(`数据点数超过${CONFIG.MAX_DATA_POINTS}，自动移除最旧数据`, 'warning')
-          return newPoints.slice(1)
-        }
-        
-        return newPoints
-      }
-    })
-
-    if (isCalibrated) {
-      addLog(`数据 [已校准]: f=${freq}Hz, H=${H_calibrated.toFixed(4)} (原始=${H_raw.toFixed(4)}), θ=${theta_calibrated.toFixed(2)}° (原始=${theta_raw.toFixed(2)}°)`, 'success')
-    } else {
-      addLog(`数据: f=${freq}Hz, H(ω)=${H.toFixed(4)}, θ(ω)=${theta.toFixed(2)}°`, 'success')
-    }
+    pushFreqResp({
+      freq, K, K1, H, theta, H_raw, theta_raw, H_calibrated, theta_calibrated, isCalibrated
+    }, addLog)
   }, [])
 
   const clearDataPoints = useCallback(() => {
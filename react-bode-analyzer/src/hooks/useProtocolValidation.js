@@ -133,13 +133,13 @@ export function useProtocolValidation() {
       return { valid: false, error: 'parse', message: '数值解析失败' }
     }
     
-    if (signalFreq < 10 || signalFreq > 2000) {
-      addError('range', `信号频率超出范围: ${signalFreq}Hz (有效: 10-2000Hz)`, data)
+    if (signalFreq < 10 || signalFreq > 20000) {
+      addError('range', `信号频率超出范围: ${signalFreq}Hz (有效: 10-20000Hz)`, data)
       return { valid: false, error: 'range', message: '信号频率超出范围' }
     }
     
-    if (sampleRate < 10 || sampleRate > 50000) {
-      addError('range', `采样率超出范围: ${sampleRate}Hz (有效: 10-50000Hz)`, data)
+    if (sampleRate < 10 || sampleRate > 200000) {
+      addError('range', `采样率超出范围: ${sampleRate}Hz (有效: 10-200000Hz)`, data)
       return { valid: false, error: 'range', message: '采样率超出范围' }
     }
     
@@ -1,7 +1,14 @@
 import { useState, useCallback, useRef } from 'react'
+import { createFrameParser } from './binaryFrames'
 
 const CONFIG = {
   BAUD_RATE_DEFAULT: 115200,
+  BAUD_RATES: [115200, 460800, 921600, 2000000],
+  BAUD_ACK_TIMEOUT: 1000,     // 等待旧波特率下的OK:BAUD应答
+  BAUD_PING_INTERVAL: 200,    // 新波特率下PING重发间隔
+  BAUD_PING_TIMEOUT: 1500,    // 须小于固件UART_BAUD_PING_TIMEOUT_MS(2000)
+  BAUD_REVERT_TIMEOUT: 1500,  // 等待固件超时回退
+  BAUD_PROBE_TIMEOUT: 600,    // 连接时每个候选波特率等待PONG的时间
   CONNECTION_TIMEOUT: 30000,
   DISCONNECT_TIMEOUT: 2000
 }
@@ -9,11 +16,15 @@ const CONFIG = {
 export function useSerialPort() {
   const [isConnected, setIsConnected] = useState(false)
   const [dataRate, setDataRate] = useState(0)
+  const [baudRate, setBaudRate] = useState(CONFIG.BAUD_RATE_DEFAULT)
+  const baudRateRef = useRef(CONFIG.BAUD_RATE_DEFAULT)  // disconnect中读取当前波特率
   const portRef = useRef(null)
   const readerRef = useRef(null)
   const dataCountRef = useRef(0)
   const lastReceiveTimeRef = useRef(Date.now())
   const dataCallbackRef = useRef(null)
+  const readLoopRef = useRef(null)
+  const lineListenersRef = useRef(new Set())
 
   const connect = useCallback(async (addLog, onDataReceived) => {
     try {
@@ -33,11 +44,19 @@ export function useSerialPort() {
 
       portRef.current = port
       dataCallbackRef.current = onDataReceived
-      setIsConnected(true)
-      addLog(`串口连接成功，波特率: ${CONFIG.BAUD_RATE_DEFAULT}`, 'success')
       
       // 开始读取数据
-      readSerialData(addLog)
+      readLoopRef.current = readSerialData(addLog)
+
+      // 固件保留协商后的波特率（上次未正常断开或页面刷新），逐个波特率PING探测
+      const rate = await probeBaudRate(addLog)
+      updateBaudRate(rate || CONFIG.BAUD_RATE_DEFAULT)
+      setIsConnected(true)
+      if (rate) {
+        addLog(`串口连接成功，波特率: ${rate}`, 'success')
+      } else {
+        addLog(`串口已打开，但设备未应答PING，按默认波特率 ${CONFIG.BAUD_RATE_DEFAULT} 连接`, 'warning')
+      }
       
       return true
     } catch (error) {
@@ -61,6 +80,11 @@ export function useSerialPort() {
       }
       
       setIsConnected(false)
+
+      // 设备切回默认波特率，下次连接/刷新页面后仍可通信
+      if (portRef.current && baudRateRef.current !== CONFIG.BAUD_RATE_DEFAULT) {
+        await negotiateBaudRate(CONFIG.BAUD_RATE_DEFAULT, addLog || (() => {}))
+      }
       
       if (readerRef.current) {
         try {
@@ -121,19 +145,160 @@ export function useSerialPort() {
     }
   }, [isConnected])
 
+  // 不经过isConnected状态直接写一行（波特率切换期间使用）
+  const writeLine = async (text) => {
+    const writer = portRef.current.writable.getWriter()
+    try {
+      await writer.write(new TextEncoder().encode(text + '\r\n'))
+    } finally {
+      writer.releaseLock()
+    }
+  }
+
+  // 等待匹配的文本行，超时返回null
+  const waitForLine = (match, timeout) => new Promise((resolve) => {
+    const listener = (line) => {
+      if (match(line)) {
+        clearTimeout(timer)
+        lineListenersRef.current.delete(listener)
+        resolve(line)
+      }
+    }
+    const timer = setTimeout(() => {
+      lineListenersRef.current.delete(listener)
+      resolve(null)
+    }, timeout)
+    lineListenersRef.current.add(listener)
+  })
+
+  // 以新波特率重新打开同一串口并重启读取循环
+  const reopenPort = async (rate, addLog) => {
+    if (readerRef.current) {
+      try {
+        await readerRef.current.cancel()
+      } catch (e) {
+        // 忽略已取消的错误
+      }
+    }
+    await readLoopRef.current
+    readerRef.current = null
+    await portRef.current.close()
+    await portRef.current.open({ baudRate: rate })
+    readLoopRef.current = readSerialData(addLog)
+  }
+
+  // 反复发送PING直到收到匹配的应答行，超时返回null
+  const pingUntil = async (match, timeout) => {
+    const reply = waitForLine(match, timeout)
+    let line = null
+    const started = Date.now()
+    while (!line && Date.now() - started < timeout) {
+      await writeLine('PING')
+      line = await Promise.race([
+        reply,
+        new Promise((resolve) => setTimeout(() => resolve(null), CONFIG.BAUD_PING_INTERVAL))
+      ])
+    }
+    return line || await reply
+  }
+
+  const updateBaudRate = (rate) => {
+    baudRateRef.current = rate
+    setBaudRate(rate)
+  }
+
+  // 连接时探测设备当前波特率：默认波特率优先，其余依次尝试；均无应答时回到默认波特率
+  const probeBaudRate = async (addLog) => {
+    let current = CONFIG.BAUD_RATE_DEFAULT
+    const rates = [CONFIG.BAUD_RATE_DEFAULT, ...CONFIG.BAUD_RATES.filter((r) => r !== CONFIG.BAUD_RATE_DEFAULT)]
+    for (const rate of rates) {
+      if (rate !== current) {
+        await reopenPort(rate, addLog)
+        current = rate
+      }
+      // 先发空行冲掉错误波特率下残留的半行
+      await writeLine('')
+      if (await pingUntil((line) => line.endsWith('PONG'), CONFIG.BAUD_PROBE_TIMEOUT)) {
+        return rate
+      }
+    }
+    if (current !== CONFIG.BAUD_RATE_DEFAULT) {
+      await reopenPort(CONFIG.BAUD_RATE_DEFAULT, addLog)
+    }
+    return null
+  }
+
+  // 波特率协商：旧波特率发送BAUD:rate并等应答 → 重开串口 → 新波特率PING/PONG
+  // 任一步失败则回到旧波特率（固件在2s内未收到PING也会自行回退）
+  const negotiateBaudRate = async (rate, addLog) => {
+    const oldRate = baudRateRef.current
+    if (rate === oldRate) return true
+
+    try {
+      const ack = waitForLine((line) => line.startsWith('OK:BAUD:') || line.startsWith('ERROR:BAUD'), CONFIG.BAUD_ACK_TIMEOUT)
+      await writeLine(`BAUD:${rate}`)
+      const reply = await ack
+      if (!reply || reply.startsWith('ERROR')) {
+        addLog(`设备拒绝波特率 ${rate}: ${reply || '无应答'}`, 'error')
+        return false
+      }
+
+      await reopenPort(rate, addLog)
+
+      const locked = await pingUntil((line) => line.startsWith('OK:BAUD_LOCKED:'), CONFIG.BAUD_PING_TIMEOUT)
+      if (locked) {
+        updateBaudRate(rate)
+        addLog(`波特率已切换: ${oldRate} → ${rate}`, 'success')
+        return true
+      }
+
+      addLog(`波特率 ${rate} 握手超时，回退到 ${oldRate}`, 'warning')
+      await reopenPort(oldRate, addLog)
+      await waitForLine((line) => line.startsWith('WARN:BAUD_REVERTED'), CONFIG.BAUD_REVERT_TIMEOUT)
+      return false
+    } catch (error) {
+      addLog(`波特率切换失败: ${error.message}`, 'error')
+      return false
+    }
+  }
+
+  const changeBaudRate = useCallback(async (rate, addLog) => {
+    if (!portRef.current) {
+      addLog('串口未连接', 'error')
+      return false
+    }
+    return negotiateBaudRate(rate, addLog)
+  }, [])
+
   const readSerialData = async (addLog) => {
-    let readableStreamClosed = null
     try {
       if (!portRef.current) {
         addLog('串口未初始化', 'error')
         return
       }
       
-      const textDecoder = new TextDecoderStream()
-      readableStreamClosed = portRef.current.readable.pipeTo(textDecoder.writable)
-      readerRef.current = textDecoder.readable.getReader()
+      // 读取原始字节：文本行与PROTO:BIN二进制帧混合在同一串口流中
+      readerRef.current = portRef.current.readable.getReader()
 
-      let buffer = ''
+      const parser = createFrameParser({
+        onLine: (line) => {
+          lineListenersRef.current.forEach((listener) => listener(line))
+          // 触发数据处理回调
+          if (dataCallbackRef.current) {
+            dataCallbackRef.current(line)
+          }
+          // 记录日志（FREQ_RESP数据会在dataPoints中处理，不需要重复记录）
+          if (!line.startsWith('FREQ_RESP:')) {
+            addLog(`接收: ${line}`, 'info')
+          }
+        },
+        onFrame: (frame) => {
+          if (dataCallbackRef.current) {
+            dataCallbackRef.current(frame)
+          }
+        },
+        onError: (message) => addLog(`[BIN] ${message}`, 'warning')
+      })
 
       while (true) {
         const { value, done } = await readerRef.current.read()
@@ -143,24 +308,7 @@ export function useSerialPort() {
           break
         }
 
-        buffer += value
-        
-        let lines = buffer.split('\n')
-        buffer = lines.pop()
-
-        for (let line of lines) {
-          line = line.trim()
-          if (line) {
-            // 触发数据处理回调
-            if (dataCallbackRef.current) {
-              dataCallbackRef.current(line)
-            }
-            // 记录日志（FREQ_RESP数据会在dataPoints中处理，不需要重复记录）
-            if (!line.startsWith('FREQ_RESP:')) {
-              addLog(`接收: ${line}`, 'info')
-            }
-          }
-        }
+        parser.push(value)
 
         // 更新接收速率
         dataCountRef.current++
@@ -171,10 +319,6 @@ export function useSerialPort() {
           lastReceiveTimeRef.current = now
         }
       }
-      
-      if (readableStreamClosed) {
-        await readableStreamClosed.catch(() => {})
-      }
     } catch (error) {
       // AbortError 是正常的取消操作，不需要记录为错误
       if (error.name !== 'AbortError') {
@@ -191,23 +335,19 @@ export function useSerialPort() {
           console.warn('Reader release warning:', e.message)
         }
       }
-      if (readableStreamClosed) {
-        try {
-          await readableStreamClosed.catch(() => {})
-        } catch (e) {
-          console.warn('Stream close warning:', e.message)
-        }
-      }
     }
   }
 
   return {
     isConnected,
     dataRate,
+    baudRate,
+    baudRates: CONFIG.BAUD_RATES,
     serialPort: portRef.current,  // 暴露serialPort供其他组件使用
     connect,
     disconnect,
-    sendCommand
+    sendCommand,
+    changeBaudRate
   }
 }
 